@@ -0,0 +1,43 @@
+# Try to find jemalloc
+# Once done, this will define
+#
+# Jemalloc_FOUND        - system has jemalloc
+# JEMALLOC_INCLUDE_DIRS - jemalloc include directories
+# JEMALLOC_LIBRARIES    - libraries need to use jemalloc
+#
+# and the imported target Jemalloc_lib
+
+if (JEMALLOC_INCLUDE_DIRS AND JEMALLOC_LIBRARIES)
+    set(JEMALLOC_FIND_QUIETLY TRUE)
+    set(Jemalloc_FOUND TRUE)
+else ()
+    find_path(
+            JEMALLOC_INCLUDE_DIR
+            NAMES jemalloc/jemalloc.h
+            HINTS ${JEMALLOC_ROOT_DIR}
+            PATH_SUFFIXES include)
+
+    find_library(
+            JEMALLOC_LIBRARY
+            NAMES jemalloc
+            HINTS ${JEMALLOC_ROOT_DIR}
+            PATH_SUFFIXES ${CMAKE_INSTALL_LIBDIR})
+
+    set(JEMALLOC_INCLUDE_DIRS ${JEMALLOC_INCLUDE_DIR})
+    set(JEMALLOC_LIBRARIES ${JEMALLOC_LIBRARY})
+
+    include(FindPackageHandleStandardArgs)
+    find_package_handle_standard_args(
+            Jemalloc DEFAULT_MSG JEMALLOC_LIBRARY JEMALLOC_INCLUDE_DIR)
+
+    mark_as_advanced(JEMALLOC_LIBRARY JEMALLOC_INCLUDE_DIR)
+endif ()
+
+if(Jemalloc_FOUND AND NOT TARGET Jemalloc_lib)
+    add_library(Jemalloc_lib INTERFACE IMPORTED)
+    set_target_properties(Jemalloc_lib
+            PROPERTIES INTERFACE_INCLUDE_DIRECTORIES
+            "${JEMALLOC_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES
+            "${JEMALLOC_LIBRARIES}")
+endif(Jemalloc_FOUND AND NOT TARGET Jemalloc_lib)
@@ -0,0 +1,49 @@
+# Try to find mimalloc
+# Once done, this will define
+#
+# Mimalloc_FOUND        - system has mimalloc
+# MIMALLOC_INCLUDE_DIRS - mimalloc include directories
+# MIMALLOC_LIBRARIES    - libraries need to use mimalloc
+#
+# and the imported target Mimalloc_lib
+
+if (MIMALLOC_INCLUDE_DIRS AND MIMALLOC_LIBRARIES)
+    set(MIMALLOC_FIND_QUIETLY TRUE)
+    set(Mimalloc_FOUND TRUE)
+else ()
+    # mimalloc installs its headers in a versioned directory, e.g.
+    # include/mimalloc-2.1
+    file(GLOB MIMALLOC_VERSIONED_DIRS
+            ${MIMALLOC_ROOT_DIR}/include/mimalloc-*
+            /usr/local/include/mimalloc-*
+            /usr/include/mimalloc-*)
+    find_path(
+            MIMALLOC_INCLUDE_DIR
+            NAMES mimalloc.h
+            HINTS ${MIMALLOC_ROOT_DIR} ${MIMALLOC_VERSIONED_DIRS}
+            PATH_SUFFIXES include)
+
+    find_library(
+            MIMALLOC_LIBRARY
+            NAMES mimalloc mimalloc-static
+            HINTS ${MIMALLOC_ROOT_DIR}
+            PATH_SUFFIXES ${CMAKE_INSTALL_LIBDIR})
+
+    set(MIMALLOC_INCLUDE_DIRS ${MIMALLOC_INCLUDE_DIR})
+    set(MIMALLOC_LIBRARIES ${MIMALLOC_LIBRARY})
+
+    include(FindPackageHandleStandardArgs)
+    find_package_handle_standard_args(
+            Mimalloc DEFAULT_MSG MIMALLOC_LIBRARY MIMALLOC_INCLUDE_DIR)
+
+    mark_as_advanced(MIMALLOC_LIBRARY MIMALLOC_INCLUDE_DIR)
+endif ()
+
+if(Mimalloc_FOUND AND NOT TARGET Mimalloc_lib)
+    add_library(Mimalloc_lib INTERFACE IMPORTED)
+    set_target_properties(Mimalloc_lib
+            PROPERTIES INTERFACE_INCLUDE_DIRECTORIES
+            "${MIMALLOC_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES
+            "${MIMALLOC_LIBRARIES}")
+endif(Mimalloc_FOUND AND NOT TARGET Mimalloc_lib)
@@ -0,0 +1,137 @@
+/**
+ *
+ *  @file CompressionDictionary.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+class CompressionDictionary;
+using CompressionDictionaryPtr = std::shared_ptr<const CompressionDictionary>;
+
+/**
+ * @brief A shared dictionary for the dictionary-compressed content encodings
+ * of the Compression Dictionary Transport: "dcb" (brotli) and "dcz" (zstd).
+ * Small responses that repeat the content of the dictionary, e.g. the JSON
+ * bodies of an API, compress much better with it than alone.
+ *
+ * A client advertises the dictionary it has with the Available-Dictionary
+ * header (the SHA-256 hash of the dictionary as a structured field byte
+ * sequence) or, for the clients that don't hash it, with the Dictionary-ID
+ * header. The encoded bodies begin with the hash of the dictionary, so a
+ * client never decodes with the wrong one.
+ *
+ * The dictionary is prepared for each encoding once when it's created, the
+ * object is immutable and can be shared by all threads.
+ */
+class DROGON_EXPORT CompressionDictionary
+{
+  public:
+    enum class Encoding
+    {
+        // "dcb", requires brotli 1.1 or later
+        kBrotli,
+        // "dcz", requires zstd
+        kZstd
+    };
+
+    /**
+     * @brief Create a dictionary with the content of a file.
+     *
+     * @param path The path of the file.
+     * @param id The optional id sent to the clients with the dictionary.
+     * @return nullptr if the file can't be read or is empty.
+     */
+    static CompressionDictionaryPtr fromFile(const std::string &path,
+                                             std::string id = std::string());
+
+    /// Create a dictionary with the data, nullptr if the data is empty.
+    static CompressionDictionaryPtr fromData(std::string data,
+                                             std::string id = std::string());
+
+    ~CompressionDictionary();
+
+    /// Return true if the encoding is available in this build.
+    static bool supports(Encoding encoding);
+
+    /// The content coding name of the encoding: "dcb" or "dcz".
+    static const char *name(Encoding encoding);
+
+    /// The encoding of a content coding name.
+    static std::optional<Encoding> encodingOf(std::string_view name);
+
+    const std::string &data() const
+    {
+        return data_;
+    }
+
+    const std::string &id() const
+    {
+        return id_;
+    }
+
+    /// The SHA-256 hash of the dictionary, 32 bytes.
+    const std::string &hash() const
+    {
+        return hash_;
+    }
+
+    /// The hash as the value of the Available-Dictionary header, e.g.
+    /// ":pZGm1Av0IEBKARczz7exkNYsZb8LzaMrV7J32a2fFG4=:".
+    const std::string &availableDictionary() const
+    {
+        return availableDictionary_;
+    }
+
+    /// Return true if the Available-Dictionary header value refers to this
+    /// dictionary, spaces around the value are ignored.
+    bool matches(std::string_view availableDictionary) const;
+
+    /**
+     * @brief Compress the data with the dictionary, the result begins with
+     * the header of the encoding and the hash of the dictionary.
+     *
+     * @return An empty string if the encoding isn't supported or fails.
+     */
+    std::string compress(const char *data,
+                         size_t length,
+                         Encoding encoding) const;
+
+    /**
+     * @brief Decompress data compressed by compress() or by another server
+     * with the same dictionary.
+     *
+     * @return An empty optional if the data is invalid, or was compressed with
+     * another dictionary.
+     */
+    std::optional<std::string> decompress(const char *data,
+                                          size_t length,
+                                          Encoding encoding) const;
+
+  private:
+    CompressionDictionary(std::string data, std::string id);
+
+    struct Prepared;
+
+    std::string data_;
+    std::string id_;
+    std::string hash_;
+    std::string availableDictionary_;
+    std::unique_ptr<Prepared> prepared_;
+};
+}  // namespace drogon
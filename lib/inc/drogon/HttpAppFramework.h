@@ -19,6 +19,7 @@
 #include <drogon/exports.h>
 #include <drogon/utils/HttpConstraint.h>
 #include <drogon/CacheMap.h>
+#include <drogon/CompressionDictionary.h>
 #include <drogon/DrObject.h>
 #include <drogon/HttpBinder.h>
 #include <drogon/HttpFilter.h>
@@ -79,6 +80,77 @@ using DefaultHandler =
                        std::function<void(const HttpResponsePtr &)> &&)>;
 using HttpHandlerInfo = std::tuple<std::string, HttpMethod, std::string>;
 
+/**
+ * @brief The counters of the static file metadata cache, summed over all IO
+ * threads.
+ */
+struct StaticFileCacheStats
+{
+    /// Lookups answered from the cache
+    size_t hits{0};
+    /// Lookups that called stat()
+    size_t misses{0};
+    /// Cache hits for missing files
+    size_t notFoundHits{0};
+    /// The number of cached paths
+    size_t entries{0};
+};
+
+/**
+ * @brief The counters of the MSG_ZEROCOPY sends of large response bodies, see
+ * HttpAppFramework::setZeroCopySendThreshold().
+ */
+struct ZeroCopySendStats
+{
+    /// The send() calls with MSG_ZEROCOPY
+    size_t sends{0};
+    /// The bytes sent with MSG_ZEROCOPY
+    size_t bytes{0};
+    /// The sends for which the kernel copied the data anyway
+    size_t copiedSends{0};
+    /// The bytes of the large bodies sent by copying them, when the socket is
+    /// full or the kernel reported copied sends on the connection
+    size_t fallbackBytes{0};
+};
+
+/**
+ * @brief The CPUs the threads of the framework run on (Linux only), see
+ * HttpAppFramework::setCpuAffinity(). The threads with an empty CPU list are
+ * not pinned.
+ */
+struct CpuAffinityConfig
+{
+    /// The IO loop i runs on the CPU ioLoopCpus[i % ioLoopCpus.size()]
+    std::vector<unsigned int> ioLoopCpus;
+    /// Spread the IO loops over the NUMA nodes round-robin, each loop runs on
+    /// the CPUs of its node. It overrides ioLoopCpus.
+    bool numaAware{false};
+    std::vector<unsigned int> mainLoopCpus;
+    /// The CPUs of the threads of the database and redis clients, except the
+    /// fast clients, which run in the IO loops.
+    std::vector<unsigned int> dbLoopCpus;
+};
+
+/**
+ * @brief The load of a group of IO loops, see
+ * HttpAppFramework::setListenerThreadGroup().
+ */
+struct IoThreadGroupStats
+{
+    /// "ip:port" of the listener of a dedicated group, "shared" for the loops
+    /// of the other listeners
+    std::string name;
+    size_t threads{0};
+    size_t connections{0};
+    size_t maxConnections{0};
+    /// The average fraction of the last second the loops of the group spent
+    /// on the CPU (0 where the thread CPU time can't be read, or when no
+    /// listener has a group of its own)
+    double utilization{0};
+    /// The fraction of the busiest loop of the group
+    double maxUtilization{0};
+};
+
 #ifdef __cpp_impl_coroutine
 class HttpAppFramework;
 
@@ -321,6 +393,9 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
                sync join point o----------->[HttpResponsePtr]----------->+
                                |                                         |
                                v                                         |
+           Pre-body join point o----------->[Advice callback]----------->+
+                               |                                         |
+                               v                                         |
         Pre-routing join point o----------->[Advice callback]----------->+
                                |                                         |
                                v         Invalid path                    |
@@ -357,6 +432,25 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         const std::function<HttpResponsePtr(const HttpRequestPtr &)>
             &advice) = 0;
 
+    /// Register an advice called before the body of a request is received
+    /**
+     * @param advice is called as soon as the headers of a request are
+     * received, before the pre-routing advices. If the request has a body, it
+     * is not read (and the 100 (Continue) response is not sent) until the
+     * advice passes, a response given by the advice closes the connection.
+     * Authentication or quota checks based on the headers fit here. The
+     * parameters of the advice are same as those of the doFilter method of the
+     * Filter class.
+     * @note The body of the request must not be accessed in this advice, nor
+     * in the synchronous advices which run before it. The later join points
+     * get the whole body as before, unless early rejection (see
+     * enableEarlyRejection()) or request streaming is enabled.
+     */
+    virtual HttpAppFramework &registerPreBodyAdvice(
+        const std::function<void(const HttpRequestPtr &,
+                                 AdviceCallback &&,
+                                 AdviceChainCallback &&)> &advice) = 0;
+
     /// Register an advice called before routing
     /**
      * @param advice is called after all the synchronous advice return
@@ -801,6 +895,21 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &setThreadNum(size_t threadNum) = 0;
 
+    /// Pin the IO loops, the main loop and the database threads to CPUs
+    /**
+     * A pinned thread allocates its memory on its own NUMA node. When the IO
+     * loops are pinned, the listening socket of each loop prefers the
+     * connections received on a CPU of the loop (SO_INCOMING_CPU), so the
+     * connections stay on the node whose network queue received them. The
+     * placement of the threads is logged at startup.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It's only supported on Linux.
+     */
+    virtual HttpAppFramework &setCpuAffinity(
+        const CpuAffinityConfig &config) = 0;
+
     /// Get the number of threads for IO event loops
     virtual size_t getThreadNum() const = 0;
 
@@ -812,6 +921,21 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Supplies file style SSL options to `SSL_CONF_cmd`. Valid options are
     /// available at
     /// https://www.openssl.org/docs/manmaster/man3/SSL_CONF_cmd.html
+    /**
+     * TLS sessions are resumed with the session cache and the session tickets
+     * of the TLS context that accepted them. Session tickets are on by
+     * default, `{"Options", "-SessionTicket"}` turns them off.
+     *
+     * @note
+     * An https listener accepts its connections with one TLS context shared
+     * by all its IO loops, except on Linux, where each IO loop has its own
+     * SO_REUSEPORT socket and its own TLS context. There, a session is only
+     * resumed when the next connection of the client lands on the same loop.
+     * The ticket keys are generated by each context and live in the memory of
+     * the process. Shared ticket key files, keeping the previous keys after a
+     * rotation and counting the resumed handshakes need access to the
+     * `SSL_CTX` and `SSL` objects, which trantor doesn't expose.
+     */
     virtual HttpAppFramework &setSSLConfigCommands(
         const std::vector<std::pair<std::string, std::string>>
             &sslConfCmds) = 0;
@@ -823,6 +947,8 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Typically, when our SSL is about to expire,
     /// we need to reload the SSL. The purpose of this function
     /// is to use the new SSL certificate without stopping the framework.
+    /// The reloaded TLS contexts have new session ticket keys and an empty
+    /// session cache, so the sessions issued before are not resumed.
     virtual HttpAppFramework &reloadSSLFiles() = 0;
 
     /// Add plugins
@@ -844,6 +970,22 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
                            const std::vector<std::string> &dependencies,
                            const Json::Value &config) = 0;
 
+    /// Set the number of threads initializing the plugins at startup
+    /**
+     * @param threadNum 1 by default, the plugins are initialized one after
+     * another in the main thread. With more threads, the plugins that opt in
+     * with `"parallel_init": true` in their configs, and whose dependencies
+     * all opt in too, are initialized in parallel before the others. The
+     * initAndStart() method of such a plugin runs in a pool thread, so it
+     * must not register advices or handlers, or rely on plugins that are not
+     * declared as its dependencies. The other plugins are still initialized
+     * in the main thread, in order.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setPluginInitThreadNum(size_t threadNum) = 0;
+
     /// Add a listener for http or https service
     /**
      * @param ip is the ip that the listener listens on.
@@ -871,6 +1013,37 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         const std::vector<std::pair<std::string, std::string>> &sslConfCmds =
             {}) = 0;
 
+    /// Give a listener its own IO loops
+    /**
+     * @param ip
+     * @param port the address of a listener added by addListener().
+     * @param threadNum the number of IO loops handling the connections of
+     * the listener. They are taken from the end of the loops set by
+     * setThreadNum() and no other listener uses them, so a flood of
+     * connections on the other listeners (e.g. the public port) doesn't
+     * delay the listener (e.g. the admin, metrics or health check port).
+     * @param maxConnections the maximum number of connections of the
+     * listener, counted apart from the other listeners. If it's 0, the value
+     * of setMaxConnectionNum() is used. The limit of setMaxConnectionNumPerIP()
+     * counts the connections of an IP on all the listeners together.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The number of threads set by setThreadNum() must be greater than the
+     * sum of the threads of the groups. The load of each group is returned
+     * by getIoThreadGroupStats().
+     */
+    virtual HttpAppFramework &setListenerThreadGroup(
+        const std::string &ip,
+        uint16_t port,
+        size_t threadNum,
+        size_t maxConnections = 0) = 0;
+
+    /// Get the connections and the loop utilization of the shared IO loops
+    /// and of each group set by setListenerThreadGroup(), empty before the
+    /// listeners are created.
+    virtual std::vector<IoThreadGroupStats> getIoThreadGroupStats() const = 0;
+
     /// Enable sessions supporting.
     /**
      * @param timeout The number of seconds which is the timeout of a session
@@ -1127,6 +1300,28 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &enableSendfile(bool sendFile) = 0;
 
+    /// Send the large in-memory response bodies with MSG_ZEROCOPY in linux.
+    /**
+     * @param threshold The bodies of at least this size (in bytes) are sent
+     * from their own buffers without being copied into the socket buffers
+     * of the kernel. The buffers are kept alive until the kernel reports the
+     * completion of the sends. 0 (the default value) disables it.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It only applies to the http (not https) connections. Zero-copy sends
+     * pay for page pinning and completion notifications, so a threshold
+     * below 64k is usually not worth it. On the loopback device the kernel
+     * copies the data anyway.
+     */
+    virtual HttpAppFramework &setZeroCopySendThreshold(size_t threshold) = 0;
+
+    /// Get the threshold set by setZeroCopySendThreshold().
+    virtual size_t getZeroCopySendThreshold() const = 0;
+
+    /// Get the counters of the zero-copy sends.
+    virtual ZeroCopySendStats getZeroCopySendStats() const = 0;
+
     /// Enable gzip compression.
     /**
      * @param useGzip if the parameter is true, use gzip to compress the
@@ -1161,6 +1356,50 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Return true if brotli is enabled.
     virtual bool isBrotliEnabled() const = 0;
 
+    /// Add a shared dictionary for the compression of responses.
+    /**
+     * @param filePath The file of the dictionary, usually a sample of the
+     * responses it's used for. The program exits if it can't be read.
+     * @param path The path where the clients download the dictionary, it's
+     * served with a Use-As-Dictionary header. If it's empty, the dictionary
+     * isn't served and the clients get it another way.
+     * @param match The URL pattern of the responses the clients use the
+     * dictionary for (e.g. "/api/" followed by the "*" wildcard), sent in the
+     * Use-As-Dictionary header.
+     * @param id The optional id of the dictionary, the clients that don't hash
+     * the dictionary can advertise it with a Dictionary-ID header instead of
+     * the Available-Dictionary header.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * A response is compressed with a dictionary ("dcb" with brotli 1.1,
+     * "dcz" with zstd) when it would be compressed with gzip or brotli, the
+     * request advertises the dictionary and the Accept-Encoding header has
+     * the encoding. The dictionary is preferred to brotli and gzip.
+     */
+    virtual HttpAppFramework &addCompressionDictionary(
+        const std::string &filePath,
+        const std::string &path,
+        const std::string &match,
+        const std::string &id = "") = 0;
+
+    /// Enable the automatic ETags of the responses.
+    /**
+     * @param flag if the parameter is true, the 200 responses get a strong
+     * ETag computed from the body, and the requests with a matching
+     * If-None-Match header are answered with 304 Not Modified. See
+     * HttpResponse::setAutoETag(), which overrides it for a response. The
+     * default value is false.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The static files have their own ETags.
+     */
+    virtual HttpAppFramework &enableAutoETag(bool flag) = 0;
+
+    /// Return true if the automatic ETags are enabled.
+    virtual bool isAutoETagEnabled() const = 0;
+
     /// Set the time in which the static file response is cached in memory.
     /**
      * @param cacheTime in seconds. 0 means always cached, negative means no
@@ -1174,6 +1413,22 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Get the time set by the above method.
     virtual int staticFilesCacheTime() const = 0;
 
+    /// Set the time in which the metadata of static files is cached in memory.
+    /**
+     * @param cacheTime in seconds, 1 by default. The result of looking up a
+     * path (including a missing file) is kept for that time on each IO
+     * thread, so a changed file may be served with its old size or
+     * Last-Modified value until then. 0 or negative disables the cache.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setStaticFileMetadataCacheTime(
+        double cacheTime) = 0;
+
+    /// Get the hit counts of the static file metadata cache.
+    virtual StaticFileCacheStats getStaticFileCacheStats() const = 0;
+
     /// Set the lifetime of the connection without read or write
     /**
      * @param timeout in seconds. 60 by default. Setting the timeout to 0 means
@@ -1199,6 +1454,24 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         return setIdleConnectionTimeout((size_t)timeout.count());
     }
 
+    /// Set the time after which the buffers of an idle connection are released
+    /**
+     * @param releaseTime in seconds. 10 by default. The connections that
+     * receive no data for one to two times this value give back the memory
+     * of their empty buffers and pooled requests, which is allocated again
+     * with the next data. It keeps the memory of many idle keep-alive and
+     * websocket connections small. Setting the time to 0 disables it.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The value is read when a connection is established.
+     */
+    virtual HttpAppFramework &setIdleBufferReleaseTime(double releaseTime) = 0;
+
+    /// Get the time after which the buffers of an idle connection are
+    /// released.
+    virtual double getIdleBufferReleaseTime() const = 0;
+
     /// Set the 'server' header field in each response sent by drogon.
     /**
      * @param server empty string by default with which the 'server' header
@@ -1405,6 +1678,22 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual bool areAllDbClientsAvailable() const noexcept = 0;
 
+    /// Wait for the database and redis connections before listening
+    /**
+     * @param minConnections The listeners start once every database and
+     * redis client, except the fast ones, has established this number of
+     * connections (or all of its connections if it has fewer). 0 by default,
+     * the listeners start without waiting.
+     * @param timeout The listeners start anyway after this time in seconds,
+     * with a warning.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setStartupConnectionWarmUp(
+        size_t minConnections,
+        double timeout = 10.0) = 0;
+
     /// Get a redis client by name
     /**
      * @note
@@ -1637,6 +1926,26 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     virtual HttpAppFramework &enableRequestStream(bool enable = true) = 0;
     virtual bool isRequestStreamEnabled() const = 0;
 
+    /**
+     * @brief Enable early rejection of requests with a body.
+     *
+     * @param enable If true, a request with a body is routed as soon as its
+     * headers are received, and the body is only read after the request passes
+     * the post-routing advices and the filters/middlewares of the handler.
+     * The 100 (Continue) response to an 'Expect: 100-continue' request is sent
+     * at that point too. If the request is rejected before, the server stops
+     * reading it and closes the connection after the response, without
+     * receiving (or spilling to a temporary file) the body.
+     * @note Pre-routing and post-routing advices, and filters/middlewares,
+     * must not access the body of the request in this mode, nor rely on its
+     * form parameters. The parameters are parsed again once the body is
+     * received.
+     * @note This operation can be performed by an option in the configuration
+     * file.
+     */
+    virtual HttpAppFramework &enableEarlyRejection(bool enable = true) = 0;
+    virtual bool isEarlyRejectionEnabled() const = 0;
+
   private:
     virtual void registerHttpController(
         const std::string &pathPattern,
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <drogon/exports.h>
+#include <drogon/CompressionDictionary.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/drogon_callbacks.h>
 #include <drogon/HttpResponse.h>
@@ -33,8 +34,24 @@
 
 namespace drogon
 {
+namespace monitoring
+{
+class Registry;
+}
+
 class HttpClient;
 using HttpClientPtr = std::shared_ptr<HttpClient>;
+
+/**
+ * @brief The statistics of the DNS cache shared by all http clients.
+ */
+struct DnsCacheStats
+{
+    size_t hits{0};
+    size_t negativeHits{0};
+    size_t misses{0};
+    size_t entries{0};
+};
 #ifdef __cpp_impl_coroutine
 namespace internal
 {
@@ -56,6 +73,85 @@ struct HttpRespAwaiter : public CallbackAwaiter<HttpResponsePtr>
 }  // namespace internal
 #endif
 
+/**
+ * @brief The configuration of the response cache of a http client, see
+ * HttpClient::enableCache().
+ */
+struct HttpClientCacheConfig
+{
+    /// The max size in bytes of the responses kept in memory.
+    size_t maxMemorySize{16 * 1024 * 1024};
+    /// Responses larger than this value are never cached.
+    size_t maxEntrySize{1024 * 1024};
+    /// The directory that keeps the responses evicted from memory. Disabled
+    /// if empty.
+    std::string diskPath;
+    /// The max size in bytes of the responses kept in diskPath.
+    size_t maxDiskSize{256 * 1024 * 1024};
+};
+
+struct HttpClientCacheStats
+{
+    /// Requests served by fresh responses
+    size_t hits{0};
+    /// Requests served by stale responses (max-stale, stale-while-revalidate
+    /// or stale-if-error)
+    size_t staleHits{0};
+    /// Requests sent to the server without a stored response
+    size_t misses{0};
+    /// Conditional requests sent to the server for stale responses
+    size_t revalidations{0};
+    /// 304 responses to the conditional requests
+    size_t notModified{0};
+    /// Requests merged into an identical request on the fly
+    size_t coalesced{0};
+    /// Requests not eligible for caching (no-store, conditional or range
+    /// requests)
+    size_t bypasses{0};
+    /// Responses evicted from memory
+    size_t evictions{0};
+};
+
+/**
+ * @brief The configuration of the connection maintenance of a http client,
+ * see HttpClient::enableKeepAlive().
+ */
+struct HttpClientKeepAliveConfig
+{
+    /// Connect to the server at once instead of on the first request, and
+    /// reconnect whenever the connection is closed.
+    bool prewarm{true};
+    /// Send a probe request on a connection idle for this many seconds. It
+    /// should be shorter than the keepalive timeout of the server. 0 disables
+    /// the probes.
+    double probeInterval{30.0};
+    /// The probe is considered failed if there is no response in this many
+    /// seconds.
+    double probeTimeout{5.0};
+    HttpMethod probeMethod{Head};
+    std::string probePath{"/"};
+    /// Replace a connection older than this many seconds with a new one
+    /// established in background, before the server or a load balancer
+    /// closes it. 0 disables the replacement.
+    double maxConnectionAge{0.0};
+};
+
+struct HttpClientConnectionStats
+{
+    /// Connections established to the server
+    size_t connections{0};
+    /// The time in seconds of the TCP and TLS handshakes of the last
+    /// connection
+    double lastHandshakeTime{0.0};
+    double averageHandshakeTime{0.0};
+    size_t probes{0};
+    /// Probes that timed out or got a 5xx response
+    size_t failedProbes{0};
+    /// Connections replaced by a new one because of their age or of a
+    /// failed probe
+    size_t replacements{0};
+};
+
 /// Asynchronous http client
 /**
  * HttpClient implementation object uses the HttpAppFramework's event loop by
@@ -230,6 +326,78 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
      */
     virtual void setUserAgent(const std::string &userAgent) = 0;
 
+    /**
+     * @brief Set the shared dictionary the server compresses the responses
+     * with. The requests advertise it with the Available-Dictionary (and the
+     * Dictionary-ID if it has an id) header and accept the "dcb" and "dcz"
+     * encodings this build supports, the responses encoded with it are
+     * decoded before the callbacks.
+     *
+     * @param dictionary The dictionary, e.g. downloaded from the server or
+     * loaded from the same file, nullptr to stop using it.
+     * @note Only the clients created by drogon support it, the default
+     * implementation ignores the dictionary so that other subclasses keep
+     * compiling.
+     */
+    virtual void setCompressionDictionary(CompressionDictionaryPtr dictionary)
+    {
+        (void)dictionary;
+    }
+
+    /**
+     * @brief Enable the private response cache (RFC 9111) of the client.
+     * Responses of GET requests are stored according to their Cache-Control,
+     * Expires and Vary headers. Stale responses are revalidated with
+     * If-None-Match/If-Modified-Since, or served while revalidated in
+     * background within their stale-while-revalidate window. Identical GET
+     * requests on the fly are merged into one request to the server, unless
+     * their Authorization headers differ. Responses to requests with an
+     * Authorization header are only stored if they are public, or have the
+     * s-maxage or must-revalidate directive. Unsafe requests (e.g. POST)
+     * invalidate the responses of their URI, and of the Location and
+     * Content-Location of their response.
+     *
+     * @note Responses served from the cache are copies, an Age header is
+     * added to them.
+     * @note Only the clients created by drogon support it, the default
+     * implementation does nothing so that other subclasses keep compiling.
+     */
+    virtual void enableCache(
+        const HttpClientCacheConfig &config = HttpClientCacheConfig())
+    {
+        (void)config;
+    }
+
+    /// Get the statistics of the response cache.
+    virtual HttpClientCacheStats getCacheStats()
+    {
+        return {};
+    }
+
+    /**
+     * @brief Keep the connection of the client warm. The client connects
+     * before the first request, probes the connection when it is idle so that
+     * the server doesn't close it, and replaces it before it gets too old.
+     * Replacement connections are established in background and take over
+     * once the current one is idle, so requests never wait for a handshake.
+     *
+     * @note A client keeps one connection to the server, create several
+     * clients (e.g. one per IO loop) to keep several connections warm.
+     * @note Only the clients created by drogon support it, the default
+     * implementation does nothing so that other subclasses keep compiling.
+     */
+    virtual void enableKeepAlive(
+        const HttpClientKeepAliveConfig &config = HttpClientKeepAliveConfig())
+    {
+        (void)config;
+    }
+
+    /// Get the statistics of the connections of the client.
+    virtual HttpClientConnectionStats getConnectionStats()
+    {
+        return {};
+    }
+
     /**
      * @brief Create a new HTTP client which use ip and port to connect to
      * server
@@ -346,6 +514,38 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
                                        bool useOldTLS = false,
                                        bool validateCert = true);
 
+    /**
+     * @brief Set the lifetime of the DNS cache entries shared by all clients
+     * created with a host name.
+     *
+     * @param ttl The number of seconds a resolved host is cached, the default
+     * value is 60. Setting it to 0 makes clients query DNS on every
+     * (re)connection.
+     * @param negativeTtl The number of seconds a failed query is cached, the
+     * default value is 5.
+     */
+    static void setDnsCacheTtl(double ttl, double negativeTtl = 5.0);
+
+    /// Get the hit/miss statistics of the DNS cache.
+    static DnsCacheStats getDnsCacheStats();
+
+    /// Remove all entries from the DNS cache.
+    static void clearDnsCache();
+
+    /**
+     * @brief Export the lookups of the DNS cache to the registry (e.g. the
+     * PromExporter plugin) as the drogon_http_client_dns_lookups_total counter
+     * labeled with result="hit|negative_hit|miss".
+     */
+    static void enableDnsCacheMetrics(monitoring::Registry &registry);
+
+    /**
+     * @brief Register the histogram of the handshake time of the connections
+     * of all http clients (drogon_http_client_handshake_seconds) to the
+     * registry.
+     */
+    static void enableConnectionMetrics(monitoring::Registry &registry);
+
     virtual ~HttpClient()
     {
     }
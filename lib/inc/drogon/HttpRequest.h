@@ -20,6 +20,7 @@
 #include <drogon/HttpTypes.h>
 #include <drogon/Session.h>
 #include <drogon/Attribute.h>
+#include <drogon/ParameterView.h>
 #include <drogon/UploadFile.h>
 #include <json/json.h>
 #include <trantor/net/InetAddress.h>
@@ -303,9 +304,18 @@ class DROGON_EXPORT HttpRequest
         return attributes();
     }
 
-    /// Get parameters of the request.
+    /// Get parameters of the request. All the parameters are decoded into the
+    /// map on the first call, parameterView() decodes only the requested ones.
     virtual const SafeStringMap<std::string> &parameters() const = 0;
 
+    /**
+     * @brief Get the lazy view of the parameters of the request, from the
+     * query string and the x-www-form-urlencoded body, e.g.
+     * `req->parameterView().get("id")`. The values without escapes are not
+     * copied.
+     */
+    virtual const ParameterView &parameterView() const = 0;
+
     /// Get parameters of the request.
     const SafeStringMap<std::string> &getParameters() const
     {
@@ -327,14 +337,13 @@ class DROGON_EXPORT HttpRequest
     template <typename T>
     std::optional<T> getOptionalParameter(const std::string &key)
     {
-        auto &params = getParameters();
-        auto it = params.find(key);
-        if (it != params.end())
+        auto value = parameterView().get(key);
+        if (value)
         {
             try
             {
                 return std::optional<T>(
-                    drogon::utils::fromString<T>(it->second));
+                    drogon::utils::fromString<T>(std::string(*value)));
             }
             catch (const std::exception &e)
             {
@@ -24,9 +24,13 @@
 #include <drogon/HttpViewData.h>
 #include <drogon/utils/Utilities.h>
 #include <json/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace drogon
 {
@@ -71,46 +75,150 @@ inline HttpResponsePtr toResponse<Json::Value &>(Json::Value &pJson)
     return toResponse((const Json::Value &)pJson);
 }
 
-class DROGON_EXPORT ResponseStream
+class SseStream;
+using SseStreamPtr = std::shared_ptr<SseStream>;
+
+class ChunkWriter;
+class ResponseStream;
+
+#ifdef __cpp_impl_coroutine
+namespace internal
+{
+struct [[nodiscard]] ResponseStreamAwaiter : public CallbackAwaiter<bool>
 {
   public:
-    explicit ResponseStream(trantor::AsyncStreamPtr asyncStream)
-        : asyncStream_(std::move(asyncStream))
+    ResponseStreamAwaiter(ResponseStream &stream, std::string &&data)
+        : stream_(stream), data_(std::move(data))
     {
     }
 
-    ~ResponseStream()
-    {
-        close();
-    }
+    // Return false to go on at once if the stream is writable (or failed),
+    // so a loop of sends to a fast client doesn't nest the resumptions
+    bool await_suspend(std::coroutine_handle<> handle);
 
-    bool send(const std::string &data)
+  private:
+    enum State
     {
-        if (!asyncStream_)
-        {
-            return false;
-        }
-        std::ostringstream oss;
-        oss << std::hex << data.length() << "\r\n";
-        oss << data << "\r\n";
-        return asyncStream_->send(oss.str());
-    }
+        kSending,
+        kSuspended,
+        kDone
+    };
+
+    ResponseStream &stream_;
+    std::string data_;
+    std::atomic<int> state_{kSending};
+};
+}  // namespace internal
+#endif
 
-    void close()
+/**
+ * @brief The body of an asynchronous stream response, sent with the chunked
+ * transfer coding, see HttpResponse::newAsyncStreamResponse().
+ *
+ * Each chunk is framed with a small header on the stack, the payload is not
+ * copied before it reaches the send buffer of the connection: the strings
+ * passed by rvalue and the shared buffers are moved to the event loop of the
+ * connection when they are sent from another thread. Only the small chunks
+ * are gathered into a single write.
+ *
+ * A producer can pace itself to the socket: the stream is not writable while
+ * the data waiting to be sent (in the send buffer of the connection or on the
+ * way to the event loop) exceeds the high water mark, and the drain callback
+ * is called once it's written out. The stream can be used from any thread,
+ * the callbacks are called in the event loop of the connection.
+ */
+class DROGON_EXPORT ResponseStream
+{
+  public:
+    explicit ResponseStream(trantor::AsyncStreamPtr asyncStream);
+
+    ResponseStream(trantor::AsyncStreamPtr asyncStream,
+                   const trantor::TcpConnectionPtr &conn);
+
+    ~ResponseStream();
+
+    /**
+     * @brief Send a chunk, the data is copied once into the send buffer (or
+     * into the task that carries it to the event loop).
+     *
+     * @return false if the stream is closed. An empty chunk is ignored.
+     */
+    bool send(const std::string &data);
+
+    /// Send a chunk without copying the data.
+    bool send(std::string &&data);
+
+    /// Send a chunk from a buffer which may be shared, e.g. by the streams of
+    /// a broadcast.
+    bool send(std::shared_ptr<const std::string> data);
+
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Send a chunk and wait until the stream is writable, e.g.
+     * `co_await stream->sendCoro(std::move(data));`. The coroutine resumes in
+     * the event loop of the connection if it has to wait.
+     *
+     * @return false if the stream or the connection is closed.
+     */
+    internal::ResponseStreamAwaiter sendCoro(std::string data)
     {
-        if (asyncStream_)
-        {
-            static std::string closeStream{"0\r\n\r\n"};
-            asyncStream_->send(closeStream);
-            asyncStream_->close();
-            asyncStream_.reset();
-        }
+        return internal::ResponseStreamAwaiter(*this, std::move(data));
     }
+#endif
+
+    /// Finish the response, the chunks sent before are written first.
+    void close();
+
+    /// Return false if the stream is closed or the data waiting to be sent
+    /// exceeds the high water mark.
+    bool writable() const;
+
+    /**
+     * @brief Set the high water mark of the data waiting to be sent, 1MB by
+     * default. 0 disables the backpressure, the stream is always writable.
+     */
+    void setHighWaterMark(size_t bytes);
+
+    /// Set the callback called when the data waiting to be sent exceeds the
+    /// high water mark.
+    void setHighWaterMarkCallback(std::function<void()> callback);
+
+    /// Set the callback called when the data waiting to be sent falls below
+    /// the high water mark after it exceeded it.
+    void setDrainCallback(std::function<void()> callback);
+
+    /**
+     * @brief Call the callback once the stream is writable, at once if it's
+     * writable now. The parameter is false if the stream or the connection is
+     * closed.
+     */
+    void whenWritable(std::function<void(bool)> callback);
 
   private:
-    trantor::AsyncStreamPtr asyncStream_;
+    std::shared_ptr<ChunkWriter> writer_;
 };
 
+#ifdef __cpp_impl_coroutine
+inline bool internal::ResponseStreamAwaiter::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    if (!stream_.send(std::move(data_)))
+    {
+        setValue(false);
+        return false;
+    }
+    // The callback is called at once if the stream is writable now, or later
+    // in the event loop, possibly before whenWritable() returns. Whichever of
+    // the two comes last resumes the coroutine.
+    stream_.whenWritable([this, handle](bool writable) {
+        setValue(writable);
+        if (state_.exchange(kDone) == kSuspended)
+            handle.resume();
+    });
+    return state_.exchange(kSuspended) != kDone;
+}
+#endif
+
 using ResponseStreamPtr = std::unique_ptr<ResponseStream>;
 
 class DROGON_EXPORT HttpResponse
@@ -353,6 +461,33 @@ class DROGON_EXPORT HttpResponse
         return expiredTime();
     }
 
+    /**
+     * @brief Send the response with a strong ETag computed from its body (a
+     * 64-bit xxHash), and answer the GET and HEAD requests whose
+     * If-None-Match header matches it with 304 Not Modified, without the body.
+     * It applies to the 200 responses with the body in memory and without an
+     * ETag header set by the handler. The body of a json response is hashed
+     * while it's serialized, the ETag of a cached response (see
+     * setExpiredTime()) is computed once when it's cached.
+     *
+     * @param flag The default value is set by
+     * HttpAppFramework::enableAutoETag().
+     *
+     * @note Only the responses created by drogon support it, the default
+     * implementation ignores the flag so that other subclasses keep
+     * compiling.
+     */
+    virtual void setAutoETag(bool flag)
+    {
+        (void)flag;
+    }
+
+    /// Return true if the ETag of the response is computed automatically.
+    virtual bool autoETag() const
+    {
+        return false;
+    }
+
     /// Get the json object from the server response.
     /// If the response is not in json format, then a empty shared_ptr is
     /// returned.
@@ -542,6 +677,19 @@ class DROGON_EXPORT HttpResponse
         const std::function<void(ResponseStreamPtr)> &callback,
         bool disableKickoffTimeout = false);
 
+    /// Create a Server-Sent Events (text/event-stream) response
+    /**
+     * @param callback function that receives the event stream in the event
+     *                 loop of the connection once the response header is sent.
+     *                 The stream (see drogon/ServerSentEvents.h) can be kept
+     *                 and used to send events from any thread.
+     * @param req the request, its Last-Event-ID header is passed to the
+     *            stream.
+     */
+    static HttpResponsePtr newSseResponse(
+        const std::function<void(const SseStreamPtr &)> &callback,
+        const HttpRequestPtr &req = HttpRequestPtr());
+
     /**
      * @brief Create a custom HTTP response object. For using this template,
      * users must specialize the toResponse template.
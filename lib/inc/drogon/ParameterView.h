@@ -0,0 +1,135 @@
+/**
+ *
+ *  @file ParameterView.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/utils/Utilities.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A lazy view of the parameters of a request, from the query string
+ * and the x-www-form-urlencoded body. The positions of the keys and values
+ * are recorded when the parameters are first accessed, a value is only
+ * decoded when it's requested and it's borrowed from the request if it has no
+ * escapes.
+ *
+ * As with HttpRequest::parameters(), a parameter replaces an earlier one with
+ * the same key, except a key without '=' which only adds an empty value. The
+ * views returned are valid while the request is not modified.
+ */
+class DROGON_EXPORT ParameterView
+{
+  public:
+    /// Get the value of the parameter, an empty optional if it doesn't exist.
+    std::optional<std::string_view> get(std::string_view key) const;
+
+    bool contains(std::string_view key) const;
+
+    bool empty() const
+    {
+        return slices_.empty();
+    }
+
+    /**
+     * @brief Call the function with the decoded key and value of every
+     * parameter, in the order of the request. A replaced parameter is visited
+     * too.
+     */
+    void forEach(const std::function<void(std::string_view key,
+                                          std::string_view value)> &function)
+        const;
+
+    /// Record the parameters of a query string or a form body. They go
+    /// before the parameters added by set().
+    void parse(std::string_view input, bool body);
+
+    /// Add a parameter, e.g. by HttpRequest::setParameter().
+    void set(const std::string &key, const std::string &value);
+
+    /// Decode all the parameters into the map.
+    void materialize(SafeStringMap<std::string> &parameters) const;
+
+    /// Set the query and the body the recorded positions refer to, they may
+    /// move with the request.
+    void setSources(std::string_view query, std::string_view body)
+    {
+        if (query.data() != query_.data() || body.data() != body_.data())
+            clearIndex();
+        query_ = query;
+        body_ = body;
+    }
+
+    void clear();
+
+    /// Forget the parameters recorded by parse(), keep those added by set().
+    void clearParsed();
+
+  private:
+    enum class Source : uint8_t
+    {
+        kQuery,
+        kBody,
+        // The key and the value are in owned_
+        kOwned
+    };
+
+    struct Slice
+    {
+        Source source;
+        bool keyEscaped;
+        bool valueEscaped;
+        // False for a key without '=', which doesn't replace an earlier value
+        bool hasValue;
+        uint32_t keyOffset;
+        uint32_t keyLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+        // 1 + the index of the decoded value in owned_, 0 if not decoded
+        mutable uint32_t decodedValue{0};
+        // The same for the key
+        mutable uint32_t decodedKey{0};
+    };
+
+    void clearIndex()
+    {
+        index_.clear();
+        indexedSlices_ = 0;
+    }
+
+    std::string_view key(const Slice &slice) const;
+    std::string_view decodedKey(const Slice &slice) const;
+    std::string_view rawValue(const Slice &slice) const;
+    std::string_view value(const Slice &slice) const;
+    const Slice *find(std::string_view key) const;
+
+    std::string_view query_;
+    std::string_view body_;
+    std::vector<Slice> slices_;
+    // Strings which keep their addresses as more are added
+    mutable std::deque<std::string> owned_;
+    // The last slice of each decoded key, built on the first lookup and
+    // extended with the slices added after it
+    mutable std::unordered_map<std::string_view, uint32_t> index_;
+    mutable size_t indexedSlices_{0};
+};
+}  // namespace drogon
@@ -0,0 +1,201 @@
+/**
+ *
+ *  @file ServerSentEvents.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief An event of the text/event-stream format (Server-Sent Events).
+ */
+struct DROGON_EXPORT SseEvent
+{
+    /// The data of the event, it may contain several lines.
+    std::string data;
+    /// The event type, the client dispatches a "message" event if it's empty.
+    std::string event;
+    /// The event ID, the client sends it back in the Last-Event-ID header
+    /// when it reconnects.
+    std::string id;
+    /// The reconnection time the client should use, ignored if negative.
+    std::chrono::milliseconds retry{-1};
+
+    SseEvent() = default;
+
+    explicit SseEvent(std::string eventData) : data(std::move(eventData))
+    {
+    }
+
+    /**
+     * @brief Format the event as a text/event-stream message. Line breaks in
+     * the event type and the ID are removed.
+     */
+    std::string format() const;
+};
+
+/**
+ * @brief The event stream of a Server-Sent Events response, created by
+ * HttpResponse::newSseResponse().
+ * @note All methods are thread-safe. A comment is sent to idle streams
+ * periodically from a timer shared by all streams of an event loop, see
+ * setHeartbeatInterval(). A closed connection is detected at the next
+ * event or heartbeat written to it.
+ */
+class DROGON_EXPORT SseStream
+{
+  public:
+    virtual ~SseStream() = default;
+
+    /**
+     * @brief Send an event to the client.
+     *
+     * @return false if the stream is closed.
+     */
+    virtual bool send(const SseEvent &event) = 0;
+
+    /**
+     * @brief Send an event with the data and no event type or ID.
+     */
+    bool send(std::string_view data)
+    {
+        SseEvent event;
+        event.data = std::string(data);
+        return send(event);
+    }
+
+    /**
+     * @brief Send a comment, which is ignored by the client.
+     */
+    virtual bool sendComment(std::string_view comment) = 0;
+
+    /**
+     * @brief Close the stream, the response is finished gracefully.
+     */
+    virtual void close() = 0;
+
+    /// Return true if the stream is closed.
+    virtual bool closed() const = 0;
+
+    /// Return the Last-Event-ID header of the request, empty if the client
+    /// connected for the first time.
+    virtual const std::string &lastEventId() const = 0;
+
+    /// Return the event loop of the connection.
+    virtual trantor::EventLoop *getLoop() const = 0;
+
+    /**
+     * @brief Set the interval of the heartbeat comments sent to the idle
+     * streams, the default value is 15 seconds. A value of 0 disables the
+     * heartbeats. The new value applies to the event loops that start their
+     * heartbeat timer afterwards.
+     */
+    static void setHeartbeatInterval(
+        const std::chrono::duration<double> &interval);
+};
+
+using SseStreamPtr = std::shared_ptr<SseStream>;
+
+/**
+ * @brief What a broadcast channel does with the events for a subscriber whose
+ * connection can't keep up (the data waiting in its send buffer exceeds the
+ * high water mark).
+ */
+enum class SseSlowConsumerPolicy
+{
+    /// Keep buffering the events in memory.
+    kBuffer,
+    /// Skip the events until the buffered data is written out.
+    kDropEvents,
+    /// Close the stream, the client reconnects and resumes with the
+    /// Last-Event-ID header from the replay buffer.
+    kDisconnect
+};
+
+struct SseChannelConfig
+{
+    /// The number of the latest events kept to resume the streams of
+    /// reconnected clients, 0 disables resuming.
+    size_t replayBufferSize{1024};
+    SseSlowConsumerPolicy slowConsumerPolicy{
+        SseSlowConsumerPolicy::kDropEvents};
+    /// The size of the send buffer of a connection that makes it a slow
+    /// consumer.
+    size_t highWaterMark{1024 * 1024};
+};
+
+/**
+ * @brief A channel that broadcasts events to many Server-Sent Events streams.
+ * Every event is formatted once into a shared buffer which is passed to each
+ * IO event loop, and written there to the streams of that loop.
+ * @code
+    static auto channel = SseChannel::newChannel();
+    app().registerHandler("/events",
+                          [](const HttpRequestPtr &req,
+                             std::function<void(const HttpResponsePtr &)>
+                                 &&callback) {
+                              callback(channel->newResponse(req));
+                          });
+    channel->publish(SseEvent("hello"));
+   @endcode
+ */
+class DROGON_EXPORT SseChannel
+{
+  public:
+    virtual ~SseChannel() = default;
+
+    static std::shared_ptr<SseChannel> newChannel(
+        const SseChannelConfig &config = SseChannelConfig());
+
+    /**
+     * @brief Create a Server-Sent Events response subscribed to the channel.
+     * The events after the one in the Last-Event-ID header of the request are
+     * replayed first.
+     */
+    virtual HttpResponsePtr newResponse(const HttpRequestPtr &req) = 0;
+
+    /**
+     * @brief Subscribe a stream to the channel.
+     *
+     * @return false if the last event ID of the stream is not in the replay
+     * buffer, in which case all buffered events are replayed and some events
+     * may have been missed.
+     */
+    virtual bool subscribe(const SseStreamPtr &stream) = 0;
+
+    /**
+     * @brief Broadcast an event to all subscribers. The channel assigns an
+     * increasing number as the ID of the event if it has none.
+     *
+     * @return The ID of the event.
+     */
+    virtual std::string publish(const SseEvent &event) = 0;
+
+    /// Return the number of subscribed streams.
+    virtual size_t subscriberCount() const = 0;
+
+    /// Return the number of events skipped or streams closed because of slow
+    /// consumers.
+    virtual size_t slowConsumerEvents() const = 0;
+};
+
+using SseChannelPtr = std::shared_ptr<SseChannel>;
+}  // namespace drogon
@@ -228,6 +228,29 @@ class WebSocketConnection
      */
     virtual void disablePing() = 0;
 
+    /**
+     * @brief Gather the frames sent on the connection into fewer writes.
+     *
+     * @param maxDelay The longest time a frame is held back. With the default
+     * value 0, the frames sent during an iteration of the event loop are
+     * written together at the end of the iteration.
+     * @param maxBufferSize The pending frames are written as soon as their
+     * size reaches this value.
+     * @note Control frames (ping, pong and close) are never held back, they
+     * are written at once along with the pending frames. This mode trades a
+     * little latency for fewer system calls when many small messages are
+     * sent, e.g. in chat or telemetry applications.
+     */
+    virtual void enableWriteCoalescing(
+        const std::chrono::duration<double> &maxDelay =
+            std::chrono::duration<double>(0),
+        size_t maxBufferSize = 64 * 1024) = 0;
+
+    /**
+     * @brief Write every frame at once, the pending frames are flushed.
+     */
+    virtual void disableWriteCoalescing() = 0;
+
   private:
     std::shared_ptr<void> contextPtr_;
 };
@@ -38,6 +38,7 @@
 #include <drogon/LocalHostFilter.h>
 #include <drogon/Cookie.h>
 #include <drogon/Session.h>
+#include <drogon/ServerSentEvents.h>
 #include <drogon/IOThreadStorage.h>
 #include <drogon/UploadFile.h>
 #include <drogon/orm/DbClient.h>
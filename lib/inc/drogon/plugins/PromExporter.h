@@ -32,6 +32,11 @@ namespace plugin
       "config": {
          // The path of the metrics. the default value is "/metrics".
          "path": "/metrics",
+         // Export the memory stats of the allocator and, in the debug builds
+         // with the COUNT_REQUEST_ALLOCATIONS CMake option, the allocations
+         // of each route (see monitoring/AllocatorCollector.h). The default
+         // value is false.
+         "allocator_stats": false,
          // The list of collectors.
          "collectors":[
             {
@@ -0,0 +1,122 @@
+/**
+ *
+ *  AllocatorCollector.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+#include <drogon/exports.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+namespace monitoring
+{
+/**
+ * The memory stats of the allocator drogon is linked with (the
+ * MEMORY_ALLOCATOR CMake option). The values an allocator can't report are 0.
+ * */
+struct AllocatorStats
+{
+    /// "mimalloc", "jemalloc" or "system"
+    std::string allocator;
+    /// The bytes of the allocator (the process for the system allocator) in
+    /// physical memory
+    size_t resident{0};
+    /// The bytes of the pages holding allocated blocks
+    size_t active{0};
+    /// The bytes allocated by the application
+    size_t allocated{0};
+    /// The bytes cached by the threads for their next allocations
+    size_t threadCache{0};
+};
+
+/**
+ * This class exports the allocator stats as the gauge
+ * drogon_allocator_bytes{kind="resident|active|allocated|thread_cache"}.
+ * The stats are read from the allocator when the metrics are collected.
+ * */
+class DROGON_EXPORT AllocatorCollector : public CollectorBase
+{
+  public:
+    AllocatorCollector();
+
+    static AllocatorStats stats();
+
+    std::vector<SamplesGroup> collect() const override;
+
+    const std::string &name() const override
+    {
+        return name_;
+    }
+
+    const std::string &help() const override
+    {
+        return help_;
+    }
+
+    const std::string_view type() const override
+    {
+        return "gauge";
+    }
+
+  private:
+    const std::string name_{"drogon_allocator_bytes"};
+    const std::string help_{"The memory of the allocator in bytes"};
+    std::shared_ptr<Metric> metric_;
+};
+
+/**
+ * This class exports the number of the blocks and the bytes allocated with
+ * operator new while the requests of each route are handled in the IO
+ * threads, as the counter drogon_request_allocations_total{route,unit}.
+ * Only the synchronous part of the handling is counted, the allocations of
+ * the callbacks run later or in other threads are not.
+ *
+ * The counting is only compiled into the debug builds with the
+ * COUNT_REQUEST_ALLOCATIONS CMake option, the collector is empty otherwise.
+ * */
+class DROGON_EXPORT RequestAllocationCollector : public CollectorBase
+{
+  public:
+    RequestAllocationCollector();
+
+    /// Return true if drogon is built with the allocation counting.
+    static bool enabled();
+
+    std::vector<SamplesGroup> collect() const override;
+
+    const std::string &name() const override
+    {
+        return name_;
+    }
+
+    const std::string &help() const override
+    {
+        return help_;
+    }
+
+    const std::string_view type() const override
+    {
+        return "counter";
+    }
+
+  private:
+    const std::string name_{"drogon_request_allocations"};
+    const std::string help_{
+        "The allocations made while handling the requests of each route"};
+    std::shared_ptr<Metric> metric_;
+};
+}  // namespace monitoring
+}  // namespace drogon
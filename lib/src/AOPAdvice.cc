@@ -65,6 +65,21 @@ HttpResponsePtr AopAdvice::passSyncAdvices(const HttpRequestPtr &req) const
     return nullptr;
 }
 
+void AopAdvice::passPreBodyAdvices(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    if (preBodyAdvices_.empty())
+    {
+        callback(nullptr);
+        return;
+    }
+
+    auto callbackPtr =
+        std::make_shared<std::decay_t<decltype(callback)>>(std::move(callback));
+    doAdviceChain(preBodyAdvices_, 0, req, std::move(callbackPtr));
+}
+
 void AopAdvice::passPreRoutingObservers(const HttpRequestImplPtr &req) const
 {
     if (!preRoutingObservers_.empty())
@@ -31,6 +31,11 @@ class AopAdvice
     }
 
     // Getters?
+    bool hasPreBodyAdvices() const
+    {
+        return !preBodyAdvices_.empty();
+    }
+
     bool hasPreRoutingAdvices() const
     {
         return !preRoutingAdvices_.empty();
@@ -67,6 +72,14 @@ class AopAdvice
         syncAdvices_.emplace_back(std::move(advice));
     }
 
+    void registerPreBodyAdvice(
+        std::function<void(const HttpRequestPtr &,
+                           AdviceCallback &&,
+                           AdviceChainCallback &&)> advice)
+    {
+        preBodyAdvices_.emplace_back(std::move(advice));
+    }
+
     void registerPreRoutingObserver(
         std::function<void(const HttpRequestPtr &)> advice)
     {
@@ -128,6 +141,9 @@ class AopAdvice
     void passResponseCreationAdvices(const HttpResponsePtr &resp) const;
 
     HttpResponsePtr passSyncAdvices(const HttpRequestPtr &req) const;
+    void passPreBodyAdvices(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback) const;
     void passPreRoutingObservers(const HttpRequestImplPtr &req) const;
     void passPreRoutingAdvices(
         const HttpRequestImplPtr &req,
@@ -163,6 +179,7 @@ class AopAdvice
         responseCreationAdvices_;
 
     std::vector<SyncAdvice> syncAdvices_;
+    std::vector<AsyncAdvice> preBodyAdvices_;
     std::vector<SyncReqObserver> preRoutingObservers_;
     std::vector<AsyncAdvice> preRoutingAdvices_;
     std::vector<SyncReqObserver> postRoutingObservers_;
@@ -0,0 +1,89 @@
+/**
+ *
+ *  @file AllocationCounter.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+using namespace drogon;
+
+#if COUNT_REQUEST_ALLOCATIONS
+namespace
+{
+// Plain thread_local integers, they can be used before the thread is set up
+thread_local size_t threadBlocks{0};
+thread_local size_t threadBytes{0};
+
+std::mutex routesMutex;
+std::unordered_map<std::string, AllocationCounter::Count> routeCounts;
+}  // namespace
+
+// The other forms of operator new of the standard library (array, nothrow)
+// call this one, and the default operator delete frees the malloc() blocks.
+void *operator new(std::size_t size)
+{
+    ++threadBlocks;
+    threadBytes += size;
+    if (size == 0)
+        size = 1;
+    while (true)
+    {
+        auto p = std::malloc(size);
+        if (p)
+            return p;
+        auto handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+AllocationCounter::Count AllocationCounter::current()
+{
+    return {threadBlocks, threadBytes};
+}
+
+void AllocationCounter::addToRoute(std::string_view route, const Count &start)
+{
+    Count count{threadBlocks - start.blocks, threadBytes - start.bytes};
+    std::lock_guard<std::mutex> lock(routesMutex);
+    auto &total = routeCounts[std::string(route)];
+    total.blocks += count.blocks;
+    total.bytes += count.bytes;
+}
+
+std::vector<std::pair<std::string, AllocationCounter::Count>>
+AllocationCounter::routes()
+{
+    std::lock_guard<std::mutex> lock(routesMutex);
+    return {routeCounts.begin(), routeCounts.end()};
+}
+#else
+AllocationCounter::Count AllocationCounter::current()
+{
+    return {};
+}
+
+void AllocationCounter::addToRoute(std::string_view, const Count &)
+{
+}
+
+std::vector<std::pair<std::string, AllocationCounter::Count>>
+AllocationCounter::routes()
+{
+    return {};
+}
+#endif
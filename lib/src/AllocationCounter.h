@@ -0,0 +1,58 @@
+/**
+ *
+ *  @file AllocationCounter.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Counts the allocations made with operator new by each thread and
+ * sums them up per route (the COUNT_REQUEST_ALLOCATIONS CMake option, debug
+ * builds only). Without the option, operator new is not replaced and the
+ * counts stay 0.
+ */
+class AllocationCounter
+{
+  public:
+    struct Count
+    {
+        size_t blocks{0};
+        size_t bytes{0};
+    };
+
+    static constexpr bool enabled()
+    {
+#if COUNT_REQUEST_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// The allocations of the current thread since it started
+    static Count current();
+
+    /// Add the allocations of the current thread since the start count to
+    /// the route
+    static void addToRoute(std::string_view route, const Count &start);
+
+    static std::vector<std::pair<std::string, Count>> routes();
+};
+}  // namespace drogon
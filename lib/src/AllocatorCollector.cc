@@ -0,0 +1,184 @@
+/**
+ *
+ *  @file AllocatorCollector.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/monitoring/AllocatorCollector.h>
+#include "AllocationCounter.h"
+#if defined(USE_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(USE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <fstream>
+#endif
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+namespace
+{
+#if defined(USE_JEMALLOC)
+size_t jemallocStat(const char *name)
+{
+    size_t value{0};
+    size_t len = sizeof(value);
+    if (mallctl(name, &value, &len, nullptr, 0) != 0)
+        return 0;
+    return value;
+}
+#elif !defined(USE_MIMALLOC)
+size_t processResidentMemory()
+{
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t size{0};
+    size_t resident{0};
+    statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+#endif
+
+class AllocatorMetric : public Metric
+{
+  public:
+    explicit AllocatorMetric(const std::string &name) : Metric(name, {}, {})
+    {
+    }
+
+    std::vector<Sample> collect() const override
+    {
+        auto stats = AllocatorCollector::stats();
+        std::vector<Sample> samples;
+        for (auto &[kind, value] :
+             {std::make_pair("resident", stats.resident),
+              std::make_pair("active", stats.active),
+              std::make_pair("allocated", stats.allocated),
+              std::make_pair("thread_cache", stats.threadCache)})
+        {
+            Sample sample;
+            sample.name = name_;
+            sample.value = static_cast<double>(value);
+            sample.exLabels.emplace_back("allocator", stats.allocator);
+            sample.exLabels.emplace_back("kind", kind);
+            samples.emplace_back(std::move(sample));
+        }
+        return samples;
+    }
+};
+
+class RequestAllocationMetric : public Metric
+{
+  public:
+    explicit RequestAllocationMetric(const std::string &name)
+        : Metric(name, {}, {})
+    {
+    }
+
+    std::vector<Sample> collect() const override
+    {
+        std::vector<Sample> samples;
+        for (auto &[route, count] : AllocationCounter::routes())
+        {
+            Sample sample;
+            sample.name = name_ + "_total";
+            sample.exLabels.emplace_back("route", route);
+            sample.exLabels.emplace_back("unit", "blocks");
+            sample.value = static_cast<double>(count.blocks);
+            samples.push_back(sample);
+            sample.exLabels.back().second = "bytes";
+            sample.value = static_cast<double>(count.bytes);
+            samples.emplace_back(std::move(sample));
+        }
+        return samples;
+    }
+};
+}  // namespace
+
+AllocatorCollector::AllocatorCollector()
+    : metric_(std::make_shared<AllocatorMetric>(name_))
+{
+}
+
+AllocatorStats AllocatorCollector::stats()
+{
+    AllocatorStats stats;
+#if defined(USE_MIMALLOC)
+    stats.allocator = "mimalloc";
+    size_t elapsed, user, system, peakRss, peakCommit, pageFaults;
+    mi_process_info(&elapsed,
+                    &user,
+                    &system,
+                    &stats.resident,
+                    &peakRss,
+                    &stats.active,
+                    &peakCommit,
+                    &pageFaults);
+#elif defined(USE_JEMALLOC)
+    stats.allocator = "jemalloc";
+    // The stats are cached by jemalloc until the epoch is advanced
+    uint64_t epoch{1};
+    size_t len = sizeof(epoch);
+    mallctl("epoch", &epoch, &len, &epoch, len);
+    stats.resident = jemallocStat("stats.resident");
+    stats.active = jemallocStat("stats.active");
+    stats.allocated = jemallocStat("stats.allocated");
+#ifdef MALLCTL_ARENAS_ALL
+    static const std::string tcacheBytes =
+        "stats.arenas." + std::to_string(MALLCTL_ARENAS_ALL) + ".tcache_bytes";
+    stats.threadCache = jemallocStat(tcacheBytes.c_str());
+#endif
+#else
+    stats.allocator = "system";
+    stats.resident = processResidentMemory();
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    auto info = mallinfo2();
+    stats.active = info.arena + info.hblkhd;
+    stats.allocated = info.uordblks + info.hblkhd;
+#endif
+#endif
+    return stats;
+}
+
+std::vector<SamplesGroup> AllocatorCollector::collect() const
+{
+    SamplesGroup group;
+    group.metric = metric_;
+    group.samples = metric_->collect();
+    return {std::move(group)};
+}
+
+RequestAllocationCollector::RequestAllocationCollector()
+    : metric_(std::make_shared<RequestAllocationMetric>(name_))
+{
+}
+
+bool RequestAllocationCollector::enabled()
+{
+    return AllocationCounter::enabled();
+}
+
+std::vector<SamplesGroup> RequestAllocationCollector::collect() const
+{
+    SamplesGroup group;
+    group.metric = metric_;
+    group.samples = metric_->collect();
+    return {std::move(group)};
+}
@@ -0,0 +1,407 @@
+/**
+ *
+ *  @file CompressionDictionary.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/CompressionDictionary.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <trantor/utils/Utilities.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#ifdef USE_BROTLI
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+// The shared dictionaries came with brotli 1.1
+#if __has_include(<brotli/shared_dictionary.h>)
+#define USE_BROTLI_DICTIONARY
+#endif
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kHashLength = 32;
+
+#ifdef USE_BROTLI_DICTIONARY
+// The same quality as brotliCompress()
+constexpr int kBrotliQuality = 5;
+#endif
+
+#if defined(USE_BROTLI_DICTIONARY) || defined(USE_ZSTD)
+// The magic numbers before the hash of the dictionary
+constexpr unsigned char kBrotliMagic[] = {0xff, 0x44, 0x43, 0x42};
+// A zstd skippable frame of 32 bytes, which holds the hash
+constexpr unsigned char kZstdMagic[] =
+    {0x5e, 0x2a, 0x4d, 0x18, 0x20, 0x00, 0x00, 0x00};
+
+std::string_view magic(CompressionDictionary::Encoding encoding)
+{
+    if (encoding == CompressionDictionary::Encoding::kBrotli)
+        return std::string_view(reinterpret_cast<const char *>(kBrotliMagic),
+                                sizeof(kBrotliMagic));
+    return std::string_view(reinterpret_cast<const char *>(kZstdMagic),
+                            sizeof(kZstdMagic));
+}
+#endif
+
+#ifdef USE_ZSTD
+constexpr int kZstdLevel = 3;
+
+struct ZstdContexts
+{
+    ~ZstdContexts()
+    {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+
+    ZSTD_CCtx *cctx{ZSTD_createCCtx()};
+    ZSTD_DCtx *dctx{ZSTD_createDCtx()};
+};
+
+// The contexts keep their buffers between the responses of a thread
+ZstdContexts &zstdContexts()
+{
+    thread_local ZstdContexts contexts;
+    return contexts;
+}
+#endif
+}  // namespace
+
+struct CompressionDictionary::Prepared
+{
+    ~Prepared()
+    {
+#ifdef USE_BROTLI_DICTIONARY
+        if (brotli)
+            BrotliEncoderDestroyPreparedDictionary(brotli);
+#endif
+#ifdef USE_ZSTD
+        ZSTD_freeCDict(zstdCompress);
+        ZSTD_freeDDict(zstdDecompress);
+#endif
+    }
+
+#ifdef USE_BROTLI_DICTIONARY
+    // Refers to the data of the dictionary
+    BrotliEncoderPreparedDictionary *brotli{nullptr};
+#endif
+#ifdef USE_ZSTD
+    ZSTD_CDict *zstdCompress{nullptr};
+    ZSTD_DDict *zstdDecompress{nullptr};
+#endif
+};
+
+CompressionDictionaryPtr CompressionDictionary::fromFile(
+    const std::string &path,
+    std::string id)
+{
+    std::ifstream file(utils::toNativePath(path), std::ios::binary);
+    if (!file)
+    {
+        LOG_ERROR << "Can't open the compression dictionary " << path;
+        return nullptr;
+    }
+    std::string data{std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>()};
+    if (data.empty())
+    {
+        LOG_ERROR << "The compression dictionary " << path << " is empty";
+        return nullptr;
+    }
+    return fromData(std::move(data), std::move(id));
+}
+
+CompressionDictionaryPtr CompressionDictionary::fromData(std::string data,
+                                                         std::string id)
+{
+    if (data.empty())
+        return nullptr;
+    return CompressionDictionaryPtr(
+        new CompressionDictionary(std::move(data), std::move(id)));
+}
+
+CompressionDictionary::CompressionDictionary(std::string data, std::string id)
+    : data_(std::move(data)),
+      id_(std::move(id)),
+      prepared_(std::make_unique<Prepared>())
+{
+    auto hash = trantor::utils::sha256(data_.data(), data_.size());
+    hash_.assign(reinterpret_cast<const char *>(hash.bytes), kHashLength);
+    availableDictionary_ = ":" + utils::base64Encode(hash_) + ":";
+#ifdef USE_BROTLI_DICTIONARY
+    prepared_->brotli = BrotliEncoderPrepareDictionary(
+        BROTLI_SHARED_DICTIONARY_RAW,
+        data_.size(),
+        reinterpret_cast<const uint8_t *>(data_.data()),
+        kBrotliQuality,
+        nullptr,
+        nullptr,
+        nullptr);
+    if (!prepared_->brotli)
+        LOG_ERROR << "Failed to prepare the brotli dictionary";
+#endif
+#ifdef USE_ZSTD
+    prepared_->zstdCompress =
+        ZSTD_createCDict(data_.data(), data_.size(), kZstdLevel);
+    prepared_->zstdDecompress = ZSTD_createDDict(data_.data(), data_.size());
+    if (!prepared_->zstdCompress || !prepared_->zstdDecompress)
+        LOG_ERROR << "Failed to prepare the zstd dictionary";
+#endif
+}
+
+CompressionDictionary::~CompressionDictionary() = default;
+
+bool CompressionDictionary::supports(Encoding encoding)
+{
+    switch (encoding)
+    {
+        case Encoding::kBrotli:
+#ifdef USE_BROTLI_DICTIONARY
+            return true;
+#else
+            return false;
+#endif
+        case Encoding::kZstd:
+#ifdef USE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *CompressionDictionary::name(Encoding encoding)
+{
+    return encoding == Encoding::kBrotli ? "dcb" : "dcz";
+}
+
+std::optional<CompressionDictionary::Encoding> CompressionDictionary::
+    encodingOf(std::string_view name)
+{
+    if (name == "dcb")
+        return Encoding::kBrotli;
+    if (name == "dcz")
+        return Encoding::kZstd;
+    return std::nullopt;
+}
+
+bool CompressionDictionary::matches(std::string_view availableDictionary) const
+{
+    while (!availableDictionary.empty() &&
+           (availableDictionary.front() == ' ' ||
+            availableDictionary.front() == '\t'))
+        availableDictionary.remove_prefix(1);
+    while (!availableDictionary.empty() &&
+           (availableDictionary.back() == ' ' ||
+            availableDictionary.back() == '\t'))
+        availableDictionary.remove_suffix(1);
+    return availableDictionary == availableDictionary_;
+}
+
+#if defined(USE_BROTLI_DICTIONARY) || defined(USE_ZSTD)
+std::string CompressionDictionary::compress(const char *data,
+                                            size_t length,
+                                            Encoding encoding) const
+{
+    std::string ret;
+    if (!supports(encoding))
+        return ret;
+    auto header = magic(encoding);
+    auto headerLength = header.size() + kHashLength;
+    if (encoding == Encoding::kBrotli)
+    {
+#ifdef USE_BROTLI_DICTIONARY
+        if (!prepared_->brotli)
+            return ret;
+        auto state = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+        BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, kBrotliQuality);
+        BrotliEncoderSetParameter(state,
+                                  BROTLI_PARAM_SIZE_HINT,
+                                  static_cast<uint32_t>(length));
+        if (!BrotliEncoderAttachPreparedDictionary(state, prepared_->brotli))
+        {
+            BrotliEncoderDestroyInstance(state);
+            return ret;
+        }
+        ret.resize(headerLength + BrotliEncoderMaxCompressedSize(length) + 16);
+        size_t availableIn = length;
+        auto nextIn = reinterpret_cast<const uint8_t *>(data);
+        size_t availableOut = ret.size() - headerLength;
+        auto nextOut = reinterpret_cast<uint8_t *>(&ret[headerLength]);
+        bool ok = true;
+        while (ok && !BrotliEncoderIsFinished(state))
+        {
+            ok = BrotliEncoderCompressStream(state,
+                                             BROTLI_OPERATION_FINISH,
+                                             &availableIn,
+                                             &nextIn,
+                                             &availableOut,
+                                             &nextOut,
+                                             nullptr);
+            if (ok && availableOut == 0)
+            {
+                auto used = ret.size();
+                ret.resize(used * 2);
+                nextOut = reinterpret_cast<uint8_t *>(&ret[used]);
+                availableOut = ret.size() - used;
+            }
+        }
+        BrotliEncoderDestroyInstance(state);
+        if (!ok)
+        {
+            ret.clear();
+            return ret;
+        }
+        ret.resize(ret.size() - availableOut);
+#endif
+    }
+    else
+    {
+#ifdef USE_ZSTD
+        if (!prepared_->zstdCompress)
+            return ret;
+        auto cctx = zstdContexts().cctx;
+        ret.resize(headerLength + ZSTD_compressBound(length));
+        auto size = ZSTD_compress_usingCDict(cctx,
+                                             &ret[headerLength],
+                                             ret.size() - headerLength,
+                                             data,
+                                             length,
+                                             prepared_->zstdCompress);
+        if (ZSTD_isError(size))
+        {
+            LOG_ERROR << "zstd: " << ZSTD_getErrorName(size);
+            ret.clear();
+            return ret;
+        }
+        ret.resize(headerLength + size);
+#endif
+    }
+    memcpy(&ret[0], header.data(), header.size());
+    memcpy(&ret[header.size()], hash_.data(), kHashLength);
+    return ret;
+}
+
+std::optional<std::string> CompressionDictionary::decompress(
+    const char *data,
+    size_t length,
+    Encoding encoding) const
+{
+    if (!supports(encoding))
+        return std::nullopt;
+    auto header = magic(encoding);
+    auto headerLength = header.size() + kHashLength;
+    if (length < headerLength ||
+        std::string_view(data, header.size()) != header ||
+        std::string_view(data + header.size(), kHashLength) != hash_)
+    {
+        return std::nullopt;
+    }
+    data += headerLength;
+    length -= headerLength;
+    std::string decompressed(length * 3 + 256, '\0');
+    if (encoding == Encoding::kBrotli)
+    {
+#ifdef USE_BROTLI_DICTIONARY
+        auto state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!BrotliDecoderAttachDictionary(
+                state,
+                BROTLI_SHARED_DICTIONARY_RAW,
+                data_.size(),
+                reinterpret_cast<const uint8_t *>(data_.data())))
+        {
+            BrotliDecoderDestroyInstance(state);
+            return std::nullopt;
+        }
+        size_t availableIn = length;
+        auto nextIn = reinterpret_cast<const uint8_t *>(data);
+        size_t availableOut = decompressed.size();
+        auto nextOut = reinterpret_cast<uint8_t *>(&decompressed[0]);
+        size_t totalOut{0};
+        BrotliDecoderResult result;
+        while ((result = BrotliDecoderDecompressStream(state,
+                                                       &availableIn,
+                                                       &nextIn,
+                                                       &availableOut,
+                                                       &nextOut,
+                                                       &totalOut)) ==
+               BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+        {
+            decompressed.resize(totalOut * 2);
+            nextOut = reinterpret_cast<uint8_t *>(&decompressed[totalOut]);
+            availableOut = decompressed.size() - totalOut;
+        }
+        BrotliDecoderDestroyInstance(state);
+        if (result != BROTLI_DECODER_RESULT_SUCCESS)
+            return std::nullopt;
+        decompressed.resize(totalOut);
+#endif
+    }
+    else
+    {
+#ifdef USE_ZSTD
+        if (!prepared_->zstdDecompress)
+            return std::nullopt;
+        auto dctx = zstdContexts().dctx;
+        ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+        ZSTD_DCtx_refDDict(dctx, prepared_->zstdDecompress);
+        ZSTD_inBuffer in{data, length, 0};
+        ZSTD_outBuffer out{&decompressed[0], decompressed.size(), 0};
+        size_t ret;
+        while (true)
+        {
+            ret = ZSTD_decompressStream(dctx, &out, &in);
+            if (ZSTD_isError(ret) || ret == 0)
+                break;
+            if (out.pos == out.size)
+            {
+                decompressed.resize(out.size * 2);
+                out.dst = &decompressed[0];
+                out.size = decompressed.size();
+            }
+            else if (in.pos == in.size)
+            {
+                // Truncated
+                break;
+            }
+        }
+        if (ret != 0 || in.pos != in.size)
+            return std::nullopt;
+        decompressed.resize(out.pos);
+#endif
+    }
+    return decompressed;
+}
+#else
+std::string CompressionDictionary::compress(const char * /*data*/,
+                                            size_t /*length*/,
+                                            Encoding /*encoding*/) const
+{
+    return std::string();
+}
+
+std::optional<std::string> CompressionDictionary::decompress(
+    const char * /*data*/,
+    size_t /*length*/,
+    Encoding /*encoding*/) const
+{
+    return std::nullopt;
+}
+#endif
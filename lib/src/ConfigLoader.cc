@@ -13,6 +13,7 @@
  */
 
 #include "ConfigLoader.h"
+#include "CpuAffinity.h"
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/config.h>
 #include <fstream>
@@ -262,6 +263,26 @@ static void loadApp(const Json::Value &app)
     if (threadsNum < 1)
         threadsNum = 1;
     drogon::app().setThreadNum(threadsNum);
+    auto &affinity = app["cpu_affinity"];
+    if (affinity.isObject())
+    {
+        CpuAffinityConfig config;
+        auto ioLoops = affinity.get("io_loops", "").asString();
+        if (ioLoops == "numa")
+            config.numaAware = true;
+        else
+            config.ioLoopCpus = CpuAffinity::parseCpuList(ioLoops);
+        config.mainLoopCpus = CpuAffinity::parseCpuList(
+            affinity.get("main_loop", "").asString());
+        config.dbLoopCpus = CpuAffinity::parseCpuList(
+            affinity.get("db_loops", "").asString());
+        drogon::app().setCpuAffinity(config);
+    }
+    drogon::app().setPluginInitThreadNum(
+        app.get("plugin_init_thread_num", 1).asUInt64());
+    drogon::app().setStartupConnectionWarmUp(
+        app.get("warm_up_connections", 0).asUInt64(),
+        app.get("warm_up_timeout", 10.0).asDouble());
     // session
     auto enableSession = app.get("enable_session", false).asBool();
     if (enableSession)
@@ -439,16 +460,31 @@ static void loadApp(const Json::Value &app)
     }
     auto useSendfile = app.get("use_sendfile", true).asBool();
     drogon::app().enableSendfile(useSendfile);
+    drogon::app().setZeroCopySendThreshold(
+        app.get("zero_copy_send_threshold", 0).asUInt64());
     auto useGzip = app.get("use_gzip", true).asBool();
     drogon::app().enableGzip(useGzip);
     auto useBr = app.get("use_brotli", false).asBool();
     drogon::app().enableBrotli(useBr);
+    drogon::app().enableAutoETag(app.get("auto_etag", false).asBool());
+    for (auto &dictionary : app["compression_dictionaries"])
+    {
+        drogon::app().addCompressionDictionary(
+            dictionary.get("file", "").asString(),
+            dictionary.get("path", "").asString(),
+            dictionary.get("match", "").asString(),
+            dictionary.get("id", "").asString());
+    }
     auto staticFilesCacheTime = app.get("static_files_cache_time", 5).asInt();
     drogon::app().setStaticFilesCacheTime(staticFilesCacheTime);
+    drogon::app().setStaticFileMetadataCacheTime(
+        app.get("static_file_metadata_cache_time", 1.0).asDouble());
     loadControllers(app["simple_controllers_map"]);
     // Kick off idle connections
     auto kickOffTimeout = app.get("idle_connection_timeout", 60).asUInt64();
     drogon::app().setIdleConnectionTimeout(kickOffTimeout);
+    drogon::app().setIdleBufferReleaseTime(
+        app.get("idle_buffer_release_time", 10.0).asDouble());
     auto server = app.get("server_header_field", "").asString();
     if (!server.empty())
         drogon::app().setServerHeaderField(server);
@@ -527,6 +563,8 @@ static void loadApp(const Json::Value &app)
 
     drogon::app().enableRequestStream(
         app.get("enable_request_stream", false).asBool());
+    drogon::app().enableEarlyRejection(
+        app.get("early_rejection", false).asBool());
 }
 
 static void loadDbClients(const Json::Value &dbClients)
@@ -670,6 +708,15 @@ static void loadListeners(const Json::Value &listeners)
         LOG_TRACE << "Add listener:" << addr << ":" << port;
         drogon::app().addListener(
             addr, port, useSSL, cert, key, useOldTLS, sslConfCmds);
+        auto threads = listener.get("threads", 0).asUInt64();
+        if (threads > 0)
+        {
+            drogon::app().setListenerThreadGroup(
+                addr,
+                port,
+                threads,
+                listener.get("max_connections", 0).asUInt64());
+        }
     }
 }
 
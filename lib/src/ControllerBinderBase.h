@@ -20,6 +20,7 @@
 #include <drogon/IOThreadStorage.h>
 #include <drogon/HttpResponse.h>
 #include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
 
 namespace drogon
 {
@@ -34,6 +35,7 @@ struct ControllerBinderBase
     std::vector<std::string> middlewareNames_;
     std::vector<std::shared_ptr<HttpMiddlewareBase>> middlewares_;
     IOThreadStorage<HttpResponsePtr> responseCache_;
+    IOThreadStorage<ResponseHeaderTemplate> headerTemplates_;
     std::shared_ptr<std::string> corsMethods_;
     bool isCORS_{false};
 
@@ -0,0 +1,267 @@
+/**
+ *
+ *  @file CpuAffinity.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CpuAffinity.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#ifdef __linux__
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+#ifdef __linux__
+std::vector<unsigned int> currentThreadCpus()
+{
+    std::vector<unsigned int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Log the CPUs the current thread may run on and their NUMA nodes
+void reportPlacement(const std::string &name)
+{
+    auto cpus = currentThreadCpus();
+    std::set<size_t> nodes;
+    auto &numaNodes = CpuAffinity::numaNodes();
+    for (size_t i = 0; i < numaNodes.size(); ++i)
+    {
+        for (auto cpu : cpus)
+        {
+            if (std::binary_search(numaNodes[i].begin(),
+                                   numaNodes[i].end(),
+                                   cpu))
+            {
+                nodes.insert(i);
+                break;
+            }
+        }
+    }
+    std::string nodeList;
+    for (auto node : nodes)
+    {
+        if (!nodeList.empty())
+            nodeList.append(",");
+        nodeList.append(std::to_string(node));
+    }
+    LOG_INFO << name << " runs on CPUs " << CpuAffinity::formatCpuList(cpus)
+             << (nodeList.empty()
+                     ? std::string()
+                     : (nodes.size() == 1 ? " (NUMA node " : " (NUMA nodes ") +
+                           nodeList + ")");
+}
+#else
+void warnUnsupported()
+{
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+        LOG_WARN << "CPU affinity is only supported on Linux";
+    });
+}
+#endif
+}  // namespace
+
+std::vector<unsigned int> CpuAffinity::parseCpuList(std::string_view list)
+{
+    std::vector<unsigned int> cpus;
+    std::string_view rest = list;
+    while (!rest.empty())
+    {
+        auto comma = rest.find(',');
+        auto item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view()
+                                               : rest.substr(comma + 1);
+        while (!item.empty() && item.front() == ' ')
+            item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ')
+            item.remove_suffix(1);
+        if (item.empty())
+            continue;
+        try
+        {
+            auto dash = item.find('-');
+            size_t first =
+                std::stoul(std::string(item.substr(0, dash)), nullptr, 10);
+            size_t last = dash == std::string_view::npos
+                              ? first
+                              : std::stoul(std::string(item.substr(dash + 1)),
+                                           nullptr,
+                                           10);
+            if (last < first || last >= 65536)
+                throw std::out_of_range("invalid CPU range");
+            for (auto cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(static_cast<unsigned int>(cpu));
+            }
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Invalid CPU list: \"" << list << "\"";
+            return {};
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string CpuAffinity::formatCpuList(std::vector<unsigned int> cpus)
+{
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    std::string list;
+    for (size_t i = 0; i < cpus.size();)
+    {
+        auto j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            ++j;
+        if (!list.empty())
+            list.append(",");
+        list.append(std::to_string(cpus[i]));
+        if (j > i)
+            list.append("-").append(std::to_string(cpus[j]));
+        i = j + 1;
+    }
+    return list;
+}
+
+const std::vector<std::vector<unsigned int>> &CpuAffinity::numaNodes()
+{
+    static const std::vector<std::vector<unsigned int>> nodes = []() {
+        std::vector<std::vector<unsigned int>> result;
+#ifdef __linux__
+        // The node directories may be sparse, e.g. node0 and node2
+        std::vector<std::pair<unsigned long, std::string>> dirs;
+        std::error_code ec;
+        for (auto &entry : std::filesystem::directory_iterator(
+                 "/sys/devices/system/node", ec))
+        {
+            auto name = entry.path().filename().string();
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                std::all_of(name.begin() + 4, name.end(), ::isdigit))
+            {
+                dirs.emplace_back(std::stoul(name.substr(4)),
+                                  entry.path().string());
+            }
+        }
+        std::sort(dirs.begin(), dirs.end());
+        for (auto &dir : dirs)
+        {
+            std::ifstream file(dir.second + "/cpulist");
+            std::string list;
+            std::getline(file, list);
+            auto cpus = parseCpuList(list);
+            if (!cpus.empty())
+                result.push_back(std::move(cpus));
+        }
+#endif
+        return result;
+    }();
+    return nodes;
+}
+
+std::vector<unsigned int> CpuAffinity::ioLoopCpus(
+    const CpuAffinityConfig &config,
+    size_t index)
+{
+    if (config.numaAware)
+    {
+        auto &nodes = numaNodes();
+        if (!nodes.empty())
+            return nodes[index % nodes.size()];
+    }
+    if (config.ioLoopCpus.empty())
+        return {};
+    return {config.ioLoopCpus[index % config.ioLoopCpus.size()]};
+}
+
+int CpuAffinity::incomingCpu(const CpuAffinityConfig &config, size_t index)
+{
+    auto cpus = ioLoopCpus(config, index);
+    if (cpus.empty())
+        return -1;
+    // The loops of a NUMA node take different CPUs of the node
+    auto nodes = config.numaAware ? numaNodes().size() : 0;
+    if (nodes == 0)
+        return static_cast<int>(cpus[0]);
+    return static_cast<int>(cpus[(index / nodes) % cpus.size()]);
+}
+
+void CpuAffinity::pinLoop(trantor::EventLoop *loop,
+                          std::vector<unsigned int> cpus,
+                          std::string name)
+{
+    loop->queueInLoop([cpus = std::move(cpus), name = std::move(name)]() {
+        pinCurrentThread(cpus, name);
+    });
+}
+
+void CpuAffinity::pinCurrentThread(const std::vector<unsigned int> &cpus,
+                                   const std::string &name)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    auto err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0)
+    {
+        LOG_ERROR << "Failed to pin " << name << " to CPUs "
+                  << formatCpuList(cpus) << ": " << strerror(err);
+    }
+    reportPlacement(name);
+#else
+    (void)cpus;
+    (void)name;
+    warnUnsupported();
+#endif
+}
+
+void CpuAffinity::setIncomingCpu(int fd, unsigned int cpu)
+{
+#if defined(__linux__) && defined(SO_INCOMING_CPU)
+    int value = static_cast<int>(cpu);
+    if (::setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &value, sizeof(value)) !=
+        0)
+    {
+        LOG_WARN << "Failed to set SO_INCOMING_CPU: " << strerror(errno);
+    }
+#else
+    (void)fd;
+    (void)cpu;
+#endif
+}
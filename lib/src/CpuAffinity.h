@@ -0,0 +1,70 @@
+/**
+ *
+ *  @file CpuAffinity.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpAppFramework.h>
+#include <trantor/net/EventLoop.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Places the threads of the framework on CPUs and NUMA nodes (Linux
+ * only, the other platforms ignore it with a warning).
+ */
+class CpuAffinity
+{
+  public:
+    /// Parse a CPU list like "0-3,8,10-11", return an empty list and log an
+    /// error if it's malformed.
+    static std::vector<unsigned int> parseCpuList(std::string_view list);
+
+    /// Format a CPU list in the above form.
+    static std::string formatCpuList(std::vector<unsigned int> cpus);
+
+    /// Return the CPUs of each NUMA node, empty if they can't be read.
+    static const std::vector<std::vector<unsigned int>> &numaNodes();
+
+    /// Return the CPUs of the IO loop with the index, empty if it's not
+    /// pinned.
+    static std::vector<unsigned int> ioLoopCpus(const CpuAffinityConfig &config,
+                                                size_t index);
+
+    /// Return the CPU whose connections the listener of the IO loop with the
+    /// index prefers, -1 if the loop is not pinned.
+    static int incomingCpu(const CpuAffinityConfig &config, size_t index);
+
+    /**
+     * @brief Pin the thread of the loop to the CPUs when the loop runs the
+     * queued functions (the loop may not be started yet) and log where it
+     * runs.
+     */
+    static void pinLoop(trantor::EventLoop *loop,
+                        std::vector<unsigned int> cpus,
+                        std::string name);
+
+    /// Pin the current thread to the CPUs and log where it runs.
+    static void pinCurrentThread(const std::vector<unsigned int> &cpus,
+                                 const std::string &name);
+
+    /**
+     * @brief Make a listening socket of a SO_REUSEPORT group prefer the
+     * connections received on the CPU (SO_INCOMING_CPU).
+     */
+    static void setIncomingCpu(int fd, unsigned int cpu);
+};
+}  // namespace drogon
@@ -50,6 +50,13 @@ class DbClientManager : public trantor::NonCopyable
     void addDbClient(const DbConfig &config);
     bool areAllDbClientsAvailable() const noexcept;
 
+    // Return true if every client, except the fast ones, has established
+    // minConnections connections (or all of them if it has fewer)
+    bool areAllDbClientsWarmedUp(size_t minConnections) const noexcept;
+
+    // The event loops of the clients, except the fast ones
+    std::vector<trantor::EventLoop *> getClientLoops() const;
+
   private:
     std::map<std::string, DbClientPtr> dbClientsMap_;
 
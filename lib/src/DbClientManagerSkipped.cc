@@ -39,6 +39,16 @@ bool DbClientManager::areAllDbClientsAvailable() const noexcept
     abort();
 }
 
+bool DbClientManager::areAllDbClientsWarmedUp(size_t) const noexcept
+{
+    return true;
+}
+
+std::vector<trantor::EventLoop *> DbClientManager::getClientLoops() const
+{
+    return {};
+}
+
 DbClientManager::~DbClientManager()
 {
 }
@@ -0,0 +1,179 @@
+/**
+ *
+ *  @file DnsCache.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DnsCache.h"
+#include <algorithm>
+
+using namespace drogon;
+
+DnsCache::DnsCache()
+    : lookups_(std::make_shared<monitoring::Collector<monitoring::Counter>>(
+          "drogon_http_client_dns_lookups_total",
+          "The number of DNS lookups of http clients by the cache result",
+          std::vector<std::string>{"result"}))
+{
+    hitCounter_ = lookups_->metric({"hit"});
+    negativeHitCounter_ = lookups_->metric({"negative_hit"});
+    missCounter_ = lookups_->metric({"miss"});
+}
+
+DnsCache &DnsCache::instance()
+{
+    static DnsCache cache;
+    return cache;
+}
+
+void DnsCache::resolve(const std::string &hostname,
+                       const ResolveFunction &resolver,
+                       AddressesCallback &&callback)
+{
+    std::vector<trantor::InetAddress> addrs;
+    bool cached{false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = entries_.find(hostname);
+        if (iter != entries_.end() &&
+            iter->second.expiry > std::chrono::steady_clock::now())
+        {
+            auto &entry = iter->second;
+            cached = true;
+            if (entry.addrs.empty())
+            {
+                ++negativeHits_;
+                negativeHitCounter_->increment();
+            }
+            else
+            {
+                ++hits_;
+                hitCounter_->increment();
+                auto first = entry.next++ % entry.addrs.size();
+                addrs.reserve(entry.addrs.size());
+                addrs.insert(addrs.end(),
+                             entry.addrs.begin() + first,
+                             entry.addrs.end());
+                addrs.insert(addrs.end(),
+                             entry.addrs.begin(),
+                             entry.addrs.begin() + first);
+            }
+        }
+        else
+        {
+            if (iter != entries_.end())
+                entries_.erase(iter);
+            ++misses_;
+            missCounter_->increment();
+            auto &callbacks = pending_[hostname];
+            callbacks.emplace_back(std::move(callback));
+            if (callbacks.size() > 1)
+                return;  // A query of the host is on going
+        }
+    }
+    if (cached)
+    {
+        callback(addrs);
+        return;
+    }
+    resolver(hostname,
+             [this, hostname](const std::vector<trantor::InetAddress> &addrs) {
+                 onResolved(hostname, addrs);
+             });
+}
+
+void DnsCache::onResolved(const std::string &hostname,
+                          const std::vector<trantor::InetAddress> &addrs)
+{
+    auto sorted = sortAddresses(addrs);
+    std::vector<AddressesCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = entries_[hostname];
+        entry.addrs = sorted;
+        entry.next = 1;
+        entry.expiry =
+            std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                sorted.empty() ? negativeTtl_ : ttl_);
+        auto iter = pending_.find(hostname);
+        if (iter != pending_.end())
+        {
+            callbacks = std::move(iter->second);
+            pending_.erase(iter);
+        }
+    }
+    for (auto &callback : callbacks)
+    {
+        callback(sorted);
+    }
+}
+
+void DnsCache::setTtl(double ttl, double negativeTtl)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = std::chrono::duration<double>(ttl);
+    negativeTtl_ = std::chrono::duration<double>(negativeTtl);
+}
+
+void DnsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+DnsCacheStats DnsCache::stats() const
+{
+    DnsCacheStats stats;
+    stats.hits = hits_;
+    stats.negativeHits = negativeHits_;
+    stats.misses = misses_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.entries = entries_.size();
+    return stats;
+}
+
+void DnsCache::registerMetrics(monitoring::Registry &registry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (registered_)
+        return;
+    registered_ = true;
+    lookups_->registerTo(registry);
+}
+
+std::vector<trantor::InetAddress> DnsCache::sortAddresses(
+    const std::vector<trantor::InetAddress> &addrs)
+{
+    if (addrs.empty())
+        return {};
+    std::vector<trantor::InetAddress> first, second;
+    bool firstIsV6 = addrs.front().isIpV6();
+    for (auto const &addr : addrs)
+    {
+        if (addr.isUnspecified())
+            continue;
+        if (addr.isIpV6() == firstIsV6)
+            first.push_back(addr);
+        else
+            second.push_back(addr);
+    }
+    std::vector<trantor::InetAddress> sorted;
+    sorted.reserve(first.size() + second.size());
+    for (size_t i = 0; i < std::max(first.size(), second.size()); ++i)
+    {
+        if (i < first.size())
+            sorted.push_back(first[i]);
+        if (i < second.size())
+            sorted.push_back(second[i]);
+    }
+    return sorted;
+}
@@ -0,0 +1,101 @@
+/**
+ *
+ *  @file DnsCache.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A DNS cache shared by all http clients of the process. Resolved
+ * addresses are kept for ttl seconds and failed queries for negativeTtl
+ * seconds. Concurrent queries of the same host are merged into one.
+ */
+class DROGON_EXPORT DnsCache : public trantor::NonCopyable
+{
+  public:
+    using AddressesCallback =
+        std::function<void(const std::vector<trantor::InetAddress> &)>;
+    /// The function which resolves a host name, it is replaced by a stub in
+    /// tests.
+    using ResolveFunction =
+        std::function<void(const std::string &, AddressesCallback &&)>;
+
+    DnsCache();
+
+    static DnsCache &instance();
+
+    /**
+     * @brief Get the addresses of the hostname. The callback is called with
+     * an empty vector if the hostname can't be resolved, it may be called in
+     * the current thread (on cache hits) or in the thread of the resolver.
+     * The addresses are ordered for happy eyeballs (see sortAddresses()) and
+     * rotated on every hit, so the clients of a host are spread across all
+     * its addresses.
+     */
+    void resolve(const std::string &hostname,
+                 const ResolveFunction &resolver,
+                 AddressesCallback &&callback);
+
+    void setTtl(double ttl, double negativeTtl);
+    void clear();
+    DnsCacheStats stats() const;
+    void registerMetrics(monitoring::Registry &registry);
+
+    /**
+     * @brief Interleave the IPv6 and IPv4 addresses, starting with the family
+     * of the first address (RFC 8305 section 4).
+     */
+    static std::vector<trantor::InetAddress> sortAddresses(
+        const std::vector<trantor::InetAddress> &addrs);
+
+  private:
+    struct Entry
+    {
+        std::vector<trantor::InetAddress> addrs;
+        std::chrono::steady_clock::time_point expiry;
+        size_t next{0};
+    };
+
+    void onResolved(const std::string &hostname,
+                    const std::vector<trantor::InetAddress> &addrs);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, std::vector<AddressesCallback>> pending_;
+    std::chrono::duration<double> ttl_{60.0};
+    std::chrono::duration<double> negativeTtl_{5.0};
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> negativeHits_{0};
+    std::atomic<size_t> misses_{0};
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>> lookups_;
+    std::shared_ptr<monitoring::Counter> hitCounter_;
+    std::shared_ptr<monitoring::Counter> negativeHitCounter_;
+    std::shared_ptr<monitoring::Counter> missCounter_;
+    bool registered_{false};
+};
+}  // namespace drogon
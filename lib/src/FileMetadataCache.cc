@@ -0,0 +1,120 @@
+/**
+ *
+ *  @file FileMetadataCache.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "FileMetadataCache.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(_WIN32) && !defined(__MINGW32__)
+#define stat _wstati64
+#define S_ISREG(m) (((m) & 0170000) == (0100000))
+#define S_ISDIR(m) (((m) & 0170000) == (0040000))
+#endif
+#include <sys/stat.h>
+
+using namespace drogon;
+
+const FileMetadata &FileMetadataCache::get(const std::string &filePath,
+                                           double cacheTime,
+                                           const trantor::Date &now)
+{
+    auto iter = entries_.find(filePath);
+    if (iter != entries_.end() && now < iter->second.expiry)
+    {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        if (iter->second.type == FileMetadata::kNotFound)
+            notFoundHits_.fetch_add(1, std::memory_order_relaxed);
+        return iter->second;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    if (iter == entries_.end())
+    {
+        if (entries_.size() >= maxEntries)
+        {
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                if (it->second.expiry < now)
+                    it = entries_.erase(it);
+                else
+                    ++it;
+            }
+            if (entries_.size() >= maxEntries)
+                entries_.clear();
+        }
+        iter = entries_.emplace(filePath, FileMetadata{}).first;
+        size_.store(entries_.size(), std::memory_order_relaxed);
+    }
+    statFile(filePath, iter->second);
+    iter->second.expiry = now.after(cacheTime);
+    return iter->second;
+}
+
+void FileMetadataCache::addStats(StaticFileCacheStats &stats) const
+{
+    stats.hits += hits_.load(std::memory_order_relaxed);
+    stats.misses += misses_.load(std::memory_order_relaxed);
+    stats.notFoundHits += notFoundHits_.load(std::memory_order_relaxed);
+    stats.entries += size_.load(std::memory_order_relaxed);
+}
+
+// std::filesystem::file_time_type::clock::to_time_t still not
+// implemented by M$, even in c++20, so keep calls to stat()
+void FileMetadataCache::statFile(const std::string &filePath,
+                                 FileMetadata &metadata)
+{
+#if defined(_WIN32) && !defined(__MINGW32__)
+    struct _stati64 fileStat;
+#else   // _WIN32
+    struct stat fileStat;
+#endif  // _WIN32
+    metadata.size = 0;
+    metadata.lastModified.clear();
+    metadata.etag.clear();
+    if (stat(utils::toNativePath(filePath).c_str(), &fileStat) != 0)
+    {
+        metadata.type = FileMetadata::kNotFound;
+        return;
+    }
+    if (S_ISDIR(fileStat.st_mode))
+    {
+        metadata.type = FileMetadata::kDirectory;
+        return;
+    }
+    if (!S_ISREG(fileStat.st_mode))
+    {
+        metadata.type = FileMetadata::kOther;
+        return;
+    }
+    metadata.type = FileMetadata::kRegular;
+    metadata.size = fileStat.st_size;
+    LOG_TRACE << "last modify time:" << fileStat.st_mtime;
+    struct tm modifiedTime;
+#ifdef _WIN32
+    gmtime_s(&modifiedTime, &fileStat.st_mtime);
+#else
+    gmtime_r(&fileStat.st_mtime, &modifiedTime);
+#endif
+    char buf[64];
+    size_t len =
+        strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &modifiedTime);
+    metadata.lastModified.assign(buf, len);
+    // The modification time and the size, as nginx does
+    len = snprintf(buf,
+                   sizeof(buf),
+                   "\"%llx-%llx\"",
+                   static_cast<unsigned long long>(fileStat.st_mtime),
+                   static_cast<unsigned long long>(fileStat.st_size));
+    metadata.etag.assign(buf, len);
+}
@@ -0,0 +1,84 @@
+/**
+ *
+ *  @file FileMetadataCache.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpAppFramework.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief The result of one stat() call on a path.
+ */
+struct FileMetadata
+{
+    enum Type
+    {
+        kNotFound,
+        kRegular,
+        kDirectory,
+        kOther
+    } type{kNotFound};
+
+    size_t size{0};
+    // Pre-formatted Last-Modified and ETag header values
+    std::string lastModified;
+    std::string etag;
+    trantor::Date expiry;
+};
+
+/**
+ * @brief The metadata of the static files looked up by an IO thread, so that
+ * hot files (and missing files) don't hit the filesystem on every request.
+ * The entries are only dropped when they expire, a changed file may be seen
+ * with its old metadata until then.
+ * @note Only the counters may be read from other threads.
+ */
+class DROGON_EXPORT FileMetadataCache : public trantor::NonCopyable
+{
+  public:
+    /// The most paths kept, which bounds the memory a flood of requests to
+    /// random paths can take.
+    static constexpr size_t maxEntries{16384};
+
+    /**
+     * @brief Get the metadata of the path, which is looked up again if it
+     * was cached more than cacheTime seconds before now. When the cache is
+     * full, the expired entries are purged, and all entries if none expired.
+     *
+     * @return A reference valid until the next call.
+     */
+    const FileMetadata &get(const std::string &filePath,
+                            double cacheTime,
+                            const trantor::Date &now = trantor::Date::now());
+
+    /// Add the counters of the cache to the statistics.
+    void addStats(StaticFileCacheStats &stats) const;
+
+    /// Call stat() on the path.
+    static void statFile(const std::string &filePath, FileMetadata &metadata);
+
+  private:
+    std::unordered_map<std::string, FileMetadata> entries_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> notFoundHits_{0};
+    std::atomic<size_t> size_{0};
+};
+}  // namespace drogon
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include "AOPAdvice.h"
 #include "ConfigLoader.h"
+#include "CpuAffinity.h"
 #include "DbClientManager.h"
 #include "HttpClientImpl.h"
 #include "HttpConnectionLimit.h"
@@ -30,6 +31,7 @@
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpServer.h"
+#include "ZeroCopySocket.h"
 #include "HttpUtils.h"
 #include "ListenerManager.h"
 #include "PluginsManager.h"
@@ -38,8 +40,11 @@
 #include "SharedLibManager.h"
 #include "StaticFileRouter.h"
 
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -196,6 +201,61 @@ HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesCacheTime(int cacheTime)
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::addCompressionDictionary(
+    const std::string &filePath,
+    const std::string &path,
+    const std::string &match,
+    const std::string &id)
+{
+    auto dictionary = CompressionDictionary::fromFile(filePath, id);
+    if (!dictionary)
+    {
+        LOG_FATAL << "Can't load the compression dictionary " << filePath;
+        exit(1);
+    }
+    using Encoding = CompressionDictionary::Encoding;
+    if (!CompressionDictionary::supports(Encoding::kBrotli) &&
+        !CompressionDictionary::supports(Encoding::kZstd))
+    {
+        LOG_WARN << "Drogon is built without brotli 1.1 or zstd, the "
+                    "compression dictionaries are not used";
+    }
+    compressionDictionaries_.push_back(dictionary);
+    if (path.empty())
+        return *this;
+    // The dictionary is cached by the clients as long as any other resource,
+    // a new version of it should be served at a new path.
+    auto useAsDictionary = "match=\"" + match + "\"";
+    if (!id.empty())
+        useAsDictionary.append(", id=\"").append(id).append("\"");
+    registerHandler(
+        path,
+        [dictionary, useAsDictionary](
+            const HttpRequestPtr &,
+            std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setContentTypeCode(CT_APPLICATION_OCTET_STREAM);
+            resp->setBody(dictionary->data());
+            resp->addHeader("use-as-dictionary", useAsDictionary);
+            resp->addHeader("cache-control", "public, max-age=31536000");
+            callback(resp);
+        },
+        {Get});
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFileMetadataCacheTime(
+    double cacheTime)
+{
+    StaticFileRouter::instance().setFileMetadataCacheTime(cacheTime);
+    return *this;
+}
+
+StaticFileCacheStats HttpAppFrameworkImpl::getStaticFileCacheStats() const
+{
+    return StaticFileRouter::instance().getFileMetadataCacheStats();
+}
+
 int HttpAppFrameworkImpl::staticFilesCacheTime() const
 {
     return StaticFileRouter::instance().staticFilesCacheTime();
@@ -414,6 +474,25 @@ HttpAppFramework &HttpAppFrameworkImpl::addListener(
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setListenerThreadGroup(
+    const std::string &ip,
+    uint16_t port,
+    size_t threadNum,
+    size_t maxConnections)
+{
+    assert(!running_);
+    listenerManagerPtr_->setThreadGroup(ip, port, threadNum, maxConnections);
+    return *this;
+}
+
+std::vector<IoThreadGroupStats> HttpAppFrameworkImpl::getIoThreadGroupStats()
+    const
+{
+    if (!listenerManagerPtr_)
+        return {};
+    return listenerManagerPtr_->getThreadGroupStats();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setMaxConnectionNum(
     size_t maxConnections)
 {
@@ -519,6 +598,93 @@ HttpAppFramework &HttpAppFrameworkImpl::reloadSSLFiles()
     return *this;
 }
 
+ZeroCopySendStats HttpAppFrameworkImpl::getZeroCopySendStats() const
+{
+    return ZeroCopySocket::getStats();
+}
+
+namespace
+{
+// The durations of the startup phases, logged when the listeners start
+class StartupReport
+{
+  public:
+    void phaseDone(const char *name)
+    {
+        auto now = std::chrono::steady_clock::now();
+        phases_.emplace_back(name, now - last_);
+        last_ = now;
+    }
+
+    std::string str(
+        std::vector<std::pair<std::string, double>> pluginTimes) const
+    {
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(1) << "Startup took "
+               << milliseconds(last_ - start_) << "ms:";
+        for (size_t i = 0; i < phases_.size(); ++i)
+        {
+            report << (i == 0 ? " " : ", ") << phases_[i].first << " "
+                   << milliseconds(phases_[i].second) << "ms";
+            if (std::string_view(phases_[i].first) != "plugins" ||
+                pluginTimes.empty())
+                continue;
+            std::sort(pluginTimes.begin(),
+                      pluginTimes.end(),
+                      [](const auto &a, const auto &b) {
+                          return a.second > b.second;
+                      });
+            pluginTimes.resize((std::min)(pluginTimes.size(), size_t(3)));
+            report << " (slowest:";
+            for (auto &plugin : pluginTimes)
+            {
+                report << " " << plugin.first << " "
+                       << plugin.second * 1000 << "ms";
+            }
+            report << ")";
+        }
+        return report.str();
+    }
+
+  private:
+    static double milliseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    std::chrono::steady_clock::time_point start_{
+        std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::time_point last_{start_};
+    std::vector<std::pair<const char *, std::chrono::steady_clock::duration>>
+        phases_;
+};
+}  // namespace
+
+void HttpAppFrameworkImpl::waitForConnections(const trantor::Date &deadline,
+                                              std::function<void()> &&callback)
+{
+    if (warmUpConnections_ == 0 ||
+        (dbClientManagerPtr_->areAllDbClientsWarmedUp(warmUpConnections_) &&
+         redisClientManagerPtr_->areAllRedisClientsWarmedUp(
+             warmUpConnections_)))
+    {
+        callback();
+        return;
+    }
+    if (trantor::Date::now() >= deadline)
+    {
+        LOG_WARN << "The database and redis connections are not ready after "
+                 << warmUpTimeout_ << " seconds, start listening anyway";
+        callback();
+        return;
+    }
+    getLoop()->runAfter(0.01,
+                        [this, deadline, callback = std::move(callback)]() {
+                            auto cb = callback;
+                            waitForConnections(deadline, std::move(cb));
+                        });
+}
+
 void HttpAppFrameworkImpl::run()
 {
     if (!getLoop()->isInLoopThread())
@@ -610,11 +776,13 @@ void HttpAppFrameworkImpl::run()
     }
 #endif
 
+    auto report = std::make_shared<StartupReport>();
     // Create IO threads
     // threadNum 默认是 1
     ioLoopThreadPool_ =
         std::make_unique<trantor::EventLoopThreadPool>(threadNum_,
                                                        "DrogonIoLoop");
+    report->phaseDone("IO threads");
     // 获取所有的 EventLoop 对象并设置下标
     std::vector<trantor::EventLoop *> ioLoops = ioLoopThreadPool_->getLoops();
     for (size_t i = 0; i < threadNum_; ++i)
@@ -624,6 +792,16 @@ void HttpAppFrameworkImpl::run()
     
     // getLoop 函数返回的这个 EventLoop 对象不是在这个 EventLoopThreadPool 中创建的
     getLoop()->setIndex(threadNum_);
+    for (size_t i = 0; i < threadNum_; ++i)
+    {
+        auto cpus = CpuAffinity::ioLoopCpus(cpuAffinity_, i);
+        if (!cpus.empty())
+        {
+            CpuAffinity::pinLoop(ioLoops[i],
+                                 std::move(cpus),
+                                 "IO loop " + std::to_string(i));
+        }
+    }
 
     // 创建监听套接字的地方
     // Create all listeners.
@@ -634,6 +812,7 @@ void HttpAppFrameworkImpl::run()
                                          sslKeyPath_,
                                          sslConfCmds_,
                                          ioLoops);
+    report->phaseDone("listeners");
 
     // A fast database client instance should be created in the main event
     // loop, so put the main loop into ioLoops.
@@ -642,6 +821,19 @@ void HttpAppFrameworkImpl::run()
     // 不知道创建数据库客户端干嘛
     dbClientManagerPtr_->createDbClients(ioLoops);
     redisClientManagerPtr_->createRedisClients(ioLoops);
+    if (!cpuAffinity_.dbLoopCpus.empty())
+    {
+        auto dbLoops = dbClientManagerPtr_->getClientLoops();
+        auto redisLoops = redisClientManagerPtr_->getClientLoops();
+        dbLoops.insert(dbLoops.end(), redisLoops.begin(), redisLoops.end());
+        for (size_t i = 0; i < dbLoops.size(); ++i)
+        {
+            CpuAffinity::pinLoop(dbLoops[i],
+                                 cpuAffinity_.dbLoopCpus,
+                                 "Database loop " + std::to_string(i));
+        }
+    }
+    report->phaseDone("database clients");
     // enableSession 修改该变量为 true 
     if (useSession_)
     {
@@ -682,24 +874,35 @@ void HttpAppFrameworkImpl::run()
                                                          << "new plugin:"
                                                          << plugin->className();
                                                      // TODO: new plugin
-                                                 });
+                                                 },
+                                                 pluginInitThreadNum_);
     }
+    report->phaseDone("plugins");
 
     // 初始化路由
     routersInit_ = true;
     HttpControllersRouter::instance().init(ioLoops);
     StaticFileRouter::instance().init(ioLoops);
+    report->phaseDone("routers");
     // 事件循环中进行排队
-    getLoop()->queueInLoop([this]() {
+    getLoop()->queueInLoop([this, report]() {
         for (auto &adv : beginningAdvices_)
         {
             adv();
         }
         // 调用完给清空掉
         beginningAdvices_.clear();
+        report->phaseDone("beginning advices");
         // Let listener event loops run when everything is ready.
         // 启动监听
-        listenerManagerPtr_->startListening();
+        waitForConnections(trantor::Date::now().after(warmUpTimeout_),
+                           [this, report]() {
+                               if (warmUpConnections_ > 0)
+                                   report->phaseDone("connection warm-up");
+                               listenerManagerPtr_->startListening();
+                               LOG_INFO << report->str(
+                                   pluginsManagerPtr_->initializationTimes());
+                           });
     });
     // start all loops
     // TODO: when should IOLoops start?
@@ -708,6 +911,12 @@ void HttpAppFrameworkImpl::run()
     // However, we should consider other components.
     // 启动所有的事件循环
     ioLoopThreadPool_->start();
+    // The threads created before inherit the CPUs of the main thread, so it's
+    // pinned last
+    if (!cpuAffinity_.mainLoopCpus.empty())
+    {
+        CpuAffinity::pinCurrentThread(cpuAffinity_.mainLoopCpus, "Main loop");
+    }
     // 阻塞当前线程，因为其中有一个 while 循环
     getLoop()->loop();
 }
@@ -1017,7 +1226,8 @@ void HttpAppFrameworkImpl::addDbClient(
                                      name,
                                      isFast,
                                      characterSet,
-                                     timeout});
+                                     timeout,
+                                     autoBatch});
     }
     else if (dbType == "sqlite3")
     {
@@ -1271,7 +1481,11 @@ HttpAppFramework &HttpAppFrameworkImpl::registerCustomExtensionMime(
 
 int64_t HttpAppFrameworkImpl::getConnectionCount() const
 {
-    return HttpConnectionLimit::instance().getConnectionNum();
+    auto count = HttpConnectionLimit::instance().getConnectionNum();
+    // The listeners with their own IO loops count their connections apart
+    if (listenerManagerPtr_)
+        count += listenerManagerPtr_->getThreadGroupConnectionNum();
+    return count;
 }
 
 HttpAppFramework &HttpAppFrameworkImpl::enableRequestStream(bool enable)
@@ -1285,6 +1499,17 @@ bool HttpAppFrameworkImpl::isRequestStreamEnabled() const
     return enableRequestStream_;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::enableEarlyRejection(bool enable)
+{
+    enableEarlyRejection_ = enable;
+    return *this;
+}
+
+bool HttpAppFrameworkImpl::isEarlyRejectionEnabled() const
+{
+    return enableEarlyRejection_;
+}
+
 // AOP registration methods
 
 HttpAppFramework &HttpAppFrameworkImpl::registerNewConnectionAdvice(
@@ -1312,6 +1537,15 @@ HttpAppFramework &HttpAppFrameworkImpl::registerSyncAdvice(
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::registerPreBodyAdvice(
+    const std::function<void(const HttpRequestPtr &,
+                             AdviceCallback &&,
+                             AdviceChainCallback &&)> &advice)
+{
+    AopAdvice::instance().registerPreBodyAdvice(advice);
+    return *this;
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::registerPreRoutingAdvice(
     const std::function<void(const HttpRequestPtr &)> &advice)
 {
@@ -60,6 +60,12 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     std::shared_ptr<PluginBase> getSharedPlugin(
         const std::string &name) override;
     void addPlugins(const Json::Value &configs) override;
+
+    HttpAppFramework &setPluginInitThreadNum(size_t threadNum) override
+    {
+        pluginInitThreadNum_ = threadNum;
+        return *this;
+    }
     void addPlugin(const std::string &name,
                    const std::vector<std::string> &dependencies,
                    const Json::Value &config) override;
@@ -72,6 +78,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         bool useOldTLS,
         const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
         override;
+    HttpAppFramework &setListenerThreadGroup(const std::string &ip,
+                                             uint16_t port,
+                                             size_t threadNum,
+                                             size_t maxConnections) override;
+    std::vector<IoThreadGroupStats> getIoThreadGroupStats() const override;
     HttpAppFramework &setThreadNum(size_t threadNum) override;
 
     size_t getThreadNum() const override
@@ -79,6 +90,17 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return threadNum_;
     }
 
+    HttpAppFramework &setCpuAffinity(const CpuAffinityConfig &config) override
+    {
+        cpuAffinity_ = config;
+        return *this;
+    }
+
+    const CpuAffinityConfig &getCpuAffinity() const
+    {
+        return cpuAffinity_;
+    }
+
     HttpAppFramework &setSSLConfigCommands(
         const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
         override;
@@ -148,6 +170,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         const std::function<HttpResponsePtr(const HttpRequestPtr &)> &advice)
         override;
 
+    HttpAppFramework &registerPreBodyAdvice(
+        const std::function<void(const HttpRequestPtr &,
+                                 AdviceCallback &&,
+                                 AdviceChainCallback &&)> &advice) override;
+
     HttpAppFramework &registerPreRoutingAdvice(
         const std::function<void(const HttpRequestPtr &,
                                  AdviceCallback &&,
@@ -314,6 +341,19 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return *this;
     }
 
+    HttpAppFramework &setZeroCopySendThreshold(size_t threshold) override
+    {
+        zeroCopySendThreshold_ = threshold;
+        return *this;
+    }
+
+    size_t getZeroCopySendThreshold() const override
+    {
+        return zeroCopySendThreshold_;
+    }
+
+    ZeroCopySendStats getZeroCopySendStats() const override;
+
     HttpAppFramework &enableGzip(bool useGzip) override
     {
         useGzip_ = useGzip;
@@ -336,7 +376,32 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return useBrotli_;
     }
 
+    HttpAppFramework &addCompressionDictionary(const std::string &filePath,
+                                               const std::string &path,
+                                               const std::string &match,
+                                               const std::string &id) override;
+
+    const std::vector<CompressionDictionaryPtr> &getCompressionDictionaries()
+        const
+    {
+        return compressionDictionaries_;
+    }
+
+    HttpAppFramework &enableAutoETag(bool flag) override
+    {
+        useAutoETag_ = flag;
+        return *this;
+    }
+
+    bool isAutoETagEnabled() const override
+    {
+        return useAutoETag_;
+    }
+
     HttpAppFramework &setStaticFilesCacheTime(int cacheTime) override;
+    HttpAppFramework &setStaticFileMetadataCacheTime(
+        double cacheTime) override;
+    StaticFileCacheStats getStaticFileCacheStats() const override;
     int staticFilesCacheTime() const override;
 
     HttpAppFramework &setIdleConnectionTimeout(size_t timeout) override
@@ -350,6 +415,17 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return idleConnectionTimeout_;
     }
 
+    HttpAppFramework &setIdleBufferReleaseTime(double releaseTime) override
+    {
+        idleBufferReleaseTime_ = releaseTime;
+        return *this;
+    }
+
+    double getIdleBufferReleaseTime() const override
+    {
+        return idleBufferReleaseTime_;
+    }
+
     HttpAppFramework &setKeepaliveRequestsNumber(const size_t number) override
     {
         keepaliveRequestsNumber_ = number;
@@ -608,6 +684,14 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     }
 
     bool areAllDbClientsAvailable() const noexcept override;
+
+    HttpAppFramework &setStartupConnectionWarmUp(size_t minConnections,
+                                                 double timeout) override
+    {
+        warmUpConnections_ = minConnections;
+        warmUpTimeout_ = timeout;
+        return *this;
+    }
     const std::function<HttpResponsePtr(HttpStatusCode,
                                         const HttpRequestPtr &req)> &
     getCustomErrorHandler() const override;
@@ -670,8 +754,14 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
 
     HttpAppFramework &enableRequestStream(bool enable) override;
     bool isRequestStreamEnabled() const override;
+    HttpAppFramework &enableEarlyRejection(bool enable) override;
+    bool isEarlyRejectionEnabled() const override;
 
   private:
+    // Call the callback once the database and redis connections are warmed
+    // up, or at the deadline
+    void waitForConnections(const trantor::Date &deadline,
+                            std::function<void()> &&callback);
     void registerHttpController(const std::string &pathPattern,
                                 const internal::HttpBinderBasePtr &binder,
                                 const std::vector<HttpMethod> &validMethods,
@@ -692,6 +782,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     std::string sessionCookieKey_{"JSESSIONID"};
     int sessionMaxAge_{-1};
     size_t idleConnectionTimeout_{60};
+    double idleBufferReleaseTime_{10.0};
+    size_t pluginInitThreadNum_{1};
+    size_t warmUpConnections_{0};
+    double warmUpTimeout_{10.0};
+    CpuAffinityConfig cpuAffinity_;
     bool useSession_{false};
     std::string serverHeader_{"server: drogon/" + drogon::getVersion() +
                               "\r\n"};
@@ -731,8 +826,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     size_t pipeliningRequestsNumber_{0};
     size_t jsonStackLimit_{1000};
     bool useSendfile_{true};
+    size_t zeroCopySendThreshold_{0};
     bool useGzip_{true};
     bool useBrotli_{false};
+    std::vector<CompressionDictionaryPtr> compressionDictionaries_;
+    bool useAutoETag_{false};
     bool usingUnicodeEscaping_{true};
     std::pair<unsigned int, std::string> floatPrecisionInJson_{0,
                                                                "significant"};
@@ -763,6 +861,7 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     bool enableCompressedRequest_{false};
 
     bool enableRequestStream_{false};
+    bool enableEarlyRejection_{false};
 };
 
 }  // namespace drogon
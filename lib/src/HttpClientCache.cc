@@ -0,0 +1,963 @@
+/**
+ *
+ *  @file HttpClientCache.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientCache.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+using namespace drogon;
+
+namespace
+{
+// The max freshness lifetime computed from Last-Modified (RFC 9111 4.2.2)
+constexpr double kMaxHeuristicLifetime{24 * 3600};
+
+std::string_view trim(std::string_view sv)
+{
+    while (!sv.empty() && (sv.front() == ' ' || sv.front() == '\t'))
+        sv.remove_prefix(1);
+    while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t'))
+        sv.remove_suffix(1);
+    return sv;
+}
+
+long long parseSeconds(std::string_view value)
+{
+    if (!value.empty() && value.front() == '"' && value.back() == '"' &&
+        value.size() >= 2)
+    {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.empty())
+        return -1;
+    long long seconds = 0;
+    for (auto c : value)
+    {
+        if (c < '0' || c > '9')
+            return -1;
+        seconds = seconds * 10 + (c - '0');
+        if (seconds > std::numeric_limits<int32_t>::max())
+            return std::numeric_limits<int32_t>::max();
+    }
+    return seconds;
+}
+
+bool isHeuristicallyCacheable(HttpStatusCode code)
+{
+    switch (code)
+    {
+        case k200OK:
+        case k203NonAuthoritativeInformation:
+        case k204NoContent:
+        case k300MultipleChoices:
+        case k301MovedPermanently:
+        case k308PermanentRedirect:
+        case k404NotFound:
+        case k405MethodNotAllowed:
+        case k410Gone:
+        case k414RequestURITooLarge:
+        case k501NotImplemented:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Returns 0 if the header is absent or invalid
+double parseHttpDate(const std::string &value)
+{
+    if (value.empty())
+        return 0;
+    auto date = utils::getHttpDate(value);
+    if (date.microSecondsSinceEpoch() == std::numeric_limits<int64_t>::max())
+        return 0;
+    return static_cast<double>(date.microSecondsSinceEpoch()) /
+           MICRO_SECONDS_PRE_SEC;
+}
+
+double toSeconds(const trantor::Date &date)
+{
+    return static_cast<double>(date.microSecondsSinceEpoch()) /
+           MICRO_SECONDS_PRE_SEC;
+}
+
+std::vector<std::string> varyHeaders(const HttpResponsePtr &resp)
+{
+    std::vector<std::string> names;
+    auto &vary = resp->getHeader("vary");
+    std::string_view sv(vary);
+    while (!sv.empty())
+    {
+        auto pos = sv.find(',');
+        auto name = trim(sv.substr(0, pos));
+        if (!name.empty())
+        {
+            std::string lowerName(name);
+            std::transform(lowerName.begin(),
+                           lowerName.end(),
+                           lowerName.begin(),
+                           [](unsigned char c) { return tolower(c); });
+            names.emplace_back(std::move(lowerName));
+        }
+        if (pos == std::string_view::npos)
+            break;
+        sv.remove_prefix(pos + 1);
+    }
+    return names;
+}
+
+// The headers of a 304 response which must not update the stored response
+bool isPayloadHeader(const std::string &name)
+{
+    return name == "content-length" || name == "content-encoding" ||
+           name == "transfer-encoding" || name == "content-range";
+}
+}  // namespace
+
+CacheControl CacheControl::parse(const std::string &header)
+{
+    CacheControl cc;
+    std::string_view sv(header);
+    while (!sv.empty())
+    {
+        auto pos = sv.find(',');
+        auto directive = trim(sv.substr(0, pos));
+        std::string_view value;
+        auto eq = directive.find('=');
+        if (eq != std::string_view::npos)
+        {
+            value = trim(directive.substr(eq + 1));
+            directive = trim(directive.substr(0, eq));
+        }
+        std::string name(directive);
+        std::transform(name.begin(),
+                       name.end(),
+                       name.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (name == "no-store")
+            cc.noStore = true;
+        else if (name == "no-cache")
+            cc.noCache = true;
+        else if (name == "must-revalidate" || name == "proxy-revalidate")
+            cc.mustRevalidate = true;
+        else if (name == "only-if-cached")
+            cc.onlyIfCached = true;
+        else if (name == "public")
+            cc.isPublic = true;
+        else if (name == "max-age")
+            cc.maxAge = parseSeconds(value);
+        else if (name == "s-maxage")
+            cc.sMaxAge = parseSeconds(value);
+        else if (name == "max-stale")
+            // max-stale without a value means any staleness is accepted
+            cc.maxStale = value.empty() ? std::numeric_limits<int32_t>::max()
+                                        : parseSeconds(value);
+        else if (name == "min-fresh")
+            cc.minFresh = parseSeconds(value);
+        else if (name == "stale-while-revalidate")
+            cc.staleWhileRevalidate = parseSeconds(value);
+        else if (name == "stale-if-error")
+            cc.staleIfError = parseSeconds(value);
+        if (pos == std::string_view::npos)
+            break;
+        sv.remove_prefix(pos + 1);
+    }
+    return cc;
+}
+
+HttpClientCache::HttpClientCache(HttpClientCacheConfig config,
+                                 UpstreamFunction upstream)
+    : config_(std::move(config)), upstream_(std::move(upstream))
+{
+    if (!config_.diskPath.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(
+            utils::toNativePath(config_.diskPath), ec);
+        if (ec)
+        {
+            LOG_ERROR << "Can't create the cache directory "
+                      << config_.diskPath << ": " << ec.message();
+        }
+    }
+}
+
+HttpClientCache::~HttpClientCache()
+{
+    for (auto &file : diskFiles_)
+    {
+        std::error_code ec;
+        std::filesystem::remove(utils::toNativePath(file.fileName), ec);
+    }
+}
+
+void HttpClientCache::sendRequest(const HttpRequestPtr &req,
+                                  HttpReqCallback &&callback)
+{
+    if (req->method() != Get)
+    {
+        if (req->method() == Head || req->method() == Options)
+        {
+            upstream_(req, std::move(callback));
+            return;
+        }
+        // Unsafe methods invalidate the stored responses of the target URI
+        // and of the URIs in the Location and Content-Location headers of a
+        // non-error response (RFC 9111 4.4). The parameters of the request
+        // are its body, not a part of the URI.
+        std::string target = req->path();
+        if (!req->query().empty())
+            target.append(1, '?').append(req->query());
+        invalidate(target);
+        std::weak_ptr<HttpClientCache> weakPtr = shared_from_this();
+        upstream_(req,
+                  [weakPtr, callback = std::move(callback)](
+                      ReqResult result, const HttpResponsePtr &resp) {
+                      auto thisPtr = weakPtr.lock();
+                      if (thisPtr && result == ReqResult::Ok && resp &&
+                          static_cast<int>(resp->statusCode()) < 400)
+                      {
+                          thisPtr->invalidate(resp->getHeader("location"));
+                          thisPtr->invalidate(
+                              resp->getHeader("content-location"));
+                      }
+                      callback(result, resp);
+                  });
+        return;
+    }
+    auto reqCc = CacheControl::parse(req->getHeader("cache-control"));
+    if (reqCc.noStore || !req->getHeader("if-none-match").empty() ||
+        !req->getHeader("if-modified-since").empty() ||
+        !req->getHeader("range").empty())
+    {
+        ++stats_.bypasses;
+        upstream_(req, std::move(callback));
+        return;
+    }
+    auto key = makeKey(req);
+    auto flight = flightKey(key, req);
+    auto entry = find(key, req);
+    if (entry)
+    {
+        auto respCc =
+            CacheControl::parse(entry->response->getHeader("cache-control"));
+        auto age = currentAge(*entry);
+        auto lifetime = freshnessLifetime(*entry);
+        auto staleness = age - lifetime;
+        if (!reqCc.noCache && !respCc.noCache)
+        {
+            bool fresh = age < lifetime;
+            if (fresh && reqCc.maxAge >= 0 &&
+                age > static_cast<double>(reqCc.maxAge))
+                fresh = false;
+            if (fresh && reqCc.minFresh >= 0 &&
+                age + static_cast<double>(reqCc.minFresh) >= lifetime)
+                fresh = false;
+            if (fresh)
+            {
+                ++stats_.hits;
+                respond(entry, callback);
+                return;
+            }
+            if (!respCc.mustRevalidate && reqCc.maxStale >= 0 &&
+                staleness <= static_cast<double>(reqCc.maxStale))
+            {
+                ++stats_.staleHits;
+                respond(entry, callback);
+                return;
+            }
+            if (!respCc.mustRevalidate && respCc.staleWhileRevalidate >= 0 &&
+                staleness <= static_cast<double>(respCc.staleWhileRevalidate))
+            {
+                ++stats_.staleHits;
+                respond(entry, callback);
+                if (inflight_.find(flight) == inflight_.end())
+                {
+                    inflight_[flight];
+                    fetch(key, flight, req, entry);
+                }
+                return;
+            }
+        }
+    }
+    if (reqCc.onlyIfCached)
+    {
+        callback(ReqResult::Ok,
+                 HttpResponse::newHttpResponse(k504GatewayTimeout, CT_NONE));
+        return;
+    }
+    auto &waiters = inflight_[flight];
+    waiters.emplace_back(req, std::move(callback));
+    if (waiters.size() > 1)
+    {
+        ++stats_.coalesced;
+        return;
+    }
+    if (entry)
+        ++stats_.revalidations;
+    else
+        ++stats_.misses;
+    fetch(key, flight, req, entry);
+}
+
+void HttpClientCache::fetch(const std::string &key,
+                            const std::string &flight,
+                            const HttpRequestPtr &req,
+                            const EntryPtr &entry)
+{
+    auto upstreamReq = req;
+    if (entry)
+    {
+        // The validators are added to a copy, the request of the user may be
+        // sent again by the user or be on the fly (stale-while-revalidate)
+        auto &etag = entry->response->getHeader("etag");
+        auto &lastModified = entry->response->getHeader("last-modified");
+        if (!etag.empty() || !lastModified.empty())
+            upstreamReq = copyRequest(req);
+        if (!etag.empty())
+            upstreamReq->addHeader("if-none-match", etag);
+        if (!lastModified.empty())
+            upstreamReq->addHeader("if-modified-since", lastModified);
+    }
+    auto requestTime = trantor::Date::now();
+    std::weak_ptr<HttpClientCache> weakPtr = shared_from_this();
+    upstream_(upstreamReq,
+              [weakPtr, key, flight, req, entry, requestTime](
+                  ReqResult result, const HttpResponsePtr &resp) {
+                  auto thisPtr = weakPtr.lock();
+                  if (!thisPtr)
+                      return;
+                  thisPtr->handleResponse(
+                      key, flight, req, entry, requestTime, result, resp);
+              });
+}
+
+void HttpClientCache::handleResponse(const std::string &key,
+                                     const std::string &flight,
+                                     const HttpRequestPtr &req,
+                                     const EntryPtr &entry,
+                                     const trantor::Date &requestTime,
+                                     ReqResult result,
+                                     const HttpResponsePtr &resp)
+{
+    Waiters waiters;
+    auto iter = inflight_.find(flight);
+    if (iter != inflight_.end())
+    {
+        waiters = std::move(iter->second);
+        inflight_.erase(iter);
+    }
+    if (result != ReqResult::Ok || !resp ||
+        (entry && static_cast<int>(resp->statusCode()) >= 500))
+    {
+        if (entry)
+        {
+            auto respCc = CacheControl::parse(
+                entry->response->getHeader("cache-control"));
+            auto staleness = currentAge(*entry) - freshnessLifetime(*entry);
+            if (respCc.staleIfError >= 0 &&
+                staleness <= static_cast<double>(respCc.staleIfError))
+            {
+                for (auto &waiter : waiters)
+                {
+                    ++stats_.staleHits;
+                    respond(entry, waiter.second);
+                }
+                return;
+            }
+        }
+        for (auto &waiter : waiters)
+        {
+            waiter.second(result, resp ? copyResponse(resp) : resp);
+        }
+        return;
+    }
+    EntryPtr stored;
+    if (entry && resp->statusCode() == k304NotModified)
+    {
+        // Freshen the stored response with the new headers (RFC 9111 4.3.4)
+        ++stats_.notModified;
+        for (auto const &header : resp->headers())
+        {
+            if (!isPayloadHeader(header.first))
+                entry->response->addHeader(header.first, header.second);
+        }
+        entry->requestTime = requestTime;
+        entry->responseTime = trantor::Date::now();
+        // The entry may have been evicted while revalidating
+        if (lruIndex_.find(entry.get()) != lruIndex_.end())
+            touch(entry);
+        stored = entry;
+    }
+    else if (isStorable(req, resp))
+    {
+        stored = store(key, req, resp, requestTime);
+    }
+    else if (static_cast<int>(resp->statusCode()) < 500)
+    {
+        remove(key);
+    }
+    if (!stored)
+    {
+        // The response isn't cached, the waiters of the same request share
+        // it and every one gets its own copy.
+        for (size_t i = 0; i < waiters.size(); ++i)
+        {
+            waiters[i].second(ReqResult::Ok,
+                              i + 1 == waiters.size() ? resp
+                                                      : copyResponse(resp));
+        }
+        return;
+    }
+    for (auto &waiter : waiters)
+    {
+        if (varyMatches(*stored, waiter.first))
+            respond(stored, waiter.second);
+        else
+            sendRequest(waiter.first, std::move(waiter.second));
+    }
+}
+
+void HttpClientCache::respond(const EntryPtr &entry,
+                              const HttpReqCallback &callback)
+{
+    touch(entry);
+    auto resp = copyResponse(entry->response);
+    resp->addHeader("age",
+                    std::to_string(static_cast<long long>(currentAge(*entry))));
+    callback(ReqResult::Ok, resp);
+}
+
+std::string HttpClientCache::makeKey(const HttpRequestPtr &req)
+{
+    std::string key = req->path();
+    if (!req->query().empty())
+    {
+        key.append(1, '?').append(req->query());
+    }
+    auto &params = req->getParameters();
+    if (!params.empty())
+    {
+        std::vector<std::pair<std::string, std::string>> sorted(params.begin(),
+                                                                params.end());
+        std::sort(sorted.begin(), sorted.end());
+        key.append(1, '#');
+        for (auto &param : sorted)
+        {
+            key.append(utils::urlEncodeComponent(param.first))
+                .append(1, '=')
+                .append(utils::urlEncodeComponent(param.second))
+                .append(1, '&');
+        }
+    }
+    return key;
+}
+
+std::string HttpClientCache::flightKey(const std::string &key,
+                                       const HttpRequestPtr &req)
+{
+    // A response fetched with some credentials is not given to the requests
+    // made with other ones
+    auto &authorization = req->getHeader("authorization");
+    if (authorization.empty())
+        return key;
+    std::string flight = key;
+    flight.append(1, '\n').append(authorization);
+    return flight;
+}
+
+bool HttpClientCache::isStorable(const HttpRequestPtr &req,
+                                 const HttpResponsePtr &resp)
+{
+    if (CacheControl::parse(req->getHeader("cache-control")).noStore)
+        return false;
+    auto respCc = CacheControl::parse(resp->getHeader("cache-control"));
+    if (respCc.noStore)
+        return false;
+    // The stored responses are served to every request of the client, the
+    // server must allow sharing an authorized one (RFC 9111 3.5)
+    if (!req->getHeader("authorization").empty() && !respCc.isPublic &&
+        !respCc.mustRevalidate && respCc.sMaxAge < 0)
+        return false;
+    if (resp->getHeader("vary") == "*")
+        return false;
+    if (resp->statusCode() == k206PartialContent ||
+        resp->statusCode() == k304NotModified)
+        return false;
+    if (respCc.maxAge >= 0 || !resp->getHeader("expires").empty())
+        return true;
+    if (isHeuristicallyCacheable(resp->statusCode()) &&
+        (respCc.noCache || !resp->getHeader("etag").empty() ||
+         !resp->getHeader("last-modified").empty()))
+        return true;
+    return false;
+}
+
+double HttpClientCache::freshnessLifetime(const Entry &entry)
+{
+    auto &resp = entry.response;
+    auto respCc = CacheControl::parse(resp->getHeader("cache-control"));
+    if (respCc.maxAge >= 0)
+        return static_cast<double>(respCc.maxAge);
+    auto date = parseHttpDate(resp->getHeader("date"));
+    if (date == 0)
+        date = toSeconds(entry.responseTime);
+    auto &expiresHeader = resp->getHeader("expires");
+    if (!expiresHeader.empty())
+    {
+        // An invalid date means already expired
+        auto expires = parseHttpDate(expiresHeader);
+        return expires == 0 ? 0 : std::max(0.0, expires - date);
+    }
+    auto lastModified = parseHttpDate(resp->getHeader("last-modified"));
+    if (lastModified > 0 && lastModified < date &&
+        isHeuristicallyCacheable(resp->statusCode()))
+    {
+        return std::min((date - lastModified) / 10, kMaxHeuristicLifetime);
+    }
+    return 0;
+}
+
+double HttpClientCache::currentAge(const Entry &entry)
+{
+    // RFC 9111 4.2.3
+    auto &resp = entry.response;
+    auto responseTime = toSeconds(entry.responseTime);
+    auto requestTime = toSeconds(entry.requestTime);
+    auto ageValue = parseSeconds(resp->getHeader("age"));
+    auto dateValue = parseHttpDate(resp->getHeader("date"));
+    auto apparentAge =
+        dateValue == 0 ? 0.0 : std::max(0.0, responseTime - dateValue);
+    auto responseDelay = responseTime - requestTime;
+    auto correctedAgeValue =
+        (ageValue < 0 ? 0.0 : static_cast<double>(ageValue)) + responseDelay;
+    auto correctedInitialAge = std::max(apparentAge, correctedAgeValue);
+    auto residentTime = toSeconds(trantor::Date::now()) - responseTime;
+    return correctedInitialAge + residentTime;
+}
+
+HttpResponsePtr HttpClientCache::copyResponse(const HttpResponsePtr &resp)
+{
+    auto copy = std::make_shared<HttpResponseImpl>();
+    copy->setStatusCode(resp->statusCode());
+    copy->setVersion(resp->version());
+    for (auto const &header : resp->headers())
+    {
+        copy->addHeader(header.first, header.second);
+    }
+    for (auto const &cookie : resp->cookies())
+    {
+        copy->addCookie(cookie.second);
+    }
+    copy->setBody(std::string(resp->body()));
+    return copy;
+}
+
+HttpRequestPtr HttpClientCache::copyRequest(const HttpRequestPtr &req)
+{
+    auto copy = HttpRequest::newHttpRequest();
+    auto reqImpl = static_cast<HttpRequestImpl *>(req.get());
+    auto copyImpl = static_cast<HttpRequestImpl *>(copy.get());
+    copy->setMethod(req->method());
+    copy->setPath(req->path());
+    copy->setPathEncode(reqImpl->pathEncode());
+    copy->setPassThrough(reqImpl->passThrough());
+    copyImpl->setQuery(req->query());
+    for (auto const &param : req->parameters())
+    {
+        copy->setParameter(param.first, param.second);
+    }
+    for (auto const &header : req->headers())
+    {
+        copy->addHeader(header.first, header.second);
+    }
+    for (auto const &cookie : req->cookies())
+    {
+        copy->addCookie(cookie.first, cookie.second);
+    }
+    if (!req->body().empty())
+    {
+        copy->setContentTypeCode(req->contentType());
+        copy->setBody(std::string(req->body()));
+    }
+    return copy;
+}
+
+bool HttpClientCache::varyMatches(const Entry &entry, const HttpRequestPtr &req)
+{
+    for (auto const &value : entry.varyValues)
+    {
+        if (req->getHeader(value.first) != value.second)
+            return false;
+    }
+    return true;
+}
+
+HttpClientCache::EntryPtr HttpClientCache::find(const std::string &key,
+                                                const HttpRequestPtr &req)
+{
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+    {
+        for (auto &entry : iter->second)
+        {
+            if (varyMatches(*entry, req))
+                return entry;
+        }
+    }
+    if (config_.diskPath.empty())
+        return nullptr;
+    auto fileIter = diskIndex_.find(key);
+    if (fileIter == diskIndex_.end())
+        return nullptr;
+    // Promote the variants of the request from the disk to the memory
+    EntryPtr found;
+    for (auto &entry : readFromDisk(key))
+    {
+        if (!found && varyMatches(*entry, req))
+            found = entry;
+        insert(entry);
+    }
+    evict();
+    return found;
+}
+
+HttpClientCache::EntryPtr HttpClientCache::store(
+    const std::string &key,
+    const HttpRequestPtr &req,
+    const HttpResponsePtr &resp,
+    const trantor::Date &requestTime)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->requestTime = requestTime;
+    entry->responseTime = trantor::Date::now();
+    entry->size = key.size() + resp->body().size();
+    for (auto const &name : varyHeaders(resp))
+    {
+        entry->varyValues.emplace_back(name, req->getHeader(name));
+        entry->size += name.size() + entry->varyValues.back().second.size();
+    }
+    for (auto const &header : resp->headers())
+    {
+        entry->size += header.first.size() + header.second.size() + 4;
+    }
+    if (entry->size > config_.maxEntrySize)
+        return nullptr;
+    entry->response = copyResponse(resp);
+
+    // Replace the variant with the same values of the Vary headers
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+    {
+        for (auto &old : iter->second)
+        {
+            if (old->varyValues == entry->varyValues)
+            {
+                erase(old);
+                break;
+            }
+        }
+    }
+    insert(entry);
+    evict();
+    return entry;
+}
+
+void HttpClientCache::insert(const EntryPtr &entry)
+{
+    entries_[entry->key].push_back(entry);
+    lru_.push_front(entry);
+    lruIndex_[entry.get()] = lru_.begin();
+    memorySize_ += entry->size;
+}
+
+void HttpClientCache::erase(EntryPtr entry)
+{
+    auto lruIter = lruIndex_.find(entry.get());
+    if (lruIter == lruIndex_.end())
+        return;
+    lru_.erase(lruIter->second);
+    lruIndex_.erase(lruIter);
+    memorySize_ -= entry->size;
+    auto iter = entries_.find(entry->key);
+    if (iter != entries_.end())
+    {
+        auto &variants = iter->second;
+        variants.erase(std::remove(variants.begin(), variants.end(), entry),
+                       variants.end());
+        if (variants.empty())
+            entries_.erase(iter);
+    }
+}
+
+void HttpClientCache::remove(const std::string &key)
+{
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+    {
+        auto variants = iter->second;
+        for (auto &entry : variants)
+        {
+            erase(entry);
+        }
+    }
+    if (!config_.diskPath.empty())
+        removeFromDisk(key);
+}
+
+void HttpClientCache::invalidate(const std::string &target)
+{
+    std::string_view uri{target};
+    auto pos = uri.find('#');
+    if (pos != std::string_view::npos)
+        uri = uri.substr(0, pos);
+    // Only the path and the query of an absolute URI are compared, the cache
+    // belongs to the client of one host
+    pos = uri.find("://");
+    if (pos != std::string_view::npos)
+    {
+        pos = uri.find('/', pos + 3);
+        uri = pos == std::string_view::npos ? std::string_view{"/"}
+                                            : uri.substr(pos);
+    }
+    if (uri.empty() || uri.front() != '/')
+        return;
+    // The keys of the requests with parameters go on with '#'
+    auto matches = [uri](const std::string &key) {
+        return key.compare(0, uri.size(), uri) == 0 &&
+               (key.size() == uri.size() || key[uri.size()] == '#');
+    };
+    std::vector<std::string> keys;
+    for (auto &item : entries_)
+    {
+        if (matches(item.first))
+            keys.push_back(item.first);
+    }
+    for (auto &item : diskIndex_)
+    {
+        if (matches(item.first))
+            keys.push_back(item.first);
+    }
+    for (auto &key : keys)
+    {
+        remove(key);
+    }
+}
+
+void HttpClientCache::touch(const EntryPtr &entry)
+{
+    auto iter = lruIndex_.find(entry.get());
+    if (iter == lruIndex_.end())
+        return;
+    lru_.splice(lru_.begin(), lru_, iter->second);
+}
+
+void HttpClientCache::evict()
+{
+    while (memorySize_ > config_.maxMemorySize && !lru_.empty())
+    {
+        auto victim = lru_.back();
+        if (!config_.diskPath.empty())
+            writeToDisk(victim);
+        erase(victim);
+        ++stats_.evictions;
+    }
+}
+
+std::string HttpClientCache::diskFileName(const Entry &entry) const
+{
+    std::string variant;
+    for (auto const &value : entry.varyValues)
+    {
+        variant.append(value.first).append(1, ':').append(value.second);
+        variant.append(1, '\n');
+    }
+    char name[64];
+    snprintf(name,
+             sizeof(name),
+             "drogon_cache_%p_%zx_%zx",
+             static_cast<const void *>(this),
+             std::hash<std::string>{}(entry.key),
+             std::hash<std::string>{}(variant));
+    auto path = config_.diskPath;
+    if (path.back() != '/')
+        path.append(1, '/');
+    return path.append(name);
+}
+
+void HttpClientCache::writeToDisk(const EntryPtr &entry)
+{
+    auto fileName = diskFileName(*entry);
+    std::ofstream file(utils::toNativePath(fileName),
+                       std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        LOG_ERROR << "Can't write the cache file " << fileName;
+        return;
+    }
+    auto &resp = entry->response;
+    file << entry->key << '\n'
+         << static_cast<int>(resp->statusCode()) << '\n'
+         << entry->requestTime.microSecondsSinceEpoch() << '\n'
+         << entry->responseTime.microSecondsSinceEpoch() << '\n'
+         << entry->varyValues.size() << '\n';
+    for (auto const &value : entry->varyValues)
+    {
+        file << value.first << '\n' << value.second << '\n';
+    }
+    file << resp->headers().size() << '\n';
+    for (auto const &header : resp->headers())
+    {
+        file << header.first << '\n' << header.second << '\n';
+    }
+    file << resp->cookies().size() << '\n';
+    for (auto const &cookie : resp->cookies())
+    {
+        // "Set-Cookie: ...\r\n"
+        auto line = cookie.second.cookieString();
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+        file << line << '\n';
+    }
+    auto body = resp->body();
+    file << body.size() << '\n';
+    file.write(body.data(), static_cast<std::streamsize>(body.size()));
+    if (!file)
+    {
+        LOG_ERROR << "Can't write the cache file " << fileName;
+        return;
+    }
+    file.close();
+
+    // Replace the older file of the same variant
+    auto range = diskIndex_.equal_range(entry->key);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if (iter->second->fileName == fileName)
+        {
+            diskSize_ -= iter->second->size;
+            diskFiles_.erase(iter->second);
+            diskIndex_.erase(iter);
+            break;
+        }
+    }
+    diskFiles_.push_front({entry->key, fileName, entry->size});
+    diskIndex_.emplace(entry->key, diskFiles_.begin());
+    diskSize_ += entry->size;
+    while (diskSize_ > config_.maxDiskSize && !diskFiles_.empty())
+    {
+        auto &oldest = diskFiles_.back();
+        auto range = diskIndex_.equal_range(oldest.key);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (iter->second == std::prev(diskFiles_.end()))
+            {
+                diskIndex_.erase(iter);
+                break;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::remove(utils::toNativePath(oldest.fileName), ec);
+        diskSize_ -= oldest.size;
+        diskFiles_.pop_back();
+    }
+}
+
+std::vector<HttpClientCache::EntryPtr> HttpClientCache::readFromDisk(
+    const std::string &key)
+{
+    std::vector<EntryPtr> result;
+    auto range = diskIndex_.equal_range(key);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        auto &fileName = iter->second->fileName;
+        std::ifstream file(utils::toNativePath(fileName), std::ios::binary);
+        auto entry = std::make_shared<Entry>();
+        auto resp = std::make_shared<HttpResponseImpl>();
+        int status{0};
+        int64_t requestTime{0}, responseTime{0};
+        size_t count{0};
+        std::getline(file, entry->key);
+        file >> status >> requestTime >> responseTime >> count;
+        file.ignore();
+        for (size_t i = 0; i < count && file; ++i)
+        {
+            std::string name, value;
+            std::getline(file, name);
+            std::getline(file, value);
+            entry->varyValues.emplace_back(std::move(name), std::move(value));
+        }
+        file >> count;
+        file.ignore();
+        for (size_t i = 0; i < count && file; ++i)
+        {
+            std::string name, value;
+            std::getline(file, name);
+            std::getline(file, value);
+            resp->addHeader(std::move(name), std::move(value));
+        }
+        file >> count;
+        file.ignore();
+        for (size_t i = 0; i < count && file; ++i)
+        {
+            std::string line;
+            std::getline(file, line);
+            auto colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+            resp->addHeader(line.data(),
+                            line.data() + colon,
+                            line.data() + line.size());
+        }
+        size_t bodyLength{0};
+        file >> bodyLength;
+        file.ignore();
+        std::string body(bodyLength, '\0');
+        file.read(body.data(), static_cast<std::streamsize>(bodyLength));
+        if (!file || entry->key != key)
+        {
+            LOG_ERROR << "Invalid cache file " << fileName;
+            continue;
+        }
+        resp->setStatusCode(static_cast<HttpStatusCode>(status));
+        resp->setBody(std::move(body));
+        entry->response = std::move(resp);
+        entry->requestTime = trantor::Date(requestTime);
+        entry->responseTime = trantor::Date(responseTime);
+        entry->size = iter->second->size;
+        result.emplace_back(std::move(entry));
+    }
+    removeFromDisk(key);
+    return result;
+}
+
+void HttpClientCache::removeFromDisk(const std::string &key)
+{
+    auto range = diskIndex_.equal_range(key);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        std::error_code ec;
+        std::filesystem::remove(utils::toNativePath(iter->second->fileName),
+                                ec);
+        diskSize_ -= iter->second->size;
+        diskFiles_.erase(iter->second);
+    }
+    diskIndex_.erase(range.first, range.second);
+}
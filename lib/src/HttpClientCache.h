@@ -0,0 +1,173 @@
+/**
+ *
+ *  @file HttpClientCache.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The parsed directives of a Cache-Control header, a negative value
+ * means the directive is absent.
+ */
+struct CacheControl
+{
+    bool noStore{false};
+    bool noCache{false};
+    bool mustRevalidate{false};
+    bool onlyIfCached{false};
+    bool isPublic{false};
+    long long maxAge{-1};
+    long long sMaxAge{-1};
+    long long maxStale{-1};
+    long long minFresh{-1};
+    long long staleWhileRevalidate{-1};
+    long long staleIfError{-1};
+
+    static CacheControl parse(const std::string &header);
+};
+
+/**
+ * @brief A private cache (RFC 9111) for the GET requests of a http client.
+ * Fresh responses are served from the cache, stale ones are revalidated with
+ * conditional requests, or served immediately and revalidated in background
+ * within their stale-while-revalidate window. Concurrent misses of the same
+ * request with the same credentials are merged into one upstream request.
+ * The responses to requests with an Authorization header are only stored if
+ * the server allows sharing them (RFC 9111 3.5).
+ * The responses are kept in memory in LRU order, those evicted from memory
+ * are optionally kept in a directory.
+ * @note All methods are called in the event loop of the client.
+ */
+class DROGON_EXPORT HttpClientCache
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<HttpClientCache>
+{
+  public:
+    /// Sends a request to the server, bypassing the cache.
+    using UpstreamFunction =
+        std::function<void(const HttpRequestPtr &, HttpReqCallback &&)>;
+
+    HttpClientCache(HttpClientCacheConfig config, UpstreamFunction upstream);
+    ~HttpClientCache();
+
+    /**
+     * @brief Send a request through the cache. Requests that can't be served
+     * from the cache are passed to the upstream function.
+     */
+    void sendRequest(const HttpRequestPtr &req, HttpReqCallback &&callback);
+
+    const HttpClientCacheStats &stats() const
+    {
+        return stats_;
+    }
+
+    size_t memorySize() const
+    {
+        return memorySize_;
+    }
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        HttpResponsePtr response;
+        // The values of the request headers listed in the Vary header
+        std::vector<std::pair<std::string, std::string>> varyValues;
+        trantor::Date requestTime;
+        trantor::Date responseTime;
+        size_t size{0};
+    };
+
+    struct DiskFile
+    {
+        std::string key;
+        std::string fileName;
+        size_t size{0};
+    };
+
+    using EntryPtr = std::shared_ptr<Entry>;
+    using Waiters = std::vector<std::pair<HttpRequestPtr, HttpReqCallback>>;
+
+    static std::string makeKey(const HttpRequestPtr &req);
+    static bool isStorable(const HttpRequestPtr &req,
+                           const HttpResponsePtr &resp);
+    static double freshnessLifetime(const Entry &entry);
+    static double currentAge(const Entry &entry);
+    static HttpResponsePtr copyResponse(const HttpResponsePtr &resp);
+    static HttpRequestPtr copyRequest(const HttpRequestPtr &req);
+    static bool varyMatches(const Entry &entry, const HttpRequestPtr &req);
+
+    static std::string flightKey(const std::string &key,
+                                 const HttpRequestPtr &req);
+
+    void fetch(const std::string &key,
+               const std::string &flight,
+               const HttpRequestPtr &req,
+               const EntryPtr &entry);
+    void handleResponse(const std::string &key,
+                        const std::string &flight,
+                        const HttpRequestPtr &req,
+                        const EntryPtr &entry,
+                        const trantor::Date &requestTime,
+                        ReqResult result,
+                        const HttpResponsePtr &resp);
+    void respond(const EntryPtr &entry, const HttpReqCallback &callback);
+
+    EntryPtr find(const std::string &key, const HttpRequestPtr &req);
+    EntryPtr store(const std::string &key,
+                   const HttpRequestPtr &req,
+                   const HttpResponsePtr &resp,
+                   const trantor::Date &requestTime);
+    void insert(const EntryPtr &entry);
+    void erase(EntryPtr entry);
+    void remove(const std::string &key);
+    void invalidate(const std::string &target);
+    void touch(const EntryPtr &entry);
+    void evict();
+
+    std::string diskFileName(const Entry &entry) const;
+    void writeToDisk(const EntryPtr &entry);
+    std::vector<EntryPtr> readFromDisk(const std::string &key);
+    void removeFromDisk(const std::string &key);
+
+    const HttpClientCacheConfig config_;
+    UpstreamFunction upstream_;
+    // The variants of a request are stored under the same key
+    std::unordered_map<std::string, std::vector<EntryPtr>> entries_;
+    // LRU order, the most recently used entry is at the front
+    std::list<EntryPtr> lru_;
+    std::unordered_map<Entry *, std::list<EntryPtr>::iterator> lruIndex_;
+    size_t memorySize_{0};
+    // The entries evicted from the memory, in LRU order
+    std::list<DiskFile> diskFiles_;
+    std::unordered_multimap<std::string, std::list<DiskFile>::iterator>
+        diskIndex_;
+    size_t diskSize_{0};
+    // The requests waiting for the response of the same upstream request, by
+    // the key and the credentials of the request
+    std::unordered_map<std::string, Waiters> inflight_;
+    HttpClientCacheStats stats_;
+};
+}  // namespace drogon
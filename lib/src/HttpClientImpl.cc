@@ -13,14 +13,19 @@
  */
 
 #include "HttpClientImpl.h"
+#include "DnsCache.h"
+#include "HttpClientCache.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpResponseParser.h"
 
 #include <drogon/config.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Histogram.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <mutex>
 
 using namespace trantor;
 using namespace drogon;
@@ -28,14 +33,83 @@ using namespace std::placeholders;
 
 namespace trantor
 {
-static const size_t kDefaultDNSTimeout{600};
-}
+// Resolved hosts are cached by the DnsCache, so the cache of the resolver
+// itself is kept short to make the TTL of the DnsCache effective.
+static const size_t kDefaultDNSTimeout{1};
+}  // namespace trantor
+
+// The delay before racing the next address while a connection attempt is
+// pending (the Connection Attempt Delay of RFC 8305).
+static const double kConnectionAttemptDelay{0.25};
+
+// The interval of the connection maintenance of clients with keepalive
+// enabled.
+static const double kKeepAliveTick{1.0};
+
+namespace
+{
+// The handshake time histograms shared by all clients, they are created when
+// registered to a registry.
+class HandshakeMetrics
+{
+  public:
+    static HandshakeMetrics &instance()
+    {
+        static HandshakeMetrics metrics;
+        return metrics;
+    }
+
+    void registerTo(monitoring::Registry &registry)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (collector_)
+            return;
+        collector_ = std::make_shared<
+            monitoring::Collector<monitoring::Histogram>>(
+            "drogon_http_client_handshake_seconds",
+            "The time of the TCP and TLS handshakes of the connections of "
+            "http clients",
+            std::vector<std::string>{"scheme"});
+        const std::vector<double> buckets{
+            0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5};
+        // The histograms never expire, the loop isn't used by them.
+        auto loop = HttpAppFrameworkImpl::instance().getLoop();
+        http_ = collector_->metric(
+            {"http"}, buckets, std::chrono::duration<double>(0), 0, loop);
+        https_ = collector_->metric(
+            {"https"}, buckets, std::chrono::duration<double>(0), 0, loop);
+        collector_->registerTo(registry);
+    }
+
+    void observe(bool secure, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &histogram = secure ? https_ : http_;
+        if (histogram)
+            histogram->observe(seconds);
+    }
+
+  private:
+    std::mutex mutex_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>> collector_;
+    std::shared_ptr<monitoring::Histogram> http_;
+    std::shared_ptr<monitoring::Histogram> https_;
+};
+}  // namespace
 
 void HttpClientImpl::createTcpClient()
 {
-    LOG_TRACE << "New TcpClient," << serverAddr_.toIpPort();
-    tcpClientPtr_ =
-        std::make_shared<trantor::TcpClient>(loop_, serverAddr_, "httpClient");
+    tcpClientPtr_ = makeTcpClient(serverAddr_);
+    tcpClientPtr_->connect();
+    startConnectionRace();
+}
+
+std::shared_ptr<trantor::TcpClient> HttpClientImpl::makeTcpClient(
+    const trantor::InetAddress &addr)
+{
+    LOG_TRACE << "New TcpClient," << addr.toIpPort();
+    auto tcpClientPtr =
+        std::make_shared<trantor::TcpClient>(loop_, addr, "httpClient");
 
     if (useSSL_ && utils::supportsTls())
     {
@@ -48,42 +122,60 @@ void HttpClientImpl::createTcpClient()
             .setConfCmds(sslConfCmds_)
             .setCertPath(clientCertPath_)
             .setKeyPath(clientKeyPath_);
-        tcpClientPtr_->enableSSL(std::move(policy));
+        tcpClientPtr->enableSSL(std::move(policy));
     }
 
     auto thisPtr = shared_from_this();
     std::weak_ptr<HttpClientImpl> weakPtr = thisPtr;
-    tcpClientPtr_->setSockOptCallback([weakPtr](int fd) {
+    // Identifies the tcp client in the callbacks, the racing clients share
+    // the callbacks.
+    auto client = tcpClientPtr.get();
+    auto startTime = trantor::Date::now();
+    tcpClientPtr->setSockOptCallback([weakPtr](int fd) {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
         if (thisPtr->sockOptCallback_)
             thisPtr->sockOptCallback_(fd);
     });
-    tcpClientPtr_->setConnectionCallback(
-        [weakPtr](const trantor::TcpConnectionPtr &connPtr) {
+    tcpClientPtr->setConnectionCallback(
+        [weakPtr, client, startTime](
+            const trantor::TcpConnectionPtr &connPtr) {
             auto thisPtr = weakPtr.lock();
             if (!thisPtr)
                 return;
             if (connPtr->connected())
             {
+                if (client == thisPtr->replacementClientPtr_.get())
+                {
+                    connPtr->setContext(
+                        std::make_shared<HttpResponseParser>(connPtr));
+                    thisPtr->recordHandshake(startTime);
+                    if (thisPtr->pipeliningCallbacks_.empty())
+                        thisPtr->swapInReplacement();
+                    return;
+                }
+                if (!thisPtr->adoptTcpClient(client))
+                {
+                    // Lost the race
+                    connPtr->forceClose();
+                    return;
+                }
                 connPtr->setContext(
                     std::make_shared<HttpResponseParser>(connPtr));
+                thisPtr->recordHandshake(startTime);
                 // send request;
                 LOG_TRACE << "Connection established!";
-                while (thisPtr->pipeliningCallbacks_.size() <=
-                           thisPtr->pipeliningDepth_ &&
-                       !thisPtr->requestsBuffer_.empty())
-                {
-                    thisPtr->sendReq(connPtr,
-                                     thisPtr->requestsBuffer_.front().first);
-                    thisPtr->pipeliningCallbacks_.push(
-                        std::move(thisPtr->requestsBuffer_.front()));
-                    thisPtr->requestsBuffer_.pop_front();
-                }
+                thisPtr->sendBufferedRequests(connPtr);
             }
             else
             {
+                if (client != thisPtr->tcpClientPtr_.get())
+                {
+                    if (client == thisPtr->replacementClientPtr_.get())
+                        thisPtr->replacementClientPtr_.reset();
+                    return;
+                }
                 LOG_TRACE << "connection disconnect";
                 auto responseParser = connPtr->getContext<HttpResponseParser>();
                 if (responseParser && responseParser->parseResponseOnClose() &&
@@ -106,17 +198,25 @@ void HttpClientImpl::createTcpClient()
                     }
                     return;
                 }
+                if (thisPtr->pipeliningCallbacks_.empty() &&
+                    thisPtr->replacementClientPtr_ &&
+                    thisPtr->replacementClientPtr_->connection())
+                {
+                    // Closed by the server while idle, the replacement takes
+                    // over at once.
+                    thisPtr->swapInReplacement();
+                    return;
+                }
                 thisPtr->onError(ReqResult::NetworkFailure);
             }
         });
-    tcpClientPtr_->setConnectionErrorCallback([weakPtr]() {
+    tcpClientPtr->setConnectionErrorCallback([weakPtr, client]() {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
-        // can't connect to server
-        thisPtr->onError(ReqResult::BadServerAddress);
+        thisPtr->handleConnectionError(client);
     });
-    tcpClientPtr_->setMessageCallback(
+    tcpClientPtr->setMessageCallback(
         [weakPtr](const trantor::TcpConnectionPtr &connPtr,
                   trantor::MsgBuffer *msg) {
             auto thisPtr = weakPtr.lock();
@@ -125,10 +225,18 @@ void HttpClientImpl::createTcpClient()
                 thisPtr->onRecvMessage(connPtr, msg);
             }
         });
-    tcpClientPtr_->setSSLErrorCallback([weakPtr](SSLError err) {
+    tcpClientPtr->setSSLErrorCallback([weakPtr, client](SSLError err) {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
+        if (client != thisPtr->tcpClientPtr_.get())
+        {
+            if (client == thisPtr->racingClientPtr_.get())
+                thisPtr->racingClientPtr_.reset();
+            else if (client == thisPtr->replacementClientPtr_.get())
+                thisPtr->replacementClientPtr_.reset();
+            return;
+        }
         if (err == trantor::SSLError::kSSLHandshakeError)
             thisPtr->onError(ReqResult::HandshakeError);
         else if (err == trantor::SSLError::kSSLInvalidCertificate)
@@ -141,7 +249,229 @@ void HttpClientImpl::createTcpClient()
             abort();
         }
     });
-    tcpClientPtr_->connect();
+    return tcpClientPtr;
+}
+
+bool HttpClientImpl::nextAddress(trantor::InetAddress &addr)
+{
+    if (addressIndex_ + 1 >= addresses_.size())
+        return false;
+    addr = addresses_[++addressIndex_];
+    return true;
+}
+
+void HttpClientImpl::startConnectionRace()
+{
+    if (addressIndex_ + 1 >= addresses_.size())
+        return;
+    if (raceTimerId_ != trantor::InvalidTimerId)
+        loop_->invalidateTimer(raceTimerId_);
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    raceTimerId_ = loop_->runAfter(kConnectionAttemptDelay, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->raceTimerId_ = trantor::InvalidTimerId;
+        if (!thisPtr->tcpClientPtr_ || thisPtr->tcpClientPtr_->connection() ||
+            thisPtr->racingClientPtr_)
+            return;
+        trantor::InetAddress addr;
+        if (!thisPtr->nextAddress(addr))
+            return;
+        LOG_TRACE << "Racing " << addr.toIpPort() << " against "
+                  << thisPtr->serverAddr_.toIpPort();
+        thisPtr->racingClientPtr_ = thisPtr->makeTcpClient(addr);
+        thisPtr->racingClientPtr_->connect();
+    });
+}
+
+void HttpClientImpl::stopConnectionRace()
+{
+    if (raceTimerId_ != trantor::InvalidTimerId)
+    {
+        loop_->invalidateTimer(raceTimerId_);
+        raceTimerId_ = trantor::InvalidTimerId;
+    }
+    racingClientPtr_.reset();
+}
+
+bool HttpClientImpl::adoptTcpClient(trantor::TcpClient *client)
+{
+    if (racingClientPtr_ && client == racingClientPtr_.get())
+    {
+        // The racing attempt wins, the pending one is dropped.
+        tcpClientPtr_ = std::move(racingClientPtr_);
+        serverAddr_ = addresses_[addressIndex_];
+    }
+    else if (client != tcpClientPtr_.get())
+    {
+        return false;
+    }
+    stopConnectionRace();
+    connectedTime_ = trantor::Date::now();
+    lastActivity_ = connectedTime_;
+    return true;
+}
+
+void HttpClientImpl::handleConnectionError(trantor::TcpClient *client)
+{
+    if (replacementClientPtr_ && client == replacementClientPtr_.get())
+    {
+        // Keep the current connection, the replacement is retried by the
+        // next maintenance.
+        replacementClientPtr_.reset();
+        return;
+    }
+    if (racingClientPtr_ && client == racingClientPtr_.get())
+    {
+        racingClientPtr_.reset();
+        startConnectionRace();
+        return;
+    }
+    if (client != tcpClientPtr_.get())
+        return;
+    if (racingClientPtr_)
+    {
+        // Keep waiting for the racing attempt
+        tcpClientPtr_ = std::move(racingClientPtr_);
+        serverAddr_ = addresses_[addressIndex_];
+        startConnectionRace();
+        return;
+    }
+    trantor::InetAddress addr;
+    if (nextAddress(addr))
+    {
+        LOG_DEBUG << "Failed to connect to " << serverAddr_.toIpPort()
+                  << ", try " << addr.toIpPort();
+        serverAddr_ = addr;
+        createTcpClient();
+        return;
+    }
+    // can't connect to server
+    onError(ReqResult::BadServerAddress);
+}
+
+void HttpClientImpl::sendBufferedRequests(
+    const trantor::TcpConnectionPtr &connPtr)
+{
+    while (pipeliningCallbacks_.size() <= pipeliningDepth_ &&
+           !requestsBuffer_.empty())
+    {
+        sendReq(connPtr, requestsBuffer_.front().first);
+        pipeliningCallbacks_.push(std::move(requestsBuffer_.front()));
+        requestsBuffer_.pop_front();
+    }
+}
+
+void HttpClientImpl::recordHandshake(const trantor::Date &startTime)
+{
+    auto seconds = static_cast<double>(
+                       trantor::Date::now().microSecondsSinceEpoch() -
+                       startTime.microSecondsSinceEpoch()) /
+                   1000000.0;
+    ++connectionStats_.connections;
+    connectionStats_.lastHandshakeTime = seconds;
+    totalHandshakeTime_ += seconds;
+    connectionStats_.averageHandshakeTime =
+        totalHandshakeTime_ / static_cast<double>(connectionStats_.connections);
+    HandshakeMetrics::instance().observe(useSSL_, seconds);
+}
+
+void HttpClientImpl::maintainConnection()
+{
+    if (!tcpClientPtr_)
+    {
+        if (keepAliveConfig_.prewarm && !dns_)
+            connectToServer();
+        return;
+    }
+    auto connPtr = tcpClientPtr_->connection();
+    if (!connPtr || connPtr->disconnected())
+        return;
+    if (replacementClientPtr_)
+    {
+        if (replacementClientPtr_->connection() &&
+            pipeliningCallbacks_.empty())
+            swapInReplacement();
+        return;
+    }
+    auto now = trantor::Date::now();
+    if (keepAliveConfig_.maxConnectionAge > 0 &&
+        now > connectedTime_.after(keepAliveConfig_.maxConnectionAge))
+    {
+        startReplacement();
+        return;
+    }
+    if (keepAliveConfig_.probeInterval > 0 && !probing_ &&
+        pipeliningCallbacks_.empty() && requestsBuffer_.empty() &&
+        now > lastActivity_.after(keepAliveConfig_.probeInterval))
+    {
+        sendProbe();
+    }
+}
+
+void HttpClientImpl::sendProbe()
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(keepAliveConfig_.probeMethod);
+    req->setPath(keepAliveConfig_.probePath);
+    // Not answered by the response cache (or any other), a cached response
+    // says nothing about the connection
+    req->addHeader("cache-control", "no-store");
+    probing_ = true;
+    ++connectionStats_.probes;
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    auto client = tcpClientPtr_.get();
+    sendRequestInLoop(
+        req,
+        [weakPtr, client](ReqResult result, const HttpResponsePtr &resp) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->probing_ = false;
+            if (result == ReqResult::Ok &&
+                static_cast<int>(resp->statusCode()) < 500)
+                return;
+            ++thisPtr->connectionStats_.failedProbes;
+            LOG_WARN << "The probe of " << thisPtr->host() << " failed";
+            if (client != thisPtr->tcpClientPtr_.get())
+                return;
+            if (result == ReqResult::Ok)
+            {
+                // The server is unhealthy, try another connection
+                thisPtr->startReplacement();
+                return;
+            }
+            // No response, the connection is dead and so are the requests
+            // sent after the probe.
+            thisPtr->onError(ReqResult::NetworkFailure);
+        },
+        keepAliveConfig_.probeTimeout);
+}
+
+void HttpClientImpl::startReplacement()
+{
+    LOG_TRACE << "Replace the connection to " << serverAddr_.toIpPort();
+    replacementClientPtr_ = makeTcpClient(serverAddr_);
+    replacementClientPtr_->connect();
+}
+
+void HttpClientImpl::swapInReplacement()
+{
+    auto oldClientPtr = std::move(tcpClientPtr_);
+    tcpClientPtr_ = std::move(replacementClientPtr_);
+    connectedTime_ = trantor::Date::now();
+    lastActivity_ = connectedTime_;
+    if (oldClientPtr)
+    {
+        ++connectionStats_.replacements;
+        auto oldConnPtr = oldClientPtr->connection();
+        if (oldConnPtr)
+            oldConnPtr->shutdown();
+    }
+    auto connPtr = tcpClientPtr_->connection();
+    if (connPtr)
+        sendBufferedRequests(connPtr);
 }
 
 HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
@@ -259,6 +589,8 @@ HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
 HttpClientImpl::~HttpClientImpl()
 {
     LOG_TRACE << "Deconstruction HttpClient";
+    if (keepAliveTimerId_ != trantor::InvalidTimerId)
+        loop_->invalidateTimer(keepAliveTimerId_);
     if (resolverPtr_ && !(loop_->isInLoopThread()))
     {
         // Make sure the resolverPtr_ is destroyed in the correct thread.
@@ -382,8 +714,91 @@ static bool isValidIpAddr(const trantor::InetAddress &addr)
     return false;
 }
 
+void HttpClientImpl::connectToServer()
+{
+    if (domain_.empty() || !isDomainName_)
+    {
+        // Valid ip address, no domain, connect directly
+        if (isValidIpAddr(serverAddr_))
+        {
+            createTcpClient();
+        }
+        // No ip address and no domain, respond with BadServerAddress
+        else
+        {
+            onError(ReqResult::BadServerAddress);
+        }
+        return;
+    }
+
+    // A dns query is on going.
+    if (dns_)
+    {
+        return;
+    }
+
+    // The addresses of the domain are cached by the DnsCache, the clients
+    // of the domain connect to them in turn.
+    dns_ = true;
+    if (!resolverPtr_)
+    {
+        resolverPtr_ =
+            trantor::Resolver::newResolver(loop_, kDefaultDNSTimeout);
+    }
+    auto thisPtr = shared_from_this();
+    DnsCache::instance().resolve(
+        domain_,
+        [resolverPtr = resolverPtr_](const std::string &hostname,
+                                     DnsCache::AddressesCallback &&cb) {
+            resolverPtr->resolve(hostname, std::move(cb));
+        },
+        [thisPtr](const std::vector<trantor::InetAddress> &addrs) {
+            thisPtr->loop_->runInLoop([thisPtr, addrs]() {
+                thisPtr->dns_ = false;
+                // Retrieve port from old serverAddr_
+                auto port = thisPtr->serverAddr_.portNetEndian();
+                thisPtr->addresses_ = addrs;
+                thisPtr->addressIndex_ = 0;
+                for (auto &addr : thisPtr->addresses_)
+                {
+                    addr.setPortNetEndian(port);
+                }
+                if (!thisPtr->addresses_.empty() &&
+                    isValidIpAddr(thisPtr->addresses_[0]))
+                {
+                    thisPtr->serverAddr_ = thisPtr->addresses_[0];
+                    LOG_TRACE << "dns:domain=" << thisPtr->domain_
+                              << ";ip=" << thisPtr->serverAddr_.toIp();
+                    thisPtr->createTcpClient();
+                    return;
+                }
+
+                // DNS fail to get valid ip address,
+                // respond all requests with BadServerAddress
+                while (!(thisPtr->requestsBuffer_).empty())
+                {
+                    auto &reqAndCb = (thisPtr->requestsBuffer_).front();
+                    reqAndCb.second(ReqResult::BadServerAddress, nullptr);
+                    (thisPtr->requestsBuffer_).pop_front();
+                }
+            });
+        });
+}
+
 void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                        drogon::HttpReqCallback &&callback)
+{
+    loop_->assertInLoopThread();
+    if (cachePtr_)
+    {
+        cachePtr_->sendRequest(req, std::move(callback));
+        return;
+    }
+    sendRequestToServer(req, std::move(callback));
+}
+
+void HttpClientImpl::sendRequestToServer(const drogon::HttpRequestPtr &req,
+                                         drogon::HttpReqCallback &&callback)
 {
     loop_->assertInLoopThread();
     if (!static_cast<drogon::HttpRequestImpl *>(req.get())->passThrough())
@@ -391,6 +806,8 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
         req->addHeader("connection", "Keep-Alive");
         if (!userAgent_.empty())
             req->addHeader("user-agent", userAgent_);
+        if (compressionDictionary_)
+            addDictionaryHeaders(req);
     }
     // Set the host header if not already set
     if (req->getHeader("host").empty())
@@ -417,74 +834,14 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
 
     if (!tcpClientPtr_)
     {
-        auto callbackPtr =
-            std::make_shared<drogon::HttpReqCallback>(std::move(callback));
         requestsBuffer_.push_back(
             {req,
              [thisPtr = shared_from_this(),
-              callbackPtr](ReqResult result, const HttpResponsePtr &response) {
-                 (*callbackPtr)(result, response);
+              callback = std::move(callback)](ReqResult result,
+                                              const HttpResponsePtr &response) {
+                 callback(result, response);
              }});
-
-        if (domain_.empty() || !isDomainName_)
-        {
-            // Valid ip address, no domain, connect directly
-            if (isValidIpAddr(serverAddr_))
-            {
-                createTcpClient();
-            }
-            // No ip address and no domain, respond with BadServerAddress
-            else
-            {
-                requestsBuffer_.pop_front();
-                (*callbackPtr)(ReqResult::BadServerAddress, nullptr);
-                assert(requestsBuffer_.empty());
-            }
-            return;
-        }
-
-        // A dns query is on going.
-        if (dns_)
-        {
-            return;
-        }
-
-        // Always do dns query when (re)connects a domain.
-        dns_ = true;
-        if (!resolverPtr_)
-        {
-            resolverPtr_ =
-                trantor::Resolver::newResolver(loop_, kDefaultDNSTimeout);
-        }
-        auto thisPtr = shared_from_this();
-        resolverPtr_->resolve(
-            domain_, [thisPtr](const trantor::InetAddress &addr) {
-                thisPtr->loop_->runInLoop([thisPtr, addr]() {
-                    // Retrieve port from old serverAddr_
-                    auto port = thisPtr->serverAddr_.portNetEndian();
-                    thisPtr->serverAddr_ = addr;
-                    thisPtr->serverAddr_.setPortNetEndian(port);
-                    LOG_TRACE << "dns:domain=" << thisPtr->domain_
-                              << ";ip=" << thisPtr->serverAddr_.toIp();
-                    thisPtr->dns_ = false;
-
-                    if (isValidIpAddr(thisPtr->serverAddr_))
-                    {
-                        thisPtr->createTcpClient();
-                        return;
-                    }
-
-                    // DNS fail to get valid ip address,
-                    // respond all requests with BadServerAddress
-                    while (!(thisPtr->requestsBuffer_).empty())
-                    {
-                        auto &reqAndCb = (thisPtr->requestsBuffer_).front();
-                        reqAndCb.second(ReqResult::BadServerAddress, nullptr);
-                        (thisPtr->requestsBuffer_).pop_front();
-                    }
-                });
-            });
-
+        connectToServer();
         return;
     }
 
@@ -540,9 +897,45 @@ void HttpClientImpl::sendReq(const trantor::TcpConnectionPtr &connPtr,
     LOG_TRACE << "Send request:"
               << std::string(buffer.peek(), buffer.readableBytes());
     bytesSent_ += buffer.readableBytes();
+    lastActivity_ = trantor::Date::now();
     connPtr->send(std::move(buffer));
 }
 
+void HttpClientImpl::addDictionaryHeaders(const HttpRequestPtr &req) const
+{
+    auto &acceptEncoding = req->getHeader("accept-encoding");
+    std::string encodings;
+    for (auto encoding : {CompressionDictionary::Encoding::kBrotli,
+                          CompressionDictionary::Encoding::kZstd})
+    {
+        auto name = CompressionDictionary::name(encoding);
+        // The request may be sent again, e.g. on a redirection
+        if (CompressionDictionary::supports(encoding) &&
+            acceptEncoding.find(name) == std::string::npos)
+            encodings.append(name).append(", ");
+    }
+    if (encodings.empty())
+        return;
+    if (acceptEncoding.empty())
+    {
+        // The encodings handleResponse() decodes without the dictionary
+#ifdef USE_BROTLI
+        encodings.append("br, ");
+#endif
+        encodings.append("gzip");
+    }
+    else
+    {
+        encodings.append(acceptEncoding);
+    }
+    req->addHeader("accept-encoding", std::move(encodings));
+    req->addHeader("available-dictionary",
+                   compressionDictionary_->availableDictionary());
+    if (!compressionDictionary_->id().empty())
+        req->addHeader("dictionary-id",
+                       "\"" + compressionDictionary_->id() + "\"");
+}
+
 void HttpClientImpl::handleResponse(
     const HttpResponseImplPtr &resp,
     std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb,
@@ -551,7 +944,12 @@ void HttpClientImpl::handleResponse(
     assert(!pipeliningCallbacks_.empty());
     auto &type = resp->getHeaderBy("content-type");
     auto &coding = resp->getHeaderBy("content-encoding");
-    if (coding == "gzip")
+    if (auto encoding = CompressionDictionary::encodingOf(coding))
+    {
+        if (compressionDictionary_)
+            resp->decompressWithDictionary(*compressionDictionary_, *encoding);
+    }
+    else if (coding == "gzip")
     {
         resp->gunzip();
     }
@@ -605,6 +1003,7 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
 
     // LOG_TRACE << "###:" << msg->readableBytes();
     auto msgSize = msg->readableBytes();
+    lastActivity_ = trantor::Date::now();
     while (msg->readableBytes() > 0)
     {
         if (pipeliningCallbacks_.empty())
@@ -657,6 +1056,31 @@ HttpClientPtr HttpClient::newHttpClient(const std::string &ip,
         validateCert);
 }
 
+void HttpClient::setDnsCacheTtl(double ttl, double negativeTtl)
+{
+    DnsCache::instance().setTtl(ttl, negativeTtl);
+}
+
+DnsCacheStats HttpClient::getDnsCacheStats()
+{
+    return DnsCache::instance().stats();
+}
+
+void HttpClient::clearDnsCache()
+{
+    DnsCache::instance().clear();
+}
+
+void HttpClient::enableDnsCacheMetrics(monitoring::Registry &registry)
+{
+    DnsCache::instance().registerMetrics(registry);
+}
+
+void HttpClient::enableConnectionMetrics(monitoring::Registry &registry)
+{
+    HandshakeMetrics::instance().registerTo(registry);
+}
+
 HttpClientPtr HttpClient::newHttpClient(const std::string &hostString,
                                         trantor::EventLoop *loop,
                                         bool useOldTLS,
@@ -683,9 +1107,78 @@ void HttpClientImpl::onError(ReqResult result)
         requestsBuffer_.pop_front();
         cb(result, nullptr);
     }
+    stopConnectionRace();
     tcpClientPtr_.reset();
 }
 
+void HttpClientImpl::enableCache(const HttpClientCacheConfig &config)
+{
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    loop_->runInLoop([weakPtr, config]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->cachePtr_ = std::make_shared<HttpClientCache>(
+            config,
+            [weakPtr](const HttpRequestPtr &req, HttpReqCallback &&callback) {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr)
+                {
+                    callback(ReqResult::NetworkFailure, nullptr);
+                    return;
+                }
+                thisPtr->sendRequestToServer(req, std::move(callback));
+            });
+    });
+}
+
+HttpClientCacheStats HttpClientImpl::getCacheStats()
+{
+    if (loop_->isInLoopThread())
+    {
+        return cachePtr_ ? cachePtr_->stats() : HttpClientCacheStats{};
+    }
+    std::promise<HttpClientCacheStats> stats;
+    loop_->queueInLoop([this, &stats]() {
+        stats.set_value(cachePtr_ ? cachePtr_->stats()
+                                  : HttpClientCacheStats{});
+    });
+    return stats.get_future().get();
+}
+
+void HttpClientImpl::enableKeepAlive(const HttpClientKeepAliveConfig &config)
+{
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    loop_->runInLoop([weakPtr, config]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->keepAliveConfig_ = config;
+        if (thisPtr->keepAliveTimerId_ == trantor::InvalidTimerId)
+        {
+            thisPtr->keepAliveTimerId_ =
+                thisPtr->loop_->runEvery(kKeepAliveTick, [weakPtr]() {
+                    auto thisPtr = weakPtr.lock();
+                    if (thisPtr)
+                        thisPtr->maintainConnection();
+                });
+        }
+        if (config.prewarm && !thisPtr->tcpClientPtr_ && !thisPtr->dns_)
+            thisPtr->connectToServer();
+    });
+}
+
+HttpClientConnectionStats HttpClientImpl::getConnectionStats()
+{
+    if (loop_->isInLoopThread())
+    {
+        return connectionStats_;
+    }
+    std::promise<HttpClientConnectionStats> stats;
+    loop_->queueInLoop([this, &stats]() { stats.set_value(connectionStats_); });
+    return stats.get_future().get();
+}
+
 void HttpClientImpl::handleCookies(const HttpResponseImplPtr &resp)
 {
     loop_->assertInLoopThread();
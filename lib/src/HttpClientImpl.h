@@ -30,6 +30,8 @@
 
 namespace drogon
 {
+class HttpClientCache;
+
 class HttpClientImpl final : public HttpClient,
                              public std::enable_shared_from_this<HttpClientImpl>
 {
@@ -92,6 +94,11 @@ class HttpClientImpl final : public HttpClient,
         userAgent_ = userAgent;
     }
 
+    void setCompressionDictionary(CompressionDictionaryPtr dictionary) override
+    {
+        compressionDictionary_ = std::move(dictionary);
+    }
+
     uint16_t port() const override
     {
         return serverAddr_.toPort();
@@ -118,6 +125,11 @@ class HttpClientImpl final : public HttpClient,
         sockOptCallback_ = std::move(cb);
     }
 
+    void enableCache(const HttpClientCacheConfig &config) override;
+    HttpClientCacheStats getCacheStats() override;
+    void enableKeepAlive(const HttpClientKeepAliveConfig &config) override;
+    HttpClientConnectionStats getConnectionStats() override;
+
     std::size_t requestsBufferSize() override
     {
         if (loop_->isInLoopThread())
@@ -139,6 +151,7 @@ class HttpClientImpl final : public HttpClient,
     trantor::InetAddress serverAddr_;
     bool useSSL_;
     bool validateCert_;
+    void addDictionaryHeaders(const HttpRequestPtr &req) const;
     void sendReq(const trantor::TcpConnectionPtr &connPtr,
                  const HttpRequestPtr &req);
     void sendRequestInLoop(const HttpRequestPtr &req,
@@ -146,11 +159,27 @@ class HttpClientImpl final : public HttpClient,
     void sendRequestInLoop(const HttpRequestPtr &req,
                            HttpReqCallback &&callback,
                            double timeout);
+    void sendRequestToServer(const HttpRequestPtr &req,
+                             HttpReqCallback &&callback);
     void handleCookies(const HttpResponseImplPtr &resp);
     void handleResponse(const HttpResponseImplPtr &resp,
                         std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb,
                         const trantor::TcpConnectionPtr &connPtr);
+    void connectToServer();
     void createTcpClient();
+    std::shared_ptr<trantor::TcpClient> makeTcpClient(
+        const trantor::InetAddress &addr);
+    bool nextAddress(trantor::InetAddress &addr);
+    void startConnectionRace();
+    void stopConnectionRace();
+    bool adoptTcpClient(trantor::TcpClient *client);
+    void handleConnectionError(trantor::TcpClient *client);
+    void sendBufferedRequests(const trantor::TcpConnectionPtr &connPtr);
+    void recordHandshake(const trantor::Date &startTime);
+    void maintainConnection();
+    void sendProbe();
+    void startReplacement();
+    void swapInReplacement();
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
     std::list<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
@@ -164,12 +193,31 @@ class HttpClientImpl final : public HttpClient,
     size_t bytesReceived_{0};
     bool dns_{false};
     std::shared_ptr<trantor::Resolver> resolverPtr_;
+    // The resolved addresses of domain_, tried in order on connection failures
+    std::vector<trantor::InetAddress> addresses_;
+    size_t addressIndex_{0};
+    // The connection attempt to the next address while the current one is
+    // pending (happy eyeballs).
+    std::shared_ptr<trantor::TcpClient> racingClientPtr_;
+    trantor::TimerId raceTimerId_{trantor::InvalidTimerId};
     bool useOldTLS_{false};
     std::string userAgent_{"DrogonClient"};
+    CompressionDictionaryPtr compressionDictionary_;
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
     std::string clientCertPath_;
     std::string clientKeyPath_;
     std::function<void(int)> sockOptCallback_;
+    std::shared_ptr<HttpClientCache> cachePtr_;
+    // Connection maintenance (see enableKeepAlive())
+    HttpClientKeepAliveConfig keepAliveConfig_;
+    trantor::TimerId keepAliveTimerId_{trantor::InvalidTimerId};
+    // The connection that takes over from tcpClientPtr_ once it is idle
+    std::shared_ptr<trantor::TcpClient> replacementClientPtr_;
+    trantor::Date connectedTime_;
+    trantor::Date lastActivity_;
+    bool probing_{false};
+    double totalHandshakeTime_{0.0};
+    HttpClientConnectionStats connectionStats_;
 };
 
 using HttpClientImplPtr = std::shared_ptr<HttpClientImpl>;
@@ -36,23 +36,24 @@ bool HttpConnectionLimit::tryAddConnection(
     {
         return false;
     }
-    if (maxConnectionNumPerIP_ > 0)
+    if (perIPLimit_->maxConnectionNumPerIP_ > 0)
     {
-        std::string ip = conn->peerAddr().toIp();
-        size_t numOnThisIp;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            numOnThisIp = (++ipConnectionsMap_[ip]);
-        }
-        if (numOnThisIp > maxConnectionNumPerIP_)
-        {
-            return false;
-        }
+        return perIPLimit_->tryAddIP(conn->peerAddr().toIp());
     }
 
     return true;
 }
 
+bool HttpConnectionLimit::tryAddIP(const std::string &ip)
+{
+    size_t numOnThisIp;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        numOnThisIp = (++ipConnectionsMap_[ip]);
+    }
+    return numOnThisIp <= maxConnectionNumPerIP_;
+}
+
 void HttpConnectionLimit::releaseConnection(
     const trantor::TcpConnectionPtr &conn)
 {
@@ -64,17 +65,21 @@ void HttpConnectionLimit::releaseConnection(
         return;
     }
     connectionNum_.fetch_sub(1, std::memory_order_relaxed);
-    if (maxConnectionNumPerIP_ > 0)
+    if (perIPLimit_->maxConnectionNumPerIP_ > 0)
     {
-        std::string ip = conn->peerAddr().toIp();
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto iter = ipConnectionsMap_.find(ip);
-        if (iter != ipConnectionsMap_.end())
+        perIPLimit_->releaseIP(conn->peerAddr().toIp());
+    }
+}
+
+void HttpConnectionLimit::releaseIP(const std::string &ip)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = ipConnectionsMap_.find(ip);
+    if (iter != ipConnectionsMap_.end())
+    {
+        if (--iter->second <= 0)
         {
-            if (--iter->second <= 0)
-            {
-                ipConnectionsMap_.erase(iter);
-            }
+            ipConnectionsMap_.erase(iter);
         }
     }
 }
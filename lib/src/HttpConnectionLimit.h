@@ -41,10 +41,31 @@ class HttpConnectionLimit
     void setMaxConnectionNum(size_t num);
     void setMaxConnectionNumPerIP(size_t num);
 
+    size_t getMaxConnectionNum() const
+    {
+        return maxConnectionNum_;
+    }
+
+    size_t getMaxConnectionNumPerIP() const
+    {
+        return maxConnectionNumPerIP_;
+    }
+
+    // Count the connections of each IP in another limit, whose limit per IP
+    // applies, so that the connections of an IP are counted once across the
+    // listeners with their own limits
+    void sharePerIPLimit(HttpConnectionLimit &limit)
+    {
+        perIPLimit_ = &limit;
+    }
+
     bool tryAddConnection(const trantor::TcpConnectionPtr &conn);
     void releaseConnection(const trantor::TcpConnectionPtr &conn);
 
   private:
+    bool tryAddIP(const std::string &ip);
+    void releaseIP(const std::string &ip);
+
     std::mutex mutex_;
 
     size_t maxConnectionNum_{100000};
@@ -52,5 +73,6 @@ class HttpConnectionLimit
 
     size_t maxConnectionNumPerIP_{0};
     std::unordered_map<std::string, size_t> ipConnectionsMap_;
+    HttpConnectionLimit *perIPLimit_{this};
 };
 }  // namespace drogon
@@ -671,16 +671,17 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
 
     if (!binder->queryParametersPlaces_.empty())
     {
-        auto &queryPara = req->getParameters();
+        // Only the bound parameters are decoded
+        auto &queryPara = req->parameterView();
         for (const auto &paraPlace : binder->queryParametersPlaces_)
         {
             auto place = paraPlace.second;
             if (place > params.size())
                 params.resize(place);
-            auto iter = queryPara.find(paraPlace.first);
-            if (iter != queryPara.end())
+            auto value = queryPara.get(paraPlace.first);
+            if (value)
             {
-                params[place - 1] = iter->second;
+                params[place - 1] = std::string(*value);
             }
             else
             {
@@ -72,63 +72,43 @@ void HttpRequestImpl::parseJson() const
     }
 }
 
-void HttpRequestImpl::parseParameters() const
+void HttpRequestImpl::resetParameters()
 {
-    auto input = queryView();
-    if (!input.empty())
+    if (!flagForParsingParameters_)
+        return;
+    flagForParsingParameters_ = false;
+    parameterView_.clearParsed();
+    if (flagForMaterializingParameters_)
     {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
-        {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos = value.find('&')) != std::string_view::npos)
+        SafeStringMap<std::string> parameters;
+        parameterView().materialize(parameters);
+        for (auto iter = parameters_.begin(); iter != parameters_.end();)
         {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
+            if (parameters.find(iter->first) == parameters.end())
+                iter = parameters_.erase(iter);
             else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
+                ++iter;
         }
-        if (value.length() > 0)
+        for (auto &param : parameters)
         {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
+            parameters_[param.first] = std::move(param.second);
         }
     }
+    for (auto &param : parameterCache_)
+    {
+        auto value = parameterView().get(param.first);
+        if (value)
+            param.second.assign(value->data(), value->size());
+        else
+            param.second.clear();
+    }
+}
+
+void HttpRequestImpl::parseParameters() const
+{
+    parameterView_.parse(queryView(), false);
 
-    input = contentView();
+    auto input = contentView();
     if (input.empty())
         return;
     std::string type = getHeaderBy("content-type");
@@ -138,55 +118,7 @@ void HttpRequestImpl::parseParameters() const
     if (type.empty() ||
         type.find("application/x-www-form-urlencoded") != std::string::npos)
     {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
-        {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos = value.find('&')) != std::string_view::npos)
-        {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
-        }
-        if (value.length() > 0)
-        {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-        }
+        parameterView_.parse(input, true);
     }
 }
 
@@ -568,6 +500,8 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(version_, that.version_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
     swap(flagForParsingParameters_, that.flagForParsingParameters_);
+    swap(flagForMaterializingParameters_,
+         that.flagForMaterializingParameters_);
     swap(matchedPathPattern_, that.matchedPathPattern_);
     swap(path_, that.path_);
     swap(originalPath_, that.originalPath_);
@@ -578,6 +512,8 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(contentLengthHeaderValue_, that.contentLengthHeaderValue_);
     swap(realContentLength_, that.realContentLength_);
     swap(parameters_, that.parameters_);
+    swap(parameterView_, that.parameterView_);
+    swap(parameterCache_, that.parameterCache_);
     swap(jsonPtr_, that.jsonPtr_);
     swap(sessionPtr_, that.sessionPtr_);
     swap(attributesPtr_, that.attributesPtr_);
@@ -1010,6 +946,7 @@ void HttpRequestImpl::setStreamReader(RequestStreamReaderPtr reader)
     assert(!streamReaderPtr_);
     assert(streamStatus_ > ReqStreamStatus::None);
 
+    requestBody();
     if (streamExceptionPtr_)
     {
         assert(streamStatus_ == ReqStreamStatus::Error);
@@ -1096,6 +1033,7 @@ void HttpRequestImpl::waitForStreamFinish(std::function<void()> &&cb)
     assert(loop_->isInLoopThread());
     assert(streamStatus_ > ReqStreamStatus::None);
 
+    requestBody();
     if (streamStatus_ <= ReqStreamStatus::Open)
     {
         assert(!streamFinishCb_);  // should only be called once
@@ -1107,10 +1045,33 @@ void HttpRequestImpl::waitForStreamFinish(std::function<void()> &&cb)
     }
 }
 
+void HttpRequestImpl::requestBody()
+{
+    if (!bodyDeferred_.exchange(false, std::memory_order_acq_rel))
+        return;
+    if (expectContinue_)
+    {
+        // rfc7231-5.1.1
+        expectContinue_ = false;
+        static const std::string continueResponse{
+            "HTTP/1.1 100 Continue\r\n\r\n"};
+        if (auto conn = connPtr_.lock())
+            conn->send(continueResponse);
+    }
+    if (bodyRequestedCb_)
+    {
+        auto cb = std::move(bodyRequestedCb_);
+        bodyRequestedCb_ = nullptr;
+        cb();
+    }
+}
+
 void HttpRequestImpl::quitStreamMode()
 {
     assert(loop_->isInLoopThread());
     assert(streamStatus_ >= ReqStreamStatus::Finish);
     assert(!streamReaderPtr_);
     streamStatus_ = ReqStreamStatus::None;
+    // The parameters may have been parsed before the body was received
+    resetParameters();
 }
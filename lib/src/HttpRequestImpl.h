@@ -29,6 +29,7 @@
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -76,12 +77,15 @@ class HttpRequestImpl : public HttpRequest
         contentLengthHeaderValue_.reset();
         realContentLength_ = 0;
         flagForParsingParameters_ = false;
+        flagForMaterializingParameters_ = false;
         path_.clear();
         originalPath_.clear();
         pathEncode_ = true;
         matchedPathPattern_ = "";
         query_.clear();
         parameters_.clear();
+        parameterView_.clear();
+        parameterCache_.clear();
         jsonPtr_.reset();
         sessionPtr_.reset();
         attributesPtr_.reset();
@@ -100,6 +104,9 @@ class HttpRequestImpl : public HttpRequest
         streamReaderPtr_.reset();
         streamFinishCb_ = nullptr;
         streamExceptionPtr_ = nullptr;
+        bodyDeferred_ = false;
+        expectContinue_ = false;
+        bodyRequestedCb_ = nullptr;
         startProcessing_ = false;
         connPtr_.reset();
     }
@@ -191,20 +198,49 @@ class HttpRequestImpl : public HttpRequest
         pathEncode_ = pathEncode;
     }
 
+    bool pathEncode() const
+    {
+        return pathEncode_;
+    }
+
     const SafeStringMap<std::string> &parameters() const override
     {
-        parseParametersOnce();
+        auto &view = parameterView();
+        if (!flagForMaterializingParameters_)
+        {
+            flagForMaterializingParameters_ = true;
+            view.materialize(parameters_);
+        }
         return parameters_;
     }
 
+    const ParameterView &parameterView() const override
+    {
+        parseParametersOnce();
+        // The query and the body may have moved since they were parsed
+        parameterView_.setSources(queryView(), contentView());
+        return parameterView_;
+    }
+
     const std::string &getParameter(const std::string &key) const override
     {
         static const std::string defaultVal;
-        parseParametersOnce();
-        auto iter = parameters_.find(key);
-        if (iter != parameters_.end())
+        if (flagForMaterializingParameters_)
+        {
+            auto iter = parameters_.find(key);
+            if (iter != parameters_.end())
+                return iter->second;
+            return defaultVal;
+        }
+        // Only the requested parameters are decoded and copied
+        auto iter = parameterCache_.find(key);
+        if (iter != parameterCache_.end())
             return iter->second;
-        return defaultVal;
+        auto value = parameterView().get(key);
+        if (!value)
+            return defaultVal;
+        return parameterCache_.emplace(key, std::string(*value))
+            .first->second;
     }
 
     const std::string &path() const override
@@ -220,13 +256,22 @@ class HttpRequestImpl : public HttpRequest
     void setQuery(const char *start, const char *end)
     {
         query_.assign(start, end);
+        resetParameters();
     }
 
     void setQuery(const std::string &query)
     {
         query_ = query;
+        resetParameters();
     }
 
+    /**
+     * @brief Parse the parameters again on the next access, after the query
+     * or the body changed. The parameters set by setParameter() are kept, and
+     * the values already returned by reference are updated in place.
+     */
+    void resetParameters();
+
     std::string_view bodyView() const
     {
         if (isStreamMode())
@@ -406,6 +451,12 @@ class HttpRequestImpl : public HttpRequest
     {
         flagForParsingParameters_ = true;
         parameters_[key] = value;
+        parameterView_.set(key, value);
+        // getParameter() returned references to the cached values, they are
+        // overwritten instead of erased
+        auto iter = parameterCache_.find(key);
+        if (iter != parameterCache_.end())
+            iter->second = value;
     }
 
     const std::string &getContent() const
@@ -418,16 +469,19 @@ class HttpRequestImpl : public HttpRequest
     void setContent(const std::string &content)
     {
         content_ = content;
+        resetParameters();
     }
 
     void setBody(const std::string &body) override
     {
         content_ = body;
+        resetParameters();
     }
 
     void setBody(std::string &&body) override
     {
         content_ = std::move(body);
+        resetParameters();
     }
 
     void addHeader(std::string field, const std::string &value) override
@@ -613,6 +667,30 @@ class HttpRequestImpl : public HttpRequest
     void waitForStreamFinish(std::function<void()> &&cb);
     void quitStreamMode();
 
+    // The body of a stream mode request is deferred until a handler asks for
+    // it, the 100 (Continue) response is sent at that point if the client
+    // expects it. Until then the parser leaves the body in the receive buffer
+    // of the connection.
+    void deferBody(bool expectContinue)
+    {
+        expectContinue_ = expectContinue;
+        bodyDeferred_ = true;
+    }
+
+    // Called in the loop of the connection when the deferred body is asked
+    // for, to parse what the connection has received so far.
+    void setBodyRequestedCallback(std::function<void()> &&cb)
+    {
+        bodyRequestedCb_ = std::move(cb);
+    }
+
+    bool isBodyDeferred() const
+    {
+        return bodyDeferred_;
+    }
+
+    void requestBody();
+
     void startProcessing()
     {
         startProcessing_ = true;
@@ -693,6 +771,7 @@ class HttpRequestImpl : public HttpRequest
     static constexpr const std::string_view emptySv_{""};
 
     mutable bool flagForParsingParameters_{false};
+    mutable bool flagForMaterializingParameters_{false};
     mutable bool flagForParsingJson_{false};
     HttpMethod method_{Invalid};
     HttpMethod previousMethod_{Invalid};
@@ -710,6 +789,9 @@ class HttpRequestImpl : public HttpRequest
     std::optional<size_t> contentLengthHeaderValue_;
     size_t realContentLength_{0};
     mutable SafeStringMap<std::string> parameters_;
+    mutable ParameterView parameterView_;
+    // The values returned by getParameter() before parameters_ is built
+    mutable SafeStringMap<std::string> parameterCache_;
     mutable std::shared_ptr<Json::Value> jsonPtr_;
     SessionPtr sessionPtr_;
     mutable AttributesPtr attributesPtr_;
@@ -729,6 +811,9 @@ class HttpRequestImpl : public HttpRequest
     std::function<void()> streamFinishCb_;
     RequestStreamReaderPtr streamReaderPtr_;
     std::exception_ptr streamExceptionPtr_;
+    std::atomic<bool> bodyDeferred_{false};
+    bool expectContinue_{false};
+    std::function<void()> bodyRequestedCb_;
     bool startProcessing_{false};
     std::weak_ptr<trantor::TcpConnection> connPtr_;
 
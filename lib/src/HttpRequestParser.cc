@@ -17,10 +17,12 @@
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/MsgBuffer.h>
 #include <iostream>
+#include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpUtils.h"
+#include "WebSocketConnectionImpl.h"
 
 using namespace trantor;
 using namespace drogon;
@@ -93,6 +95,12 @@ HttpRequestImplPtr HttpRequestParser::makeRequestForPool(HttpRequestImpl *ptr)
             {
                 if (thisPtr->loop_->isInLoopThread())
                 {
+                    if (thisPtr->releasingPool_)
+                    {
+                        // The parser is releasing its idle buffers
+                        delete p;
+                        return;
+                    }
                     p->reset();
                     thisPtr->requestsPool_.emplace_back(
                         thisPtr->makeRequestForPool(p));
@@ -119,6 +127,12 @@ void HttpRequestParser::reset()
     assert(loop_->isInLoopThread());
     remainContentLength_ = 0;
     status_ = HttpRequestParseStatus::kExpectMethod;
+    // The next request is taken when its data arrives
+    request_.reset();
+}
+
+void HttpRequestParser::prepareRequest()
+{
     if (requestsPool_.empty())
     {
         request_ = makeRequestForPool(new HttpRequestImpl(loop_));
@@ -132,6 +146,14 @@ void HttpRequestParser::reset()
     }
 }
 
+bool HttpRequestParser::holdBody(const MsgBuffer *buf) const
+{
+    // A body nobody asked for yet is neither copied nor spilled to a file, a
+    // client which doesn't wait for 100 (Continue) may fill the buffer though.
+    return request_->isBodyDeferred() &&
+           buf->readableBytes() <= maxHeldBodySize;
+}
+
 /**
  * @return return -HttpStatusCode if encounters any http errors in request
  * @return return -1 if encounters any other errors in request
@@ -142,6 +164,11 @@ void HttpRequestParser::reset()
  */
 int HttpRequestParser::parseRequest(MsgBuffer *buf)
 {
+    active_ = true;
+    if (!request_)
+    {
+        prepareRequest();
+    }
     while (true)
     {
         switch (status_)
@@ -272,31 +299,17 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 }
 
                 // Check expect:100-continue
+                bool expectContinue{false};
                 auto &expect = request_->expect();
                 if (expect == "100-continue" &&
                     request_->getVersion() >= Version::kHttp11)
                 {
-                    if (remainContentLength_ == 0)
+                    if (status_ == HttpRequestParseStatus::kGotAll)
                     {
                         // error
                         return -k400BadRequest;
                     }
-                    else
-                    {
-                        // rfc2616-8.2.3
-                        // TODO: consider adding an AOP for expect header
-                        auto connPtr = conn_.lock();  // ugly
-                        if (!connPtr)
-                        {
-                            return -1;
-                        }
-                        auto resp = HttpResponse::newHttpResponse();
-                        resp->setStatusCode(k100Continue);
-                        auto httpString =
-                            static_cast<HttpResponseImpl *>(resp.get())
-                                ->renderToBuffer();
-                        connPtr->send(std::move(*httpString));
-                    }
+                    expectContinue = true;
                 }
                 else if (!expect.empty())
                 {
@@ -308,7 +321,13 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                        status_ == HttpRequestParseStatus::kExpectBody ||
                        status_ == HttpRequestParseStatus::kExpectChunkLen);
 
-                if (app().isRequestStreamEnabled())
+                // Requests with a body are handed over at the end of headers
+                // when they can be rejected before the body is read.
+                if (app().isRequestStreamEnabled() ||
+                    (status_ != HttpRequestParseStatus::kGotAll &&
+                     (HttpAppFrameworkImpl::instance()
+                          .isEarlyRejectionEnabled() ||
+                      AopAdvice::instance().hasPreBodyAdvices())))
                 {
                     request_->streamStart();
                     if (status_ == HttpRequestParseStatus::kGotAll)
@@ -318,10 +337,29 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                     }
                     else
                     {
+                        // The 100 (Continue) response is sent when a handler
+                        // asks for the body.
+                        request_->deferBody(expectContinue);
                         return 3;
                     }
                 }
 
+                if (expectContinue)
+                {
+                    // rfc2616-8.2.3
+                    auto connPtr = conn_.lock();  // ugly
+                    if (!connPtr)
+                    {
+                        return -1;
+                    }
+                    auto resp = HttpResponse::newHttpResponse();
+                    resp->setStatusCode(k100Continue);
+                    auto httpString =
+                        static_cast<HttpResponseImpl *>(resp.get())
+                            ->renderToBuffer();
+                    connPtr->send(std::move(*httpString));
+                }
+
                 // Reserve space for full body in non-stream mode.
                 // For stream mode requests that match a non-stream handler,
                 // we will reserve full body before waitForStreamFinish().
@@ -333,6 +371,10 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectBody:
             {
+                if (holdBody(buf))
+                {
+                    return 0;
+                }
                 size_t bytesToConsume =
                     remainContentLength_ <= buf->readableBytes()
                         ? remainContentLength_
@@ -355,6 +397,10 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectChunkLen:
             {
+                if (holdBody(buf))
+                {
+                    return 0;
+                }
                 const char *crlf = buf->findCRLF();
                 if (!crlf)
                 {
@@ -417,7 +463,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 }
                 buf->retrieve(CRLF_LEN);
 
-                if (!request_->isStreamMode())
+                if (!request_->isStreamMode() ||
+                    !app().isRequestStreamEnabled())
                 {
                     // Previously we only have non-stream mode, drogon handled
                     // chunked encoding internally, and give user a regular
@@ -434,6 +481,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                     //
                     // NOTE: request forward behavior may be infected in stream
                     // mode, we should check it out.
+                    // Requests deferred for early rejection are not stream
+                    // mode requests for users.
                     request_->addHeader("content-length",
                                         std::to_string(
                                             request_->realContentLength()));
@@ -457,7 +506,12 @@ void HttpRequestParser::pushRequestToPipelining(const HttpRequestPtr &req,
                                                 bool isHeadMethod)
 {
     assert(loop_->isInLoopThread());
-    requestPipelining_.push_back({req, {nullptr, isHeadMethod}});
+    if (!requestPipelining_)
+    {
+        requestPipelining_ = std::make_unique<std::deque<
+            std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>>();
+    }
+    requestPipelining_->push_back({req, {nullptr, isHeadMethod}});
 }
 
 /**
@@ -467,11 +521,13 @@ bool HttpRequestParser::pushResponseToPipelining(const HttpRequestPtr &req,
                                                  HttpResponsePtr resp)
 {
     assert(loop_->isInLoopThread());
-    for (size_t i = 0; i != requestPipelining_.size(); ++i)
+    assert(requestPipelining_);
+    auto &pipelining = *requestPipelining_;
+    for (size_t i = 0; i != pipelining.size(); ++i)
     {
-        if (requestPipelining_[i].first == req)
+        if (pipelining[i].first == req)
         {
-            requestPipelining_[i].second.first = std::move(resp);
+            pipelining[i].second.first = std::move(resp);
             return i == 0;
         }
     }
@@ -482,10 +538,58 @@ bool HttpRequestParser::pushResponseToPipelining(const HttpRequestPtr &req,
 void HttpRequestParser::popReadyResponses(
     std::vector<std::pair<HttpResponsePtr, bool>> &buffer)
 {
-    while (!requestPipelining_.empty() &&
-           requestPipelining_.front().second.first)
+    if (!requestPipelining_)
+        return;
+    auto &pipelining = *requestPipelining_;
+    while (!pipelining.empty() && pipelining.front().second.first)
+    {
+        buffer.push_back(std::move(pipelining.front().second));
+        pipelining.pop_front();
+    }
+}
+
+void HttpRequestParser::releaseIfIdle()
+{
+    if (active_)
+    {
+        active_ = false;
+        return;
+    }
+    releaseIdleBuffers();
+}
+
+void HttpRequestParser::releaseIdleBuffers()
+{
+    assert(loop_->isInLoopThread());
+    if (status_ == HttpRequestParseStatus::kExpectMethod && request_)
+    {
+        // Nothing of the next request is parsed yet
+        releasingPool_ = true;
+        request_.reset();
+        releasingPool_ = false;
+    }
+    if (!requestsPool_.empty())
+    {
+        releasingPool_ = true;
+        std::vector<HttpRequestImplPtr>().swap(requestsPool_);
+        releasingPool_ = false;
+    }
+    if (requestPipelining_ && requestPipelining_->empty())
+        requestPipelining_.reset();
+    if (responseBuffer_ && responseBuffer_->empty())
+        responseBuffer_.reset();
+    if (requestBuffer_ && requestBuffer_->empty())
+        requestBuffer_.reset();
+    if (sendBuffer_ && sendBuffer_->readableBytes() == 0)
+        sendBuffer_.reset();
+    auto connPtr = conn_.lock();
+    if (connPtr && connPtr->getRecvBuffer()->readableBytes() == 0)
     {
-        buffer.push_back(std::move(requestPipelining_.front().second));
-        requestPipelining_.pop_front();
+        // Replace the receive buffer of the connection by a small one, it
+        // grows again with the data
+        trantor::MsgBuffer smallBuffer(idleRecvBufferSize);
+        connPtr->getRecvBuffer()->swap(smallBuffer);
     }
+    if (websockConnPtr_)
+        websockConnPtr_->releaseIdleBuffers();
 }
@@ -25,6 +25,8 @@
 
 namespace drogon
 {
+class ZeroCopySocket;
+
 class HttpRequestParser : public trantor::NonCopyable,
                           public std::enable_shared_from_this<HttpRequestParser>
 {
@@ -52,6 +54,7 @@ class HttpRequestParser : public trantor::NonCopyable,
 
     void reset();
 
+    // The request being parsed, nullptr until the next request starts
     const HttpRequestImplPtr &requestImpl() const
     {
         return request_;
@@ -84,12 +87,12 @@ class HttpRequestParser : public trantor::NonCopyable,
 
     size_t numberOfRequestsInPipelining() const
     {
-        return requestPipelining_.size();
+        return requestPipelining_ ? requestPipelining_->size() : 0;
     }
 
     bool emptyPipelining()
     {
-        return requestPipelining_.empty();
+        return !requestPipelining_ || requestPipelining_->empty();
     }
 
     bool isStop() const
@@ -102,6 +105,34 @@ class HttpRequestParser : public trantor::NonCopyable,
         stopWorking_ = true;
     }
 
+    // Stop parsing and discard the unread body of a rejected request.
+    void discardBody()
+    {
+        stopWorking_ = true;
+        discardingBody_ = true;
+    }
+
+    // Return false once more than maxDrainSize bytes of the body are
+    // discarded, the connection should be closed without draining it further.
+    bool drain(size_t bytes)
+    {
+        if (!discardingBody_)
+            return true;
+        drainedBytes_ += bytes;
+        return drainedBytes_ <= maxDrainSize;
+    }
+
+    // Set if the large response bodies are sent with MSG_ZEROCOPY
+    const std::shared_ptr<ZeroCopySocket> &zeroCopySocket() const
+    {
+        return zeroCopySocket_;
+    }
+
+    void setZeroCopySocket(std::shared_ptr<ZeroCopySocket> socket)
+    {
+        zeroCopySocket_ = std::move(socket);
+    }
+
     size_t numberOfRequestsParsed() const
     {
         return requestsCounter_;
@@ -109,7 +140,11 @@ class HttpRequestParser : public trantor::NonCopyable,
 
     trantor::MsgBuffer &getBuffer()
     {
-        return sendBuffer_;
+        if (!sendBuffer_)
+        {
+            sendBuffer_ = std::make_unique<trantor::MsgBuffer>();
+        }
+        return *sendBuffer_;
     }
 
     std::vector<std::pair<HttpResponsePtr, bool>> &getResponseBuffer()
@@ -135,24 +170,56 @@ class HttpRequestParser : public trantor::NonCopyable,
         return *requestBuffer_;
     }
 
+    // Mark the connection as active, it keeps its buffers at the next check
+    // of releaseIfIdle()
+    void setActive()
+    {
+        active_ = true;
+    }
+
+    /**
+     * Called periodically in the loop of the connection. Release the buffers
+     * if the connection has been idle since the last call.
+     */
+    void releaseIfIdle();
+
+    // Release the memory of the empty buffers and the pooled requests, they
+    // are allocated again when needed.
+    void releaseIdleBuffers();
+
   private:
     HttpRequestImplPtr makeRequestForPool(HttpRequestImpl *p);
+    void prepareRequest();
     bool processRequestLine(const char *begin, const char *end);
+    bool holdBody(const trantor::MsgBuffer *buf) const;
     HttpRequestParseStatus status_;
     trantor::EventLoop *loop_;
     HttpRequestImplPtr request_;
     bool firstRequest_{true};
     WebSocketConnectionImplPtr websockConnPtr_;
-    std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
+    // The buffers below are allocated on demand, most connections are idle
+    std::unique_ptr<
+        std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>>
         requestPipelining_;
     size_t requestsCounter_{0};
     std::weak_ptr<trantor::TcpConnection> conn_;
     bool stopWorking_{false};
-    trantor::MsgBuffer sendBuffer_;
+    bool discardingBody_{false};
+    std::shared_ptr<ZeroCopySocket> zeroCopySocket_;
+    size_t drainedBytes_{0};
+    static constexpr size_t maxDrainSize{256 * 1024};
+    // The size of a deferred body left in the receive buffer, above it the
+    // body is stored in the request to bound the memory of the connection.
+    static constexpr size_t maxHeldBodySize{256 * 1024};
+    static constexpr size_t idleRecvBufferSize{256};
+    std::unique_ptr<trantor::MsgBuffer> sendBuffer_;
     std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
         responseBuffer_;
     std::unique_ptr<std::vector<HttpRequestImplPtr>> requestBuffer_;
     std::vector<HttpRequestImplPtr> requestsPool_;
+    // The released requests are deleted instead of pooled while it's set
+    bool releasingPool_{false};
+    bool active_{true};
     size_t currentChunkLength_{0};
     size_t remainContentLength_{0};
 };
@@ -16,8 +16,10 @@
 #include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpUtils.h"
+#include "XxHash64.h"
 #include <drogon/HttpViewData.h>
 #include <drogon/IOThreadStorage.h>
+#include <charconv>
 #include <filesystem>
 #include <fstream>
 #include <memory>
@@ -39,6 +41,60 @@ namespace drogon
 // "Fri, 23 Aug 2019 12:58:03 GMT" length = 29
 static const size_t httpFullDateStringLength = 29;
 
+namespace
+{
+// Appends the output of the json writer to a string and hashes it at the same
+// time, so that the body isn't read again for the ETag.
+class HashingStringBuf : public std::streambuf
+{
+  public:
+    explicit HashingStringBuf(std::string &output) : output_(output)
+    {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    uint64_t digest()
+    {
+        flush();
+        return hash_.digest();
+    }
+
+  protected:
+    int_type overflow(int_type ch) override
+    {
+        flush();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        flush();
+        return 0;
+    }
+
+  private:
+    void flush()
+    {
+        auto length = static_cast<size_t>(pptr() - pbase());
+        if (length > 0)
+        {
+            hash_.update(pbase(), length);
+            output_.append(pbase(), length);
+            setp(buffer_, buffer_ + sizeof(buffer_));
+        }
+    }
+
+    std::string &output_;
+    XxHash64 hash_;
+    char buffer_[1024];
+};
+}  // namespace
+
 static inline HttpResponsePtr genHttpResponse(const std::string &viewName,
                                               const HttpViewData &data,
                                               const HttpRequestPtr &req)
@@ -127,8 +183,73 @@ void HttpResponseImpl::generateBodyFromJson() const
             builder["precisionType"] = precision.second;
         }
     });
-    bodyPtr_ = std::make_shared<HttpMessageStringBody>(
-        writeString(builder, *jsonPtr_));
+    if (!autoETag())
+    {
+        bodyPtr_ = std::make_shared<HttpMessageStringBody>(
+            writeString(builder, *jsonPtr_));
+        return;
+    }
+    std::string body;
+    HashingStringBuf buf(body);
+    std::ostream stream(&buf);
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(*jsonPtr_, &stream);
+    bodyHash_ = buf.digest();
+    bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
+}
+
+bool HttpResponseImpl::autoETag() const
+{
+    if (autoETag_ >= 0)
+    {
+        return autoETag_ > 0;
+    }
+    return HttpAppFrameworkImpl::instance().isAutoETagEnabled();
+}
+
+const std::string &HttpResponseImpl::makeAutoETag()
+{
+    if (!etag_.empty() || fullHeaderString_ || passThrough_ ||
+        customStatusCode_ >= 0 || statusCode_ != k200OK ||
+        streamCallback_ || asyncStreamCallback_ || !sendfileName_.empty() ||
+        headers_.find("etag") != headers_.end() || !autoETag())
+    {
+        return etag_;
+    }
+    generateBodyFromJson();
+    if (!bodyHash_)
+    {
+        bodyHash_ = bodyPtr_ ? XxHash64::hash(bodyPtr_->data(),
+                                              bodyPtr_->length())
+                             : XxHash64::hash(nullptr, 0);
+    }
+    char etag[20];
+    auto length = snprintf(etag,
+                           sizeof(etag),
+                           "\"%016llx\"",
+                           static_cast<unsigned long long>(*bodyHash_));
+    etag_.assign(etag, length);
+    return etag_;
+}
+
+HttpResponsePtr HttpResponseImpl::newNotModifiedResponse() const
+{
+    auto resp = std::make_shared<HttpResponseImpl>(k304NotModified, CT_NONE);
+    resp->version_ = version_;
+    resp->closeConnection_ = closeConnection_;
+    // The headers a 304 response must have if the 200 one would (see
+    // rfc9110-15.4.5), ETag aside.
+    for (auto field : {"cache-control", "content-location", "expires", "vary"})
+    {
+        auto iter = headers_.find(field);
+        if (iter != headers_.end())
+        {
+            resp->headers_.emplace(*iter);
+        }
+    }
+    resp->etag_ = etag_;
+    resp->cookies_ = cookies_;
+    return resp;
 }
 
 HttpResponsePtr HttpResponse::newNotFoundResponse(const HttpRequestPtr &req)
@@ -398,6 +519,96 @@ HttpResponsePtr HttpResponse::newFileResponse(
     return resp;
 }
 
+HttpResponsePtr HttpResponseImpl::newMultiRangeFileResponse(
+    const std::string &fullPath,
+    size_t filesize,
+    const std::vector<FileRange> &ranges,
+    const std::string_view &typeString,
+    const HttpRequestPtr &req)
+{
+    size_t dataLength = 0;
+    for (auto const &range : ranges)
+    {
+        if (range.start >= range.end || range.end > filesize)
+        {
+            auto resp = std::make_shared<HttpResponseImpl>();
+            resp->setStatusCode(k416RequestedRangeNotSatisfiable);
+            char buf[64];
+            snprintf(buf, sizeof(buf), "bytes */%zu", filesize);
+            resp->addHeader("Content-Range", std::string(buf));
+            return resp;
+        }
+        dataLength += range.end - range.start;
+    }
+
+    auto boundary = utils::genRandomString(32);
+    std::vector<SendfilePart> parts;
+    parts.reserve(ranges.size());
+    for (auto const &range : ranges)
+    {
+        char buf[128];
+        snprintf(buf,
+                 sizeof(buf),
+                 "bytes %zu-%zu/%zu\r\n\r\n",
+                 range.start,
+                 range.end - 1,
+                 filesize);
+        std::string header;
+        if (!parts.empty())
+            header.append("\r\n");
+        header.append("--").append(boundary).append("\r\n");
+        if (!typeString.empty())
+        {
+            header.append("Content-Type: ")
+                .append(typeString)
+                .append("\r\n");
+        }
+        header.append("Content-Range: ").append(buf);
+        parts.push_back({std::move(header),
+                         range.start,
+                         range.end - range.start});
+    }
+    std::string trailer = "\r\n--" + boundary + "--\r\n";
+
+    auto resp = std::make_shared<HttpResponseImpl>();
+    if (HttpAppFrameworkImpl::instance().useSendfile() &&
+        dataLength > 1024 * 200)
+    {
+        resp->setSendfile(fullPath);
+        resp->setSendfileParts(std::move(parts), std::move(trailer));
+    }
+    else
+    {
+        std::ifstream infile(utils::toNativePath(fullPath),
+                             std::ifstream::binary);
+        if (!infile)
+        {
+            return HttpResponse::newNotFoundResponse(req);
+        }
+        std::streambuf *pbuf = infile.rdbuf();
+        std::string body;
+        body.reserve(dataLength + trailer.length() +
+                     parts.size() * (parts[0].header.length() + 16));
+        for (auto const &part : parts)
+        {
+            body.append(part.header);
+            auto pos = body.length();
+            body.resize(pos + part.length);
+            pbuf->pubseekoff(part.offset, std::ifstream::beg);
+            pbuf->sgetn(&body[pos], part.length);
+        }
+        body.append(trailer);
+        resp->setBody(std::move(body));
+    }
+    resp->setStatusCode(k206PartialContent);
+    auto contentType = "multipart/byteranges; boundary=" + boundary;
+    resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
+                                            contentType.data(),
+                                            contentType.length());
+    AopAdvice::instance().passResponseCreationAdvices(resp);
+    return resp;
+}
+
 HttpResponsePtr HttpResponse::newStreamResponse(
     const std::function<std::size_t(char *, std::size_t)> &callback,
     const std::string &attachmentFileName,
@@ -478,57 +689,25 @@ HttpResponsePtr HttpResponse::newAsyncStreamResponse(
     return resp;
 }
 
-void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
+static inline void appendContentLength(trantor::MsgBuffer &buffer,
+                                       size_t length)
 {
-    buffer.ensureWritableBytes(128);
-    int len{0};
-    if (version_ == Version::kHttp11)
-    {
-        if (customStatusCode_ >= 0)
-        {
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           "HTTP/1.1 %d ",
-                           customStatusCode_);
-        }
-        else
-        {
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           "HTTP/1.1 %d ",
-                           statusCode_);
-        }
-    }
-    else
-    {
-        if (customStatusCode_ >= 0)
-        {
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           "HTTP/1.0 %d ",
-                           customStatusCode_);
-        }
-        else
-        {
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           "HTTP/1.0 %d ",
-                           statusCode_);
-        }
-    }
-
-    buffer.hasWritten(len);
+    static constexpr std::string_view prefix{"content-length: "};
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), length);
+    buffer.ensureWritableBytes(prefix.size() + (result.ptr - digits) + 2);
+    buffer.append(prefix.data(), prefix.size());
+    buffer.append(digits, result.ptr - digits);
+    buffer.append("\r\n", 2);
+}
 
-    if (!statusMessage_.empty())
-        buffer.append(statusMessage_.data(), statusMessage_.length());
-    buffer.append("\r\n");
+void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
+{
     generateBodyFromJson();
     if (!passThrough_)
     {
-        buffer.ensureWritableBytes(64);
         if (!contentLengthIsAllowed())
         {
-            len = 0;
             if ((bodyPtr_ && bodyPtr_->length() > 0) ||
                 !sendfileName_.empty() || streamCallback_ ||
                 asyncStreamCallback_)
@@ -547,56 +726,153 @@ void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
                 LOG_DEBUG << "send stream with transfer-encoding chunked";
                 headers_["transfer-encoding"] = "chunked";
             }
-            len = 0;
         }
-        else if (sendfileName_.empty())
+    }
+
+    if (headerTemplate_ &&
+        headerTemplate_->loop == EventLoop::getEventLoopOfCurrentThread())
+    {
+        auto &tmpl = *headerTemplate_;
+        if (!matchesHeaderTemplate(tmpl))
         {
-            auto bodyLength = bodyPtr_ ? bodyPtr_->length() : 0;
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           contentLengthFormatString<decltype(bodyLength)>(),
-                           bodyLength);
+            tmpl.statusCode =
+                customStatusCode_ >= 0 ? customStatusCode_ : statusCode_;
+            tmpl.statusMessage = statusMessage_;
+            tmpl.version = version_;
+            tmpl.closeConnection = closeConnection_;
+            tmpl.passThrough = passThrough_;
+            tmpl.contentTypeString = contentTypeString_;
+            tmpl.headers = headers_;
+            tmpl.rendered.retrieveAll();
+            makeStaticHeaderString(tmpl.rendered);
+        }
+        buffer.append(tmpl.rendered.peek(), tmpl.rendered.readableBytes());
+    }
+    else
+    {
+        makeStaticHeaderString(buffer);
+    }
+    if (!etag_.empty())
+    {
+        buffer.append("etag: ", 6);
+        buffer.append(etag_);
+        buffer.append("\r\n", 2);
+    }
+
+    if (!passThrough_ && contentLengthIsAllowed() && !streamCallback_ &&
+        !asyncStreamCallback_)
+    {
+        if (sendfileName_.empty())
+        {
+            appendContentLength(buffer, bodyPtr_ ? bodyPtr_->length() : 0);
+        }
+        else if (!sendfileParts_.empty())
+        {
+            appendContentLength(buffer, sendfilePartsLength_);
         }
         else
         {
-            auto bodyLength = sendfileRange_.second;
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           contentLengthFormatString<decltype(bodyLength)>(),
-                           bodyLength);
+            appendContentLength(buffer, sendfileRange_.second);
         }
-        buffer.hasWritten(len);
+    }
+}
+
+bool HttpResponseImpl::matchesHeaderTemplate(
+    const ResponseHeaderTemplate &tmpl) const
+{
+    return tmpl.statusCode ==
+               (customStatusCode_ >= 0 ? customStatusCode_ : statusCode_) &&
+           tmpl.version == version_ &&
+           tmpl.closeConnection == closeConnection_ &&
+           tmpl.passThrough == passThrough_ &&
+           tmpl.statusMessage == statusMessage_ &&
+           tmpl.contentTypeString == contentTypeString_ &&
+           tmpl.headers == headers_;
+}
+
+void HttpResponseImpl::makeStaticHeaderString(trantor::MsgBuffer &buffer) const
+{
+    // The status line of a standard status code with its reason phrase is
+    // rendered in advance.
+    std::string_view line;
+    char code[16];
+    size_t codeLength{0};
+    if (customStatusCode_ < 0 &&
+        statusMessage_.data() == statusCodeToString(statusCode_).data())
+    {
+        line = statusLine(version_, statusCode_);
+    }
+    if (line.empty())
+    {
+        auto result = std::to_chars(code,
+                                    code + sizeof(code),
+                                    customStatusCode_ >= 0 ? customStatusCode_
+                                                           : statusCode_);
+        codeLength = result.ptr - code;
+    }
+
+    std::string_view connection;
+    bool sendServerHeader{false};
+    if (!passThrough_)
+    {
         if (headers_.find("connection") == headers_.end())
         {
             if (closeConnection_)
             {
-                buffer.append("connection: close\r\n");
+                connection = "connection: close\r\n";
             }
             else if (version_ == Version::kHttp10)
             {
-                buffer.append("connection: Keep-Alive\r\n");
+                connection = "connection: Keep-Alive\r\n";
             }
         }
-
-        if (!contentTypeString_.empty())
-        {
-            buffer.append("content-type: ");
-            buffer.append(contentTypeString_);
-            buffer.append("\r\n");
-        }
-        if (HttpAppFrameworkImpl::instance().sendServerHeader())
-        {
-            buffer.append(
-                HttpAppFrameworkImpl::instance().getServerHeaderString());
-        }
+        sendServerHeader = HttpAppFrameworkImpl::instance().sendServerHeader();
     }
+    const auto &serverHeader =
+        HttpAppFrameworkImpl::instance().getServerHeaderString();
+
+    // Compute the size first to write everything with one allocation
+    size_t size = line.empty() ? 9 + codeLength + 1 + statusMessage_.size() + 2
+                               : line.size();
+    size += connection.size();
+    if (!passThrough_ && !contentTypeString_.empty())
+        size += 14 + contentTypeString_.size() + 2;
+    if (sendServerHeader)
+        size += serverHeader.size();
+    for (auto &[field, value] : headers_)
+        size += field.size() + 2 + value.size() + 2;
+    buffer.ensureWritableBytes(size);
 
-    for (auto it = headers_.begin(); it != headers_.end(); ++it)
+    if (line.empty())
     {
-        buffer.append(it->first);
-        buffer.append(": ");
-        buffer.append(it->second);
-        buffer.append("\r\n");
+        buffer.append(version_ == Version::kHttp11 ? "HTTP/1.1 " : "HTTP/1.0 ",
+                      9);
+        buffer.append(code, codeLength);
+        buffer.append(" ", 1);
+        buffer.append(statusMessage_.data(), statusMessage_.length());
+        buffer.append("\r\n", 2);
+    }
+    else
+    {
+        buffer.append(line.data(), line.size());
+    }
+    buffer.append(connection.data(), connection.size());
+    if (!passThrough_ && !contentTypeString_.empty())
+    {
+        buffer.append("content-type: ", 14);
+        buffer.append(contentTypeString_);
+        buffer.append("\r\n", 2);
+    }
+    if (sendServerHeader)
+    {
+        buffer.append(serverHeader);
+    }
+    for (auto &[field, value] : headers_)
+    {
+        buffer.append(field);
+        buffer.append(": ", 2);
+        buffer.append(value);
+        buffer.append("\r\n", 2);
     }
 }
 
@@ -887,13 +1163,21 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(flagForParsingContentType_, that.flagForParsingContentType_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
     swap(sendfileName_, that.sendfileName_);
+    swap(sendfileRange_, that.sendfileRange_);
+    sendfileParts_.swap(that.sendfileParts_);
+    swap(sendfileTrailer_, that.sendfileTrailer_);
+    swap(sendfilePartsLength_, that.sendfilePartsLength_);
     swap(streamCallback_, that.streamCallback_);
     swap(asyncStreamCallback_, that.asyncStreamCallback_);
     jsonPtr_.swap(that.jsonPtr_);
     fullHeaderString_.swap(that.fullHeaderString_);
+    swap(headerTemplate_, that.headerTemplate_);
     httpString_.swap(that.httpString_);
     swap(datePos_, that.datePos_);
     swap(jsonParsingErrorPtr_, that.jsonParsingErrorPtr_);
+    swap(autoETag_, that.autoETag_);
+    swap(bodyHash_, that.bodyHash_);
+    etag_.swap(that.etag_);
 }
 
 void HttpResponseImpl::clear()
@@ -902,8 +1186,12 @@ void HttpResponseImpl::clear()
     version_ = Version::kHttp11;
     statusMessage_ = std::string_view{};
     fullHeaderString_.reset();
+    headerTemplate_ = nullptr;
     jsonParsingErrorPtr_.reset();
     sendfileName_.clear();
+    sendfileParts_.clear();
+    sendfileTrailer_.clear();
+    sendfilePartsLength_ = 0;
     if (streamCallback_)
     {
         LOG_TRACE << "Cleanup HttpResponse stream callback";
@@ -919,6 +1207,9 @@ void HttpResponseImpl::clear()
     cookies_.clear();
     bodyPtr_.reset();
     jsonPtr_.reset();
+    autoETag_ = -1;
+    bodyHash_.reset();
+    etag_.clear();
     expriedTime_ = -1;
     datePos_ = std::string::npos;
     flagForParsingContentType_ = false;
@@ -16,20 +16,45 @@
 
 #include "HttpUtils.h"
 #include "HttpMessageBody.h"
+#include "RangeParser.h"
 #include <drogon/exports.h>
+#include <drogon/CompressionDictionary.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoop.h>
 #include <trantor/net/InetAddress.h>
 #include <trantor/utils/Date.h>
 #include <trantor/utils/MsgBuffer.h>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <atomic>
 #include <unordered_map>
+#include <vector>
 
 namespace drogon
 {
+/**
+ * @brief The pre-rendered status line and headers (everything but the
+ * content-length, cookies and date headers) of the last response of a handler
+ * on an IO thread. The next response with the same status and headers reuses
+ * the rendered bytes.
+ */
+struct ResponseHeaderTemplate
+{
+    // The IO loop that owns the template
+    trantor::EventLoop *loop{nullptr};
+    int statusCode{-1};
+    std::string statusMessage;
+    Version version{Version::kUnknown};
+    bool closeConnection{false};
+    bool passThrough{false};
+    std::string contentTypeString;
+    SafeStringMap<std::string> headers;
+    trantor::MsgBuffer rendered{128};
+};
+
 class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 {
     friend class HttpResponseParser;
@@ -39,6 +64,29 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     {
     }
 
+    /**
+     * @brief A part of a multipart/byteranges response, the part header is
+     * sent before the range of the file.
+     */
+    struct SendfilePart
+    {
+        std::string header;
+        size_t offset;
+        size_t length;
+    };
+
+    /**
+     * @brief Create a 206 multipart/byteranges response of the ranges of a
+     * file of the given size. Large ranges are sent with sendfile,
+     * interleaved with the part headers.
+     */
+    static HttpResponsePtr newMultiRangeFileResponse(
+        const std::string &fullPath,
+        size_t fileSize,
+        const std::vector<FileRange> &ranges,
+        const std::string_view &typeString,
+        const HttpRequestPtr &req);
+
     HttpResponseImpl(HttpStatusCode code, ContentType type)
         : statusCode_(code),
           statusMessage_(statusCodeToString(code)),
@@ -216,6 +264,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     void setBody(const std::string &body) override
     {
         bodyPtr_ = std::make_shared<HttpMessageStringBody>(body);
+        bodyHash_.reset();
         if (passThrough_)
         {
             addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -225,6 +274,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     void setBody(std::string &&body) override
     {
         bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
+        bodyHash_.reset();
         if (passThrough_)
         {
             addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -256,6 +306,26 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         return expriedTime_;
     }
 
+    void setAutoETag(bool flag) override
+    {
+        autoETag_ = flag ? 1 : 0;
+    }
+
+    bool autoETag() const override;
+
+    /**
+     * @brief Compute the ETag of the response if it gets an automatic one (see
+     * setAutoETag()), once. A response rendered in advance is left as it is,
+     * it may be shared by several threads.
+     *
+     * @return The ETag, empty if the response doesn't have an automatic one.
+     */
+    const std::string &makeAutoETag();
+
+    /// The 304 response to a conditional request for this response, with its
+    /// ETag, cookies and cache related headers.
+    HttpResponsePtr newNotModifiedResponse() const;
+
     const char *getBodyData() const override
     {
         if (!flagForSerializingJson_ && jsonPtr_)
@@ -276,6 +346,11 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         return 0;
     }
 
+    const std::shared_ptr<HttpMessageBody> &bodyPtr() const
+    {
+        return bodyPtr_;
+    }
+
     void swap(HttpResponseImpl &that) noexcept;
     void parseJson() const;
 
@@ -347,6 +422,33 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         sendfileRange_.second = len;
     }
 
+    /**
+     * @brief Send the parts and the trailer instead of a single range of the
+     * file, the content length is the total size of them.
+     */
+    void setSendfileParts(std::vector<SendfilePart> &&parts,
+                          std::string &&trailer)
+    {
+        size_t length = trailer.length();
+        for (auto const &part : parts)
+        {
+            length += part.header.length() + part.length;
+        }
+        sendfileParts_ = std::move(parts);
+        sendfileTrailer_ = std::move(trailer);
+        sendfilePartsLength_ = length;
+    }
+
+    const std::vector<SendfilePart> &sendfileParts() const
+    {
+        return sendfileParts_;
+    }
+
+    const std::string &sendfileTrailer() const
+    {
+        return sendfileTrailer_;
+    }
+
     const std::function<std::size_t(char *, std::size_t)> &streamCallback()
         const override
     {
@@ -384,6 +486,12 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         makeHeaderString(*fullHeaderString_);
     }
 
+    // Render the headers with the template when they are rendered in its loop.
+    void setHeaderTemplate(ResponseHeaderTemplate *headerTemplate)
+    {
+        headerTemplate_ = headerTemplate;
+    }
+
     std::string contentTypeString() const override
     {
         parseContentTypeAndString();
@@ -412,6 +520,29 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         return (statusCode >= k200OK || statusCode < k100Continue) &&
                statusCode != k204NoContent;
     }
+    void decompressWithDictionary(const CompressionDictionary &dictionary,
+                                  CompressionDictionary::Encoding encoding)
+    {
+        if (bodyPtr_)
+        {
+            auto body = dictionary.decompress(bodyPtr_->data(),
+                                              bodyPtr_->length(),
+                                              encoding);
+            if (!body)
+            {
+                // Left encoded for the callback
+                LOG_ERROR << "Can't decode the "
+                          << CompressionDictionary::name(encoding)
+                          << " response with the dictionary";
+                return;
+            }
+            removeHeaderBy("content-encoding");
+            bodyPtr_ =
+                std::make_shared<HttpMessageStringBody>(std::move(*body));
+            addHeader("content-length", std::to_string(bodyPtr_->length()));
+        }
+    }
+
 #ifdef USE_BROTLI
     void brDecompress()
     {
@@ -430,6 +561,8 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
   protected:
     void makeHeaderString(trantor::MsgBuffer &headerString);
+    void makeStaticHeaderString(trantor::MsgBuffer &headerString) const;
+    bool matchesHeaderTemplate(const ResponseHeaderTemplate &tmpl) const;
 
     void parseContentTypeAndString() const
     {
@@ -466,6 +599,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     void setBody(const char *body, size_t len) override
     {
         bodyPtr_ = std::make_shared<HttpMessageStringViewBody>(body, len);
+        bodyHash_.reset();
         if (passThrough_)
         {
             addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -518,13 +652,23 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     ssize_t expriedTime_{-1};
     std::string sendfileName_;
     SendfileRange sendfileRange_{0, 0};
+    std::vector<SendfilePart> sendfileParts_;
+    std::string sendfileTrailer_;
+    size_t sendfilePartsLength_{0};
     std::function<std::size_t(char *, std::size_t)> streamCallback_;
     std::function<void(ResponseStreamPtr)> asyncStreamCallback_;
     bool asyncStreamDisableKickoff_{false};
 
     mutable std::shared_ptr<Json::Value> jsonPtr_;
+    // -1: as set by HttpAppFramework::enableAutoETag()
+    int8_t autoETag_{-1};
+    // The hash of the body, computed while the json body is serialized
+    mutable std::optional<uint64_t> bodyHash_;
+    // The automatic ETag, rendered after the header template
+    std::string etag_;
 
     std::shared_ptr<trantor::MsgBuffer> fullHeaderString_;
+    ResponseHeaderTemplate *headerTemplate_{nullptr};
     trantor::CertificatePtr peerCertificate_;
     mutable std::shared_ptr<trantor::MsgBuffer> httpString_;
     mutable size_t datePos_{static_cast<size_t>(-1)};
@@ -16,12 +16,17 @@
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <initializer_list>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include "AOPAdvice.h"
 #include "MiddlewaresFunction.h"
 #include "HttpAppFrameworkImpl.h"
+#include "AllocationCounter.h"
 #include "HttpConnectionLimit.h"
 #include "HttpControllerBinder.h"
 #include "HttpRequestImpl.h"
@@ -30,8 +35,14 @@
 #include "HttpControllersRouter.h"
 #include "StaticFileRouter.h"
 #include "WebSocketConnectionImpl.h"
+#include "ZeroCopySocket.h"
 #include "impl_forwards.h"
 
+#ifdef __linux__
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
 #if COZ_PROFILING
 #include <coz.h>
 #else
@@ -55,6 +66,8 @@ static inline bool passSyncAdvices(
     const std::shared_ptr<HttpRequestParser> &requestParser,
     bool shouldBePipelined,
     bool isHeadMethod);
+static HttpResponsePtr getNotModifiedResponse(const HttpRequestImplPtr &req,
+                                              const HttpResponsePtr &response);
     // 获取压缩的响应
 static inline HttpResponsePtr getCompressedResponse(
     const HttpRequestImplPtr &req,
@@ -62,6 +75,130 @@ static inline HttpResponsePtr getCompressedResponse(
     bool isHeadMethod);
 
     // 处理非法的 Http 方法
+namespace
+{
+#ifdef __linux__
+// The addresses of an accepted socket, or false if it is closed
+bool socketAddresses(int fd, std::string &peer, std::string &local)
+{
+    struct sockaddr_in6 addr6;
+    socklen_t len = static_cast<socklen_t>(sizeof(addr6));
+    memset(&addr6, 0, sizeof(addr6));
+    auto addr = reinterpret_cast<struct sockaddr *>(&addr6);
+    if (::getpeername(fd, addr, &len) < 0)
+        return false;
+    peer = InetAddress(addr6).toIpPort();
+    len = static_cast<socklen_t>(sizeof(addr6));
+    memset(&addr6, 0, sizeof(addr6));
+    if (::getsockname(fd, addr, &len) < 0)
+        return false;
+    local = InetAddress(addr6).toIpPort();
+    return true;
+}
+
+struct AcceptedSocket
+{
+    std::string peer;
+    std::string local;
+};
+
+// The accepted sockets with SO_ZEROCOPY waiting for their connection
+// callbacks, by fd. TcpConnection doesn't expose its socket, so the
+// connection is matched by its addresses, which are checked against the
+// socket again when it is taken. The entry of a socket closed before its
+// callback is replaced when the fd is reused, so there are never more
+// entries than open fds. Every HttpServer accepts its connections in its own
+// IO loop on Linux, and the callback usually runs right after the accept.
+thread_local std::unordered_map<int, AcceptedSocket> acceptedSockets;
+
+void rememberAcceptedSocket(int fd)
+{
+    AcceptedSocket socket;
+    if (socketAddresses(fd, socket.peer, socket.local))
+        acceptedSockets[fd] = std::move(socket);
+}
+
+void takeAcceptedSocket(const TcpConnectionPtr &conn, HttpRequestParser &parser)
+{
+    auto peer = conn->peerAddr().toIpPort();
+    auto local = conn->localAddr().toIpPort();
+    for (auto iter = acceptedSockets.begin(); iter != acceptedSockets.end();)
+    {
+        AcceptedSocket current;
+        if (!socketAddresses(iter->first, current.peer, current.local) ||
+            current.peer != iter->second.peer ||
+            current.local != iter->second.local)
+        {
+            // The socket was closed, the fd may be used by something else
+            iter = acceptedSockets.erase(iter);
+            continue;
+        }
+        if (current.peer != peer || current.local != local)
+        {
+            ++iter;
+            continue;
+        }
+        auto fd = iter->first;
+        acceptedSockets.erase(iter);
+        parser.setZeroCopySocket(
+            std::make_shared<ZeroCopySocket>(fd, conn->getLoop()));
+        return;
+    }
+}
+#endif
+
+// The parsers of the connections of the current event loop, whose buffers are
+// released by a timer shared by all connections of the loop when they are
+// idle
+struct LoopParsers
+{
+    std::vector<std::weak_ptr<HttpRequestParser>> parsers;
+    trantor::TimerId timerId{trantor::InvalidTimerId};
+};
+
+thread_local LoopParsers loopParsers;
+
+void releaseIdleBuffers(trantor::EventLoop *loop)
+{
+    auto &parsers = loopParsers.parsers;
+    for (size_t i = 0; i < parsers.size();)
+    {
+        auto parser = parsers[i].lock();
+        if (parser)
+        {
+            parser->releaseIfIdle();
+            ++i;
+            continue;
+        }
+        parsers[i] = std::move(parsers.back());
+        parsers.pop_back();
+    }
+    if (parsers.empty())
+    {
+        loop->invalidateTimer(loopParsers.timerId);
+        loopParsers.timerId = trantor::InvalidTimerId;
+        // Don't keep the capacity of a past connection peak
+        std::vector<std::weak_ptr<HttpRequestParser>>().swap(parsers);
+    }
+}
+
+void watchIdleBuffers(const TcpConnectionPtr &conn,
+                      const std::shared_ptr<HttpRequestParser> &parser)
+{
+    auto interval =
+        HttpAppFrameworkImpl::instance().getIdleBufferReleaseTime();
+    if (interval <= 0)
+        return;
+    loopParsers.parsers.emplace_back(parser);
+    if (loopParsers.timerId == trantor::InvalidTimerId)
+    {
+        auto loop = conn->getLoop();
+        loopParsers.timerId =
+            loop->runEvery(interval, [loop]() { releaseIdleBuffers(loop); });
+    }
+}
+}  // namespace
+
 static void handleInvalidHttpMethod(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback);
@@ -80,11 +217,12 @@ HttpServer::HttpServer(EventLoop *loop,
     : server_(loop, listenAddr, std::move(name), true, app().reusePort())
 #endif
 {
+    connectionLimit_ = &HttpConnectionLimit::instance();
     // 连接到达时的回调函数
     server_.setConnectionCallback(
         [this](const trantor::TcpConnectionPtr &conn) {
             // 处理连接
-            onConnection(conn);
+            onConnection(conn, *connectionLimit_);
             if (connectionCallback_)
                 connectionCallback_(conn);
         });
@@ -104,9 +242,24 @@ void HttpServer::start()
     {
         server_.setBeforeListenSockOptCallback(beforeListenSetSockOptCallback_);
     }
-    if (afterAcceptSetSockOptCallback_)
+    auto afterAcceptCallback = afterAcceptSetSockOptCallback_;
+#ifdef __linux__
+    bool zeroCopy =
+        !ssl_ && ZeroCopySocket::isSupported() &&
+        HttpAppFrameworkImpl::instance().getZeroCopySendThreshold() > 0;
+    if (zeroCopy)
+    {
+        afterAcceptCallback = [cb = std::move(afterAcceptCallback)](int fd) {
+            if (cb)
+                cb(fd);
+            if (ZeroCopySocket::enable(fd))
+                rememberAcceptedSocket(fd);
+        };
+    }
+#endif
+    if (afterAcceptCallback)
     {
-        server_.setAfterAcceptSockOptCallback(afterAcceptSetSockOptCallback_);
+        server_.setAfterAcceptSockOptCallback(std::move(afterAcceptCallback));
     }
     LOG_TRACE << "HttpServer[" << server_.name() << "] starts listening on "
               << server_.ipPort();
@@ -118,14 +271,20 @@ void HttpServer::stop()
     server_.stop();
 }
 
-void HttpServer::onConnection(const TcpConnectionPtr &conn)
+void HttpServer::onConnection(const TcpConnectionPtr &conn,
+                              HttpConnectionLimit &limit)
 {
     if (conn->connected())
     {
         auto parser = std::make_shared<HttpRequestParser>(conn);
         parser->reset();
         conn->setContext(parser);
-        if (!HttpConnectionLimit::instance().tryAddConnection(conn))
+#ifdef __linux__
+        if (!acceptedSockets.empty())
+            takeAcceptedSocket(conn, *parser);
+#endif
+        watchIdleBuffers(conn, parser);
+        if (!limit.tryAddConnection(conn))
         {
             LOG_ERROR << "too much connections!force close!";
             conn->forceClose();
@@ -139,15 +298,20 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
     else if (conn->disconnected())
     {
         LOG_TRACE << "conn disconnected!";
-        HttpConnectionLimit::instance().releaseConnection(conn);
+        limit.releaseConnection(conn);
         auto requestParser = conn->getContext<HttpRequestParser>();
         if (requestParser)
         {
+            if (requestParser->zeroCopySocket())
+            {
+                requestParser->zeroCopySocket()->close();
+            }
             if (requestParser->webSocketConn())
             {
                 requestParser->webSocketConn()->onClose();
             }
-            else if (requestParser->requestImpl()->isStreamMode())
+            else if (requestParser->requestImpl() &&
+                     requestParser->requestImpl()->isStreamMode())
             {
                 requestParser->requestImpl()->streamError(
                     std::make_exception_ptr(
@@ -169,6 +333,7 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     if (requestParser->webSocketConn())
     {
         // Websocket payload
+        requestParser->setActive();
         requestParser->webSocketConn()->onNewMessage(conn, buf);
         return;
     }
@@ -180,7 +345,12 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     {
         if (requestParser->isStop())
         {
-            // The number of requests has reached the limit.
+            // The number of requests has reached the limit, or the body of a
+            // rejected request is being discarded.
+            if (!requestParser->drain(buf->readableBytes()))
+            {
+                conn->forceClose();
+            }
             buf->retrieveAll();
             return;
         }
@@ -236,6 +406,21 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
             req->setSecure(conn->isSSLConnection());
             req->setPeerCertificate(conn->peerCertificate());
             req->setConnectionPtr(conn);
+            if (req->isBodyDeferred())
+            {
+                // The body is parsed once it's asked for, the buffer belongs
+                // to the connection
+                req->setBodyRequestedCallback(
+                    [weakConn = std::weak_ptr<TcpConnection>(conn), buf]() {
+                        auto conn = weakConn.lock();
+                        if (!conn)
+                            return;
+                        conn->getLoop()->queueInLoop([conn, buf]() {
+                            if (conn->connected())
+                                onMessage(conn, buf);
+                        });
+                    });
+            }
             // TODO: maybe call onRequests() directly in stream mode
             requests.push_back(req);
         }
@@ -380,7 +565,10 @@ void HttpServer::onRequests(
         auto paramPack = std::make_shared<CallbackParamPack>(
             conn, req, loopFlagPtr, requestParser, isHeadMethod);
 
-        auto errResp = tryDecompressRequest(req);
+        // A deferred body is decompressed once received, see
+        // waitForRequestBody()
+        auto errResp =
+            req->isBodyDeferred() ? nullptr : tryDecompressRequest(req);
         if (errResp)
         {
             handleResponse(errResp, paramPack, &respReady);
@@ -395,12 +583,21 @@ void HttpServer::onRequests(
             // By doing this, we could reduce some system calls when sending
             // through socket. In order to achieve this, we create a
             // `respReady` variable.
+#if COUNT_REQUEST_ALLOCATIONS
+            auto allocations = AllocationCounter::current();
+#endif
             onHttpRequest(req,
                           [respReadyPtr = &respReady,
                            paramPack = std::move(paramPack)](
                               const HttpResponsePtr &response) {
                               handleResponse(response, paramPack, respReadyPtr);
                           });
+#if COUNT_REQUEST_ALLOCATIONS
+            auto route = req->matchedPathPattern();
+            AllocationCounter::addToRoute(route.empty() ? "(unmatched)"
+                                                        : route,
+                                          allocations);
+#endif
         }
         if (!reqPipelined && !respReady)
         {
@@ -437,6 +634,58 @@ void HttpServer::onHttpRequest(
 
     // TODO: move session related codes to its own singleton class
     HttpAppFrameworkImpl::instance().findSessionForRequest(req);
+    // pre-body aop
+    auto &aop = AopAdvice::instance();
+    if (!aop.hasPreBodyAdvices())
+    {
+        httpRequestPreRouting(req, std::move(callback));
+        return;
+    }
+    aop.passPreBodyAdvices(req,
+                           [req, callback = std::move(callback)](
+                               const HttpResponsePtr &resp) mutable {
+                               if (resp)
+                               {
+                                   callback(resp);
+                               }
+                               else
+                               {
+                                   httpRequestPreBody(req, std::move(callback));
+                               }
+                           });
+}
+
+void HttpServer::httpRequestPreBody(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    // The body of a request is only deferred for the pre-body advices, the
+    // pre-routing advices and the rest see it as before. In early rejection
+    // or request stream mode, they run before the body is received.
+    if (req->streamStatus() < ReqStreamStatus::Open ||
+        app().isRequestStreamEnabled() ||
+        HttpAppFrameworkImpl::instance().isEarlyRejectionEnabled())
+    {
+        httpRequestPreRouting(req, std::move(callback));
+        return;
+    }
+    req->getLoop()->runInLoop([req, callback = std::move(callback)]() mutable {
+        PreRoutingParamPack pack{std::move(callback)};
+        if (!waitForRequestBody(req, pack, &httpRequestPreRoutingPack))
+            httpRequestPreRouting(req, std::move(pack.callback));
+    });
+}
+
+void HttpServer::httpRequestPreRoutingPack(const HttpRequestImplPtr &req,
+                                           PreRoutingParamPack &&pack)
+{
+    httpRequestPreRouting(req, std::move(pack.callback));
+}
+
+void HttpServer::httpRequestPreRouting(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
     // pre-routing aop
     auto &aop = AopAdvice::instance();
     aop.passPreRoutingObservers(req);
@@ -490,47 +739,62 @@ void HttpServer::httpRequestRouting(
 }
 
 template <typename Pack>
-void HttpServer::requestPostRouting(const HttpRequestImplPtr &req, Pack &&pack)
+bool HttpServer::waitForRequestBody(const HttpRequestImplPtr &req,
+                                    Pack &pack,
+                                    void (*next)(const HttpRequestImplPtr &,
+                                                 Pack &&))
 {
-    // Handle stream mode for non-stream handlers
-    if (req->streamStatus() >= ReqStreamStatus::Open &&
-        !pack.binderPtr->isStreamHandler())
+    LOG_TRACE << "Wait for request stream finish";
+    if (req->streamStatus() == ReqStreamStatus::Finish)
     {
-        LOG_TRACE << "Wait for request stream finish";
-        if (req->streamStatus() == ReqStreamStatus::Finish)
+        req->quitStreamMode();
+        if (auto resp = tryDecompressRequest(req))
         {
-            req->quitStreamMode();
+            pack.callback(resp);
+            return true;
         }
-        else
-        {
-            auto contentLength = req->getContentLengthHeaderValue();
-            if (contentLength.has_value())
+        return false;
+    }
+    auto contentLength = req->getContentLengthHeaderValue();
+    if (contentLength.has_value())
+    {
+        req->reserveBodySize(contentLength.value());
+    }
+    req->waitForStreamFinish(
+        [weakReq = std::weak_ptr(req), pack = std::move(pack), next]() mutable {
+            auto req = weakReq.lock();
+            if (!req)
+                return;
+            if (req->streamStatus() == ReqStreamStatus::Finish)
             {
-                req->reserveBodySize(contentLength.value());
-            }
-            req->waitForStreamFinish([weakReq = std::weak_ptr(req),
-                                      pack =
-                                          std::forward<Pack>(pack)]() mutable {
-                auto req = weakReq.lock();
-                if (!req)
-                    return;
-                if (req->streamStatus() == ReqStreamStatus::Finish)
-                {
-                    req->quitStreamMode();
-                    // call requestPostRouting again
-                    requestPostRouting(req, std::forward<Pack>(pack));
-                    return;
-                }
+                req->quitStreamMode();
+                if (auto resp = tryDecompressRequest(req))
+                    pack.callback(resp);
                 else
-                {
-                    req->quitStreamMode();
-                    LOG_ERROR << "Stop processing request due to stream error";
-                    pack.callback(
-                        app().getCustomErrorHandler()(k400BadRequest, req));
-                }
-            });
-            return;
-        }
+                    next(req, std::move(pack));
+            }
+            else
+            {
+                req->quitStreamMode();
+                LOG_ERROR << "Stop processing request due to stream error";
+                pack.callback(
+                    app().getCustomErrorHandler()(k400BadRequest, req));
+            }
+        });
+    return true;
+}
+
+template <typename Pack>
+void HttpServer::requestPostRouting(const HttpRequestImplPtr &req, Pack &&pack)
+{
+    // Handle stream mode for non-stream handlers, the body is read after
+    // filters/middlewares in early rejection mode
+    if (req->streamStatus() >= ReqStreamStatus::Open &&
+        !pack.binderPtr->isStreamHandler() &&
+        !HttpAppFrameworkImpl::instance().isEarlyRejectionEnabled() &&
+        waitForRequestBody(req, pack, &requestPostRouting<std::decay_t<Pack>>))
+    {
+        return;
     }
 
     // post-routing aop
@@ -592,6 +856,13 @@ void HttpServer::requestPreHandling(const HttpRequestImplPtr &req, Pack &&pack)
                           std::move(pack.callback));
         return;
     }
+    // In early rejection mode, the request has passed filters/middlewares.
+    if (req->streamStatus() >= ReqStreamStatus::Open &&
+        !pack.binderPtr->isStreamHandler() &&
+        waitForRequestBody(req, pack, &requestPreHandling<std::decay_t<Pack>>))
+    {
+        return;
+    }
 
     // pre-handling aop
     auto &aop = AopAdvice::instance();
@@ -676,7 +947,10 @@ void HttpServer::httpRequestHandling(
             // Check if we need to cache the response
             if (resp->expiredTime() >= 0 && resp->statusCode() != k404NotFound)
             {
-                static_cast<HttpResponseImpl *>(resp.get())->makeHeaderString();
+                auto respImpl = static_cast<HttpResponseImpl *>(resp.get());
+                // The ETag of the cached response is computed once here
+                respImpl->makeAutoETag();
+                respImpl->makeHeaderString();
                 auto loop = req->getLoop();
                 if (loop->isInLoopThread())
                 {
@@ -690,6 +964,17 @@ void HttpServer::httpRequestHandling(
                         });
                 }
             }
+            else if (resp->expiredTime() < 0 &&
+                     req->getLoop()->isInLoopThread())
+            {
+                // The responses of a handler usually have the same headers,
+                // render them once per IO thread.
+                auto &headerTemplate =
+                    binderPtr->headerTemplates_.getThreadData();
+                headerTemplate.loop = req->getLoop();
+                static_cast<HttpResponseImpl *>(resp.get())
+                    ->setHeaderTemplate(&headerTemplate);
+            }
             // post-handling aop
             AopAdvice::instance().passPostHandlingAdvices(req, resp);
             callback(resp);
@@ -800,11 +1085,28 @@ void HttpServer::handleResponse(
                                                                   response);
     resp->setVersion(req->getVersion());
     resp->setCloseConnection(!req->keepAlive());
+    // The request is rejected before its body is read, stop reading it and
+    // close the connection after the response.
+    bool bodyRejected =
+        req->isBodyDeferred() && (!conn->getLoop()->isInLoopThread() ||
+                                  req->streamStatus() == ReqStreamStatus::Open);
+    if (bodyRejected)
+    {
+        resp->setCloseConnection(true);
+    }
     AopAdvice::instance().passPreSendingAdvices(req, resp);
 
-    auto newResp = getCompressedResponse(req, resp, isHeadMethod);
+    auto newResp = getNotModifiedResponse(req, resp);
+    if (!newResp)
+    {
+        newResp = getCompressedResponse(req, resp, isHeadMethod);
+    }
     if (conn->getLoop()->isInLoopThread())
     {
+        if (bodyRejected)
+        {
+            requestParser->discardBody();
+        }
         /*
          * A client that supports persistent connections MAY
          * "pipeline" its requests (i.e., send multiple requests
@@ -838,21 +1140,89 @@ void HttpServer::handleResponse(
     }
     else
     {
-        conn->getLoop()->queueInLoop(
-            [conn, req, requestParser, newResp = std::move(newResp)]() mutable {
-                if (!conn->connected())
-                {
-                    return;
-                }
-                if (requestParser->pushResponseToPipelining(req,
-                                                            std::move(newResp)))
-                {
-                    std::vector<std::pair<HttpResponsePtr, bool>> responses;
-                    requestParser->popReadyResponses(responses);
-                    sendResponses(conn, responses, requestParser->getBuffer());
-                }
-            });
+        conn->getLoop()->queueInLoop([conn,
+                                      req,
+                                      requestParser,
+                                      bodyRejected,
+                                      newResp = std::move(newResp)]() mutable {
+            if (!conn->connected())
+            {
+                return;
+            }
+            if (bodyRejected)
+            {
+                requestParser->discardBody();
+            }
+            if (requestParser->pushResponseToPipelining(req,
+                                                        std::move(newResp)))
+            {
+                std::vector<std::pair<HttpResponsePtr, bool>> responses;
+                requestParser->popReadyResponses(responses);
+                sendResponses(conn, responses, requestParser->getBuffer());
+            }
+        });
+    }
+}
+
+// Send the file of a response with sendfile, a multipart/byteranges response
+// has a part header before each range of the file
+static void sendFileOfResponse(const TcpConnectionPtr &conn,
+                               const HttpResponseImpl *respImplPtr)
+{
+    const std::string &sendfileName = respImplPtr->sendfileName();
+    const auto &parts = respImplPtr->sendfileParts();
+    if (parts.empty())
+    {
+        const auto &range = respImplPtr->sendfileRange();
+        conn->sendFile(sendfileName.c_str(), range.first, range.second);
+        return;
+    }
+    for (auto const &part : parts)
+    {
+        conn->send(part.header);
+        conn->sendFile(sendfileName.c_str(), part.offset, part.length);
     }
+    conn->send(respImplPtr->sendfileTrailer());
+}
+
+// Return the zero-copy socket of the connection if the response has a body in
+// memory large enough to be sent with MSG_ZEROCOPY
+static ZeroCopySocketPtr zeroCopySocketFor(const TcpConnectionPtr &conn,
+                                           HttpResponseImpl *respImplPtr)
+{
+    auto threshold =
+        HttpAppFrameworkImpl::instance().getZeroCopySendThreshold();
+    if (threshold == 0 || conn->isSSLConnection() ||
+        respImplPtr->streamCallback() || respImplPtr->asyncStreamCallback() ||
+        !respImplPtr->sendfileName().empty() ||
+        !respImplPtr->contentLengthIsAllowed())
+        return nullptr;
+    respImplPtr->generateBodyFromJson();
+    if (respImplPtr->getBodyLength() < threshold)
+        return nullptr;
+    auto parser = conn->getContext<HttpRequestParser>();
+    if (!parser)
+        return nullptr;
+    return parser->zeroCopySocket();
+}
+
+static void sendWithZeroCopy(const TcpConnectionPtr &conn,
+                             HttpResponseImpl *respImplPtr,
+                             const ZeroCopySocketPtr &socket)
+{
+    if (respImplPtr->expiredTime() >= 0)
+    {
+        // The rendered response is cached with the body, it is never modified
+        auto httpString = respImplPtr->renderToBuffer();
+        auto data = httpString->peek();
+        auto length = httpString->readableBytes();
+        conn->sendStream(
+            socket->makeStream(std::move(httpString), data, length));
+        return;
+    }
+    conn->send(respImplPtr->renderHeaderForHeadMethod());
+    const auto &body = respImplPtr->bodyPtr();
+    conn->sendStream(socket->makeStream(body, body->data(), body->length()));
 }
 
 struct ChunkingParams
@@ -980,6 +1350,18 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
     auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
     if (!isHeadMethod)
     {
+        if (auto zeroCopySocket = zeroCopySocketFor(conn, respImplPtr))
+        {
+            sendWithZeroCopy(conn, respImplPtr, zeroCopySocket);
+            COZ_PROGRESS
+            // trantor shuts the socket down once the stream is written
+            if (respImplPtr->ifCloseConnection())
+            {
+                conn->shutdown();
+                COZ_PROGRESS
+            }
+            return;
+        }
         auto httpString = respImplPtr->renderToBuffer();
         conn->send(httpString);
         if (!respImplPtr->contentLengthIsAllowed())
@@ -989,9 +1371,10 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
         {
             if (!respImplPtr->ifCloseConnection())
             {
-                asyncStreamCallback(
-                    std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                        respImplPtr->asyncStreamKickoffDisabled())));
+                asyncStreamCallback(std::make_unique<ResponseStream>(
+                    conn->sendAsyncStream(
+                        respImplPtr->asyncStreamKickoffDisabled()),
+                    conn));
             }
             else
             {
@@ -1024,8 +1407,7 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
             }
             else
             {
-                const auto &range = respImplPtr->sendfileRange();
-                conn->sendFile(sendfileName.c_str(), range.first, range.second);
+                sendFileOfResponse(conn, respImplPtr);
             }
         }
         COZ_PROGRESS
@@ -1060,7 +1442,19 @@ void HttpServer::sendResponses(
     for (auto const &resp : responses)
     {
         auto respImplPtr = static_cast<HttpResponseImpl *>(resp.first.get());
-        if (!resp.second)
+        auto zeroCopySocket =
+            resp.second ? nullptr : zeroCopySocketFor(conn, respImplPtr);
+        if (zeroCopySocket)
+        {
+            if (buffer.readableBytes() > 0)
+            {
+                conn->send(buffer);
+                buffer.retrieveAll();
+            }
+            sendWithZeroCopy(conn, respImplPtr, zeroCopySocket);
+            COZ_PROGRESS
+        }
+        else if (!resp.second)
         {
             // Not HEAD method
             respImplPtr->renderToBuffer(buffer);
@@ -1073,9 +1467,10 @@ void HttpServer::sendResponses(
                 buffer.retrieveAll();
                 if (!respImplPtr->ifCloseConnection())
                 {
-                    asyncStreamCallback(
-                        std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                            respImplPtr->asyncStreamKickoffDisabled())));
+                    asyncStreamCallback(std::make_unique<ResponseStream>(
+                        conn->sendAsyncStream(
+                            respImplPtr->asyncStreamKickoffDisabled()),
+                        conn));
                 }
                 else
                 {
@@ -1110,10 +1505,7 @@ void HttpServer::sendResponses(
                 }
                 else
                 {
-                    const auto &range = respImplPtr->sendfileRange();
-                    conn->sendFile(sendfileName.c_str(),
-                                   range.first,
-                                   range.second);
+                    sendFileOfResponse(conn, respImplPtr);
                 }
                 COZ_PROGRESS
             }
@@ -1240,6 +1632,129 @@ static inline bool passSyncAdvices(
     return true;
 }
 
+/**
+ * @brief Give the response an automatic ETag if it should have one, and
+ * return the 304 response if it matches the If-None-Match header of the
+ * request.
+ *
+ * @return nullptr if the response should be sent as it is.
+ */
+static HttpResponsePtr getNotModifiedResponse(const HttpRequestImplPtr &req,
+                                              const HttpResponsePtr &response)
+{
+    auto method = req->method();
+    if (method != Get && method != Head)
+    {
+        return nullptr;
+    }
+    auto respImpl = static_cast<HttpResponseImpl *>(response.get());
+    auto &etag = respImpl->makeAutoETag();
+    if (etag.empty())
+    {
+        return nullptr;
+    }
+    auto &ifNoneMatch = req->getHeaderBy("if-none-match");
+    if (ifNoneMatch.empty() || !ifNoneMatchMatches(ifNoneMatch, etag))
+    {
+        return nullptr;
+    }
+    LOG_TRACE << "Not modified, etag: " << etag;
+    return respImpl->newNotModifiedResponse();
+}
+
+// Return the response with the compressed body, a cached response is cloned
+static HttpResponsePtr setCompressedBody(const HttpResponsePtr &response,
+                                         std::string &&body,
+                                         const char *encoding)
+{
+    auto newResp = response;
+    if (response->expiredTime() >= 0)
+    {
+        // cached response,we need to make a clone
+        newResp = std::make_shared<HttpResponseImpl>(
+            *static_cast<HttpResponseImpl *>(response.get()));
+        newResp->setExpiredTime(-1);
+    }
+    newResp->setBody(std::move(body));
+    newResp->addHeader("Content-Encoding", encoding);
+    return newResp;
+}
+
+// Add the fields to the Vary header of the response, after the ones the
+// handler set
+static void appendVary(const HttpResponsePtr &response,
+                       std::initializer_list<std::string_view> fields)
+{
+    std::string vary = response->getHeader("vary");
+    if (vary == "*")
+        return;
+    for (auto field : fields)
+    {
+        bool found = false;
+        std::string_view rest = vary;
+        while (!rest.empty() && !found)
+        {
+            auto pos = rest.find(',');
+            auto token = rest.substr(0, pos);
+            rest = pos == std::string_view::npos ? std::string_view{}
+                                                 : rest.substr(pos + 1);
+            while (!token.empty() && token.front() == ' ')
+                token.remove_prefix(1);
+            while (!token.empty() && token.back() == ' ')
+                token.remove_suffix(1);
+            found = token.size() == field.size() &&
+                    std::equal(token.begin(),
+                               token.end(),
+                               field.begin(),
+                               [](unsigned char a, unsigned char b) {
+                                   return tolower(a) == tolower(b);
+                               });
+        }
+        if (found)
+            continue;
+        if (!vary.empty())
+            vary.append(", ");
+        vary.append(field);
+    }
+    response->addHeader("Vary", std::move(vary));
+}
+
+// Find the dictionary advertised by the request, by its hash or by its id
+// (then byId is set)
+static const CompressionDictionary *findCompressionDictionary(
+    const HttpRequestImplPtr &req,
+    bool &byId)
+{
+    auto &dictionaries =
+        HttpAppFrameworkImpl::instance().getCompressionDictionaries();
+    if (dictionaries.empty())
+        return nullptr;
+    auto &availableDictionary = req->getHeaderBy("available-dictionary");
+    if (!availableDictionary.empty())
+    {
+        for (auto &dictionary : dictionaries)
+        {
+            if (dictionary->matches(availableDictionary))
+                return dictionary.get();
+        }
+        return nullptr;
+    }
+    auto &id = req->getHeaderBy("dictionary-id");
+    if (id.empty())
+        return nullptr;
+    byId = true;
+    // The value is a structured field string
+    std::string_view idView = id;
+    if (idView.size() >= 2 && idView.front() == '"' && idView.back() == '"')
+        idView = idView.substr(1, idView.size() - 2);
+    for (auto &dictionary : dictionaries)
+    {
+        if (!dictionary->id().empty() && dictionary->id() == idView)
+            return dictionary.get();
+    }
+    return nullptr;
+}
+
 static inline HttpResponsePtr getCompressedResponse(
     const HttpRequestImplPtr &req,
     const HttpResponsePtr &response,
@@ -1250,57 +1765,77 @@ static inline HttpResponsePtr getCompressedResponse(
     {
         return response;
     }
+    auto &acceptEncoding = req->getHeaderBy("accept-encoding");
+    // The variants without a dictionary also depend on the dictionary
+    // headers
+    auto varyOnDictionary = [](const HttpResponsePtr &resp) {
+        if (!HttpAppFrameworkImpl::instance()
+                 .getCompressionDictionaries()
+                 .empty())
+            appendVary(resp, {"available-dictionary", "dictionary-id"});
+        return resp;
+    };
+    bool byId = false;
+    if (auto dictionary = findCompressionDictionary(req, byId))
+    {
+        for (auto encoding : {CompressionDictionary::Encoding::kBrotli,
+                              CompressionDictionary::Encoding::kZstd})
+        {
+            auto name = CompressionDictionary::name(encoding);
+            if (!CompressionDictionary::supports(encoding) ||
+                acceptEncoding.find(name) == std::string::npos)
+                continue;
+            auto strCompress =
+                dictionary->compress(response->getBody().data(),
+                                     response->getBody().length(),
+                                     encoding);
+            if (strCompress.empty())
+            {
+                LOG_ERROR << name << " got 0 length result";
+                break;
+            }
+            auto newResp =
+                setCompressedBody(response, std::move(strCompress), name);
+            // The shared caches must not serve it to other clients
+            if (byId)
+                appendVary(newResp,
+                           {"accept-encoding",
+                            "available-dictionary",
+                            "dictionary-id"});
+            else
+                appendVary(newResp,
+                           {"accept-encoding", "available-dictionary"});
+            return newResp;
+        }
+    }
 #ifdef USE_BROTLI
     if (app().isBrotliEnabled() &&
-        req->getHeaderBy("accept-encoding").find("br") != std::string::npos)
+        acceptEncoding.find("br") != std::string::npos)
     {
-        auto newResp = response;
         auto strCompress =
             drogon::utils::brotliCompress(response->getBody().data(),
                                           response->getBody().length());
         if (!strCompress.empty())
         {
-            if (response->expiredTime() >= 0)
-            {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
-            }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "br");
-        }
-        else
-        {
-            LOG_ERROR << "brotli got 0 length result";
+            return varyOnDictionary(
+                setCompressedBody(response, std::move(strCompress), "br"));
         }
-        return newResp;
+        LOG_ERROR << "brotli got 0 length result";
+        return response;
     }
 #endif
     if (app().isGzipEnabled() &&
-        req->getHeaderBy("accept-encoding").find("gzip") != std::string::npos)
+        acceptEncoding.find("gzip") != std::string::npos)
     {
-        auto newResp = response;
         auto strCompress =
             drogon::utils::gzipCompress(response->getBody().data(),
                                         response->getBody().length());
         if (!strCompress.empty())
         {
-            if (response->expiredTime() >= 0)
-            {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
-            }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "gzip");
-        }
-        else
-        {
-            LOG_ERROR << "gzip got 0 length result";
+            return varyOnDictionary(
+                setCompressedBody(response, std::move(strCompress), "gzip"));
         }
-        return newResp;
+        LOG_ERROR << "gzip got 0 length result";
     }
     return response;
 }
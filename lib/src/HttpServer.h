@@ -27,6 +27,7 @@ struct CallbackParamPack;
 namespace drogon
 {
 struct ControllerBinderBase;
+class HttpConnectionLimit;
 
 class HttpServer : trantor::NonCopyable
 {
@@ -49,6 +50,7 @@ class HttpServer : trantor::NonCopyable
     void enableSSL(trantor::TLSPolicyPtr policy)
     {
         server_.enableSSL(std::move(policy));
+        ssl_ = true;
     }
 
     void reloadSSL()
@@ -77,10 +79,18 @@ class HttpServer : trantor::NonCopyable
         connectionCallback_ = std::move(cb);
     }
 
+    // Count the connections against the limit instead of the global one, it
+    // must outlive the server.
+    void setConnectionLimit(HttpConnectionLimit *limit)
+    {
+        connectionLimit_ = limit;
+    }
+
   private:
     friend class HttpInternalForwardHelper;
 
-    static void onConnection(const trantor::TcpConnectionPtr &conn);
+    static void onConnection(const trantor::TcpConnectionPtr &conn,
+                             HttpConnectionLimit &limit);
     static void onMessage(const trantor::TcpConnectionPtr &,
                           trantor::MsgBuffer *);
     static void onRequests(const trantor::TcpConnectionPtr &,
@@ -101,9 +111,22 @@ class HttpServer : trantor::NonCopyable
         WebSocketConnectionImplPtr wsConnPtr;
     };
 
+    struct PreRoutingParamPack
+    {
+        std::function<void(const HttpResponsePtr &)> callback;
+    };
+
     // Http request handling steps
     static void onHttpRequest(const HttpRequestImplPtr &,
                               std::function<void(const HttpResponsePtr &)> &&);
+    static void httpRequestPreBody(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback);
+    static void httpRequestPreRoutingPack(const HttpRequestImplPtr &req,
+                                          PreRoutingParamPack &&pack);
+    static void httpRequestPreRouting(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback);
     static void httpRequestRouting(
         const HttpRequestImplPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback);
@@ -128,6 +151,14 @@ class HttpServer : trantor::NonCopyable
         WebSocketConnectionImplPtr &&wsConnPtr);
 
     // Http/Websocket shared handling steps
+    // Returns true if the handling continues with next() once the body of a
+    // stream mode request is received, or ends with an error response (e.g.
+    // the body can't be decompressed).
+    template <typename Pack>
+    static bool waitForRequestBody(const HttpRequestImplPtr &req,
+                                   Pack &pack,
+                                   void (*next)(const HttpRequestImplPtr &,
+                                                Pack &&));
     template <typename Pack>
     static void requestPostRouting(const HttpRequestImplPtr &req, Pack &&pack);
     template <typename Pack>
@@ -157,6 +188,8 @@ class HttpServer : trantor::NonCopyable
     std::function<void(int)> afterAcceptSetSockOptCallback_;
     // 跟踪管理连接的生命周期
     std::function<void(const trantor::TcpConnectionPtr &)> connectionCallback_;
+    HttpConnectionLimit *connectionLimit_{nullptr};
+    bool ssl_{false};
 };
 
 class HttpInternalForwardHelper
@@ -18,6 +18,7 @@
 #include <map>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
 
 namespace drogon
 {
@@ -581,6 +582,54 @@ const std::string_view &statusCodeToString(int code)
     }
 }
 
+bool ifNoneMatchMatches(std::string_view ifNoneMatch, std::string_view etag)
+{
+    auto weakPart = [](std::string_view tag) {
+        if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/')
+            tag.remove_prefix(2);
+        return tag;
+    };
+    etag = weakPart(etag);
+    while (!ifNoneMatch.empty())
+    {
+        auto pos = ifNoneMatch.find(',');
+        auto tag = ifNoneMatch.substr(0, pos);
+        ifNoneMatch.remove_prefix(pos == std::string_view::npos
+                                      ? ifNoneMatch.size()
+                                      : pos + 1);
+        while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+            tag.remove_prefix(1);
+        while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+            tag.remove_suffix(1);
+        if (tag == "*" || (!tag.empty() && weakPart(tag) == etag))
+            return true;
+    }
+    return false;
+}
+
+std::string_view statusLine(Version version, int code)
+{
+    static const std::vector<std::string> lines = [] {
+        std::vector<std::string> lines;
+        lines.reserve(2 * 500);
+        for (const char *versionString : {"HTTP/1.0 ", "HTTP/1.1 "})
+        {
+            for (int code = 100; code < 600; ++code)
+            {
+                std::string line{versionString};
+                line.append(std::to_string(code)).append(" ");
+                line.append(statusCodeToString(code)).append("\r\n");
+                lines.emplace_back(std::move(line));
+            }
+        }
+        return lines;
+    }();
+    if (code < 100 || code >= 600)
+        return {};
+    // Anything but HTTP/1.1 is answered as HTTP/1.0
+    return lines[(version == Version::kHttp11 ? 500 : 0) + code - 100];
+}
+
 ContentType getContentType(const std::string &fileName)
 {
     std::string extName;
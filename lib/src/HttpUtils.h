@@ -23,6 +23,10 @@ namespace drogon
 {
 const std::string_view &contentTypeToMime(ContentType contentType);
 const std::string_view &statusCodeToString(int code);
+// Returns the status line with the standard reason phrase of the code, e.g.
+// "HTTP/1.1 200 OK\r\n", or an empty view if the code is not in [100, 600).
+// All lines are rendered once.
+std::string_view statusLine(Version version, int code);
 ContentType getContentType(const std::string &fileName);
 ContentType parseContentType(const std::string_view &contentType);
 FileType parseFileType(const std::string_view &fileExtension);
@@ -32,6 +36,9 @@ void registerCustomExtensionMime(const std::string &ext,
 const std::string_view fileNameToMime(const std::string &fileName);
 std::pair<ContentType, const std::string_view> fileNameToContentTypeAndMime(
     const std::string &filename);
+// Returns true if the If-None-Match header value (a list of entity tags or
+// "*") matches the entity tag with the weak comparison of rfc9110-8.8.3.2.
+bool ifNoneMatchMatches(std::string_view ifNoneMatch, std::string_view etag);
 
 inline std::string_view getFileExtension(const std::string &fileName)
 {
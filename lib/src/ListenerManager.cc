@@ -16,6 +16,10 @@
 #include <drogon/config.h>
 #include <fcntl.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include "CpuAffinity.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpServer.h"
 #ifndef _WIN32
@@ -50,6 +54,51 @@ class DrogonFileLocker : public trantor::NonCopyable
 using namespace trantor;
 using namespace drogon;
 
+namespace
+{
+const double utilizationInterval = 1.0;
+
+// The CPU time of the calling thread in seconds, negative if it's unknown
+double threadCpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    return -1.0;
+}
+
+// A loop waiting in poll() is off the CPU, so the share of the CPU time in the
+// wall time of a sampling period is the fraction of the period the loop was
+// busy
+void sampleUtilization(trantor::EventLoop *loop,
+                       std::atomic<double> *utilization)
+{
+    loop->queueInLoop([loop, utilization]() {
+        auto cpuTime = threadCpuTime();
+        if (cpuTime < 0)
+            return;
+        auto last = std::make_shared<
+            std::pair<double, std::chrono::steady_clock::time_point>>(
+            cpuTime, std::chrono::steady_clock::now());
+        loop->runEvery(utilizationInterval, [last, utilization]() {
+            auto cpuTime = threadCpuTime();
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> wallTime = now - last->second;
+            if (wallTime.count() > 0)
+            {
+                utilization->store((std::min)(1.0,
+                                              (cpuTime - last->first) /
+                                                  wallTime.count()),
+                                   std::memory_order_relaxed);
+            }
+            *last = {cpuTime, now};
+        });
+    });
+}
+}  // namespace
+
 void ListenerManager::addListener(
     const std::string &ip,
     uint16_t port,
@@ -68,6 +117,113 @@ void ListenerManager::addListener(
         ip, port, useSSL, certFile, keyFile, useOldTLS, sslConfCmds);
 }
 
+void ListenerManager::setThreadGroup(const std::string &ip,
+                                     uint16_t port,
+                                     size_t threadNum,
+                                     size_t maxConnections)
+{
+    bool found{false};
+    for (auto &listener : listeners_)
+    {
+        if (listener.ip_ == ip && listener.port_ == port)
+        {
+            listener.threadNum_ = threadNum;
+            listener.maxConnections_ = maxConnections;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        LOG_ERROR << "No listener on " << ip << ":" << port
+                  << ", add it before giving it a thread group";
+    }
+}
+
+void ListenerManager::createThreadGroups(
+    const std::vector<trantor::EventLoop *> &ioLoops)
+{
+    size_t dedicatedNum{0};
+    for (auto const &listener : listeners_)
+    {
+        dedicatedNum += listener.threadNum_;
+    }
+    if (dedicatedNum > 0 && dedicatedNum >= ioLoops.size())
+    {
+        LOG_FATAL << "The listeners with their own IO loops need "
+                  << dedicatedNum << " threads, the number of threads must be "
+                  << "greater than that to leave loops to the other listeners";
+        abort();
+    }
+    // The dedicated groups take their loops from the end of the IO loops, so
+    // the loop indices (and the IOThreadStorage slots) stay the same
+    auto sharedNum = ioLoops.size() - dedicatedNum;
+    auto shared = std::make_unique<ThreadGroup>();
+    shared->name = "shared";
+    shared->loops.assign(ioLoops.begin(), ioLoops.begin() + sharedNum);
+    threadGroups_.push_back(std::move(shared));
+    auto &globalLimit = HttpConnectionLimit::instance();
+    auto firstLoop = sharedNum;
+    for (auto &listener : listeners_)
+    {
+        if (listener.threadNum_ == 0)
+            continue;
+        auto group = std::make_unique<ThreadGroup>();
+        group->name = (listener.ip_.find(':') != std::string::npos
+                           ? "[" + listener.ip_ + "]"
+                           : listener.ip_) +
+                      ":" + std::to_string(listener.port_);
+        group->firstLoop = firstLoop;
+        group->loops.assign(ioLoops.begin() + firstLoop,
+                            ioLoops.begin() + firstLoop + listener.threadNum_);
+        firstLoop += listener.threadNum_;
+        group->limit = std::make_unique<HttpConnectionLimit>();
+        group->limit->setMaxConnectionNum(
+            listener.maxConnections_ > 0 ? listener.maxConnections_
+                                         : globalLimit.getMaxConnectionNum());
+        group->limit->sharePerIPLimit(globalLimit);
+        LOG_INFO << "Listener " << group->name << " runs on the IO loops "
+                 << group->firstLoop << "-"
+                 << group->firstLoop + group->loops.size() - 1
+                 << " with up to " << group->limit->getMaxConnectionNum()
+                 << " connections";
+        listener.threadGroup_ = group.get();
+        threadGroups_.push_back(std::move(group));
+    }
+    for (auto &group : threadGroups_)
+    {
+        group->utilization =
+            std::make_unique<std::atomic<double>[]>(group->loops.size());
+    }
+}
+
+const ListenerManager::ThreadGroup &ListenerManager::findThreadGroup(
+    const std::string &ip,
+    uint16_t port) const
+{
+    assert(!threadGroups_.empty());
+    for (auto const &listener : listeners_)
+    {
+        if (listener.ip_ == ip && listener.port_ == port &&
+            listener.threadGroup_)
+            return *listener.threadGroup_;
+    }
+    return *threadGroups_.front();
+}
+
+std::vector<trantor::EventLoop *> ListenerManager::getIoLoops(
+    const std::string &ip,
+    uint16_t port) const
+{
+    return findThreadGroup(ip, port).loops;
+}
+
+HttpConnectionLimit &ListenerManager::getConnectionLimit(const std::string &ip,
+                                                         uint16_t port) const
+{
+    auto &group = findThreadGroup(ip, port);
+    return group.limit ? *group.limit : HttpConnectionLimit::instance();
+}
+
 std::vector<trantor::InetAddress> ListenerManager::getListeners() const
 {
     std::vector<trantor::InetAddress> listeners;
@@ -86,39 +242,62 @@ void ListenerManager::createListeners(
     const std::vector<trantor::EventLoop *> &ioLoops)
 {
     LOG_TRACE << "thread num=" << ioLoops.size();
+    createThreadGroups(ioLoops);
 #ifdef __linux__
-    for (size_t i = 0; i < ioLoops.size(); ++i)
+    for (auto &listener : listeners_)
     {
-        for (auto const &listener : listeners_)
+        auto group = listener.threadGroup_ ? listener.threadGroup_
+                                           : threadGroups_.front().get();
+        auto const &ip = listener.ip_;
+        bool isIpv6 = (ip.find(':') != std::string::npos);
+        InetAddress listenAddress(ip, listener.port_, isIpv6);
+        if (listenAddress.isUnspecified())
         {
-            auto const &ip = listener.ip_;
-            bool isIpv6 = (ip.find(':') != std::string::npos);
-            InetAddress listenAddress(ip, listener.port_, isIpv6);
-            if (listenAddress.isUnspecified())
+            LOG_FATAL << "Failed to parse IP address '" << ip
+                      << "'. (Note: FQDN/domain names/hostnames are not "
+                         "supported. Including 'localhost')";
+            abort();
+        }
+        if (!app().reusePort())
+        {
+            DrogonFileLocker lock;
+            // Check whether the port is in use.
+            TcpServer server(HttpAppFrameworkImpl::instance().getLoop(),
+                             listenAddress,
+                             "drogonPortTest",
+                             true,
+                             false);
+        }
+        for (size_t j = 0; j < group->loops.size(); ++j)
+        {
+            auto i = group->firstLoop + j;
+            std::shared_ptr<HttpServer> serverPtr =
+                std::make_shared<HttpServer>(group->loops[j],
+                                             listenAddress,
+                                             "drogon");
+            if (group->limit)
             {
-                LOG_FATAL << "Failed to parse IP address '" << ip
-                          << "'. (Note: FQDN/domain names/hostnames are not "
-                             "supported. Including 'localhost')";
-                abort();
+                serverPtr->setConnectionLimit(group->limit.get());
             }
-            if (i == 0 && !app().reusePort())
+            auto beforeListenCallback = beforeListenSetSockOptCallback_;
+            // The listener of a pinned loop prefers the connections received
+            // on its CPU among the SO_REUSEPORT listeners of the address
+            auto incomingCpu = CpuAffinity::incomingCpu(
+                HttpAppFrameworkImpl::instance().getCpuAffinity(), i);
+            if (incomingCpu >= 0)
             {
-                DrogonFileLocker lock;
-                // Check whether the port is in use.
-                TcpServer server(HttpAppFrameworkImpl::instance().getLoop(),
-                                 listenAddress,
-                                 "drogonPortTest",
-                                 true,
-                                 false);
+                beforeListenCallback = [cb = std::move(beforeListenCallback),
+                                        incomingCpu](int fd) {
+                    if (cb)
+                        cb(fd);
+                    CpuAffinity::setIncomingCpu(
+                        fd, static_cast<unsigned int>(incomingCpu));
+                };
             }
-            std::shared_ptr<HttpServer> serverPtr =
-                std::make_shared<HttpServer>(ioLoops[i],
-                                             listenAddress,
-                                             "drogon");
-            if (beforeListenSetSockOptCallback_)
+            if (beforeListenCallback)
             {
                 serverPtr->setBeforeListenSockOptCallback(
-                    beforeListenSetSockOptCallback_);
+                    std::move(beforeListenCallback));
             }
             if (afterAcceptSetSockOptCallback_)
             {
@@ -205,9 +384,15 @@ void ListenerManager::createListeners(
                 policy->setConfCmds(cmds).setUseOldTLS(listener.useOldTLS_);
                 serverPtr->enableSSL(std::move(policy));
             }
-            // 这里传入了全部的 EventLoop 对象
             // 将IO任务分摊到多个线程上，充分利用多核CPU的资源，避免单个IO线程成为性能瓶颈
-            serverPtr->setIoLoops(ioLoops);
+            // The loops of the group of the listener
+            auto group = listener.threadGroup_ ? listener.threadGroup_
+                                               : threadGroups_.front().get();
+            serverPtr->setIoLoops(group->loops);
+            if (group->limit)
+            {
+                serverPtr->setConnectionLimit(group->limit.get());
+            }
             servers_.push_back(serverPtr);
         }
     }
@@ -220,6 +405,56 @@ void ListenerManager::startListening()
     {
         server->start();
     }
+    // The utilization is only reported for the listeners with their own
+    // loops, the timers are left out of the loops otherwise
+    if (threadGroups_.size() > 1)
+    {
+        for (auto &group : threadGroups_)
+        {
+            for (size_t i = 0; i < group->loops.size(); ++i)
+            {
+                sampleUtilization(group->loops[i], &group->utilization[i]);
+            }
+        }
+    }
+}
+
+std::vector<IoThreadGroupStats> ListenerManager::getThreadGroupStats() const
+{
+    std::vector<IoThreadGroupStats> stats;
+    for (auto const &group : threadGroups_)
+    {
+        IoThreadGroupStats groupStats;
+        auto &limit =
+            group->limit ? *group->limit : HttpConnectionLimit::instance();
+        groupStats.name = group->name;
+        groupStats.threads = group->loops.size();
+        groupStats.connections = limit.getConnectionNum();
+        groupStats.maxConnections = limit.getMaxConnectionNum();
+        for (size_t i = 0; i < group->loops.size(); ++i)
+        {
+            auto utilization =
+                group->utilization[i].load(std::memory_order_relaxed);
+            groupStats.utilization += utilization;
+            groupStats.maxUtilization =
+                (std::max)(groupStats.maxUtilization, utilization);
+        }
+        if (!group->loops.empty())
+            groupStats.utilization /= group->loops.size();
+        stats.push_back(std::move(groupStats));
+    }
+    return stats;
+}
+
+size_t ListenerManager::getThreadGroupConnectionNum() const
+{
+    size_t num{0};
+    for (auto const &group : threadGroups_)
+    {
+        if (group->limit)
+            num += group->limit->getConnectionNum();
+    }
+    return num;
 }
 
 void ListenerManager::stopListening()
@@ -17,10 +17,12 @@
 #include <trantor/net/EventLoopThreadPool.h>
 #include <trantor/net/callbacks.h>
 #include <trantor/utils/NonCopyable.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
+#include "HttpConnectionLimit.h"
 #include "impl_forwards.h"
 
 namespace trantor
@@ -30,6 +32,8 @@ class InetAddress;
 
 namespace drogon
 {
+struct IoThreadGroupStats;
+
 class ListenerManager : public trantor::NonCopyable
 {
   public:
@@ -45,7 +49,26 @@ class ListenerManager : public trantor::NonCopyable
                      // SSL的配置命令
                      const std::vector<std::pair<std::string, std::string>>
                          &sslConfCmds = {});
+    // Give the listener added before threadNum IO loops of its own, see
+    // HttpAppFramework::setListenerThreadGroup()
+    void setThreadGroup(const std::string &ip,
+                        uint16_t port,
+                        size_t threadNum,
+                        size_t maxConnections);
     std::vector<trantor::InetAddress> getListeners() const;
+    // Split the IO loops between the shared group and the listeners with
+    // loops of their own, called once by createListeners()
+    void createThreadGroups(const std::vector<trantor::EventLoop *> &ioLoops);
+    // The IO loops serving the listener and the limit its connections are
+    // counted in, after createThreadGroups()
+    std::vector<trantor::EventLoop *> getIoLoops(const std::string &ip,
+                                                 uint16_t port) const;
+    HttpConnectionLimit &getConnectionLimit(const std::string &ip,
+                                            uint16_t port) const;
+    std::vector<IoThreadGroupStats> getThreadGroupStats() const;
+    // The connections of the listeners with their own IO loops, they are not
+    // counted by the global HttpConnectionLimit
+    size_t getThreadGroupConnectionNum() const;
     // 在事件循环内部创建监听套接字
     void createListeners(
         const std::string &globalCertFile,
@@ -78,6 +101,24 @@ class ListenerManager : public trantor::NonCopyable
     void reloadSSLFiles();
 
   private:
+    // The IO loops serving a set of listeners, the first group is shared by
+    // the listeners without loops of their own
+    struct ThreadGroup
+    {
+        std::string name;
+        // The index of the first loop of the group in the IO loops
+        size_t firstLoop{0};
+        std::vector<trantor::EventLoop *> loops;
+        // nullptr for the shared group, which uses the global limit
+        std::unique_ptr<HttpConnectionLimit> limit;
+        // The fraction of time each loop of the group spent on the CPU during
+        // the last sampling period
+        std::unique_ptr<std::atomic<double>[]> utilization;
+    };
+
+    const ThreadGroup &findThreadGroup(const std::string &ip,
+                                       uint16_t port) const;
+
     struct ListenerInfo
     {
         ListenerInfo(
@@ -105,9 +146,15 @@ class ListenerManager : public trantor::NonCopyable
         std::string keyFile_;
         bool useOldTLS_;
         std::vector<std::pair<std::string, std::string>> sslConfCmds_;
+        size_t threadNum_{0};
+        size_t maxConnections_{0};
+        ThreadGroup *threadGroup_{nullptr};
     };
 
     std::vector<ListenerInfo> listeners_;
+    // Declared before the servers, which count their connections in the
+    // limits of the groups
+    std::vector<std::unique_ptr<ThreadGroup>> threadGroups_;
     std::vector<std::shared_ptr<HttpServer>> servers_;
 
     // should have value when and only when on OS that one port can only be
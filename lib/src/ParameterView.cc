@@ -0,0 +1,261 @@
+/**
+ *
+ *  @file ParameterView.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/ParameterView.h>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+using namespace drogon;
+
+namespace
+{
+bool needDecoding(std::string_view str)
+{
+    return utils::needUrlDecoding(str.data(), str.data() + str.size());
+}
+
+std::string decode(std::string_view str)
+{
+    return utils::urlDecode(str.data(), str.data() + str.size());
+}
+}  // namespace
+
+void ParameterView::parse(std::string_view input, bool body)
+{
+    if (input.empty() || input.size() > std::numeric_limits<uint32_t>::max())
+        return;
+    auto source = body ? Source::kBody : Source::kQuery;
+    auto base = input.data();
+    auto parsed = slices_.size();
+    std::string_view::size_type pos = 0;
+    while (pos < input.length() &&
+           (input[pos] == '?' ||
+            isspace(static_cast<unsigned char>(input[pos]))))
+    {
+        ++pos;
+    }
+    auto add = [this, source, base](std::string_view key,
+                                    std::string_view value,
+                                    bool hasValue) {
+        Slice slice;
+        slice.source = source;
+        slice.keyEscaped = needDecoding(key);
+        slice.valueEscaped = needDecoding(value);
+        slice.hasValue = hasValue;
+        slice.keyOffset = static_cast<uint32_t>(key.data() - base);
+        slice.keyLength = static_cast<uint32_t>(key.size());
+        slice.valueOffset = static_cast<uint32_t>(value.data() - base);
+        slice.valueLength = static_cast<uint32_t>(value.size());
+        slices_.push_back(slice);
+    };
+    // The pieces are split as in the former eager parsing: the leading
+    // spaces of a key are skipped, a piece without '=' is a key with an empty
+    // value unless it already has one, and so is an empty piece before a '&'.
+    auto addPiece = [&add](std::string_view piece) {
+        auto epos = piece.find('=');
+        if (epos == std::string_view::npos)
+        {
+            add(piece, piece.substr(piece.size()), false);
+            return;
+        }
+        auto key = piece.substr(0, epos);
+        std::string_view::size_type cpos = 0;
+        while (cpos < key.length() &&
+               isspace(static_cast<unsigned char>(key[cpos])))
+            ++cpos;
+        key.remove_prefix(cpos);
+        add(key, piece.substr(epos + 1), true);
+    };
+    auto rest = input.substr(pos);
+    while ((pos = rest.find('&')) != std::string_view::npos)
+    {
+        addPiece(rest.substr(0, pos));
+        rest.remove_prefix(pos + 1);
+    }
+    if (!rest.empty())
+        addPiece(rest);
+    // Parsed again after clearParsed(), the parameters set by the user still
+    // replace those of the request
+    if (parsed > 0 && slices_[parsed - 1].source == Source::kOwned)
+    {
+        std::stable_partition(slices_.begin(),
+                              slices_.end(),
+                              [](const Slice &slice) {
+                                  return slice.source != Source::kOwned;
+                              });
+        clearIndex();
+    }
+}
+
+void ParameterView::set(const std::string &key, const std::string &value)
+{
+    Slice slice;
+    slice.source = Source::kOwned;
+    slice.keyEscaped = false;
+    slice.valueEscaped = false;
+    slice.hasValue = true;
+    slice.keyOffset = static_cast<uint32_t>(owned_.size());
+    owned_.push_back(key);
+    slice.valueOffset = static_cast<uint32_t>(owned_.size());
+    owned_.push_back(value);
+    slice.keyLength = 0;
+    slice.valueLength = 0;
+    slices_.push_back(slice);
+}
+
+void ParameterView::clear()
+{
+    slices_.clear();
+    owned_.clear();
+    clearIndex();
+    query_ = std::string_view();
+    body_ = std::string_view();
+}
+
+void ParameterView::clearParsed()
+{
+    // The decoded strings of the parsed parameters are dropped too
+    std::vector<Slice> slices;
+    std::deque<std::string> owned;
+    for (auto &slice : slices_)
+    {
+        if (slice.source != Source::kOwned)
+            continue;
+        slices.push_back(slice);
+        auto &copy = slices.back();
+        copy.keyOffset = static_cast<uint32_t>(owned.size());
+        owned.push_back(std::move(owned_[slice.keyOffset]));
+        copy.valueOffset = static_cast<uint32_t>(owned.size());
+        owned.push_back(std::move(owned_[slice.valueOffset]));
+    }
+    slices_ = std::move(slices);
+    owned_ = std::move(owned);
+    clearIndex();
+    query_ = std::string_view();
+    body_ = std::string_view();
+}
+
+std::string_view ParameterView::key(const Slice &slice) const
+{
+    switch (slice.source)
+    {
+        case Source::kQuery:
+            return query_.substr(slice.keyOffset, slice.keyLength);
+        case Source::kBody:
+            return body_.substr(slice.keyOffset, slice.keyLength);
+        default:
+            return owned_[slice.keyOffset];
+    }
+}
+
+std::string_view ParameterView::decodedKey(const Slice &slice) const
+{
+    if (!slice.keyEscaped)
+        return key(slice);
+    if (slice.decodedKey == 0)
+    {
+        owned_.push_back(decode(key(slice)));
+        slice.decodedKey = static_cast<uint32_t>(owned_.size());
+    }
+    return owned_[slice.decodedKey - 1];
+}
+
+std::string_view ParameterView::rawValue(const Slice &slice) const
+{
+    switch (slice.source)
+    {
+        case Source::kQuery:
+            return query_.substr(slice.valueOffset, slice.valueLength);
+        case Source::kBody:
+            return body_.substr(slice.valueOffset, slice.valueLength);
+        default:
+            return owned_[slice.valueOffset];
+    }
+}
+
+std::string_view ParameterView::value(const Slice &slice) const
+{
+    if (!slice.valueEscaped)
+        return rawValue(slice);
+    if (slice.decodedValue == 0)
+    {
+        owned_.push_back(decode(rawValue(slice)));
+        slice.decodedValue = static_cast<uint32_t>(owned_.size());
+    }
+    return owned_[slice.decodedValue - 1];
+}
+
+const ParameterView::Slice *ParameterView::find(std::string_view key) const
+{
+    // Every key is decoded once, not on every lookup
+    for (; indexedSlices_ < slices_.size(); ++indexedSlices_)
+    {
+        // The last one with a value wins
+        auto &slice = slices_[indexedSlices_];
+        auto index = static_cast<uint32_t>(indexedSlices_);
+        if (slice.hasValue)
+            index_[decodedKey(slice)] = index;
+        else
+            index_.emplace(decodedKey(slice), index);
+    }
+    auto iter = index_.find(key);
+    if (iter == index_.end())
+        return nullptr;
+    return &slices_[iter->second];
+}
+
+std::optional<std::string_view> ParameterView::get(std::string_view key) const
+{
+    auto slice = find(key);
+    if (!slice)
+        return std::nullopt;
+    return value(*slice);
+}
+
+bool ParameterView::contains(std::string_view key) const
+{
+    return find(key) != nullptr;
+}
+
+void ParameterView::forEach(
+    const std::function<void(std::string_view key, std::string_view value)>
+        &function) const
+{
+    for (auto &slice : slices_)
+    {
+        auto rawKey = key(slice);
+        if (slice.keyEscaped)
+            function(decode(rawKey), value(slice));
+        else
+            function(rawKey, value(slice));
+    }
+}
+
+void ParameterView::materialize(SafeStringMap<std::string> &parameters) const
+{
+    for (auto &slice : slices_)
+    {
+        auto rawKey = key(slice);
+        auto &value = slice.keyEscaped ? parameters[decode(rawKey)]
+                                       : parameters[std::string(rawKey)];
+        if (!slice.hasValue)
+            continue;
+        auto rawValue = this->rawValue(slice);
+        if (slice.valueEscaped)
+            value = decode(rawValue);
+        else
+            value.assign(rawValue.data(), rawValue.size());
+    }
+}
@@ -14,9 +14,24 @@
 
 #include "PluginsManager.h"
 #include <trantor/utils/Logger.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace drogon;
 
+namespace
+{
+// The time the plugin being initialized in the current thread started, a
+// plugin is initialized right after its dependencies
+thread_local std::chrono::steady_clock::time_point initStart;
+}  // namespace
+
 PluginsManager::~PluginsManager()
 {
     // Shut down all plugins in reverse order of initialization.
@@ -30,10 +45,12 @@ PluginsManager::~PluginsManager()
 
 void PluginsManager::initializeAllPlugins(
     const Json::Value &configs,
-    const std::function<void(PluginBase *)> &forEachCallback)
+    const std::function<void(PluginBase *)> &forEachCallback,
+    size_t threadNum)
 {
     assert(configs.isArray());
     std::vector<PluginBase *> plugins;
+    std::unordered_set<PluginBase *> parallelPlugins;
     for (auto &config : configs)
     {
         auto name = config.get("name", "").asString();
@@ -74,19 +91,154 @@ void PluginsManager::initializeAllPlugins(
             }
         }
         pluginPtr->setInitializedCallback([this](PluginBase *p) {
-            LOG_TRACE << "Plugin " << p->className() << " initialized!";
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed = now - initStart;
+            initStart = now;
+            LOG_TRACE << "Plugin " << p->className() << " initialized in "
+                      << elapsed.count() << "s!";
+            std::lock_guard<std::mutex> lock(mutex_);
             initializedPlugins_.push_back(p);
+            initializationTimes_.emplace_back(p->className(), elapsed.count());
         });
         plugins.push_back(pluginPtr);
+        if (config.get("parallel_init", false).asBool())
+            parallelPlugins.insert(pluginPtr);
+    }
+    if (threadNum > 1 && parallelPlugins.size() > 1)
+    {
+        // Only the opted-in plugins depending on opted-in plugins only are
+        // initialized on the pool, the others are initialized below in the
+        // main thread
+        std::unordered_map<PluginBase *, bool> eligible;
+        std::function<bool(PluginBase *)> isEligible;
+        isEligible = [&](PluginBase *plugin) {
+            auto iter = eligible.find(plugin);
+            if (iter != eligible.end())
+                return iter->second;
+            // Also ends a circular dependency, which is reported below
+            eligible[plugin] = false;
+            if (parallelPlugins.find(plugin) == parallelPlugins.end())
+                return false;
+            for (auto dependency : plugin->dependencies_)
+            {
+                if (!isEligible(dependency))
+                    return false;
+            }
+            eligible[plugin] = true;
+            return true;
+        };
+        std::vector<PluginBase *> poolPlugins;
+        for (auto plugin : plugins)
+        {
+            if (isEligible(plugin))
+                poolPlugins.push_back(plugin);
+        }
+        if (poolPlugins.size() > 1)
+            initializeInParallel(poolPlugins, threadNum);
     }
     // Initialize them, Depth first
     for (auto plugin : plugins)
     {
+        initStart = std::chrono::steady_clock::now();
         plugin->initialize();
         forEachCallback(plugin);
     }
 }
 
+void PluginsManager::initializeInParallel(
+    const std::vector<PluginBase *> &plugins,
+    size_t threadNum)
+{
+    // The number of dependencies to wait for and the dependent plugins of
+    // each plugin
+    std::unordered_map<PluginBase *, size_t> waiting;
+    std::unordered_map<PluginBase *, std::vector<PluginBase *>> dependents;
+    std::deque<PluginBase *> ready;
+    for (auto plugin : plugins)
+    {
+        if (waiting.find(plugin) != waiting.end())
+            continue;
+        std::unordered_set<PluginBase *> dependencies(
+            plugin->dependencies_.begin(), plugin->dependencies_.end());
+        waiting[plugin] = dependencies.size();
+        for (auto dependency : dependencies)
+        {
+            dependents[dependency].push_back(plugin);
+        }
+        if (dependencies.empty())
+            ready.push_back(plugin);
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t left = waiting.size();
+    size_t running = 0;
+    std::exception_ptr exception;
+    auto work = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            cond.wait(lock, [&]() {
+                return left == 0 || exception || !ready.empty() ||
+                       running == 0;
+            });
+            if (left == 0 || exception)
+                return;
+            if (ready.empty())
+            {
+                LOG_FATAL << "There are a circular dependency within plugins.";
+                abort();
+            }
+            auto plugin = ready.front();
+            ready.pop_front();
+            ++running;
+            lock.unlock();
+            std::exception_ptr error;
+            // The dependencies are initialized, only the plugin itself is
+            // initialized here
+            initStart = std::chrono::steady_clock::now();
+            try
+            {
+                plugin->initialize();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+            --running;
+            if (error)
+            {
+                exception = error;
+            }
+            else
+            {
+                --left;
+                for (auto dependent : dependents[plugin])
+                {
+                    if (--waiting[dependent] == 0)
+                        ready.push_back(dependent);
+                }
+            }
+            cond.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    auto extraThreads = (std::min)(threadNum, waiting.size()) - 1;
+    for (size_t i = 0; i < extraThreads; ++i)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
 void PluginsManager::createPlugin(const std::string &pluginName)
 {
     auto pluginPtr = std::dynamic_pointer_cast<PluginBase>(
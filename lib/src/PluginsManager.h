@@ -15,6 +15,10 @@
 #pragma once
 #include <drogon/plugins/Plugin.h>
 #include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace drogon
 {
@@ -23,9 +27,25 @@ using PluginBasePtr = std::shared_ptr<PluginBase>;
 class PluginsManager : trantor::NonCopyable
 {
   public:
+    /**
+     * Initialize the plugins, a plugin is initialized after its dependencies.
+     * With more than one thread, the plugins with "parallel_init" set in
+     * their configs, whose dependencies are all set too, are initialized in
+     * parallel first. The other plugins are then initialized in the main
+     * thread in the order of the configs.
+     */
     void initializeAllPlugins(
         const Json::Value &configs,
-        const std::function<void(PluginBase *)> &forEachCallback);
+        const std::function<void(PluginBase *)> &forEachCallback,
+        size_t threadNum = 1);
+
+    // The initialization time of each plugin in seconds, in the order of
+    // initialization
+    const std::vector<std::pair<std::string, double>> &initializationTimes()
+        const
+    {
+        return initializationTimes_;
+    }
 
     PluginBase *getPlugin(const std::string &pluginName);
 
@@ -35,8 +55,13 @@ class PluginsManager : trantor::NonCopyable
 
   private:
     void createPlugin(const std::string &pluginName);
+    void initializeInParallel(const std::vector<PluginBase *> &plugins,
+                              size_t threadNum);
     std::map<std::string, PluginBasePtr> pluginsMap_;
+    // Guards the initialized plugins and their times
+    std::mutex mutex_;
     std::vector<PluginBase *> initializedPlugins_;
+    std::vector<std::pair<std::string, double>> initializationTimes_;
 };
 
 }  // namespace drogon
@@ -4,6 +4,7 @@
 #include <drogon/utils/monitoring/Gauge.h>
 #include <drogon/utils/monitoring/Histogram.h>
 #include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/AllocatorCollector.h>
 
 using namespace drogon;
 using namespace drogon::monitoring;
@@ -108,6 +109,14 @@ void PromExporter::initAndStart(const Json::Value &config)
             LOG_ERROR << "collectors must be an array!";
         }
     }
+    if (config.get("allocator_stats", false).asBool())
+    {
+        registerCollector(std::make_shared<AllocatorCollector>());
+        if (RequestAllocationCollector::enabled())
+        {
+            registerCollector(std::make_shared<RequestAllocationCollector>());
+        }
+    }
 }
 
 static std::string exportCollector(
@@ -14,11 +14,19 @@
 
 #include "RangeParser.h"
 
+#include <algorithm>
 #include <limits>
 
 using namespace drogon;
 
 static constexpr size_t MAX_SIZE = std::numeric_limits<size_t>::max();
+// We restrict the number of ranges to be under 100, to avoid malicious
+// requests. Though rfc does not say anything about max number of ranges, it
+// does mention that server can ignore range header freely.
+static constexpr size_t MAX_RANGES = 100;
+// Ranges separated by a gap smaller than the overhead of a part header of a
+// multipart/byteranges response are coalesced, rfc7233-4.1.
+static constexpr size_t MIN_GAP_BETWEEN_PARTS = 80;
 static constexpr size_t MAX_TEN = MAX_SIZE / 10;
 static constexpr size_t MAX_DIGIT = MAX_SIZE % 10;
 
@@ -50,7 +58,6 @@ FileRangeParseResult drogon::parseRangeHeader(const std::string &rangeStr,
     }
     const char *iter = rangeStr.c_str() + 6;
 
-    size_t totalSize = 0;
     while (true)
     {
         size_t start = 0;
@@ -95,12 +102,11 @@ FileRangeParseResult drogon::parseRangeHeader(const std::string &rangeStr,
                 // Handle found
                 if (start < end)
                 {
-                    if (totalSize > MAX_SIZE - (end - start))
+                    ranges.push_back({start, end});
+                    if (ranges.size() > MAX_RANGES)
                     {
-                        return NotSatisfiable;
+                        return InvalidRange;
                     }
-                    totalSize += end - start;
-                    ranges.push_back({start, end});
                 }
                 if (*iter++ != ',')
                 {
@@ -148,16 +154,7 @@ FileRangeParseResult drogon::parseRangeHeader(const std::string &rangeStr,
         if (start < end)
         {
             ranges.push_back({start, end});
-            if (totalSize > MAX_SIZE - (end - start))
-            {
-                return NotSatisfiable;
-            }
-            totalSize += end - start;
-            // We restrict the number to be under 100, to avoid malicious
-            // requests.
-            // Though rfc does not say anything about max number of ranges,
-            // it does mention that server can ignore range header freely.
-            if (ranges.size() > 100)
+            if (ranges.size() > MAX_RANGES)
             {
                 return InvalidRange;
             }
@@ -168,13 +165,42 @@ FileRangeParseResult drogon::parseRangeHeader(const std::string &rangeStr,
         }
     }
 
-    if (ranges.size() == 0 || totalSize > contentLength)
+    if (ranges.size() == 0)
     {
         return NotSatisfiable;
     }
+    coalesceRanges(ranges);
     return ranges.size() == 1 ? SinglePart : MultiPart;
 }
 
+void drogon::coalesceRanges(std::vector<FileRange> &ranges)
+{
+    if (ranges.size() < 2)
+    {
+        return;
+    }
+    std::sort(ranges.begin(),
+              ranges.end(),
+              [](const FileRange &a, const FileRange &b) {
+                  return a.start < b.start;
+              });
+    size_t last = 0;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        // Overlapping, adjacent or separated by a small gap
+        if (ranges[i].start <= ranges[last].end ||
+            ranges[i].start - ranges[last].end < MIN_GAP_BETWEEN_PARTS)
+        {
+            ranges[last].end = (std::max)(ranges[last].end, ranges[i].end);
+        }
+        else
+        {
+            ranges[++last] = ranges[i];
+        }
+    }
+    ranges.resize(last + 1);
+}
+
 #undef DR_SKIP_WHITESPACE
 #undef DR_ISDIGIT
 #undef DR_WOULD_OVERFLOW
@@ -34,8 +34,18 @@ enum FileRangeParseResult
     MultiPart = 2
 };
 
+/**
+ * Parse the Range header, the ranges are sorted and the overlapping or
+ * adjacent ones are coalesced (see coalesceRanges()).
+ */
 FileRangeParseResult parseRangeHeader(const std::string &rangeStr,
                                       size_t contentLength,
                                       std::vector<FileRange> &ranges);
 
+/**
+ * Sort the ranges by their start and merge the ranges that overlap or are
+ * separated by a gap smaller than the overhead of a multipart part.
+ */
+void coalesceRanges(std::vector<FileRange> &ranges);
+
 }  // namespace drogon
@@ -55,6 +55,13 @@ class RedisClientManager : public trantor::NonCopyable
                            unsigned int db);
     // bool areAllRedisClientsAvailable() const noexcept;
 
+    // Return true if every client, except the fast ones, has established
+    // minConnections connections (or all of them if it has fewer)
+    bool areAllRedisClientsWarmedUp(size_t minConnections) const noexcept;
+
+    // The event loops of the clients, except the fast ones
+    std::vector<trantor::EventLoop *> getClientLoops() const;
+
     ~RedisClientManager();
 
   private:
@@ -49,6 +49,16 @@ void RedisClientManager::createRedisClient(const std::string & /*name*/,
 //     abort();
 // }
 
+bool RedisClientManager::areAllRedisClientsWarmedUp(size_t) const noexcept
+{
+    return true;
+}
+
+std::vector<trantor::EventLoop *> RedisClientManager::getClientLoops() const
+{
+    return {};
+}
+
 RedisClientManager::~RedisClientManager()
 {
 }
@@ -0,0 +1,408 @@
+/**
+ *
+ *  @file ResponseStream.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <stdio.h>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Frames the chunks of a ResponseStream and tracks the data waiting to
+ * be sent. The chunks are written in the event loop of the connection, the
+ * ones sent from other threads are moved there with their payload.
+ */
+class ChunkWriter : public std::enable_shared_from_this<ChunkWriter>
+{
+  public:
+    ChunkWriter(trantor::AsyncStreamPtr asyncStream,
+                const trantor::TcpConnectionPtr &conn)
+        : asyncStream_(std::move(asyncStream)),
+          conn_(conn),
+          loop_(conn ? conn->getLoop() : nullptr)
+    {
+    }
+
+    void start()
+    {
+        if (!loop_)
+            return;
+        loop_->runInLoop([thisPtr = shared_from_this()]() {
+            thisPtr->watchConnection();
+        });
+    }
+
+    template <typename Payload>
+    bool send(Payload &&payload)
+    {
+        std::string_view data = view(payload);
+        if (closed_ || failed_)
+            return false;
+        if (data.empty())
+            return true;
+        if (!loop_)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return asyncStream_ && writeChunk(data);
+        }
+        // The chunks queued before must be written first
+        if (loop_->isInLoopThread() && queued_ == 0)
+            return writeInLoop(data);
+        auto size = data.size();
+        queuedBytes_ += size;
+        ++queued_;
+        loop_->queueInLoop([thisPtr = shared_from_this(),
+                            payload = std::forward<Payload>(payload),
+                            size]() {
+            thisPtr->queuedBytes_ -= size;
+            --thisPtr->queued_;
+            thisPtr->writeInLoop(view(payload));
+            thisPtr->updateState();
+        });
+        return true;
+    }
+
+    void close()
+    {
+        if (closed_.exchange(true))
+            return;
+        if (!loop_)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closeStream();
+            return;
+        }
+        if (loop_->isInLoopThread() && queued_ == 0)
+        {
+            closeInLoop();
+            return;
+        }
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->closeInLoop(); });
+    }
+
+    bool writable() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writableLocked();
+    }
+
+    void setHighWaterMark(size_t bytes)
+    {
+        highWaterMark_ = bytes;
+        if (!loop_)
+            return;
+        loop_->runInLoop([thisPtr = shared_from_this()]() {
+            thisPtr->watchConnection();
+            thisPtr->updateState();
+        });
+    }
+
+    void setHighWaterMarkCallback(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        highWaterMarkCallback_ = std::move(callback);
+    }
+
+    void setDrainCallback(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainCallback_ = std::move(callback);
+    }
+
+    void whenWritable(std::function<void(bool)> callback)
+    {
+        bool result;
+        {
+            // Checked and queued under the lock, so the state can't change in
+            // between
+            std::lock_guard<std::mutex> lock(mutex_);
+            result = writableLocked();
+            if (!result && !closed_ && !failed_)
+            {
+                waiters_.push_back(std::move(callback));
+                return;
+            }
+        }
+        callback(result);
+    }
+
+  private:
+    static std::string_view view(const std::string &payload)
+    {
+        return payload;
+    }
+
+    static std::string_view view(const std::shared_ptr<const std::string> &p)
+    {
+        return p ? std::string_view(*p) : std::string_view();
+    }
+
+    bool writableLocked() const
+    {
+        if (closed_ || failed_)
+            return false;
+        auto highWaterMark = highWaterMark_.load();
+        return highWaterMark == 0 ||
+               (!overHighWaterMark_ && queuedBytes_ < highWaterMark);
+    }
+
+    // Write the chunk header, the payload and the trailing CRLF. The small
+    // chunks are gathered into one write, the large payloads are passed to
+    // the connection as they are.
+    bool writeChunk(std::string_view data)
+    {
+        static constexpr size_t kGatherLimit = 16 * 1024;
+        char header[20];
+        auto len = snprintf(header, sizeof(header), "%zx\r\n", data.size());
+        if (data.size() <= kGatherLimit)
+        {
+            thread_local std::string buffer;
+            buffer.assign(header, len);
+            buffer.append(data.data(), data.size());
+            buffer.append("\r\n", 2);
+            return asyncStream_->send(buffer.data(), buffer.size());
+        }
+        return asyncStream_->send(header, len) &&
+               asyncStream_->send(data.data(), data.size()) &&
+               asyncStream_->send("\r\n", 2);
+    }
+
+    bool writeInLoop(std::string_view data)
+    {
+        if (!asyncStream_)
+            return false;
+        if (writeChunk(data))
+            return true;
+        failed_ = true;
+        updateState();
+        return false;
+    }
+
+    void closeStream()
+    {
+        if (!asyncStream_)
+            return;
+        asyncStream_->send("0\r\n\r\n", 5);
+        asyncStream_->close();
+        asyncStream_.reset();
+    }
+
+    void closeInLoop()
+    {
+        closeStream();
+        if (watching_)
+        {
+            // The connection may serve other requests after the response
+            if (auto conn = conn_.lock())
+            {
+                conn->setHighWaterMarkCallback({}, 0);
+                conn->setWriteCompleteCallback({});
+            }
+            watching_ = false;
+        }
+        updateState();
+    }
+
+    // Follow the send buffer of the connection, called in the event loop
+    void watchConnection()
+    {
+        auto conn = conn_.lock();
+        if (!conn || closed_)
+            return;
+        auto highWaterMark = highWaterMark_.load();
+        std::weak_ptr<ChunkWriter> weakPtr = shared_from_this();
+        conn->setHighWaterMarkCallback(
+            [weakPtr](const trantor::TcpConnectionPtr &, const size_t) {
+                if (auto thisPtr = weakPtr.lock())
+                {
+                    thisPtr->overHighWaterMark_ = true;
+                    thisPtr->updateState();
+                }
+            },
+            highWaterMark == 0 ? std::numeric_limits<size_t>::max()
+                               : highWaterMark);
+        conn->setWriteCompleteCallback(
+            [weakPtr](const trantor::TcpConnectionPtr &) {
+                if (auto thisPtr = weakPtr.lock())
+                {
+                    thisPtr->overHighWaterMark_ = false;
+                    thisPtr->updateState();
+                }
+            });
+        watching_ = true;
+    }
+
+    // Call the callbacks and resume the waiters when the state changes,
+    // called in the event loop
+    void updateState()
+    {
+        std::function<void()> callback;
+        std::vector<std::function<void(bool)>> waiters;
+        bool result{false};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ || failed_)
+            {
+                stopTimer();
+                waiters.swap(waiters_);
+            }
+            else if (!writableLocked())
+            {
+                if (!blocked_)
+                {
+                    blocked_ = true;
+                    callback = highWaterMarkCallback_;
+                    startTimer();
+                }
+            }
+            else
+            {
+                if (blocked_)
+                {
+                    blocked_ = false;
+                    callback = drainCallback_;
+                    stopTimer();
+                }
+                waiters.swap(waiters_);
+                result = true;
+            }
+        }
+        if (callback)
+            callback();
+        for (auto &waiter : waiters)
+        {
+            waiter(result);
+        }
+    }
+
+    // The send buffer never drains if the connection is closed, the timer
+    // fails the stream then.
+    void startTimer()
+    {
+        std::weak_ptr<ChunkWriter> weakPtr = shared_from_this();
+        timerId_ = loop_->runEvery(1.0, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            auto conn = thisPtr->conn_.lock();
+            if (!conn || conn->disconnected())
+            {
+                LOG_DEBUG << "The connection of a blocked stream is closed";
+                thisPtr->failed_ = true;
+                thisPtr->updateState();
+            }
+        });
+    }
+
+    void stopTimer()
+    {
+        if (timerId_ == trantor::InvalidTimerId)
+            return;
+        loop_->invalidateTimer(timerId_);
+        timerId_ = trantor::InvalidTimerId;
+    }
+
+    // Only accessed in the event loop (or under mutex_ without a loop)
+    trantor::AsyncStreamPtr asyncStream_;
+    const std::weak_ptr<trantor::TcpConnection> conn_;
+    trantor::EventLoop *const loop_;
+    bool watching_{false};
+
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<bool> overHighWaterMark_{false};
+    std::atomic<size_t> highWaterMark_{1024 * 1024};
+    // The chunks on the way to the event loop
+    std::atomic<size_t> queuedBytes_{0};
+    std::atomic<size_t> queued_{0};
+
+    mutable std::mutex mutex_;
+    bool blocked_{false};
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+    std::function<void()> highWaterMarkCallback_;
+    std::function<void()> drainCallback_;
+    std::vector<std::function<void(bool)>> waiters_;
+};
+}  // namespace drogon
+
+using namespace drogon;
+
+ResponseStream::ResponseStream(trantor::AsyncStreamPtr asyncStream)
+    : writer_(std::make_shared<ChunkWriter>(std::move(asyncStream), nullptr))
+{
+}
+
+ResponseStream::ResponseStream(trantor::AsyncStreamPtr asyncStream,
+                               const trantor::TcpConnectionPtr &conn)
+    : writer_(std::make_shared<ChunkWriter>(std::move(asyncStream), conn))
+{
+    writer_->start();
+}
+
+ResponseStream::~ResponseStream()
+{
+    close();
+}
+
+bool ResponseStream::send(const std::string &data)
+{
+    return writer_->send(data);
+}
+
+bool ResponseStream::send(std::string &&data)
+{
+    return writer_->send(std::move(data));
+}
+
+bool ResponseStream::send(std::shared_ptr<const std::string> data)
+{
+    return writer_->send(std::move(data));
+}
+
+void ResponseStream::close()
+{
+    writer_->close();
+}
+
+bool ResponseStream::writable() const
+{
+    return writer_->writable();
+}
+
+void ResponseStream::setHighWaterMark(size_t bytes)
+{
+    writer_->setHighWaterMark(bytes);
+}
+
+void ResponseStream::setHighWaterMarkCallback(std::function<void()> callback)
+{
+    writer_->setHighWaterMarkCallback(std::move(callback));
+}
+
+void ResponseStream::setDrainCallback(std::function<void()> callback)
+{
+    writer_->setDrainCallback(std::move(callback));
+}
+
+void ResponseStream::whenWritable(std::function<void(bool)> callback)
+{
+    writer_->whenWritable(std::move(callback));
+}
@@ -0,0 +1,508 @@
+/**
+ *
+ *  @file ServerSentEvents.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/ServerSentEvents.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+std::atomic<double> heartbeatInterval{15.0};
+
+// Append a field for every line of the value, a line ends with CRLF, LF or
+// CR.
+void appendLines(std::string &message,
+                 std::string_view field,
+                 std::string_view value)
+{
+    size_t pos = 0;
+    while (true)
+    {
+        auto end = value.find_first_of("\r\n", pos);
+        message.append(field.data(), field.size());
+        message.append(value.data() + pos,
+                       (end == std::string_view::npos ? value.size() : end) -
+                           pos);
+        message.push_back('\n');
+        if (end == std::string_view::npos)
+            break;
+        pos = end + 1;
+        if (value[end] == '\r' && pos < value.size() && value[pos] == '\n')
+            ++pos;
+    }
+}
+
+void appendSingleLine(std::string &message,
+                      std::string_view field,
+                      std::string_view value)
+{
+    message.append(field.data(), field.size());
+    for (auto c : value)
+    {
+        if (c != '\r' && c != '\n' && c != '\0')
+            message.push_back(c);
+    }
+    message.push_back('\n');
+}
+}  // namespace
+
+std::string SseEvent::format() const
+{
+    std::string message;
+    if (!event.empty())
+        appendSingleLine(message, "event: ", event);
+    if (!id.empty())
+        appendSingleLine(message, "id: ", id);
+    if (retry.count() >= 0)
+    {
+        message.append("retry: ");
+        message.append(std::to_string(retry.count()));
+        message.push_back('\n');
+    }
+    if (!data.empty())
+        appendLines(message, "data: ", data);
+    message.push_back('\n');
+    return message;
+}
+
+namespace drogon
+{
+class SseStreamImpl final : public SseStream,
+                            public std::enable_shared_from_this<SseStreamImpl>
+{
+  public:
+    SseStreamImpl(ResponseStreamPtr stream,
+                  std::string lastEventId,
+                  trantor::EventLoop *loop)
+        : stream_(std::move(stream)),
+          lastEventId_(std::move(lastEventId)),
+          loop_(loop)
+    {
+    }
+
+    bool send(const SseEvent &event) override
+    {
+        return sendPayload(event.format());
+    }
+
+    bool sendComment(std::string_view comment) override
+    {
+        std::string message;
+        appendLines(message, ":", comment);
+        return sendPayload(std::move(message));
+    }
+
+    void close() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stream_)
+        {
+            stream_->close();
+            stream_.reset();
+        }
+    }
+
+    bool closed() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !stream_;
+    }
+
+    const std::string &lastEventId() const override
+    {
+        return lastEventId_;
+    }
+
+    trantor::EventLoop *getLoop() const override
+    {
+        return loop_;
+    }
+
+    // Send a formatted message, the response stream frames it as a chunk
+    template <typename Payload>
+    bool sendPayload(Payload &&payload)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stream_)
+            return false;
+        if (!stream_->send(std::forward<Payload>(payload)))
+        {
+            stream_.reset();
+            return false;
+        }
+        active_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Mark the stream as slow while the data waiting to be sent exceeds the
+    // high water mark. Called in the event loop.
+    void watchSendBuffer(size_t highWaterMark)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stream_)
+            return;
+        std::weak_ptr<SseStreamImpl> weakPtr = shared_from_this();
+        stream_->setHighWaterMarkCallback([weakPtr]() {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->slow_ = true;
+        });
+        stream_->setDrainCallback([weakPtr]() {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->slow_ = false;
+        });
+        stream_->setHighWaterMark(highWaterMark);
+    }
+
+    bool slow() const
+    {
+        return slow_;
+    }
+
+    // Return true if something was sent since the last call
+    bool checkActivity()
+    {
+        return active_.exchange(false, std::memory_order_relaxed);
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    ResponseStreamPtr stream_;
+    const std::string lastEventId_;
+    trantor::EventLoop *const loop_;
+    std::atomic<bool> active_{false};
+    // Only accessed in the event loop
+    bool slow_{false};
+};
+}  // namespace drogon
+
+namespace
+{
+// The streams of the current event loop, which share a heartbeat timer
+struct LoopStreams
+{
+    std::vector<std::weak_ptr<SseStreamImpl>> streams;
+    trantor::TimerId timerId{trantor::InvalidTimerId};
+};
+
+thread_local LoopStreams loopStreams;
+
+void sendHeartbeats(trantor::EventLoop *loop)
+{
+    static const auto heartbeat =
+        std::make_shared<const std::string>(":\n\n");
+    auto &streams = loopStreams.streams;
+    for (size_t i = 0; i < streams.size();)
+    {
+        auto stream = streams[i].lock();
+        // Idle streams get a comment, which also detects closed connections
+        if (stream && (stream->checkActivity() || stream->sendPayload(heartbeat)))
+        {
+            ++i;
+            continue;
+        }
+        streams[i] = std::move(streams.back());
+        streams.pop_back();
+    }
+    if (streams.empty())
+    {
+        loop->invalidateTimer(loopStreams.timerId);
+        loopStreams.timerId = trantor::InvalidTimerId;
+    }
+}
+
+void addToLoop(const std::shared_ptr<SseStreamImpl> &stream)
+{
+    auto loop = stream->getLoop();
+    loop->assertInLoopThread();
+    loopStreams.streams.emplace_back(stream);
+    auto interval = heartbeatInterval.load(std::memory_order_relaxed);
+    if (loopStreams.timerId == trantor::InvalidTimerId && interval > 0)
+    {
+        loopStreams.timerId =
+            loop->runEvery(interval, [loop]() { sendHeartbeats(loop); });
+    }
+}
+
+class SseChannelImpl final : public SseChannel,
+                             public std::enable_shared_from_this<SseChannelImpl>
+{
+  public:
+    explicit SseChannelImpl(const SseChannelConfig &config) : config_(config)
+    {
+    }
+
+    HttpResponsePtr newResponse(const HttpRequestPtr &req) override
+    {
+        std::weak_ptr<SseChannelImpl> weakPtr = shared_from_this();
+        return HttpResponse::newSseResponse(
+            [weakPtr](const SseStreamPtr &stream) {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->subscribe(stream);
+            },
+            req);
+    }
+
+    bool subscribe(const SseStreamPtr &stream) override
+    {
+        auto streamImpl = std::static_pointer_cast<SseStreamImpl>(stream);
+        auto loop = streamImpl->getLoop();
+        if (loop->isInLoopThread())
+            return subscribeInLoop(streamImpl);
+        auto resumed = streamImpl->lastEventId().empty() ||
+                       findEvent(streamImpl->lastEventId());
+        loop->queueInLoop([thisPtr = shared_from_this(), streamImpl]() {
+            thisPtr->subscribeInLoop(streamImpl);
+        });
+        return resumed;
+    }
+
+    std::string publish(const SseEvent &event) override
+    {
+        std::shared_ptr<const std::string> message;
+        uint64_t seq;
+        std::string id;
+        std::vector<std::pair<trantor::EventLoop *, std::shared_ptr<LoopGroup>>>
+            groups;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            seq = ++lastSeq_;
+            if (event.id.empty())
+            {
+                auto copy = event;
+                copy.id = std::to_string(seq);
+                message = std::make_shared<const std::string>(copy.format());
+                id = std::move(copy.id);
+            }
+            else
+            {
+                message = std::make_shared<const std::string>(event.format());
+                id = event.id;
+            }
+            if (config_.replayBufferSize > 0)
+            {
+                replayBuffer_.push_back({seq, id, message});
+                if (replayBuffer_.size() > config_.replayBufferSize)
+                    replayBuffer_.pop_front();
+            }
+            groups.assign(groups_.begin(), groups_.end());
+        }
+        // The event is formatted once, each event loop writes the same buffer
+        // to its own subscribers.
+        for (auto &group : groups)
+        {
+            group.first->queueInLoop([thisPtr = shared_from_this(),
+                                      group = std::move(group.second),
+                                      message,
+                                      seq]() {
+                thisPtr->deliverInLoop(*group, message, seq);
+            });
+        }
+        return id;
+    }
+
+    size_t subscriberCount() const override
+    {
+        return subscriberCount_.load(std::memory_order_relaxed);
+    }
+
+    size_t slowConsumerEvents() const override
+    {
+        return slowConsumerEvents_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Event
+    {
+        uint64_t seq;
+        std::string id;
+        std::shared_ptr<const std::string> message;
+    };
+
+    struct Subscriber
+    {
+        std::shared_ptr<SseStreamImpl> stream;
+        // The sequence number of the last event sent to the stream
+        uint64_t lastSeq;
+    };
+
+    // The subscribers in an event loop, only accessed in the loop
+    struct LoopGroup
+    {
+        std::vector<Subscriber> subscribers;
+    };
+
+    bool findEvent(const std::string &id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto iter = replayBuffer_.rbegin(); iter != replayBuffer_.rend();
+             ++iter)
+        {
+            if (iter->id == id)
+                return true;
+        }
+        return false;
+    }
+
+    bool subscribeInLoop(const std::shared_ptr<SseStreamImpl> &stream)
+    {
+        auto loop = stream->getLoop();
+        std::vector<std::shared_ptr<const std::string>> replay;
+        std::shared_ptr<LoopGroup> group;
+        uint64_t seq;
+        bool resumed = true;
+        {
+            // The events published before this point are replayed, the later
+            // ones are delivered by the event loop.
+            std::lock_guard<std::mutex> lock(mutex_);
+            seq = lastSeq_;
+            auto &lastEventId = stream->lastEventId();
+            if (!lastEventId.empty())
+            {
+                auto found = std::find_if(replayBuffer_.rbegin(),
+                                          replayBuffer_.rend(),
+                                          [&lastEventId](const Event &event) {
+                                              return event.id == lastEventId;
+                                          });
+                // Replay everything if the event is unknown
+                auto iter = replayBuffer_.begin();
+                if (found != replayBuffer_.rend())
+                    iter = found.base();
+                else
+                    resumed = false;
+                for (; iter != replayBuffer_.end(); ++iter)
+                {
+                    replay.push_back(iter->message);
+                }
+            }
+            auto &groupPtr = groups_[loop];
+            if (!groupPtr)
+                groupPtr = std::make_shared<LoopGroup>();
+            group = groupPtr;
+        }
+        if (!resumed)
+        {
+            LOG_DEBUG << "The last event ID " << stream->lastEventId()
+                      << " is not in the replay buffer";
+        }
+        if (config_.slowConsumerPolicy != SseSlowConsumerPolicy::kBuffer)
+            stream->watchSendBuffer(config_.highWaterMark);
+        for (auto &message : replay)
+        {
+            if (!stream->sendPayload(message))
+                return resumed;
+        }
+        group->subscribers.push_back({stream, seq});
+        ++subscriberCount_;
+        return resumed;
+    }
+
+    void deliverInLoop(LoopGroup &group,
+                       const std::shared_ptr<const std::string> &message,
+                       uint64_t seq)
+    {
+        auto &subscribers = group.subscribers;
+        for (size_t i = 0; i < subscribers.size();)
+        {
+            auto &subscriber = subscribers[i];
+            // Subscribed after the event was published
+            if (seq <= subscriber.lastSeq)
+            {
+                ++i;
+                continue;
+            }
+            subscriber.lastSeq = seq;
+            bool keep = true;
+            if (subscriber.stream->slow() &&
+                config_.slowConsumerPolicy != SseSlowConsumerPolicy::kBuffer)
+            {
+                ++slowConsumerEvents_;
+                if (config_.slowConsumerPolicy ==
+                    SseSlowConsumerPolicy::kDisconnect)
+                {
+                    LOG_DEBUG << "Close the event stream of a slow consumer";
+                    subscriber.stream->close();
+                    keep = false;
+                }
+            }
+            else
+            {
+                keep = subscriber.stream->sendPayload(message);
+            }
+            if (keep)
+            {
+                ++i;
+                continue;
+            }
+            subscriber = std::move(subscribers.back());
+            subscribers.pop_back();
+            --subscriberCount_;
+        }
+    }
+
+    const SseChannelConfig config_;
+    std::mutex mutex_;
+    uint64_t lastSeq_{0};
+    std::deque<Event> replayBuffer_;
+    std::unordered_map<trantor::EventLoop *, std::shared_ptr<LoopGroup>>
+        groups_;
+    std::atomic<size_t> subscriberCount_{0};
+    std::atomic<size_t> slowConsumerEvents_{0};
+};
+}  // namespace
+
+void SseStream::setHeartbeatInterval(
+    const std::chrono::duration<double> &interval)
+{
+    heartbeatInterval.store(interval.count(), std::memory_order_relaxed);
+}
+
+std::shared_ptr<SseChannel> SseChannel::newChannel(
+    const SseChannelConfig &config)
+{
+    return std::make_shared<SseChannelImpl>(config);
+}
+
+HttpResponsePtr HttpResponse::newSseResponse(
+    const std::function<void(const SseStreamPtr &)> &callback,
+    const HttpRequestPtr &req)
+{
+    std::string lastEventId;
+    if (req)
+        lastEventId = req->getHeader("last-event-id");
+    auto resp = newAsyncStreamResponse(
+        [callback, lastEventId = std::move(lastEventId)](
+            ResponseStreamPtr stream) {
+            // Called in the event loop of the connection
+            auto streamImpl = std::make_shared<SseStreamImpl>(
+                std::move(stream),
+                lastEventId,
+                trantor::EventLoop::getEventLoopOfCurrentThread());
+            addToLoop(streamImpl);
+            if (callback)
+                callback(streamImpl);
+        },
+        true);
+    resp->setContentTypeString("text/event-stream");
+    resp->addHeader("cache-control", "no-cache");
+    // Disable the response buffering of nginx
+    resp->addHeader("x-accel-buffering", "no");
+    return resp;
+}
@@ -0,0 +1,672 @@
+/**
+ *
+ *  @file SimdKernels.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SimdKernels.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DROGON_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles the intrinsics of every instruction set without options
+#define SSE4_TARGET
+#define AVX2_TARGET
+#else
+#define SSE4_TARGET __attribute__((target("ssse3,sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2,ssse3,sse4.1")))
+#endif
+#endif
+
+using namespace drogon;
+
+namespace
+{
+#ifdef DROGON_SIMD_X86
+inline unsigned int countTrailingZeros(uint32_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+SimdLevel detectLevel()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    auto maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool ssse3 = (info[2] & (1 << 9)) != 0;
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!ssse3 || !sse41)
+        return SimdLevel::kScalar;
+    // The OS must save the YMM registers
+    if (maxLeaf < 7 || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return SimdLevel::kSse4;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0 ? SimdLevel::kAvx2 : SimdLevel::kSse4;
+#else
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("ssse3") || !__builtin_cpu_supports("sse4.1"))
+        return SimdLevel::kScalar;
+    return __builtin_cpu_supports("avx2") ? SimdLevel::kAvx2
+                                          : SimdLevel::kSse4;
+#endif
+}
+
+// SSE4
+
+// The mask of the bytes not in the set
+SSE4_TARGET inline __m128i notInSet(__m128i v,
+                                    __m128i lo,
+                                    __m128i hi,
+                                    bool nonAscii)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    auto low = _mm_and_si128(v, nibble);
+    auto high = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+    auto bits = _mm_and_si128(_mm_shuffle_epi8(lo, low),
+                              _mm_shuffle_epi8(hi, high));
+    auto result = _mm_cmpeq_epi8(bits, _mm_setzero_si128());
+    if (nonAscii)
+        result = _mm_andnot_si128(_mm_cmplt_epi8(v, _mm_setzero_si128()),
+                                  result);
+    return result;
+}
+
+SSE4_TARGET size_t spanSse4(const char *data,
+                            size_t length,
+                            const CharSet &set,
+                            size_t i = 0)
+{
+    auto lo = _mm_load_si128(reinterpret_cast<const __m128i *>(set.lo));
+    auto hi = _mm_load_si128(reinterpret_cast<const __m128i *>(set.hi));
+    for (; i + 16 <= length; i += 16)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        auto bits = static_cast<uint32_t>(
+            _mm_movemask_epi8(notInSet(v, lo, hi, set.nonAscii)));
+        if (bits)
+            return i + countTrailingZeros(bits);
+    }
+    return i;
+}
+
+// The base64 indexes of the 12 bytes in the lower part of the vector, see
+// http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+SSE4_TARGET inline __m128i base64Spread128()
+{
+    return _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+}
+
+SSE4_TARGET inline __m128i base64Indexes(__m128i v)
+{
+    v = _mm_shuffle_epi8(v, base64Spread128());
+    auto t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+    auto t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    auto t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+    auto t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+SSE4_TARGET inline __m128i base64Chars(__m128i indexes, __m128i shifts)
+{
+    // 13 for A-Z, 0 for a-z, 1-12 for 0-9, + and /
+    auto reduced = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+    auto lower = _mm_cmpgt_epi8(_mm_set1_epi8(26), indexes);
+    reduced =
+        _mm_or_si128(reduced, _mm_and_si128(lower, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shifts, reduced), indexes);
+}
+
+SSE4_TARGET inline __m128i base64Shifts128(bool urlSafe)
+{
+    return _mm_setr_epi8('a' - 26,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         '0' - 52,
+                         urlSafe ? '-' - 62 : '+' - 62,
+                         urlSafe ? '_' - 63 : '/' - 63,
+                         'A',
+                         0,
+                         0);
+}
+
+SSE4_TARGET size_t base64EncodeSse4(const unsigned char *data,
+                                    size_t length,
+                                    unsigned char *out,
+                                    bool urlSafe,
+                                    size_t i = 0)
+{
+    auto shifts = base64Shifts128(urlSafe);
+    // 16 bytes are loaded for every 12 bytes encoded
+    for (; i + 16 <= length; i += 12)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 3 * 4),
+                         base64Chars(base64Indexes(v), shifts));
+    }
+    return i;
+}
+
+// The offsets from the characters to their values by the high nibble,
+// except for +, -, / and _
+SSE4_TARGET inline __m128i base64Offsets128()
+{
+    return _mm_setr_epi8(
+        0, 0, 0, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
+SSE4_TARGET inline __m128i base64Order128()
+{
+    return _mm_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+}
+
+// The base64 values of the characters of both alphabets
+SSE4_TARGET inline __m128i base64Values(__m128i v)
+{
+    const __m128i offsets = base64Offsets128();
+    auto hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+    auto offset = _mm_shuffle_epi8(offsets, hi);
+    offset = _mm_blendv_epi8(offset,
+                             _mm_set1_epi8('>' - '+'),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('+')));
+    offset = _mm_blendv_epi8(offset,
+                             _mm_set1_epi8('>' - '-'),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    offset = _mm_blendv_epi8(offset,
+                             _mm_set1_epi8('?' - '/'),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    offset = _mm_blendv_epi8(offset,
+                             _mm_set1_epi8('?' - '_'),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    return _mm_add_epi8(v, offset);
+}
+
+// Pack 16 values of 6 bits into 12 bytes in the lower part of the vector
+SSE4_TARGET inline __m128i base64Pack(__m128i values)
+{
+    auto merged =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged, base64Order128());
+}
+
+SSE4_TARGET inline void store12(unsigned char *out, __m128i v)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), v);
+    auto last = static_cast<uint32_t>(_mm_extract_epi32(v, 2));
+    memcpy(out + 8, &last, 4);
+}
+
+const CharSet &base64Set()
+{
+    static const CharSet set = CharSet::make([](char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+               (c >= '0' && c <= '9') || c == '+' || c == '/' || c == '-' ||
+               c == '_';
+    });
+    return set;
+}
+
+SSE4_TARGET size_t base64DecodeSse4(const char *data,
+                                    size_t length,
+                                    unsigned char *out,
+                                    size_t i = 0)
+{
+    auto &set = base64Set();
+    auto lo = _mm_load_si128(reinterpret_cast<const __m128i *>(set.lo));
+    auto hi = _mm_load_si128(reinterpret_cast<const __m128i *>(set.hi));
+    for (; i + 16 <= length; i += 16)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        if (_mm_movemask_epi8(notInSet(v, lo, hi, false)) != 0)
+            break;
+        store12(out + i / 4 * 3, base64Pack(base64Values(v)));
+    }
+    return i;
+}
+
+SSE4_TARGET inline __m128i hexDigits128(bool lowerCase)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+        lowerCase ? "0123456789abcdef" : "0123456789ABCDEF"));
+}
+
+SSE4_TARGET size_t hexEncodeSse4(const char *data,
+                                 size_t length,
+                                 char *out,
+                                 bool lowerCase,
+                                 size_t i = 0)
+{
+    auto digits = hexDigits128(lowerCase);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= length; i += 16)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        auto high = _mm_shuffle_epi8(
+            digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        auto low = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2),
+                         _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2 + 16),
+                         _mm_unpackhi_epi8(high, low));
+    }
+    return i;
+}
+
+// The values of 16 hex digits, false if there is another character
+SSE4_TARGET inline bool hexValues(__m128i v, __m128i &values)
+{
+    auto isDigit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                 _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    auto isLetter =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xffff)
+        return false;
+    values = _mm_blendv_epi8(_mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)),
+                             _mm_sub_epi8(v, _mm_set1_epi8('0')),
+                             isDigit);
+    return true;
+}
+
+SSE4_TARGET size_t hexDecodeSse4(const char *data,
+                                 size_t length,
+                                 char *out,
+                                 size_t i = 0)
+{
+    // The high nibble comes first
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    for (; i + 32 <= length; i += 32)
+    {
+        __m128i first, second;
+        if (!hexValues(_mm_loadu_si128(
+                           reinterpret_cast<const __m128i *>(data + i)),
+                       first) ||
+            !hexValues(_mm_loadu_si128(
+                           reinterpret_cast<const __m128i *>(data + i + 16)),
+                       second))
+            break;
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(out + i / 2),
+            _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                             _mm_maddubs_epi16(second, weights)));
+    }
+    return i;
+}
+
+// AVX2, the same algorithms on the two 128-bit lanes. The kernels finish
+// with the SSE4 ones.
+
+AVX2_TARGET inline __m256i broadcast(const uint8_t *table)
+{
+    return _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i *>(table)));
+}
+
+AVX2_TARGET inline __m256i notInSet(__m256i v,
+                                    __m256i lo,
+                                    __m256i hi,
+                                    bool nonAscii)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    auto low = _mm256_and_si256(v, nibble);
+    auto high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    auto bits = _mm256_and_si256(_mm256_shuffle_epi8(lo, low),
+                                 _mm256_shuffle_epi8(hi, high));
+    auto result = _mm256_cmpeq_epi8(bits, _mm256_setzero_si256());
+    if (nonAscii)
+        result = _mm256_andnot_si256(
+            _mm256_cmpgt_epi8(_mm256_setzero_si256(), v), result);
+    return result;
+}
+
+AVX2_TARGET size_t spanAvx2(const char *data,
+                            size_t length,
+                            const CharSet &set)
+{
+    auto lo = broadcast(set.lo);
+    auto hi = broadcast(set.hi);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        auto v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        auto bits = static_cast<uint32_t>(
+            _mm256_movemask_epi8(notInSet(v, lo, hi, set.nonAscii)));
+        if (bits)
+            return i + countTrailingZeros(bits);
+    }
+    return spanSse4(data, length, set, i);
+}
+
+AVX2_TARGET size_t base64EncodeAvx2(const unsigned char *data,
+                                    size_t length,
+                                    unsigned char *out,
+                                    bool urlSafe)
+{
+    auto shifts = _mm256_broadcastsi128_si256(base64Shifts128(urlSafe));
+    auto spread = _mm256_broadcastsi128_si256(base64Spread128());
+    size_t i = 0;
+    // 12 bytes in each lane
+    for (; i + 28 <= length; i += 24)
+    {
+        auto v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(data + i))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 12)),
+            1);
+        v = _mm256_shuffle_epi8(v, spread);
+        auto t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        auto t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        auto t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        auto t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        auto indexes = _mm256_or_si256(t1, t3);
+        auto reduced = _mm256_subs_epu8(indexes, _mm256_set1_epi8(51));
+        auto lower = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indexes);
+        reduced = _mm256_or_si256(
+            reduced, _mm256_and_si256(lower, _mm256_set1_epi8(13)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(out + i / 3 * 4),
+            _mm256_add_epi8(_mm256_shuffle_epi8(shifts, reduced), indexes));
+    }
+    return base64EncodeSse4(data, length, out, urlSafe, i);
+}
+
+// Use the offset from c to the character of its value for c
+AVX2_TARGET inline __m256i replaceOffset(__m256i offset,
+                                         __m256i v,
+                                         char c,
+                                         char value)
+{
+    return _mm256_blendv_epi8(offset,
+                              _mm256_set1_epi8(static_cast<char>(value - c)),
+                              _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+
+AVX2_TARGET size_t base64DecodeAvx2(const char *data,
+                                    size_t length,
+                                    unsigned char *out)
+{
+    auto &set = base64Set();
+    auto lo = broadcast(set.lo);
+    auto hi = broadcast(set.hi);
+    auto offsets = _mm256_broadcastsi128_si256(base64Offsets128());
+    auto order = _mm256_broadcastsi128_si256(base64Order128());
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        auto v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        if (_mm256_movemask_epi8(notInSet(v, lo, hi, false)) != 0)
+            break;
+        auto offset = _mm256_shuffle_epi8(
+            offsets,
+            _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f)));
+        offset = replaceOffset(offset, v, '+', '>');
+        offset = replaceOffset(offset, v, '-', '>');
+        offset = replaceOffset(offset, v, '/', '?');
+        offset = replaceOffset(offset, v, '_', '?');
+        auto values = _mm256_add_epi8(v, offset);
+        auto merged =
+            _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, order);
+        store12(out + i / 4 * 3, _mm256_castsi256_si128(merged));
+        store12(out + i / 4 * 3 + 12, _mm256_extracti128_si256(merged, 1));
+    }
+    return base64DecodeSse4(data, length, out, i);
+}
+
+AVX2_TARGET size_t hexEncodeAvx2(const char *data,
+                                 size_t length,
+                                 char *out,
+                                 bool lowerCase)
+{
+    auto digits = _mm256_broadcastsi128_si256(hexDigits128(lowerCase));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        auto v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        auto high = _mm256_shuffle_epi8(
+            digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        auto low = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, nibble));
+        // The unpacking interleaves within the lanes
+        auto first = _mm256_unpacklo_epi8(high, low);
+        auto second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * 2),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * 2 + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return hexEncodeSse4(data, length, out, lowerCase, i);
+}
+
+AVX2_TARGET inline bool hexValues(__m256i v, __m256i &values)
+{
+    auto isDigit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+    auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    auto isLetter = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(isDigit, isLetter))) != 0xffffffffu)
+        return false;
+    values = _mm256_blendv_epi8(
+        _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)),
+        _mm256_sub_epi8(v, _mm256_set1_epi8('0')),
+        isDigit);
+    return true;
+}
+
+AVX2_TARGET size_t hexDecodeAvx2(const char *data, size_t length, char *out)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        __m256i first, second;
+        if (!hexValues(_mm256_loadu_si256(
+                           reinterpret_cast<const __m256i *>(data + i)),
+                       first) ||
+            !hexValues(_mm256_loadu_si256(
+                           reinterpret_cast<const __m256i *>(data + i + 32)),
+                       second))
+            break;
+        // The packing interleaves the lanes of the two vectors
+        auto packed =
+            _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights),
+                                _mm256_maddubs_epi16(second, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i / 2),
+                            _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    return hexDecodeSse4(data, length, out, i);
+}
+#endif
+
+std::atomic<SimdLevel> &currentLevel()
+{
+    static std::atomic<SimdLevel> level{SimdKernels::supportedLevel()};
+    return level;
+}
+}  // namespace
+
+SimdLevel SimdKernels::supportedLevel()
+{
+#ifdef DROGON_SIMD_X86
+    static const SimdLevel level = detectLevel();
+    return level;
+#else
+    return SimdLevel::kScalar;
+#endif
+}
+
+SimdLevel SimdKernels::level()
+{
+    return currentLevel().load(std::memory_order_relaxed);
+}
+
+void SimdKernels::setLevel(SimdLevel level)
+{
+    if (level > supportedLevel())
+        level = supportedLevel();
+    currentLevel().store(level, std::memory_order_relaxed);
+}
+
+size_t SimdKernels::span(const char *data, size_t length, const CharSet &set)
+{
+#ifdef DROGON_SIMD_X86
+    if (length >= 16)
+    {
+        switch (level())
+        {
+            case SimdLevel::kAvx2:
+                return spanAvx2(data, length, set);
+            case SimdLevel::kSse4:
+                return spanSse4(data, length, set);
+            default:
+                break;
+        }
+    }
+#else
+    (void)data;
+    (void)length;
+    (void)set;
+#endif
+    return 0;
+}
+
+size_t SimdKernels::base64Encode(const unsigned char *data,
+                                 size_t length,
+                                 unsigned char *out,
+                                 bool urlSafe)
+{
+#ifdef DROGON_SIMD_X86
+    if (length >= 16)
+    {
+        switch (level())
+        {
+            case SimdLevel::kAvx2:
+                return base64EncodeAvx2(data, length, out, urlSafe);
+            case SimdLevel::kSse4:
+                return base64EncodeSse4(data, length, out, urlSafe);
+            default:
+                break;
+        }
+    }
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+    (void)urlSafe;
+#endif
+    return 0;
+}
+
+size_t SimdKernels::base64Decode(const char *data,
+                                 size_t length,
+                                 unsigned char *out)
+{
+#ifdef DROGON_SIMD_X86
+    if (length >= 16)
+    {
+        switch (level())
+        {
+            case SimdLevel::kAvx2:
+                return base64DecodeAvx2(data, length, out);
+            case SimdLevel::kSse4:
+                return base64DecodeSse4(data, length, out);
+            default:
+                break;
+        }
+    }
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+#endif
+    return 0;
+}
+
+size_t SimdKernels::hexEncode(const char *data,
+                              size_t length,
+                              char *out,
+                              bool lowerCase)
+{
+#ifdef DROGON_SIMD_X86
+    if (length >= 16)
+    {
+        switch (level())
+        {
+            case SimdLevel::kAvx2:
+                return hexEncodeAvx2(data, length, out, lowerCase);
+            case SimdLevel::kSse4:
+                return hexEncodeSse4(data, length, out, lowerCase);
+            default:
+                break;
+        }
+    }
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+    (void)lowerCase;
+#endif
+    return 0;
+}
+
+size_t SimdKernels::hexDecode(const char *data, size_t length, char *out)
+{
+#ifdef DROGON_SIMD_X86
+    if (length >= 32)
+    {
+        switch (level())
+        {
+            case SimdLevel::kAvx2:
+                return hexDecodeAvx2(data, length, out);
+            case SimdLevel::kSse4:
+                return hexDecodeSse4(data, length, out);
+            default:
+                break;
+        }
+    }
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+#endif
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ *
+ *  @file SimdKernels.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace drogon
+{
+enum class SimdLevel
+{
+    kScalar = 0,
+    // SSSE3 and SSE4.1
+    kSse4,
+    kAvx2
+};
+
+/**
+ * @brief A set of ASCII characters, with the non-ASCII bytes either all in it
+ * or all out of it. The set is kept as two nibble tables for the vectorized
+ * lookup: a byte is in the set if lo[byte & 0xf] & hi[byte >> 4] is not 0.
+ */
+struct CharSet
+{
+    template <typename Predicate>
+    static CharSet make(Predicate &&predicate, bool nonAscii = false)
+    {
+        CharSet set;
+        for (unsigned int c = 0; c < 128; ++c)
+        {
+            if (predicate(static_cast<char>(c)))
+                set.lo[c & 0xf] |= static_cast<uint8_t>(1u << (c >> 4));
+        }
+        for (unsigned int h = 0; h < 8; ++h)
+        {
+            set.hi[h] = static_cast<uint8_t>(1u << h);
+        }
+        set.nonAscii = nonAscii;
+        return set;
+    }
+
+    bool contains(unsigned char c) const
+    {
+        if (c >= 128)
+            return nonAscii;
+        return (lo[c & 0xf] & hi[c >> 4]) != 0;
+    }
+
+    alignas(16) uint8_t lo[16]{0};
+    alignas(16) uint8_t hi[16]{0};
+    bool nonAscii{false};
+};
+
+/**
+ * @brief The vectorized kernels of the string utilities, with the
+ * instruction set chosen at runtime. Each kernel handles the longest prefix
+ * of the input it can process in whole vectors and returns its length, the
+ * caller finishes the rest with the scalar code, so the results are the same
+ * at every level. Without SSE4 (or on other architectures) the kernels
+ * return 0.
+ */
+class DROGON_EXPORT SimdKernels
+{
+  public:
+    /// The best level the CPU supports
+    static SimdLevel supportedLevel();
+
+    static SimdLevel level();
+
+    /// Use a lower level than the CPU supports, for the tests and the
+    /// benchmarks. Not thread safe.
+    static void setLevel(SimdLevel level);
+
+    /// The length of the prefix of the data in the set
+    static size_t span(const char *data, size_t length, const CharSet &set);
+
+    /// Encode whole 12 byte groups to base64 without padding, return the
+    /// number of bytes encoded, the output is 4/3 of it.
+    static size_t base64Encode(const unsigned char *data,
+                               size_t length,
+                               unsigned char *out,
+                               bool urlSafe);
+
+    /// Decode whole 16 character groups of base64 (both alphabets), stop at
+    /// the first group with another character. Return the number of
+    /// characters decoded, the output is 3/4 of it.
+    static size_t base64Decode(const char *data,
+                               size_t length,
+                               unsigned char *out);
+
+    /// Return the number of bytes encoded to hex, the output is twice as long.
+    static size_t hexEncode(const char *data,
+                            size_t length,
+                            char *out,
+                            bool lowerCase);
+
+    /// Decode whole 32 character groups of hex digits, stop at the first
+    /// group with another character. Return the number of characters
+    /// decoded, the output is half of it.
+    static size_t hexDecode(const char *data, size_t length, char *out);
+};
+}  // namespace drogon
@@ -50,6 +50,14 @@ void StaticFileRouter::init(const std::vector<trantor::EventLoop *> &ioLoops)
         });
     staticFilesCache_ = std::make_unique<
         IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>();
+    fileMetadataCache_ = std::make_unique<
+        IOThreadStorage<std::unique_ptr<FileMetadataCache>>>();
+    fileMetadataCaches_.clear();
+    fileMetadataCache_->init(
+        [this](std::unique_ptr<FileMetadataCache> &cachePtr, size_t) {
+            cachePtr = std::make_unique<FileMetadataCache>();
+            fileMetadataCaches_.push_back(cachePtr.get());
+        });
     ioLocationsPtr_ =
         std::make_shared<IOThreadStorage<std::vector<Location>>>();
     for (auto *loop : ioLoops)
@@ -65,6 +73,8 @@ void StaticFileRouter::reset()
 {
     staticFilesCacheMap_.reset();
     staticFilesCache_.reset();
+    fileMetadataCaches_.clear();
+    fileMetadataCache_.reset();
     ioLocationsPtr_.reset();
     locations_.clear();
 }
@@ -159,14 +169,13 @@ void StaticFileRouter::route(
             std::string filePath =
                 location.realLocation_ +
                 std::string{restOfThePath.data(), restOfThePath.length()};
-            std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-            std::error_code err;
-            if (!std::filesystem::exists(fsFilePath, err))
+            auto fileType = getFileMetadata(filePath).type;
+            if (fileType == FileMetadata::kNotFound)
             {
                 defaultHandler_(req, std::move(callback));
                 return;
             }
-            if (std::filesystem::is_directory(fsFilePath, err))
+            if (fileType == FileMetadata::kDirectory)
             {
                 // Check if path is eligible for an implicit index.html
                 if (implicitPageEnable_)
@@ -237,11 +246,10 @@ void StaticFileRouter::route(
     }
     std::string directoryPath =
         HttpAppFrameworkImpl::instance().getDocumentRoot() + path;
-    std::filesystem::path fsDirectoryPath(utils::toNativePath(directoryPath));
-    std::error_code err;
-    if (std::filesystem::exists(fsDirectoryPath, err))
+    auto fileType = getFileMetadata(directoryPath).type;
+    if (fileType != FileMetadata::kNotFound)
     {
-        if (std::filesystem::is_directory(fsDirectoryPath, err))
+        if (fileType == FileMetadata::kDirectory)
         {
             // Check if path is eligible for an implicit index.html
             if (implicitPageEnable_)
@@ -278,46 +286,42 @@ void StaticFileRouter::route(
     defaultHandler_(req, std::move(callback));
 }
 
-// Expand this struct as you need, nothing to worry about
-struct FileStat
+const FileMetadata &StaticFileRouter::getFileMetadata(
+    const std::string &filePath)
 {
-    size_t fileSize_;
-    struct tm modifiedTime_;
-    std::string modifiedTimeStr_;
-};
+    if (!fileMetadataCache_ || fileMetadataCacheTime_ <= 0)
+    {
+        thread_local FileMetadata metadata;
+        FileMetadataCache::statFile(filePath, metadata);
+        return metadata;
+    }
+    return fileMetadataCache_->getThreadData()->get(filePath,
+                                                    fileMetadataCacheTime_);
+}
 
-// A wrapper to call stat()
-// std::filesystem::file_time_type::clock::to_time_t still not
-// implemented by M$, even in c++20, so keep calls to stat()
-static bool getFileStat(const std::string &filePath, FileStat &myStat)
+StaticFileCacheStats StaticFileRouter::getFileMetadataCacheStats() const
 {
-#if defined(_WIN32) && !defined(__MINGW32__)
-    struct _stati64 fileStat;
-#else   // _WIN32
-    struct stat fileStat;
-#endif  // _WIN32
-    if (stat(utils::toNativePath(filePath).c_str(), &fileStat) == 0 &&
-        S_ISREG(fileStat.st_mode))
+    StaticFileCacheStats stats;
+    for (auto *cache : fileMetadataCaches_)
     {
-        LOG_TRACE << "last modify time:" << fileStat.st_mtime;
-#ifdef _WIN32
-        gmtime_s(&myStat.modifiedTime_, &fileStat.st_mtime);
-#else
-        gmtime_r(&fileStat.st_mtime, &myStat.modifiedTime_);
-#endif
-        std::string &timeStr = myStat.modifiedTimeStr_;
-        timeStr.resize(64);
-        size_t len = strftime((char *)timeStr.data(),
-                              timeStr.size(),
-                              "%a, %d %b %Y %H:%M:%S GMT",
-                              &myStat.modifiedTime_);
-        timeStr.resize(len);
-
-        myStat.fileSize_ = fileStat.st_size;
-        return true;
+        cache->addStats(stats);
     }
+    return stats;
+}
 
-    return false;
+// rfc7232-6: If-None-Match takes precedence over If-Modified-Since
+static bool isNotModified(const HttpRequestImplPtr &req,
+                          const std::string &etag,
+                          const std::string &lastModified)
+{
+    const std::string &ifNoneMatch = req->getHeaderBy("if-none-match");
+    if (!ifNoneMatch.empty())
+    {
+        return ifNoneMatch == "*" ||
+               (!etag.empty() && ifNoneMatch.find(etag) != std::string::npos);
+    }
+    const std::string &ifModifiedSince = req->getHeaderBy("if-modified-since");
+    return !ifModifiedSince.empty() && ifModifiedSince == lastModified;
 }
 
 void StaticFileRouter::sendStaticFileResponse(
@@ -332,12 +336,14 @@ void StaticFileRouter::sendStaticFileResponse(
         return;
     }
 
-    FileStat fileStat;
+    // A copy, the cached entry may be replaced by the lookups below
+    FileMetadata fileStat;
     bool fileExists = false;
     const std::string &rangeStr = req->getHeaderBy("range");
     if (enableRange_ && !rangeStr.empty())
     {
-        if (!getFileStat(filePath, fileStat))
+        fileStat = getFileMetadata(filePath);
+        if (fileStat.type != FileMetadata::kRegular)
         {
             defaultHandler_(req, std::move(callback));
             return;
@@ -346,8 +352,8 @@ void StaticFileRouter::sendStaticFileResponse(
         // Check last modified time, rfc2616-14.25
         // If-Modified-Since: Mon, 15 Oct 2018 06:26:33 GMT
         // According to rfc 7233-3.1, preconditions must be evaluated before
-        const std::string &modiStr = req->getHeaderBy("if-modified-since");
-        if (enableLastModify_ && modiStr == fileStat.modifiedTimeStr_)
+        if (enableLastModify_ &&
+            isNotModified(req, fileStat.etag, fileStat.lastModified))
         {
             LOG_TRACE << "Not modified!";
             std::shared_ptr<HttpResponseImpl> resp =
@@ -359,32 +365,40 @@ void StaticFileRouter::sendStaticFileResponse(
         }
         // Check If-Range precondition
         const std::string &ifRange = req->getHeaderBy("if-range");
-        if (ifRange.empty() || ifRange == fileStat.modifiedTimeStr_)
+        if (ifRange.empty() || ifRange == fileStat.lastModified ||
+            ifRange == fileStat.etag)
         {
             std::vector<FileRange> ranges;
-            switch (parseRangeHeader(rangeStr, fileStat.fileSize_, ranges))
+            switch (parseRangeHeader(rangeStr, fileStat.size, ranges))
             {
-                // TODO: support only single range now
-                // Contributions are welcomed.
                 case FileRangeParseResult::SinglePart:
                 case FileRangeParseResult::MultiPart:
                 {
-                    auto firstRange = ranges.front();
                     auto ct = fileNameToContentTypeAndMime(filePath);
-                    auto resp =
-                        HttpResponse::newFileResponse(filePath,
-                                                      firstRange.start,
-                                                      firstRange.end -
-                                                          firstRange.start,
-                                                      true,
-                                                      "",
-                                                      ct.first,
-                                                      std::string(ct.second),
-                                                      req);
-                    if (!fileStat.modifiedTimeStr_.empty())
+                    HttpResponsePtr resp;
+                    if (ranges.size() == 1)
+                    {
+                        auto &range = ranges.front();
+                        resp = HttpResponse::newFileResponse(
+                            filePath,
+                            range.start,
+                            range.end - range.start,
+                            true,
+                            "",
+                            ct.first,
+                            std::string(ct.second),
+                            req);
+                    }
+                    else
+                    {
+                        resp = HttpResponseImpl::newMultiRangeFileResponse(
+                            filePath, fileStat.size, ranges, ct.second, req);
+                    }
+                    if (!fileStat.lastModified.empty())
                     {
                         resp->addHeader("Last-Modified",
-                                        fileStat.modifiedTimeStr_);
+                                        fileStat.lastModified);
+                        resp->addHeader("ETag", fileStat.etag);
                         resp->addHeader("Expires",
                                         "Thu, 01 Jan 1970 00:00:00 GMT");
                     }
@@ -399,7 +413,7 @@ void StaticFileRouter::sendStaticFileResponse(
                     snprintf(buf,
                              sizeof(buf),
                              "bytes */%zu",
-                             fileStat.fileSize_);
+                             fileStat.size);
                     resp->addHeader("Content-Range", std::string(buf));
                     callback(resp);
                     return;
@@ -434,9 +448,11 @@ void StaticFileRouter::sendStaticFileResponse(
     {
         if (cachedResp)
         {
-            if (static_cast<HttpResponseImpl *>(cachedResp.get())
-                    ->getHeaderBy("last-modified") ==
-                req->getHeaderBy("if-modified-since"))
+            auto cachedRespImpl =
+                static_cast<HttpResponseImpl *>(cachedResp.get());
+            if (isNotModified(req,
+                              cachedRespImpl->getHeaderBy("etag"),
+                              cachedRespImpl->getHeaderBy("last-modified")))
             {
                 std::shared_ptr<HttpResponseImpl> resp =
                     std::make_shared<HttpResponseImpl>();
@@ -449,14 +465,17 @@ void StaticFileRouter::sendStaticFileResponse(
         else
         {
             LOG_TRACE << "enabled LastModify";
-            if (!fileExists && !getFileStat(filePath, fileStat))
+            if (!fileExists)
             {
-                defaultHandler_(req, std::move(callback));
-                return;
+                fileStat = getFileMetadata(filePath);
+                if (fileStat.type != FileMetadata::kRegular)
+                {
+                    defaultHandler_(req, std::move(callback));
+                    return;
+                }
+                fileExists = true;
             }
-            fileExists = true;
-            const std::string &modiStr = req->getHeaderBy("if-modified-since");
-            if (modiStr == fileStat.modifiedTimeStr_)
+            if (isNotModified(req, fileStat.etag, fileStat.lastModified))
             {
                 LOG_TRACE << "not Modified!";
                 std::shared_ptr<HttpResponseImpl> resp =
@@ -475,16 +494,11 @@ void StaticFileRouter::sendStaticFileResponse(
         return;
     }
     // Check existence
-    if (!fileExists)
+    if (!fileExists &&
+        getFileMetadata(filePath).type != FileMetadata::kRegular)
     {
-        std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-        std::error_code err;
-        if (!std::filesystem::exists(fsFilePath, err) ||
-            !std::filesystem::is_regular_file(fsFilePath, err))
-        {
-            defaultHandler_(req, std::move(callback));
-            return;
-        }
+        defaultHandler_(req, std::move(callback));
+        return;
     }
 
     HttpResponsePtr resp;
@@ -494,10 +508,7 @@ void StaticFileRouter::sendStaticFileResponse(
     {
         // Find compressed file first.
         auto brFileName = filePath + ".br";
-        std::filesystem::path fsBrFile(utils::toNativePath(brFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsBrFile, err) &&
-            std::filesystem::is_regular_file(fsBrFile, err))
+        if (getFileMetadata(brFileName).type == FileMetadata::kRegular)
         {
             auto ct = fileNameToContentTypeAndMime(filePath);
             resp = HttpResponse::newFileResponse(
@@ -510,10 +521,7 @@ void StaticFileRouter::sendStaticFileResponse(
     {
         // Find compressed file first.
         auto gzipFileName = filePath + ".gz";
-        std::filesystem::path fsGzipFile(utils::toNativePath(gzipFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsGzipFile, err) &&
-            std::filesystem::is_regular_file(fsGzipFile, err))
+        if (getFileMetadata(gzipFileName).type == FileMetadata::kRegular)
         {
             auto ct = fileNameToContentTypeAndMime(filePath);
             resp = HttpResponse::newFileResponse(
@@ -535,9 +543,10 @@ void StaticFileRouter::sendStaticFileResponse(
             resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
                                                     defaultContentType);
         }
-        if (!fileStat.modifiedTimeStr_.empty())
+        if (!fileStat.lastModified.empty())
         {
-            resp->addHeader("Last-Modified", fileStat.modifiedTimeStr_);
+            resp->addHeader("Last-Modified", fileStat.lastModified);
+            resp->addHeader("ETag", fileStat.etag);
             resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
         }
         if (enableRange_)
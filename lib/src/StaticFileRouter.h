@@ -16,12 +16,15 @@
 
 #include "impl_forwards.h"
 #include "MiddlewaresFunction.h"
+#include "FileMetadataCache.h"
 #include <drogon/CacheMap.h>
+#include <drogon/HttpAppFramework.h>
 #include <drogon/IOThreadStorage.h>
 #include <functional>
 #include <set>
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 namespace drogon
 {
@@ -48,6 +51,18 @@ class StaticFileRouter
         return staticFilesCacheTime_;
     }
 
+    void setFileMetadataCacheTime(double cacheTime)
+    {
+        fileMetadataCacheTime_ = cacheTime;
+    }
+
+    double fileMetadataCacheTime() const
+    {
+        return fileMetadataCacheTime_;
+    }
+
+    StaticFileCacheStats getFileMetadataCacheStats() const;
+
     void setGzipStatic(bool useGzipStatic)
     {
         gzipStaticFlag_ = useGzipStatic;
@@ -116,6 +131,9 @@ class StaticFileRouter
     }
 
   private:
+    // The returned reference is valid until the next call.
+    const FileMetadata &getFileMetadata(const std::string &filePath);
+
     static void defaultHandler(
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback);
@@ -141,6 +159,11 @@ class StaticFileRouter
                                        "icns"};
 
     int staticFilesCacheTime_{5};
+    double fileMetadataCacheTime_{1.0};
+    std::unique_ptr<IOThreadStorage<std::unique_ptr<FileMetadataCache>>>
+        fileMetadataCache_;
+    // The caches of all threads, for the statistics
+    std::vector<FileMetadataCache *> fileMetadataCaches_;
     bool enableLastModify_{true};
     bool enableRange_{true};
     bool gzipStaticFlag_{true};
@@ -16,6 +16,7 @@
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/Utilities.h>
 #include <drogon/config.h>
+#include "SimdKernels.h"
 #ifdef USE_BROTLI
 #include <brotli/decode.h>
 #include <brotli/encode.h>
@@ -145,9 +146,54 @@ static inline bool isBase64(unsigned char c)
     return false;
 }
 
+// The character sets of the vectorized scans
+static const CharSet &digitChars()
+{
+    static const CharSet set =
+        CharSet::make([](char c) { return c >= '0' && c <= '9'; });
+    return set;
+}
+
+static const CharSet &base64CharSet()
+{
+    static const CharSet set =
+        CharSet::make([](char c) { return isBase64(c); });
+    return set;
+}
+
+// The characters urlDecode() copies as they are
+static const CharSet &plainUrlChars()
+{
+    static const CharSet set =
+        CharSet::make([](char c) { return c != '+' && c != '%'; }, true);
+    return set;
+}
+
+// The characters urlEncodeComponent() doesn't escape
+static const CharSet &urlComponentChars()
+{
+    static const CharSet set = CharSet::make([](char c) {
+        return isalnum(static_cast<unsigned char>(c)) ||
+               std::string_view("-_.!~*()").find(c) != std::string_view::npos;
+    });
+    return set;
+}
+
+// The characters urlEncode() doesn't escape
+static const CharSet &urlChars()
+{
+    static const CharSet set = CharSet::make([](char c) {
+        return isalnum(static_cast<unsigned char>(c)) ||
+               std::string_view("-_.!~*'()&=/\\?").find(c) !=
+                   std::string_view::npos;
+    });
+    return set;
+}
+
 bool isInteger(std::string_view str)
 {
-    for (auto c : str)
+    auto i = SimdKernels::span(str.data(), str.size(), digitChars());
+    for (auto c : str.substr(i))
         if (c < '0' || c > '9')
             return false;
     return true;
@@ -155,7 +201,8 @@ bool isInteger(std::string_view str)
 
 bool isBase64(std::string_view str)
 {
-    for (auto c : str)
+    auto i = SimdKernels::span(str.data(), str.size(), base64CharSet());
+    for (auto c : str.substr(i))
         if (!isBase64(c))
             return false;
     return true;
@@ -182,7 +229,8 @@ std::vector<char> hexToBinaryVector(const char *ptr, size_t length)
 {
     assert(length % 2 == 0);
     std::vector<char> ret(length / 2, '\0');
-    for (size_t i = 0; i < ret.size(); ++i)
+    auto decoded = SimdKernels::hexDecode(ptr, length, ret.data()) / 2;
+    for (size_t i = decoded; i < ret.size(); ++i)
     {
         auto p = i * 2;
         char c1 = ptr[p];
@@ -232,7 +280,8 @@ std::string hexToBinaryString(const char *ptr, size_t length)
 {
     assert(length % 2 == 0);
     std::string ret(length / 2, '\0');
-    for (size_t i = 0; i < ret.length(); ++i)
+    auto decoded = SimdKernels::hexDecode(ptr, length, &ret[0]) / 2;
+    for (size_t i = decoded; i < ret.length(); ++i)
     {
         auto p = i * 2;
         char c1 = ptr[p];
@@ -283,7 +332,8 @@ DROGON_EXPORT void binaryStringToHex(const char *ptr,
                                      char *out,
                                      bool lowerCase)
 {
-    for (size_t i = 0; i < length; ++i)
+    auto encoded = SimdKernels::hexEncode(ptr, length, out, lowerCase);
+    for (size_t i = encoded; i < length; ++i)
     {
         int value = (ptr[i] & 0xf0) >> 4;
         if (value < 10)
@@ -441,7 +491,11 @@ void base64Encode(const unsigned char *bytesToEncode,
 
     const std::string_view charSet = urlSafe ? urlBase64Chars : base64Chars;
 
-    size_t a = 0;
+    auto encoded =
+        SimdKernels::base64Encode(bytesToEncode, inLen, outputBuffer, urlSafe);
+    bytesToEncode += encoded;
+    inLen -= encoded;
+    size_t a = encoded / 3 * 4;
     while (inLen--)
     {
         charArray3[i++] = *(bytesToEncode++);
@@ -486,62 +540,10 @@ void base64Encode(const unsigned char *bytesToEncode,
 
 std::vector<char> base64DecodeToVector(std::string_view encodedString)
 {
-    auto inLen = encodedString.size();
-    int i = 0;
-    int in_{0};
-    char charArray4[4], charArray3[3];
-    std::vector<char> ret;
-    ret.reserve(base64DecodedLength(inLen));
-
-    while (inLen-- && (encodedString[in_] != '='))
-    {
-        if (!isBase64(encodedString[in_]))
-        {
-            ++in_;
-            continue;
-        }
-
-        charArray4[i++] = encodedString[in_];
-        ++in_;
-        if (i == 4)
-        {
-            for (i = 0; i < 4; ++i)
-            {
-                charArray4[i] = base64CharMap.getIndex(charArray4[i]);
-            }
-
-            charArray3[0] =
-                (charArray4[0] << 2) + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] =
-                ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) + charArray4[3];
-
-            for (i = 0; (i < 3); ++i)
-                ret.push_back(charArray3[i]);
-            i = 0;
-        }
-    }
-
-    if (i)
-    {
-        for (int j = i; j < 4; ++j)
-            charArray4[j] = 0;
-
-        for (int j = 0; j < 4; ++j)
-        {
-            charArray4[j] = base64CharMap.getIndex(charArray4[j]);
-        }
-
-        charArray3[0] = (charArray4[0] << 2) + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] =
-            ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) + charArray4[3];
-
-        --i;
-        for (int j = 0; (j < i); ++j)
-            ret.push_back(charArray3[j]);
-    }
-
+    std::vector<char> ret(base64DecodedLength(encodedString.size()));
+    ret.resize(base64Decode(encodedString.data(),
+                            encodedString.size(),
+                            reinterpret_cast<unsigned char *>(ret.data())));
     return ret;
 }
 
@@ -550,10 +552,12 @@ size_t base64Decode(const char *encodedString,
                     unsigned char *outputBuffer)
 {
     int i = 0;
-    int in_{0};
     unsigned char charArray4[4], charArray3[3];
 
-    size_t a = 0;
+    // Whole groups of valid characters are decoded in vectors
+    size_t in_ = SimdKernels::base64Decode(encodedString, inLen, outputBuffer);
+    inLen -= in_;
+    size_t a = in_ / 4 * 3;
     while (inLen-- && (encodedString[in_] != '='))
     {
         if (!isBase64(encodedString[in_]))
@@ -624,11 +628,21 @@ static std::string charToHex(char c)
 std::string urlEncodeComponent(const std::string &src)
 {
     std::string result;
-    std::string::const_iterator iter;
 
-    for (iter = src.begin(); iter != src.end(); ++iter)
+    for (size_t i = 0; i < src.size(); ++i)
     {
-        switch (*iter)
+        // Copy the runs of characters which are not escaped at once
+        auto run = SimdKernels::span(src.data() + i,
+                                     src.size() - i,
+                                     urlComponentChars());
+        if (run > 0)
+        {
+            result.append(src, i, run);
+            i += run;
+            if (i == src.size())
+                break;
+        }
+        switch (src[i])
         {
             case ' ':
                 result.append(1, '+');
@@ -705,12 +719,12 @@ std::string urlEncodeComponent(const std::string &src)
             case '*':
             case '(':
             case ')':
-                result.append(1, *iter);
+                result.append(1, src[i]);
                 break;
             // escape
             default:
                 result.append(1, '%');
-                result.append(charToHex(*iter));
+                result.append(charToHex(src[i]));
                 break;
         }
     }
@@ -721,11 +735,20 @@ std::string urlEncodeComponent(const std::string &src)
 std::string urlEncode(const std::string &src)
 {
     std::string result;
-    std::string::const_iterator iter;
 
-    for (iter = src.begin(); iter != src.end(); ++iter)
+    for (size_t i = 0; i < src.size(); ++i)
     {
-        switch (*iter)
+        // Copy the runs of characters which are not escaped at once
+        auto run =
+            SimdKernels::span(src.data() + i, src.size() - i, urlChars());
+        if (run > 0)
+        {
+            result.append(src, i, run);
+            i += run;
+            if (i == src.size())
+                break;
+        }
+        switch (src[i])
         {
             case ' ':
                 result.append(1, '+');
@@ -808,12 +831,12 @@ std::string urlEncode(const std::string &src)
             case '/':
             case '\\':
             case '?':
-                result.append(1, *iter);
+                result.append(1, src[i]);
                 break;
             // escape
             default:
                 result.append(1, '%');
-                result.append(charToHex(*iter));
+                result.append(charToHex(src[i]));
                 break;
         }
     }
@@ -823,6 +846,7 @@ std::string urlEncode(const std::string &src)
 
 bool needUrlDecoding(const char *begin, const char *end)
 {
+    begin += SimdKernels::span(begin, end - begin, plainUrlChars());
     return std::find_if(begin, end, [](const char c) {
                return c == '+' || c == '%';
            }) != end;
@@ -836,6 +860,14 @@ std::string urlDecode(const char *begin, const char *end)
     int hex = 0;
     for (size_t i = 0; i < len; ++i)
     {
+        auto run = SimdKernels::span(begin + i, len - i, plainUrlChars());
+        if (run > 0)
+        {
+            result.append(begin + i, run);
+            i += run;
+            if (i == len)
+                break;
+        }
         switch (begin[i])
         {
             case '+':
@@ -159,7 +159,89 @@ void WebSocketConnectionImpl::sendWsData(const char *msg,
         bytesFormatted.resize(indexStartRawData);
         bytesFormatted.append(msg, len);
     }
-    tcpConnectionPtr_->send(std::move(bytesFormatted));
+    sendFrame(std::move(bytesFormatted), opcode);
+}
+
+void WebSocketConnectionImpl::sendFrame(std::string &&frame,
+                                        unsigned char opcode)
+{
+    if (!coalescing_.load(std::memory_order_acquire))
+    {
+        tcpConnectionPtr_->send(std::move(frame));
+        return;
+    }
+    auto loop = tcpConnectionPtr_->getLoop();
+    if (loop->isInLoopThread())
+    {
+        coalesceFrameInLoop(std::move(frame), opcode);
+        return;
+    }
+    auto thisPtr = weak_from_this().lock();
+    if (!thisPtr)
+    {
+        // Called from the destructor, the pending frames have been flushed
+        // because the flush callbacks hold the connection.
+        tcpConnectionPtr_->send(std::move(frame));
+        return;
+    }
+    loop->queueInLoop([thisPtr = std::move(thisPtr),
+                       frame = std::move(frame),
+                       opcode]() mutable {
+        thisPtr->coalesceFrameInLoop(std::move(frame), opcode);
+    });
+}
+
+void WebSocketConnectionImpl::coalesceFrameInLoop(std::string &&frame,
+                                                  unsigned char opcode)
+{
+    if (!coalescing_.load(std::memory_order_relaxed))
+    {
+        // Coalescing was disabled after the frame was queued
+        flushFramesInLoop();
+        tcpConnectionPtr_->send(std::move(frame));
+        return;
+    }
+    pendingFrames_.append(frame);
+    // Control frames are never held back
+    if ((opcode & 0x08) || pendingFrames_.size() >= coalescingBufferSize_)
+    {
+        flushFramesInLoop();
+        return;
+    }
+    if (flushScheduled_)
+        return;
+    flushScheduled_ = true;
+    auto loop = tcpConnectionPtr_->getLoop();
+    if (coalescingDelay_ <= 0.0)
+    {
+        // Run after the other events of the current loop iteration
+        loop->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->flushFramesInLoop(); });
+    }
+    else
+    {
+        flushTimerId_ =
+            loop->runAfter(coalescingDelay_, [thisPtr = shared_from_this()]() {
+                thisPtr->flushTimerId_ = trantor::InvalidTimerId;
+                thisPtr->flushFramesInLoop();
+            });
+    }
+}
+
+void WebSocketConnectionImpl::flushFramesInLoop()
+{
+    if (flushTimerId_ != trantor::InvalidTimerId)
+    {
+        tcpConnectionPtr_->getLoop()->invalidateTimer(flushTimerId_);
+        flushTimerId_ = trantor::InvalidTimerId;
+    }
+    flushScheduled_ = false;
+    if (pendingFrames_.empty())
+        return;
+    LOG_TRACE << "flush " << pendingFrames_.length() << " bytes of frames";
+    // The buffer is kept for the next frames
+    tcpConnectionPtr_->send(pendingFrames_.data(), pendingFrames_.length());
+    pendingFrames_.clear();
 }
 
 void WebSocketConnectionImpl::send(const std::string_view msg,
@@ -265,6 +347,28 @@ void WebSocketConnectionImpl::disablePing()
     }
 }
 
+void WebSocketConnectionImpl::enableWriteCoalescing(
+    const std::chrono::duration<double> &maxDelay,
+    size_t maxBufferSize)
+{
+    tcpConnectionPtr_->getLoop()->runInLoop(
+        [thisPtr = shared_from_this(),
+         delay = maxDelay.count(),
+         maxBufferSize]() {
+            thisPtr->coalescingDelay_ = delay;
+            thisPtr->coalescingBufferSize_ = maxBufferSize;
+            thisPtr->coalescing_.store(true, std::memory_order_release);
+        });
+}
+
+void WebSocketConnectionImpl::disableWriteCoalescing()
+{
+    tcpConnectionPtr_->getLoop()->runInLoop([thisPtr = shared_from_this()]() {
+        thisPtr->coalescing_.store(false, std::memory_order_release);
+        thisPtr->flushFramesInLoop();
+    });
+}
+
 bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
 {
     // According to the rfc6455
@@ -41,6 +41,13 @@ class WebSocketMessageParser
         return true;
     }
 
+    // Release the memory of the message buffer if no message is pending
+    void releaseIdleBuffer()
+    {
+        if (message_.empty())
+            std::string().swap(message_);
+    }
+
   private:
     std::string message_;
     WebSocketMessageType type_;
@@ -83,6 +90,10 @@ class WebSocketConnectionImpl final
 
     void disablePing() override;
 
+    void enableWriteCoalescing(const std::chrono::duration<double> &maxDelay,
+                               size_t maxBufferSize) override;
+    void disableWriteCoalescing() override;
+
     void setMessageCallback(
         const std::function<void(std::string &&,
                                  const WebSocketConnectionImplPtr &,
@@ -104,9 +115,19 @@ class WebSocketConnectionImpl final
     {
         if (pingTimerId_ != trantor::InvalidTimerId)
             tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
+        if (flushTimerId_ != trantor::InvalidTimerId)
+            tcpConnectionPtr_->getLoop()->invalidateTimer(flushTimerId_);
         closeCallback_(shared_from_this());
     }
 
+    // Called in the loop when the connection is idle
+    void releaseIdleBuffers()
+    {
+        if (pendingFrames_.empty())
+            std::string().swap(pendingFrames_);
+        parser_.releaseIdleBuffer();
+    }
+
   private:
     trantor::TcpConnectionPtr tcpConnectionPtr_;
     trantor::InetAddress localAddr_;
@@ -116,6 +137,13 @@ class WebSocketConnectionImpl final
     trantor::TimerId pingTimerId_{trantor::InvalidTimerId};
     std::vector<uint32_t> masks_;
     std::atomic<bool> usingMask_;
+    // Write coalescing, the pending frames are only accessed in the loop
+    std::atomic<bool> coalescing_{false};
+    double coalescingDelay_{0.0};
+    size_t coalescingBufferSize_{0};
+    std::string pendingFrames_;
+    bool flushScheduled_{false};
+    trantor::TimerId flushTimerId_{trantor::InvalidTimerId};
 
     std::function<void(std::string &&,
                        const WebSocketConnectionImplPtr &,
@@ -127,6 +155,9 @@ class WebSocketConnectionImpl final
         [](const WebSocketConnectionImplPtr &) {};
     void sendWsData(const char *msg, uint64_t len, unsigned char opcode);
     void disablePingInLoop();
+    void sendFrame(std::string &&frame, unsigned char opcode);
+    void coalesceFrameInLoop(std::string &&frame, unsigned char opcode);
+    void flushFramesInLoop();
     void setPingMessageInLoop(std::string &&message,
                               const std::chrono::duration<double> &interval);
 };
@@ -0,0 +1,165 @@
+/**
+ *
+ *  @file XxHash64.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "XxHash64.h"
+#include <cstring>
+
+using namespace drogon;
+
+namespace
+{
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Little endian loads, memcpy is compiled to a single move
+inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline uint32_t read32(const unsigned char *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+inline uint64_t round(uint64_t lane, uint64_t input)
+{
+    lane += input * kPrime2;
+    lane = rotateLeft(lane, 31);
+    return lane * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t hash, uint64_t lane)
+{
+    hash ^= round(0, lane);
+    return hash * kPrime1 + kPrime4;
+}
+
+// Consume the whole stripes of 32 bytes, return the number of bytes consumed
+inline size_t consumeStripes(uint64_t *lanes,
+                             const unsigned char *data,
+                             size_t length)
+{
+    auto v1 = lanes[0];
+    auto v2 = lanes[1];
+    auto v3 = lanes[2];
+    auto v4 = lanes[3];
+    size_t offset = 0;
+    for (; offset + 32 <= length; offset += 32)
+    {
+        v1 = round(v1, read64(data + offset));
+        v2 = round(v2, read64(data + offset + 8));
+        v3 = round(v3, read64(data + offset + 16));
+        v4 = round(v4, read64(data + offset + 24));
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+    return offset;
+}
+}  // namespace
+
+XxHash64::XxHash64(uint64_t seed)
+    : seed_(seed),
+      lanes_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1}
+{
+}
+
+void XxHash64::update(const void *data, size_t length)
+{
+    auto input = static_cast<const unsigned char *>(data);
+    totalLength_ += length;
+    if (buffered_ > 0)
+    {
+        auto count = sizeof(buffer_) - buffered_;
+        if (length < count)
+        {
+            memcpy(buffer_ + buffered_, input, length);
+            buffered_ += length;
+            return;
+        }
+        memcpy(buffer_ + buffered_, input, count);
+        consumeStripes(lanes_, buffer_, sizeof(buffer_));
+        buffered_ = 0;
+        input += count;
+        length -= count;
+    }
+    auto consumed = consumeStripes(lanes_, input, length);
+    buffered_ = length - consumed;
+    memcpy(buffer_, input + consumed, buffered_);
+}
+
+uint64_t XxHash64::digest() const
+{
+    uint64_t hash;
+    if (totalLength_ >= 32)
+    {
+        hash = rotateLeft(lanes_[0], 1) + rotateLeft(lanes_[1], 7) +
+               rotateLeft(lanes_[2], 12) + rotateLeft(lanes_[3], 18);
+        for (auto lane : lanes_)
+        {
+            hash = mergeRound(hash, lane);
+        }
+    }
+    else
+    {
+        hash = seed_ + kPrime5;
+    }
+    hash += totalLength_;
+
+    auto p = buffer_;
+    auto end = buffer_ + buffered_;
+    for (; p + 8 <= end; p += 8)
+    {
+        hash ^= round(0, read64(p));
+        hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        hash ^= (*p) * kPrime5;
+        hash = rotateLeft(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
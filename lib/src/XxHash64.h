@@ -0,0 +1,52 @@
+/**
+ *
+ *  @file XxHash64.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace drogon
+{
+/**
+ * @brief The 64-bit xxHash, a fast non-cryptographic hash, computed
+ * incrementally. It's used for the automatic ETags of the responses, the
+ * values are the same as the ones of the reference implementation.
+ */
+class XxHash64
+{
+  public:
+    explicit XxHash64(uint64_t seed = 0);
+
+    void update(const void *data, size_t length);
+
+    /// The hash of the data so far, more data can still be added.
+    uint64_t digest() const;
+
+    static uint64_t hash(const void *data, size_t length, uint64_t seed = 0)
+    {
+        XxHash64 hasher(seed);
+        hasher.update(data, length);
+        return hasher.digest();
+    }
+
+  private:
+    uint64_t seed_;
+    uint64_t lanes_[4];
+    // The bytes not making up a whole stripe of 32 bytes yet
+    unsigned char buffer_[32];
+    size_t buffered_{0};
+    uint64_t totalLength_{0};
+};
+}  // namespace drogon
@@ -0,0 +1,226 @@
+/**
+ *
+ *  @file ZeroCopySocket.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ZeroCopySocket.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#ifdef __linux__
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define DROGON_HAS_MSG_ZEROCOPY 1
+#else
+#define DROGON_HAS_MSG_ZEROCOPY 0
+#endif
+
+using namespace drogon;
+
+namespace
+{
+struct ZeroCopyCounters
+{
+    std::atomic<size_t> sends{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> copiedSends{0};
+    std::atomic<size_t> fallbackBytes{0};
+};
+
+ZeroCopyCounters counters;
+
+// The largest chunk copied to trantor when the socket is full
+constexpr size_t maxFallbackChunk = 16 * 1024;
+// How often the error queue is read while sends are pending (in seconds)
+constexpr double completionCheckInterval = 0.001;
+// The buffers of a closed connection are released after this time (in
+// seconds), its completions can't be read anymore
+constexpr double closedSocketHoldTime = 10.0;
+}  // namespace
+
+ZeroCopySocket::~ZeroCopySocket() = default;
+
+bool ZeroCopySocket::isSupported()
+{
+    return DROGON_HAS_MSG_ZEROCOPY;
+}
+
+bool ZeroCopySocket::enable(int fd)
+{
+#if DROGON_HAS_MSG_ZEROCOPY
+    int on = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0)
+        return true;
+    LOG_DEBUG << "Failed to set SO_ZEROCOPY: " << strerror(errno);
+#else
+    (void)fd;
+#endif
+    return false;
+}
+
+std::function<std::size_t(char *, std::size_t)> ZeroCopySocket::makeStream(
+    std::shared_ptr<const void> owner,
+    const char *data,
+    size_t length)
+{
+    return [thisPtr = shared_from_this(),
+            owner = std::move(owner),
+            data,
+            length,
+            offset = size_t(0)](char *buffer, size_t bufferSize) mutable {
+        // Cleanup
+        if (buffer == nullptr)
+        {
+            owner.reset();
+            return size_t(0);
+        }
+        return thisPtr->sendData(
+            owner, data, length, offset, buffer, bufferSize);
+    };
+}
+
+size_t ZeroCopySocket::sendData(const std::shared_ptr<const void> &owner,
+                                const char *data,
+                                size_t length,
+                                size_t &offset,
+                                char *buffer,
+                                size_t bufferSize)
+{
+#if DROGON_HAS_MSG_ZEROCOPY
+    readCompletions();
+    while (fd_ >= 0 && offset < length)
+    {
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+        if (!copying_)
+            flags |= MSG_ZEROCOPY;
+        auto n = ::send(fd_, data + offset, length - offset, flags);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // EAGAIN, or ENOBUFS when the locked memory limit is reached. A
+            // broken connection is found by trantor on the next write.
+            break;
+        }
+        offset += static_cast<size_t>(n);
+        if (copying_)
+        {
+            counters.fallbackBytes += static_cast<size_t>(n);
+            continue;
+        }
+        ++counters.sends;
+        counters.bytes += static_cast<size_t>(n);
+        auto id = nextId_++;
+        if (!pending_.empty() && pending_.back().owner == owner)
+            pending_.back().lastId = id;
+        else
+            pending_.push_back({id, owner});
+    }
+    watchCompletions();
+#endif
+    if (offset >= length)
+        return 0;
+    auto n = (std::min)({length - offset, bufferSize, maxFallbackChunk});
+    memcpy(buffer, data + offset, n);
+    offset += n;
+    counters.fallbackBytes += n;
+    return n;
+}
+
+void ZeroCopySocket::readCompletions()
+{
+#if DROGON_HAS_MSG_ZEROCOPY
+    char control[128];
+    while (fd_ >= 0 && !pending_.empty())
+    {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return;
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (!(cmsg->cmsg_level == SOL_IP &&
+                  cmsg->cmsg_type == IP_RECVERR) &&
+                !(cmsg->cmsg_level == SOL_IPV6 &&
+                  cmsg->cmsg_type == IPV6_RECVERR))
+                continue;
+            auto err =
+                reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            // The sends [ee_info, ee_data] are completed. If the kernel had
+            // to copy the data (e.g. on the loopback device), the following
+            // sends skip the page pinning and the notifications.
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                counters.copiedSends += err->ee_data - err->ee_info + 1;
+                copying_ = true;
+            }
+            while (!pending_.empty() &&
+                   static_cast<int32_t>(pending_.front().lastId -
+                                        err->ee_data) <= 0)
+            {
+                pending_.pop_front();
+            }
+        }
+    }
+#endif
+}
+
+void ZeroCopySocket::watchCompletions()
+{
+    // The completions make the socket readable for errors, which trantor
+    // ignores, so they are read on a short timer.
+    if (watching_ || pending_.empty() || fd_ < 0)
+        return;
+    watching_ = true;
+    std::weak_ptr<ZeroCopySocket> weakPtr = shared_from_this();
+    loop_->runAfter(completionCheckInterval, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->watching_ = false;
+        thisPtr->readCompletions();
+        thisPtr->watchCompletions();
+    });
+}
+
+void ZeroCopySocket::close()
+{
+    fd_ = -1;
+    if (pending_.empty())
+        return;
+    // The kernel may still be sending the data
+    loop_->runAfter(closedSocketHoldTime,
+                    [pending = std::move(pending_)]() {});
+    pending_.clear();
+}
+
+ZeroCopySendStats ZeroCopySocket::getStats()
+{
+    ZeroCopySendStats stats;
+    stats.sends = counters.sends;
+    stats.bytes = counters.bytes;
+    stats.copiedSends = counters.copiedSends;
+    stats.fallbackBytes = counters.fallbackBytes;
+    return stats;
+}
@@ -0,0 +1,97 @@
+/**
+ *
+ *  @file ZeroCopySocket.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpAppFramework.h>
+#include <trantor/net/EventLoop.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace drogon
+{
+/**
+ * @brief The MSG_ZEROCOPY sends on an accepted plain TCP socket (Linux only).
+ * The kernel reads the data from the buffers of the responses, which are kept
+ * alive until the completions of the sends are read from the error queue of
+ * the socket.
+ */
+class ZeroCopySocket : public std::enable_shared_from_this<ZeroCopySocket>
+{
+  public:
+    ZeroCopySocket(int fd, trantor::EventLoop *loop) : fd_(fd), loop_(loop)
+    {
+    }
+
+    ~ZeroCopySocket();
+
+    /// Return true if MSG_ZEROCOPY is supported by the platform.
+    static bool isSupported();
+
+    /// Set the SO_ZEROCOPY option of an accepted socket.
+    static bool enable(int fd);
+
+    /**
+     * @brief Return a callback for TcpConnection::sendStream() that sends the
+     * data with MSG_ZEROCOPY. trantor calls it once all the data queued before
+     * it is written, so the direct sends keep the order of the connection.
+     * When the socket is full, a small chunk is copied to trantor, which calls
+     * back when the socket is writable again.
+     *
+     * @param owner Keeps the data alive.
+     */
+    std::function<std::size_t(char *, std::size_t)> makeStream(
+        std::shared_ptr<const void> owner,
+        const char *data,
+        size_t length);
+
+    /// Called when the connection is closed, the socket is no longer used.
+    void close();
+
+    static ZeroCopySendStats getStats();
+
+  private:
+    size_t sendData(const std::shared_ptr<const void> &owner,
+                    const char *data,
+                    size_t length,
+                    size_t &offset,
+                    char *buffer,
+                    size_t bufferSize);
+    void readCompletions();
+    void watchCompletions();
+
+    struct PendingSend
+    {
+        // The ID of the last send of the buffer
+        uint32_t lastId;
+        std::shared_ptr<const void> owner;
+    };
+
+    int fd_;
+    trantor::EventLoop *loop_;
+    // The kernel numbers the zero-copy sends of a socket from 0
+    uint32_t nextId_{0};
+    // The TCP completions are reported in order
+    std::deque<PendingSend> pending_;
+    bool watching_{false};
+    // True once the kernel copies the data instead of sending it from the
+    // buffers
+    bool copying_{false};
+};
+
+using ZeroCopySocketPtr = std::shared_ptr<ZeroCopySocket>;
+}  // namespace drogon
@@ -0,0 +1,171 @@
+/**
+ * Compares the compression of small API responses with gzip, brotli and the
+ * shared dictionary encodings (dcb, dcz). Reports the compressed size, the
+ * ratio to the original size and the time per response of each encoding.
+ *
+ * Usage: compression_dictionary_bench [dictionary file] [response files...]
+ *
+ * Without arguments, JSON responses of 1 to 4 KB are generated: the
+ * dictionary is made of the first 32 of them and the others are measured.
+ */
+#include <drogon/CompressionDictionary.h>
+#include <drogon/utils/Utilities.h>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string{std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>()};
+}
+
+// A page of orders, as returned by a typical REST API
+std::string makeResponse(std::mt19937 &random)
+{
+    static const char *statuses[] = {"pending", "paid", "shipped", "canceled"};
+    static const char *products[] = {
+        "keyboard", "monitor", "mouse", "headset", "laptop stand", "webcam"};
+    std::uniform_int_distribution<int> items(3, 14);
+    std::uniform_int_distribution<int> values(1, 99999);
+    std::string body = R"({"code":0,"message":"ok","data":{"page":)" +
+                       std::to_string(values(random) % 50) +
+                       R"(,"page_size":20,"orders":[)";
+    auto count = items(random);
+    for (int i = 0; i < count; ++i)
+    {
+        if (i > 0)
+            body.append(",");
+        body.append(R"({"order_id":")")
+            .append(std::to_string(values(random) * 1000 + i))
+            .append(R"(","customer":{"id":)")
+            .append(std::to_string(values(random)))
+            .append(R"(,"name":"customer)")
+            .append(std::to_string(values(random) % 500))
+            .append(R"(","vip":)")
+            .append(values(random) % 5 == 0 ? "true" : "false")
+            .append(R"(},"status":")")
+            .append(statuses[values(random) % 4])
+            .append(R"(","product":")")
+            .append(products[values(random) % 6])
+            .append(R"(","quantity":)")
+            .append(std::to_string(values(random) % 9 + 1))
+            .append(R"(,"price":)")
+            .append(std::to_string(values(random) % 500))
+            .append(".")
+            .append(std::to_string(values(random) % 90 + 10))
+            .append(R"(,"created_at":"2024-0)")
+            .append(std::to_string(values(random) % 9 + 1))
+            .append("-1")
+            .append(std::to_string(values(random) % 9))
+            .append(R"(T08:)")
+            .append(std::to_string(values(random) % 50 + 10))
+            .append(R"(:00Z","shipping":{"method":"standard",)")
+            .append(R"("country":"DE"}})");
+    }
+    body.append(R"(],"total":)")
+        .append(std::to_string(values(random)))
+        .append("}}");
+    return body;
+}
+
+void measure(const char *name,
+             const std::vector<std::string> &responses,
+             const std::function<std::string(const std::string &)> &compress)
+{
+    size_t original{0};
+    size_t compressed{0};
+    auto start = std::chrono::steady_clock::now();
+    for (auto &response : responses)
+    {
+        auto result = compress(response);
+        if (result.empty())
+        {
+            std::cout << std::left << std::setw(8) << name
+                      << "not available in this build" << std::endl;
+            return;
+        }
+        original += response.size();
+        compressed += result.size();
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(10) << compressed << " bytes, ratio "
+              << std::fixed << std::setprecision(2)
+              << static_cast<double>(original) / compressed << ", "
+              << std::setprecision(1) << elapsed.count() / responses.size()
+              << " us per response" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string dictionaryData;
+    std::vector<std::string> responses;
+    if (argc > 2)
+    {
+        dictionaryData = readFile(argv[1]);
+        for (int i = 2; i < argc; ++i)
+        {
+            responses.push_back(readFile(argv[i]));
+        }
+    }
+    else
+    {
+        std::mt19937 random(42);
+        for (int i = 0; i < 32; ++i)
+        {
+            dictionaryData.append(makeResponse(random));
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            responses.push_back(makeResponse(random));
+        }
+    }
+    auto dictionary = CompressionDictionary::fromData(dictionaryData);
+    if (!dictionary || responses.empty())
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [dictionary file] [response files...]" << std::endl;
+        return 1;
+    }
+    size_t original{0};
+    for (auto &response : responses)
+    {
+        original += response.size();
+    }
+    std::cout << responses.size() << " responses, " << original
+              << " bytes, dictionary of " << dictionaryData.size()
+              << " bytes" << std::endl;
+
+    measure("gzip", responses, [](const std::string &response) {
+        return utils::gzipCompress(response.data(), response.size());
+    });
+    measure("br", responses, [](const std::string &response) {
+        return utils::brotliCompress(response.data(), response.size());
+    });
+    for (auto encoding : {CompressionDictionary::Encoding::kBrotli,
+                          CompressionDictionary::Encoding::kZstd})
+    {
+        measure(CompressionDictionary::name(encoding),
+                responses,
+                [&dictionary, encoding](const std::string &response) {
+                    return dictionary->compress(response.data(),
+                                                response.size(),
+                                                encoding);
+                });
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+/**
+ * Measures the memory the server keeps for each idle keep-alive or websocket
+ * connection (see HttpAppFramework::setIdleBufferReleaseTime()). A client
+ * thread in the same process opens the connections with blocking sockets,
+ * sends one request on each of them and leaves them idle. The resident memory
+ * of the process is read from /proc/self/statm right after the requests and
+ * once the idle buffers are released. The client only keeps the descriptors,
+ * and the kernel socket buffers are not part of the resident memory.
+ *
+ * More than ~28000 connections need several loopback addresses, they are
+ * spread over 127.0.0.1, 127.0.0.2, ... and the open files limit is raised
+ * to the hard limit.
+ *
+ * Usage: idle_connection_memory_bench [http|ws] [number of connections]
+ */
+#include <drogon/WebSocketController.h>
+#include <drogon/drogon.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+const uint16_t benchPort = 8851;
+const size_t connectionsPerAddress = 25000;
+const double releaseTime = 1.0;
+
+// The resident memory of the process in bytes
+size_t residentMemory()
+{
+#ifdef __GLIBC__
+    // Give the freed memory back to the system
+    malloc_trim(0);
+#endif
+    std::ifstream statm("/proc/self/statm");
+    size_t size{0};
+    size_t resident{0};
+    statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void raiseOpenFilesLimit()
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Connect, send the request and read the response headers, returns -1 on
+// failure
+int openConnection(size_t index, const std::string &request)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(benchPort);
+    addr.sin_addr.s_addr =
+        htonl(INADDR_LOOPBACK +
+              static_cast<uint32_t>(index / connectionsPerAddress));
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof(addr)) != 0 ||
+        ::send(fd, request.data(), request.size(), 0) !=
+            static_cast<ssize_t>(request.size()))
+    {
+        ::close(fd);
+        return -1;
+    }
+    std::string response;
+    char buffer[512];
+    while (response.find("\r\n\r\n") == std::string::npos)
+    {
+        auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        response.append(buffer, static_cast<size_t>(n));
+    }
+    return fd;
+}
+
+void printMemory(const std::string &name, size_t memory, size_t base, size_t n)
+{
+    std::cout << name << (memory > base ? (memory - base) / n : 0)
+              << " bytes per connection" << std::endl;
+}
+
+void runClient(bool websocket, size_t connections)
+{
+    std::string request =
+        websocket ? "GET /ws HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                    "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                    "Sec-WebSocket-Version: 13\r\n\r\n"
+                  : "GET /idle HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    auto base = residentMemory();
+    std::vector<int> fds;
+    fds.reserve(connections);
+    for (size_t i = 0; i < connections; ++i)
+    {
+        auto fd = openConnection(i, request);
+        if (fd < 0)
+        {
+            std::cout << "Only " << fds.size() << " connections are opened"
+                      << std::endl;
+            break;
+        }
+        fds.push_back(fd);
+    }
+    if (!fds.empty())
+    {
+        std::cout << fds.size() << (websocket ? " websocket" : " keep-alive")
+                  << " connections" << std::endl;
+        printMemory("After the requests:    ",
+                    residentMemory(),
+                    base,
+                    fds.size());
+        // The buffers are released at the second check without any data
+        std::this_thread::sleep_for(
+            std::chrono::duration<double>(releaseTime * 2.5));
+        printMemory("After the idle release: ",
+                    residentMemory(),
+                    base,
+                    fds.size());
+    }
+    for (auto fd : fds)
+        ::close(fd);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+}
+}  // namespace
+
+class IdleBenchController : public WebSocketController<IdleBenchController>
+{
+  public:
+    void handleNewMessage(const WebSocketConnectionPtr &,
+                          std::string &&,
+                          const WebSocketMessageType &) override
+    {
+    }
+
+    void handleNewConnection(const HttpRequestPtr &,
+                             const WebSocketConnectionPtr &) override
+    {
+    }
+
+    void handleConnectionClosed(const WebSocketConnectionPtr &) override
+    {
+    }
+
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/ws", Get);
+    WS_PATH_LIST_END
+};
+
+int main(int argc, char *argv[])
+{
+    bool websocket = argc > 1 && std::string(argv[1]) == "ws";
+    size_t connections = argc > 2 ? std::stoul(argv[2]) : 10000;
+    raiseOpenFilesLimit();
+
+    app().registerHandler(
+        "/idle",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setBody("ok");
+            callback(resp);
+        });
+    app().getLoop()->queueInLoop([websocket, connections]() {
+        std::thread(runClient, websocket, connections).detach();
+    });
+    app()
+        .setLogLevel(trantor::Logger::kWarn)
+        .addListener("0.0.0.0", benchPort)
+        .setThreadNum(1)
+        .setMaxConnectionNum(connections + 16)
+        .setMaxConnectionNumPerIP(0)
+        .setIdleConnectionTimeout(0)
+        .setIdleBufferReleaseTime(releaseTime)
+        .run();
+    return 0;
+}
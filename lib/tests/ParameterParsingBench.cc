@@ -0,0 +1,100 @@
+/**
+ * Measures the parameter access of a form post with 30 parameters: building
+ * the whole parameters() map versus reading a few parameters through the lazy
+ * parameterView() or getParameter(). The requests are reused, as the request
+ * parser does.
+ *
+ * Usage: parameter_parsing_bench [number of requests]
+ */
+#include <drogon/drogon.h>
+#include "../src/HttpRequestImpl.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+// Keeps the results alive
+volatile size_t sink;
+
+template <typename Read>
+void run(const char *name,
+         size_t count,
+         const std::string &body,
+         Read &&read)
+{
+    HttpRequestImpl req(nullptr);
+    size_t total{0};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        req.reset();
+        req.setMethod(Post);
+        req.addHeader("content-type", "application/x-www-form-urlencoded");
+        req.setBody(body);
+        total += read(req);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << name << static_cast<size_t>(count / elapsed.count())
+              << " requests/s" << std::endl;
+    sink = total;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    // A typical form: mostly plain values, some with escaped spaces or
+    // punctuation
+    std::string body;
+    for (int i = 0; i < 30; ++i)
+    {
+        if (!body.empty())
+            body.append("&");
+        body.append("field").append(std::to_string(i)).append("=");
+        if (i % 5 == 0)
+            body.append("some+text%2C+with+escapes");
+        else
+            body.append("value").append(std::to_string(i * 37));
+    }
+
+    run("parameters() map, 3 reads:      ",
+        count,
+        body,
+        [](const HttpRequestImpl &req) {
+            auto &params = req.parameters();
+            return params.at("field3").size() + params.at("field10").size() +
+                   params.at("field29").size();
+        });
+    run("parameterView(), 3 reads:       ",
+        count,
+        body,
+        [](const HttpRequestImpl &req) {
+            auto &view = req.parameterView();
+            return view.get("field3")->size() + view.get("field10")->size() +
+                   view.get("field29")->size();
+        });
+    run("getParameter(), 3 reads:        ",
+        count,
+        body,
+        [](const HttpRequestImpl &req) {
+            return req.getParameter("field3").size() +
+                   req.getParameter("field10").size() +
+                   req.getParameter("field29").size();
+        });
+    run("parameterView(), all 30 values: ",
+        count,
+        body,
+        [](const HttpRequestImpl &req) {
+            size_t size{0};
+            req.parameterView().forEach(
+                [&size](std::string_view, std::string_view value) {
+                    size += value.size();
+                });
+            return size;
+        });
+    return 0;
+}
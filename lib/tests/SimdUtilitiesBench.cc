@@ -0,0 +1,129 @@
+/**
+ * Measures the string utilities with vectorized kernels (base64, hex, URL
+ * coding and validation) at every SIMD level the CPU supports, on inputs of
+ * a few sizes. The throughput is reported in MB of input per second.
+ *
+ * Usage: simd_utilities_bench [total MB per measurement]
+ */
+#include <drogon/utils/Utilities.h>
+#include "../src/SimdKernels.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+// Keeps the results alive
+volatile size_t sink;
+
+const char *levelName(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::kAvx2:
+            return "avx2";
+        case SimdLevel::kSse4:
+            return "sse4";
+        default:
+            return "scalar";
+    }
+}
+
+// Run the function on the input until the total size is processed
+template <typename Function>
+void run(const char *name,
+         const std::string &input,
+         size_t totalBytes,
+         Function &&function)
+{
+    size_t count = totalBytes / input.size() + 1;
+    size_t total{0};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += function(input);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "  " << std::left << std::setw(18) << name << std::right
+              << std::setw(10)
+              << static_cast<size_t>(count * input.size() /
+                                     elapsed.count() / 1e6)
+              << " MB/s" << std::endl;
+    sink = total;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    size_t totalBytes = (argc > 1 ? std::stoul(argv[1]) : 200) * 1000000;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    std::uniform_int_distribution<int> letterDist(0, 25);
+    auto supported = SimdKernels::supportedLevel();
+    for (size_t size : {64, 1024, 65536})
+    {
+        std::string bytes(size, '\0');
+        for (auto &c : bytes)
+            c = static_cast<char>(byteDist(rng));
+        std::string plain(size, '\0');
+        for (auto &c : plain)
+            c = static_cast<char>('a' + letterDist(rng));
+        // Query strings are mostly plain characters
+        auto query = plain;
+        for (size_t i = 39; i + 2 < size; i += 40)
+            query.replace(i, 3, "%2F");
+        auto base64 = utils::base64Encode(bytes);
+        auto hex = utils::binaryStringToHex(
+            reinterpret_cast<const unsigned char *>(bytes.data()), size);
+        auto digits = std::string(size, '7');
+        for (auto level : {SimdLevel::kScalar, SimdLevel::kSse4,
+                           SimdLevel::kAvx2})
+        {
+            if (level > supported)
+                break;
+            SimdKernels::setLevel(level);
+            std::cout << size << " bytes, " << levelName(level) << std::endl;
+            run("base64Encode", bytes, totalBytes, [](const std::string &in) {
+                return utils::base64Encode(in).size();
+            });
+            run("base64Decode", base64, totalBytes, [](const std::string &in) {
+                return utils::base64Decode(in).size();
+            });
+            auto toHex = [](const std::string &in) {
+                return utils::binaryStringToHex(
+                           reinterpret_cast<const unsigned char *>(in.data()),
+                           in.size())
+                    .size();
+            };
+            run("binaryStringToHex", bytes, totalBytes, toHex);
+            auto fromHex = [](const std::string &in) {
+                return utils::hexToBinaryString(in.data(), in.size()).size();
+            };
+            run("hexToBinaryString", hex, totalBytes, fromHex);
+            run("urlEncode", query, totalBytes, [](const std::string &in) {
+                return utils::urlEncode(in).size();
+            });
+            run("urlDecode", query, totalBytes, [](const std::string &in) {
+                return utils::urlDecode(in).size();
+            });
+            auto needDecoding = [](const std::string &in) {
+                return size_t(
+                    utils::needUrlDecoding(in.data(), in.data() + in.size()));
+            };
+            run("needUrlDecoding", plain, totalBytes, needDecoding);
+            run("isBase64", base64, totalBytes, [](const std::string &in) {
+                return size_t(utils::isBase64(in));
+            });
+            run("isInteger", digits, totalBytes, [](const std::string &in) {
+                return size_t(utils::isInteger(in));
+            });
+        }
+    }
+    SimdKernels::setLevel(supported);
+    return 0;
+}
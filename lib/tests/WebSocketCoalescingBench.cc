@@ -0,0 +1,166 @@
+/**
+ * Compares sending small WebSocket messages frame by frame with the write
+ * coalescing mode of WebSocketConnection. The server sends the messages in
+ * bursts (one burst per loop iteration) to a client running in the same
+ * process, the number of write system calls of the process is read from
+ * /proc/self/io on Linux.
+ *
+ * Usage: websocket_coalescing_bench [number of messages] [burst size]
+ */
+#include <drogon/WebSocketClient.h>
+#include <drogon/WebSocketController.h>
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+const uint16_t benchPort = 8849;
+
+// Returns the number of write system calls made by the process so far, or 0
+// if it is not available.
+size_t writeSyscalls()
+{
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    size_t value;
+    while (io >> key >> value)
+    {
+        if (key == "syscw:")
+            return value;
+    }
+    return 0;
+}
+
+void sendBursts(const WebSocketConnectionPtr &conn, size_t left, size_t burst)
+{
+    static const std::string message(32, 'x');
+    auto count = (std::min)(left, burst);
+    for (size_t i = 0; i < count; ++i)
+    {
+        conn->send(message);
+    }
+    left -= count;
+    if (left == 0 || !conn->connected())
+        return;
+    trantor::EventLoop::getEventLoopOfCurrentThread()->queueInLoop(
+        [conn, left, burst]() { sendBursts(conn, left, burst); });
+}
+}  // namespace
+
+class CoalescingBenchController
+    : public WebSocketController<CoalescingBenchController>
+{
+  public:
+    // The request is "<coalesce> <messages> <burst>"
+    void handleNewMessage(const WebSocketConnectionPtr &conn,
+                          std::string &&message,
+                          const WebSocketMessageType &type) override
+    {
+        if (type != WebSocketMessageType::Text)
+            return;
+        std::istringstream request(message);
+        int coalesce{0};
+        size_t messages{0};
+        size_t burst{1};
+        request >> coalesce >> messages >> burst;
+        if (coalesce)
+            conn->enableWriteCoalescing();
+        else
+            conn->disableWriteCoalescing();
+        sendBursts(conn, messages, (std::max)(burst, size_t(1)));
+    }
+
+    void handleNewConnection(const HttpRequestPtr &,
+                             const WebSocketConnectionPtr &) override
+    {
+    }
+
+    void handleConnectionClosed(const WebSocketConnectionPtr &) override
+    {
+    }
+
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/bench", Get);
+    WS_PATH_LIST_END
+};
+
+int main(int argc, char *argv[])
+{
+    size_t messages = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t burst = argc > 2 ? std::stoul(argv[2]) : 64;
+
+    struct Run
+    {
+        bool coalesce{false};
+        size_t received{0};
+        size_t syscalls{0};
+        std::chrono::steady_clock::time_point start;
+    };
+    auto run = std::make_shared<Run>();
+
+    auto startRun = [run, messages, burst](const WebSocketClientPtr &client,
+                                           bool coalesce) {
+        run->coalesce = coalesce;
+        run->received = 0;
+        run->syscalls = writeSyscalls();
+        run->start = std::chrono::steady_clock::now();
+        client->getConnection()->send(std::to_string(coalesce ? 1 : 0) + " " +
+                                      std::to_string(messages) + " " +
+                                      std::to_string(burst));
+    };
+
+    auto client = WebSocketClient::newWebSocketClient(
+        "ws://127.0.0.1:" + std::to_string(benchPort));
+    client->setMessageHandler(
+        [run, messages, startRun](const std::string &,
+                                  const WebSocketClientPtr &client,
+                                  const WebSocketMessageType &type) {
+            if (type != WebSocketMessageType::Text)
+                return;
+            if (++run->received < messages)
+                return;
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - run->start;
+            auto syscalls = writeSyscalls() - run->syscalls;
+            std::cout << (run->coalesce ? "coalesced:      "
+                                        : "frame by frame: ")
+                      << static_cast<size_t>(messages / elapsed.count())
+                      << " frames/s, "
+                      << static_cast<double>(syscalls) / messages
+                      << " write syscalls/frame" << std::endl;
+            if (!run->coalesce)
+                startRun(client, true);
+            else
+                app().quit();
+        });
+
+    app().getLoop()->queueInLoop([client, startRun]() {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/bench");
+        client->connectToServer(req,
+                                [startRun](ReqResult result,
+                                           const HttpResponsePtr &,
+                                           const WebSocketClientPtr &client) {
+                                    if (result != ReqResult::Ok)
+                                    {
+                                        LOG_ERROR << "Failed to connect";
+                                        app().quit();
+                                        return;
+                                    }
+                                    startRun(client, false);
+                                });
+    });
+    app()
+        .setLogLevel(trantor::Logger::kWarn)
+        .addListener("127.0.0.1", benchPort)
+        .setThreadNum(1)
+        .run();
+    return 0;
+}
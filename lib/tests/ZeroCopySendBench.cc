@@ -0,0 +1,200 @@
+/**
+ * Compares the CPU time the IO thread of the server spends per GB of large
+ * in-memory response bodies, sent by copying them into the socket buffers or
+ * with MSG_ZEROCOPY (see HttpAppFramework::setZeroCopySendThreshold()).
+ *
+ * By default a client in the same process downloads the body over the
+ * loopback device, where the kernel copies the data anyway (reported as
+ * copied sends), so the zero-copy numbers are only meaningful with a client
+ * on another host: in the serve mode the server listens on 0.0.0.0 and prints
+ * the CPU time per GB every 10 seconds, e.g. while
+ * `wrk -c 16 -d 60 http://server:8850/blob` runs on another host.
+ *
+ * Usage: zero_copy_send_bench [body size] [number of requests]
+ *        zero_copy_send_bench serve [body size] [threshold]
+ */
+#include <drogon/drogon.h>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+const uint16_t benchPort = 8850;
+const size_t concurrency = 8;
+
+// The CPU time of the calling thread in seconds
+double threadCpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+trantor::EventLoop *serverLoop()
+{
+    return app().getIOLoop(0);
+}
+
+struct Run
+{
+    bool zeroCopy{false};
+    size_t sent{0};
+    size_t received{0};
+    size_t bytes{0};
+    double cpuTime{0};
+    ZeroCopySendStats stats;
+};
+
+void printRun(const std::string &name,
+              double cpuTime,
+              size_t bytes,
+              const ZeroCopySendStats &before)
+{
+    auto stats = app().getZeroCopySendStats();
+    std::cout << name << (cpuTime / (bytes / 1e9)) << " CPU seconds/GB, "
+              << (stats.sends - before.sends) << " zero-copy sends, "
+              << (stats.copiedSends - before.copiedSends)
+              << " copied by the kernel" << std::endl;
+}
+
+void sendRequests(const HttpClientPtr &client,
+                  const std::shared_ptr<Run> &run,
+                  size_t requests,
+                  const std::function<void()> &done)
+{
+    while (run->sent < requests &&
+           run->sent - run->received < concurrency)
+    {
+        ++run->sent;
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/blob");
+        client->sendRequest(
+            req,
+            [client, run, requests, done](ReqResult result,
+                                          const HttpResponsePtr &resp) {
+                ++run->received;
+                if (result == ReqResult::Ok)
+                    run->bytes += resp->getBody().size();
+                if (run->received < requests)
+                {
+                    sendRequests(client, run, requests, done);
+                    return;
+                }
+                serverLoop()->queueInLoop([run, done]() {
+                    run->cpuTime = threadCpuTime() - run->cpuTime;
+                    app().getLoop()->queueInLoop(done);
+                });
+            });
+    }
+}
+
+void startRun(const HttpClientPtr &client,
+              bool zeroCopy,
+              size_t bodySize,
+              size_t requests)
+{
+    auto run = std::make_shared<Run>();
+    run->zeroCopy = zeroCopy;
+    run->stats = app().getZeroCopySendStats();
+    auto done = [client, run, bodySize, requests]() {
+        printRun(run->zeroCopy ? "MSG_ZEROCOPY: " : "copy:         ",
+                 run->cpuTime,
+                 run->bytes,
+                 run->stats);
+        if (!run->zeroCopy)
+            startRun(client, true, bodySize, requests);
+        else
+            app().quit();
+    };
+    // The threshold is read in the IO loop
+    serverLoop()->queueInLoop([client, run, bodySize, requests, done]() {
+        app().setZeroCopySendThreshold(run->zeroCopy ? bodySize : 0);
+        run->cpuTime = threadCpuTime();
+        app().getLoop()->queueInLoop([client, run, requests, done]() {
+            sendRequests(client, run, requests, done);
+        });
+    });
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    bool serve = argc > 1 && std::string(argv[1]) == "serve";
+    int argIndex = serve ? 2 : 1;
+    size_t bodySize =
+        argc > argIndex ? std::stoul(argv[argIndex]) : 1024 * 1024;
+    size_t requests = 2000;
+    size_t threshold = bodySize;
+    if (argc > argIndex + 1)
+    {
+        if (serve)
+            threshold = std::stoul(argv[argIndex + 1]);
+        else
+            requests = std::stoul(argv[argIndex + 1]);
+    }
+
+    // The same response is sent to every request, its rendered bytes are
+    // cached with the body
+    auto blob = HttpResponse::newHttpResponse();
+    blob->setBody(std::string(bodySize, 'x'));
+    blob->setExpiredTime(0);
+    app().registerHandler(
+        "/blob",
+        [blob](const HttpRequestPtr &,
+               std::function<void(const HttpResponsePtr &)> &&callback) {
+            callback(blob);
+        });
+
+    if (serve)
+    {
+        app().getLoop()->queueInLoop([]() {
+            auto last = std::make_shared<std::pair<double, size_t>>();
+            serverLoop()->runEvery(10.0, [last]() {
+                auto cpuTime = threadCpuTime();
+                auto stats = app().getZeroCopySendStats();
+                auto bytes = stats.bytes + stats.fallbackBytes;
+                if (bytes > last->second)
+                {
+                    std::cout << (cpuTime - last->first) /
+                                     ((bytes - last->second) / 1e9)
+                              << " CPU seconds/GB (large bodies only), "
+                              << stats.sends << " zero-copy sends, "
+                              << stats.copiedSends << " copied by the kernel"
+                              << std::endl;
+                }
+                *last = {cpuTime, bytes};
+            });
+        });
+        app()
+            .setLogLevel(trantor::Logger::kWarn)
+            .addListener("0.0.0.0", benchPort)
+            .setThreadNum(1)
+            .setZeroCopySendThreshold(threshold)
+            .run();
+        return 0;
+    }
+
+    app().getLoop()->queueInLoop([bodySize, requests]() {
+        auto client = HttpClient::newHttpClient(
+            "http://127.0.0.1:" + std::to_string(benchPort), app().getLoop());
+        client->setPipeliningDepth(concurrency);
+        startRun(client, false, bodySize, requests);
+    });
+    // The sockets get SO_ZEROCOPY when the threshold is set at startup
+    app()
+        .setLogLevel(trantor::Logger::kWarn)
+        .addListener("127.0.0.1", benchPort)
+        .setThreadNum(1)
+        .setZeroCopySendThreshold(bodySize)
+        .run();
+    return 0;
+}
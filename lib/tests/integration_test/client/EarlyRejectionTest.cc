@@ -0,0 +1,165 @@
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpClient.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace
+{
+// A raw connection to the test server, the test thread waits for what the
+// server sends in the loop thread.
+class RawConnection
+{
+  public:
+    RawConnection(trantor::EventLoop *loop, const trantor::InetAddress &addr)
+        : client_(std::make_shared<trantor::TcpClient>(loop,
+                                                       addr,
+                                                       "EarlyRejectionTest"))
+    {
+        client_->setMessageCallback(
+            [this](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buf) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                received_.append(buf->peek(), buf->readableBytes());
+                buf->retrieveAll();
+                cond_.notify_all();
+            });
+        client_->setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (conn->connected())
+                    conn_ = conn;
+                else
+                    closed_ = true;
+                cond_.notify_all();
+            });
+        client_->connect();
+    }
+
+    ~RawConnection()
+    {
+        client_->disconnect();
+    }
+
+    bool waitConnected()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_for(lock, 5s, [this]() { return conn_ != nullptr; });
+    }
+
+    void send(const std::string &data)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        conn_->send(data);
+    }
+
+    // Wait until the data received contains the text
+    bool waitFor(const std::string &text)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_for(lock, 5s, [this, &text]() {
+            return received_.find(text) != std::string::npos;
+        });
+    }
+
+    bool waitClosed()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_for(lock, 5s, [this]() { return closed_; });
+    }
+
+    std::string received()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_;
+    }
+
+  private:
+    std::shared_ptr<trantor::TcpClient> client_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    trantor::TcpConnectionPtr conn_;
+    std::string received_;
+    bool closed_{false};
+};
+
+std::string echoRequest(size_t contentLength, const std::string &headers)
+{
+    return "POST /early_rejection/echo HTTP/1.1\r\n"
+           "Host: 127.0.0.1\r\n"
+           "Content-Type: application/x-www-form-urlencoded\r\n"
+           "Content-Length: " +
+           std::to_string(contentLength) + "\r\n" + headers + "\r\n";
+}
+}  // namespace
+
+DROGON_TEST(EarlyRejectionTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    const trantor::InetAddress addr{"127.0.0.1", 8848};
+
+    SUBSECTION(RejectedBeforeBody)
+    {
+        // The advice rejects the request without asking the client for the
+        // body, and the connection is closed after the response
+        RawConnection conn(loopThread.getLoop(), addr);
+        REQUIRE(conn.waitConnected());
+        conn.send(echoRequest(100000,
+                              "Expect: 100-continue\r\n"
+                              "X-Reject-Before-Body: yes\r\n"));
+        CHECK(conn.waitFor("\r\n\r\n"));
+        CHECK(conn.received().rfind("HTTP/1.1 401 Unauthorized\r\n", 0) ==
+              0UL);
+        CHECK(conn.received().find("100 Continue") == std::string::npos);
+        CHECK(conn.waitClosed());
+    }
+
+    SUBSECTION(DrainThenClose)
+    {
+        // A client which sends the body anyway is cut off once 256 KiB of it
+        // are drained, the rest of the body never gets a response
+        RawConnection conn(loopThread.getLoop(), addr);
+        REQUIRE(conn.waitConnected());
+        conn.send(echoRequest(1000000, "X-Reject-Before-Body: yes\r\n"));
+        CHECK(conn.waitFor("\r\n\r\n"));
+        CHECK(conn.received().rfind("HTTP/1.1 401 Unauthorized\r\n", 0) ==
+              0UL);
+        conn.send(std::string(1000000, 'a'));
+        CHECK(conn.waitClosed());
+        CHECK(conn.received().find("HTTP/1.1", 1) == std::string::npos);
+    }
+
+    SUBSECTION(DeferredContinue)
+    {
+        // 100 (Continue) is sent once the request passes the pre-body advice,
+        // the form parameters of the body are seen by the handler
+        RawConnection conn(loopThread.getLoop(), addr);
+        REQUIRE(conn.waitConnected());
+        conn.send(echoRequest(3, "Expect: 100-continue\r\n"));
+        CHECK(conn.waitFor("\r\n\r\n"));
+        CHECK(conn.received() == "HTTP/1.1 100 Continue\r\n\r\n");
+        conn.send("a=1");
+        CHECK(conn.waitFor("a=1;a=1"));
+        CHECK(conn.received().find("HTTP/1.1 200 OK\r\n") ==
+              sizeof("HTTP/1.1 100 Continue\r\n\r\n") - 1);
+    }
+
+    SUBSECTION(BodyWithHeaders)
+    {
+        // The body received with the headers waits in the buffer until the
+        // request passes the advice, then the connection goes on as usual
+        RawConnection conn(loopThread.getLoop(), addr);
+        REQUIRE(conn.waitConnected());
+        conn.send(echoRequest(3, "") + "a=2" + echoRequest(3, "") + "a=3");
+        CHECK(conn.waitFor("a=3;a=3"));
+        auto received = conn.received();
+        CHECK(received.rfind("HTTP/1.1 200 OK\r\n", 0) == 0UL);
+        CHECK(received.find("a=2;a=2") < received.find("a=3;a=3"));
+        CHECK(received.find("100 Continue") == std::string::npos);
+    }
+}
@@ -589,6 +589,34 @@ void doTest(const HttpClientPtr &client, std::shared_ptr<test::Case> TEST_CTX)
                                             k304NotModified);
                                     // pro.set_value(1);
                                 });
+            // The ETag is matched by If-None-Match
+            auto &etag = resp->getHeader("etag");
+            CHECK(!etag.empty());
+            req = HttpRequest::newHttpRequest();
+            req->setMethod(drogon::Get);
+            req->setPath("/drogon.jpg");
+            req->addHeader("If-None-Match", "\"stale\", " + etag);
+            client->sendRequest(req,
+                                [req, TEST_CTX](ReqResult result,
+                                                const HttpResponsePtr &resp) {
+                                    REQUIRE(result == ReqResult::Ok);
+                                    CHECK(resp->statusCode() ==
+                                          k304NotModified);
+                                });
+            // If-None-Match takes precedence over If-Modified-Since
+            req = HttpRequest::newHttpRequest();
+            req->setMethod(drogon::Get);
+            req->setPath("/drogon.jpg");
+            req->addHeader("If-None-Match", "\"stale\"");
+            req->addHeader("If-Modified-Since", lastModified);
+            client->sendRequest(req,
+                                [req, TEST_CTX](ReqResult result,
+                                                const HttpResponsePtr &resp) {
+                                    REQUIRE(result == ReqResult::Ok);
+                                    CHECK(resp->statusCode() == k200OK);
+                                    CHECK(resp->getBody().length() ==
+                                          JPG_LEN);
+                                });
         });
 
     /// Test file download, It is forbidden to download files from the
@@ -0,0 +1,23 @@
+#include <drogon/HttpController.h>
+#include <drogon/HttpRequest.h>
+
+using namespace drogon;
+
+// The requests with the x-reject-before-body header are rejected by a pre-body
+// advice, see main.cc
+class EarlyRejectionTestCtrl : public HttpController<EarlyRejectionTestCtrl>
+{
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(EarlyRejectionTestCtrl::echo, "/early_rejection/echo", Post);
+    METHOD_LIST_END
+
+    void echo(const HttpRequestPtr &req,
+              std::function<void(const HttpResponsePtr &)> &&callback) const
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody("a=" + req->getParameter("a") + ";" +
+                      std::string(req->body()));
+        callback(resp);
+    }
+};
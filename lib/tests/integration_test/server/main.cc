@@ -305,6 +305,19 @@ int main()
                   << local.toIpPort();
         return true;
     });
+    app().registerPreBodyAdvice([](const drogon::HttpRequestPtr &req,
+                                   drogon::AdviceCallback &&acb,
+                                   drogon::AdviceChainCallback &&accb) {
+        // Used by EarlyRejectionTest
+        if (!req->getHeader("x-reject-before-body").empty())
+        {
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k401Unauthorized);
+            acb(resp);
+            return;
+        }
+        accb();
+    });
     app().registerPreRoutingAdvice([](const drogon::HttpRequestPtr &req,
                                       drogon::AdviceCallback &&acb,
                                       drogon::AdviceChainCallback &&accb) {
@@ -0,0 +1,32 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/monitoring/AllocatorCollector.h>
+#include <memory>
+#include <string>
+
+using namespace drogon::monitoring;
+
+DROGON_TEST(AllocatorCollectorTest)
+{
+    auto stats = AllocatorCollector::stats();
+    CHECK((stats.allocator == "system" || stats.allocator == "mimalloc" ||
+           stats.allocator == "jemalloc"));
+
+    auto collector = std::make_shared<AllocatorCollector>();
+    CHECK(collector->name() == "drogon_allocator_bytes");
+    auto groups = collector->collect();
+    REQUIRE(groups.size() == 1);
+    REQUIRE(groups[0].samples.size() == 4);
+    for (auto &sample : groups[0].samples)
+    {
+        CHECK(sample.name == "drogon_allocator_bytes");
+        REQUIRE(sample.exLabels.size() == 2);
+        CHECK(sample.exLabels[0].second == stats.allocator);
+    }
+    CHECK(groups[0].samples[0].exLabels[1].second == "resident");
+
+    auto requests = std::make_shared<RequestAllocationCollector>();
+    if (!RequestAllocationCollector::enabled())
+    {
+        CHECK(requests->collect()[0].samples.empty());
+    }
+}
@@ -0,0 +1,83 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpResponse.h>
+#include "../../lib/src/HttpResponseImpl.h"
+#include "../../lib/src/HttpUtils.h"
+#include "../../lib/src/XxHash64.h"
+#include <cstdio>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(XxHash64)
+{
+    CHECK(XxHash64::hash("", 0) == 0xef46db3751d8e999ULL);
+    CHECK(XxHash64::hash("a", 1) == 0xd24ec4f1a98c6e5bULL);
+    CHECK(XxHash64::hash("abc", 3) == 0x44bc2cf5ad770999ULL);
+
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+    {
+        data.append(std::to_string(i));
+    }
+    XxHash64 hasher;
+    for (size_t i = 0; i < data.size(); i += 7)
+    {
+        hasher.update(data.data() + i, std::min<size_t>(7, data.size() - i));
+    }
+    CHECK(hasher.digest() == XxHash64::hash(data.data(), data.size()));
+}
+
+DROGON_TEST(IfNoneMatch)
+{
+    CHECK(ifNoneMatchMatches("\"abc\"", "\"abc\""));
+    CHECK(ifNoneMatchMatches("\"x\", \"abc\"", "\"abc\""));
+    CHECK(ifNoneMatchMatches("W/\"abc\"", "\"abc\""));
+    CHECK(ifNoneMatchMatches("*", "\"abc\""));
+    CHECK(!ifNoneMatchMatches("\"abcd\"", "\"abc\""));
+    CHECK(!ifNoneMatchMatches("\"x\",,", "\"abc\""));
+}
+
+DROGON_TEST(AutoETag)
+{
+    Json::Value json;
+    json["name"] = "drogon";
+    json["list"].append(1);
+    json["list"].append(2);
+    auto resp = std::dynamic_pointer_cast<HttpResponseImpl>(
+        HttpResponse::newHttpJsonResponse(json));
+    REQUIRE(resp != nullptr);
+    CHECK(resp->makeAutoETag().empty());
+
+    resp->setAutoETag(true);
+    auto etag = resp->makeAutoETag();
+    REQUIRE(etag.size() == 18UL);
+    auto body = std::string{resp->getBody()};
+    char expected[20];
+    snprintf(expected,
+             sizeof(expected),
+             "\"%016llx\"",
+             static_cast<unsigned long long>(
+                 XxHash64::hash(body.data(), body.size())));
+    CHECK(etag == expected);
+    CHECK(resp->makeAutoETag() == etag);
+
+    resp->addCookie("id", "1");
+    resp->addHeader("Cache-Control", "max-age=60");
+    auto notModified = std::dynamic_pointer_cast<HttpResponseImpl>(
+        resp->newNotModifiedResponse());
+    REQUIRE(notModified != nullptr);
+    CHECK(notModified->statusCode() == k304NotModified);
+    CHECK(notModified->getBody().empty());
+    CHECK(notModified->getHeader("cache-control") == "max-age=60");
+    CHECK(notModified->getCookie("id").value() == "1");
+    auto buffer = notModified->renderToBuffer();
+    auto str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("etag: " + etag + "\r\n") != std::string::npos);
+
+    auto other = std::dynamic_pointer_cast<HttpResponseImpl>(
+        HttpResponse::newHttpResponse());
+    REQUIRE(other != nullptr);
+    other->setAutoETag(true);
+    other->addHeader("ETag", "\"v1\"");
+    CHECK(other->makeAutoETag().empty());
+}
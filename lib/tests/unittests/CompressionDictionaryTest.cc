@@ -0,0 +1,74 @@
+#include <drogon/CompressionDictionary.h>
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(CompressionDictionary)
+{
+    CHECK(CompressionDictionary::fromData("") == nullptr);
+    CHECK(CompressionDictionary::encodingOf("dcb") ==
+          CompressionDictionary::Encoding::kBrotli);
+    CHECK(CompressionDictionary::encodingOf("dcz") ==
+          CompressionDictionary::Encoding::kZstd);
+    CHECK(!CompressionDictionary::encodingOf("br").has_value());
+
+    auto abc = CompressionDictionary::fromData("abc", "v1");
+    REQUIRE(abc != nullptr);
+    CHECK(abc->id() == "v1");
+    CHECK(abc->hash().size() == 32);
+    CHECK(abc->availableDictionary() ==
+          ":ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0=:");
+    CHECK(abc->matches(" :ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0=: "));
+    CHECK(!abc->matches(":ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0=:x"));
+
+    std::string dictionaryData;
+    for (int i = 0; i < 50; ++i)
+    {
+        dictionaryData.append(R"({"id":)" + std::to_string(i * 7919) +
+                              R"(,"name":"user)" + std::to_string(i) +
+                              R"(","roles":["reader","writer"],)"
+                              R"("active":true})");
+    }
+    auto dictionary = CompressionDictionary::fromData(dictionaryData);
+    REQUIRE(dictionary != nullptr);
+    std::string body;
+    for (int i = 100; i < 110; ++i)
+    {
+        body.append(R"({"id":)" + std::to_string(i * 7919) +
+                    R"(,"name":"user)" + std::to_string(i) +
+                    R"(","roles":["reader"],"active":false})");
+    }
+
+    for (auto encoding : {CompressionDictionary::Encoding::kBrotli,
+                          CompressionDictionary::Encoding::kZstd})
+    {
+        if (!CompressionDictionary::supports(encoding))
+        {
+            CHECK(dictionary->compress(body.data(), body.size(), encoding)
+                      .empty());
+            continue;
+        }
+        auto compressed =
+            dictionary->compress(body.data(), body.size(), encoding);
+        REQUIRE(!compressed.empty());
+        CHECK(compressed.size() < body.size());
+        // The hash of the dictionary follows the magic number
+        CHECK(compressed.find(dictionary->hash()) ==
+              (encoding == CompressionDictionary::Encoding::kBrotli ? 4u
+                                                                     : 8u));
+        auto decompressed = dictionary->decompress(compressed.data(),
+                                                   compressed.size(),
+                                                   encoding);
+        REQUIRE(decompressed.has_value());
+        CHECK(*decompressed == body);
+        // Another dictionary or a truncated body
+        CHECK(!abc->decompress(compressed.data(), compressed.size(), encoding)
+                   .has_value());
+        CHECK(!dictionary
+                   ->decompress(compressed.data(),
+                                compressed.size() - 2,
+                                encoding)
+                   .has_value());
+    }
+}
@@ -0,0 +1,26 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/CpuAffinity.h"
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(CpuAffinityTest)
+{
+    using Cpus = std::vector<unsigned int>;
+    CHECK(CpuAffinity::parseCpuList("0-3,8") == Cpus({0, 1, 2, 3, 8}));
+    CHECK(CpuAffinity::parseCpuList(" 5, 1-2 ,2") == Cpus({1, 2, 5}));
+    CHECK(CpuAffinity::parseCpuList("").empty());
+    CHECK(CpuAffinity::parseCpuList("3-1").empty());
+    CHECK(CpuAffinity::parseCpuList("a").empty());
+
+    CHECK(CpuAffinity::formatCpuList({8, 0, 1, 2, 3, 10, 11}) ==
+          "0-3,8,10-11");
+    CHECK(CpuAffinity::formatCpuList({}).empty());
+
+    CpuAffinityConfig config;
+    CHECK(CpuAffinity::ioLoopCpus(config, 0).empty());
+    CHECK(CpuAffinity::incomingCpu(config, 0) == -1);
+    config.ioLoopCpus = {4, 6};
+    CHECK(CpuAffinity::ioLoopCpus(config, 3) == Cpus({6}));
+    CHECK(CpuAffinity::incomingCpu(config, 2) == 4);
+}
@@ -0,0 +1,38 @@
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "../../lib/src/HttpRequestImpl.h"
+
+using namespace drogon;
+
+DROGON_TEST(DeferredBodyParameters)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    auto req = std::make_shared<HttpRequestImpl>(loop);
+
+    // The parameters are parsed by the router before the body is received,
+    // the form parameters of the body are seen once it is
+    std::promise<std::string> before;
+    std::promise<std::string> after;
+    loop->runInLoop([req, &before, &after]() {
+        req->setMethod(Post);
+        req->addHeader("content-type", "application/x-www-form-urlencoded");
+        req->setQuery("q=1");
+        req->streamStart();
+        req->deferBody(false);
+        before.set_value(req->getParameter("a") + req->getParameter("q"));
+        req->waitForStreamFinish([req, &after]() {
+            req->quitStreamMode();
+            after.set_value(req->getParameter("a") + req->getParameter("q"));
+        });
+        req->appendToBody("a=2", 3);
+        req->streamFinish();
+    });
+    CHECK(before.get_future().get() == "1");
+    CHECK(after.get_future().get() == "21");
+}
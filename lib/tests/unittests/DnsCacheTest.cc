@@ -0,0 +1,148 @@
+#include "../../lib/src/DnsCache.h"
+#include <drogon/drogon_test.h>
+#include <chrono>
+#include <map>
+#include <thread>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace
+{
+// A resolver which answers from a table and counts the queries, the
+// callbacks are held until flush() to simulate slow queries.
+struct StubResolver
+{
+    std::map<std::string, std::vector<trantor::InetAddress>> table;
+    std::vector<std::pair<std::string, DnsCache::AddressesCallback>> queries;
+    size_t count{0};
+
+    DnsCache::ResolveFunction function()
+    {
+        return [this](const std::string &hostname,
+                      DnsCache::AddressesCallback &&callback) {
+            ++count;
+            queries.emplace_back(hostname, std::move(callback));
+        };
+    }
+
+    void flush()
+    {
+        auto pending = std::move(queries);
+        for (auto &query : pending)
+        {
+            query.second(table[query.first]);
+        }
+    }
+};
+
+std::vector<trantor::InetAddress> lookup(DnsCache &cache,
+                                         StubResolver &resolver,
+                                         const std::string &hostname)
+{
+    std::vector<trantor::InetAddress> result;
+    cache.resolve(hostname,
+                  resolver.function(),
+                  [&result](const std::vector<trantor::InetAddress> &addrs) {
+                      result = addrs;
+                  });
+    resolver.flush();
+    return result;
+}
+}  // namespace
+
+DROGON_TEST(DnsCacheTest)
+{
+    StubResolver resolver;
+    resolver.table["a.test"] = {trantor::InetAddress("10.0.0.1", 0),
+                                trantor::InetAddress("10.0.0.2", 0)};
+    resolver.table["b.test"] = {};
+
+    SUBSECTION(HitAndRotation)
+    {
+        DnsCache cache;
+        resolver.count = 0;
+        auto addrs = lookup(cache, resolver, "a.test");
+        MANDATE(addrs.size() == 2UL);
+        CHECK(addrs[0].toIp() == "10.0.0.1");
+        CHECK(resolver.count == 1UL);
+
+        // Every hit starts with the next address
+        addrs = lookup(cache, resolver, "a.test");
+        MANDATE(addrs.size() == 2UL);
+        CHECK(addrs[0].toIp() == "10.0.0.2");
+        CHECK(addrs[1].toIp() == "10.0.0.1");
+        addrs = lookup(cache, resolver, "a.test");
+        MANDATE(addrs.size() == 2UL);
+        CHECK(addrs[0].toIp() == "10.0.0.1");
+        CHECK(resolver.count == 1UL);
+
+        auto stats = cache.stats();
+        CHECK(stats.hits == 2UL);
+        CHECK(stats.misses == 1UL);
+        CHECK(stats.entries == 1UL);
+    }
+
+    SUBSECTION(NegativeCache)
+    {
+        DnsCache cache;
+        resolver.count = 0;
+        CHECK(lookup(cache, resolver, "b.test").empty());
+        CHECK(lookup(cache, resolver, "b.test").empty());
+        CHECK(resolver.count == 1UL);
+        CHECK(cache.stats().negativeHits == 1UL);
+    }
+
+    SUBSECTION(Expiry)
+    {
+        DnsCache cache;
+        resolver.count = 0;
+        cache.setTtl(0.05, 0.05);
+        lookup(cache, resolver, "a.test");
+        lookup(cache, resolver, "b.test");
+        std::this_thread::sleep_for(100ms);
+        lookup(cache, resolver, "a.test");
+        lookup(cache, resolver, "b.test");
+        CHECK(resolver.count == 4UL);
+        CHECK(cache.stats().misses == 4UL);
+    }
+
+    SUBSECTION(MergeQueries)
+    {
+        DnsCache cache;
+        resolver.count = 0;
+        size_t answers = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            cache.resolve("a.test",
+                          resolver.function(),
+                          [&answers](const std::vector<trantor::InetAddress>
+                                         &addrs) {
+                              if (addrs.size() == 2)
+                                  ++answers;
+                          });
+        }
+        CHECK(resolver.count == 1UL);
+        CHECK(answers == 0UL);
+        resolver.flush();
+        CHECK(answers == 3UL);
+    }
+}
+
+DROGON_TEST(DnsCacheSortTest)
+{
+    std::vector<trantor::InetAddress> addrs{
+        trantor::InetAddress("::1", 0, true),
+        trantor::InetAddress("::2", 0, true),
+        trantor::InetAddress("::3", 0, true),
+        trantor::InetAddress("10.0.0.1", 0),
+        trantor::InetAddress("10.0.0.2", 0)};
+    auto sorted = DnsCache::sortAddresses(addrs);
+    MANDATE(sorted.size() == 5UL);
+    CHECK(sorted[0].toIp() == "::1");
+    CHECK(sorted[1].toIp() == "10.0.0.1");
+    CHECK(sorted[2].toIp() == "::2");
+    CHECK(sorted[3].toIp() == "10.0.0.2");
+    CHECK(sorted[4].toIp() == "::3");
+    CHECK(DnsCache::sortAddresses({}).empty());
+}
@@ -0,0 +1,106 @@
+#include "../../lib/src/FileMetadataCache.h"
+#include <drogon/drogon_test.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+StaticFileCacheStats statsOf(const FileMetadataCache &cache)
+{
+    StaticFileCacheStats stats;
+    cache.addStats(stats);
+    return stats;
+}
+
+void writeFile(const std::filesystem::path &path, const std::string &content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+}  // namespace
+
+DROGON_TEST(FileMetadataCacheTest)
+{
+    auto dir =
+        std::filesystem::temp_directory_path() / "drogon_file_metadata_test";
+    std::filesystem::remove_all(dir);
+    REQUIRE(std::filesystem::create_directories(dir));
+    auto filePath = (dir / "a.txt").string();
+    auto now = trantor::Date::now();
+
+    SUBSECTION(Ttl)
+    {
+        // The metadata is kept until it expires, even if the file changed
+        FileMetadataCache cache;
+        writeFile(filePath, "hello");
+        auto metadata = cache.get(filePath, 1.0, now);
+        CHECK(metadata.type == FileMetadata::kRegular);
+        CHECK(metadata.size == 5UL);
+        CHECK(!metadata.lastModified.empty());
+        CHECK(metadata.etag.front() == '"');
+        CHECK(metadata.etag.find("-5\"") != std::string::npos);
+
+        writeFile(filePath, "hello world");
+        CHECK(cache.get(filePath, 1.0, now.after(0.5)).size == 5UL);
+        CHECK(cache.get(filePath, 1.0, now.after(1.5)).size == 11UL);
+        CHECK(cache.get(filePath, 1.0, now.after(1.5)).etag.find("-b\"") !=
+              std::string::npos);
+        auto stats = statsOf(cache);
+        CHECK(stats.hits == 2UL);
+        CHECK(stats.misses == 2UL);
+        CHECK(stats.notFoundHits == 0UL);
+        CHECK(stats.entries == 1UL);
+    }
+
+    SUBSECTION(NotFound)
+    {
+        // Missing paths are cached too
+        FileMetadataCache cache;
+        auto missing = (dir / "missing.txt").string();
+        CHECK(cache.get(missing, 1.0, now).type == FileMetadata::kNotFound);
+        writeFile(missing, "x");
+        CHECK(cache.get(missing, 1.0, now.after(0.5)).type ==
+              FileMetadata::kNotFound);
+        CHECK(cache.get(missing, 1.0, now.after(1.5)).type ==
+              FileMetadata::kRegular);
+        CHECK(cache.get(dir.string(), 1.0, now).type ==
+              FileMetadata::kDirectory);
+        auto stats = statsOf(cache);
+        CHECK(stats.hits == 1UL);
+        CHECK(stats.notFoundHits == 1UL);
+        CHECK(stats.misses == 3UL);
+    }
+
+    SUBSECTION(MaxEntries)
+    {
+        // When the cache is full, the expired entries are purged first
+        FileMetadataCache cache;
+        writeFile(filePath, "hello");
+        auto missing = (dir / "missing").string();
+        for (size_t i = 0; i + 1 < FileMetadataCache::maxEntries; ++i)
+        {
+            cache.get(missing + std::to_string(i), 1.0, now);
+        }
+        cache.get(filePath, 1.0, now.after(1.5));
+        CHECK(statsOf(cache).entries == FileMetadataCache::maxEntries);
+        cache.get(missing, 1.0, now.after(2.0));
+        CHECK(statsOf(cache).entries == 2UL);
+        CHECK(cache.get(filePath, 1.0, now.after(2.0)).type ==
+              FileMetadata::kRegular);
+        CHECK(statsOf(cache).hits == 1UL);
+
+        // and all of them if none expired
+        size_t i = 0;
+        while (statsOf(cache).entries < FileMetadataCache::maxEntries)
+        {
+            cache.get(missing + std::to_string(i++), 1.0, now.after(2.0));
+        }
+        cache.get(missing + "-last", 1.0, now.after(2.0));
+        CHECK(statsOf(cache).entries == 1UL);
+    }
+
+    std::filesystem::remove_all(dir);
+}
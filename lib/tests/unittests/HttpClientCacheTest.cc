@@ -0,0 +1,408 @@
+#include "../../lib/src/HttpClientCache.h"
+#include <drogon/drogon_test.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <filesystem>
+#include <map>
+
+using namespace drogon;
+
+namespace
+{
+// An upstream which answers with the responses set by the test, the callbacks
+// are held until flush() to simulate requests on the fly.
+struct StubUpstream
+{
+    std::vector<std::pair<HttpRequestPtr, HttpReqCallback>> requests;
+    std::function<HttpResponsePtr(const HttpRequestPtr &)> handler;
+    size_t count{0};
+
+    HttpClientCache::UpstreamFunction function()
+    {
+        return [this](const HttpRequestPtr &req, HttpReqCallback &&callback) {
+            ++count;
+            requests.emplace_back(req, std::move(callback));
+        };
+    }
+
+    void flush()
+    {
+        auto pending = std::move(requests);
+        for (auto &request : pending)
+        {
+            request.second(ReqResult::Ok, handler(request.first));
+        }
+    }
+};
+
+HttpResponsePtr makeResponse(const std::string &body,
+                             const std::string &cacheControl)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody(body);
+    if (!cacheControl.empty())
+        resp->addHeader("cache-control", cacheControl);
+    return resp;
+}
+
+HttpRequestPtr makeRequest(const std::string &path)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath(path);
+    return req;
+}
+
+std::string get(HttpClientCache &cache,
+                StubUpstream &upstream,
+                const HttpRequestPtr &req)
+{
+    std::string body;
+    cache.sendRequest(req,
+                      [&body](ReqResult result, const HttpResponsePtr &resp) {
+                          if (result == ReqResult::Ok && resp)
+                              body = std::string(resp->body());
+                      });
+    upstream.flush();
+    return body;
+}
+}  // namespace
+
+DROGON_TEST(CacheControlTest)
+{
+    auto cc = CacheControl::parse(
+        "public, Max-Age=60, stale-while-revalidate=\"30\", no-cache");
+    CHECK(cc.maxAge == 60);
+    CHECK(cc.staleWhileRevalidate == 30);
+    CHECK(cc.noCache == true);
+    CHECK(cc.noStore == false);
+    CHECK(cc.staleIfError == -1);
+
+    cc = CacheControl::parse("no-store,max-stale");
+    CHECK(cc.noStore == true);
+    CHECK(cc.maxStale > 0);
+    CHECK(CacheControl::parse("max-age=abc").maxAge == -1);
+    CHECK(CacheControl::parse("").maxAge == -1);
+}
+
+DROGON_TEST(HttpClientCacheTest)
+{
+    SUBSECTION(FreshHit)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &) {
+            return makeResponse("fresh", "max-age=60");
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        CHECK(get(*cache, upstream, makeRequest("/a")) == "fresh");
+        CHECK(get(*cache, upstream, makeRequest("/a")) == "fresh");
+        CHECK(upstream.count == 1UL);
+        CHECK(cache->stats().hits == 1UL);
+        CHECK(cache->stats().misses == 1UL);
+
+        // Different parameters are different resources
+        auto req = makeRequest("/a");
+        req->setParameter("k", "v");
+        CHECK(get(*cache, upstream, req) == "fresh");
+        CHECK(upstream.count == 2UL);
+
+        // no-cache in the request forces a request to the server
+        req = makeRequest("/a");
+        req->addHeader("cache-control", "no-cache");
+        get(*cache, upstream, req);
+        CHECK(upstream.count == 3UL);
+
+        // Unsafe methods invalidate the stored responses
+        req = makeRequest("/a");
+        req->setMethod(Post);
+        get(*cache, upstream, req);
+        CHECK(upstream.count == 4UL);
+        get(*cache, upstream, makeRequest("/a"));
+        CHECK(upstream.count == 5UL);
+    }
+
+    SUBSECTION(NotStored)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &req) {
+            if (req->path() == "/vary-all")
+            {
+                auto resp = makeResponse("vary", "max-age=60");
+                resp->addHeader("vary", "*");
+                return resp;
+            }
+            if (req->path() == "/no-validator")
+                return makeResponse("none", "");
+            return makeResponse("no-store", "no-store, max-age=60");
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        for (auto path : {"/no-store", "/vary-all", "/no-validator"})
+        {
+            get(*cache, upstream, makeRequest(path));
+            get(*cache, upstream, makeRequest(path));
+        }
+        CHECK(upstream.count == 6UL);
+        CHECK(cache->memorySize() == 0UL);
+    }
+
+    SUBSECTION(Authorization)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &req) {
+            auto &user = req->getHeader("authorization");
+            if (req->path() == "/public")
+                return makeResponse("public", "public, max-age=60");
+            if (req->path() == "/shared")
+                return makeResponse("shared", "max-age=60, s-maxage=60");
+            return makeResponse(user, "max-age=60");
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        auto authorized = [](const std::string &path, const std::string &user) {
+            auto req = makeRequest(path);
+            req->addHeader("authorization", user);
+            return req;
+        };
+        // The response of one user isn't served to another one
+        CHECK(get(*cache, upstream, authorized("/private", "alice")) ==
+              "alice");
+        CHECK(get(*cache, upstream, authorized("/private", "bob")) == "bob");
+        CHECK(get(*cache, upstream, makeRequest("/private")).empty());
+        CHECK(upstream.count == 3UL);
+        CHECK(cache->memorySize() > 0UL);
+
+        // Unless the server allows it
+        CHECK(get(*cache, upstream, authorized("/public", "alice")) ==
+              "public");
+        CHECK(get(*cache, upstream, authorized("/public", "bob")) == "public");
+        CHECK(get(*cache, upstream, authorized("/shared", "alice")) ==
+              "shared");
+        CHECK(get(*cache, upstream, makeRequest("/shared")) == "shared");
+        CHECK(upstream.count == 5UL);
+
+        // Concurrent requests of different users aren't merged
+        std::vector<std::string> bodies;
+        for (auto user : {"alice", "bob", "bob"})
+        {
+            cache->sendRequest(
+                authorized("/concurrent", user),
+                [&bodies](ReqResult, const HttpResponsePtr &resp) {
+                    bodies.emplace_back(resp->body());
+                });
+        }
+        CHECK(upstream.count == 7UL);
+        upstream.flush();
+        CHECK((bodies == std::vector<std::string>{"alice", "bob", "bob"}));
+    }
+
+    SUBSECTION(Invalidation)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &req) {
+            if (req->method() == Get)
+                return makeResponse("stored", "max-age=60");
+            auto resp = makeResponse("", "");
+            resp->setStatusCode(k201Created);
+            resp->addHeader("location", "http://localhost/items/2#new");
+            resp->addHeader("content-location", "/items?page=1");
+            return resp;
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        auto withParam = makeRequest("/items");
+        withParam->setParameter("k", "v");
+        auto query = makeRequest("/items?page=1");
+        for (auto &req : {makeRequest("/items"),
+                          withParam,
+                          query,
+                          makeRequest("/items/2"),
+                          makeRequest("/items/3")})
+        {
+            get(*cache, upstream, req);
+        }
+        CHECK(upstream.count == 5UL);
+
+        // A form POST invalidates the target URI without the form
+        auto post = makeRequest("/items");
+        post->setMethod(Post);
+        post->setParameter("name", "value");
+        get(*cache, upstream, post);
+        CHECK(upstream.count == 6UL);
+        for (auto &req : {makeRequest("/items"),
+                          withParam,
+                          query,
+                          makeRequest("/items/2"),
+                          makeRequest("/items/3")})
+        {
+            get(*cache, upstream, req);
+        }
+        // Only /items/3 is still stored
+        CHECK(upstream.count == 10UL);
+    }
+
+    SUBSECTION(Revalidation)
+    {
+        StubUpstream upstream;
+        std::string ifNoneMatch;
+        upstream.handler = [&ifNoneMatch](const HttpRequestPtr &req) {
+            ifNoneMatch = req->getHeader("if-none-match");
+            if (ifNoneMatch == "\"v1\"")
+            {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setStatusCode(k304NotModified);
+                resp->addHeader("x-revalidated", "yes");
+                return resp;
+            }
+            auto resp = makeResponse("etag body", "max-age=0");
+            resp->addHeader("etag", "\"v1\"");
+            return resp;
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        auto req = makeRequest("/etag");
+        CHECK(get(*cache, upstream, req) == "etag body");
+        CHECK(ifNoneMatch.empty());
+
+        HttpResponsePtr response;
+        cache->sendRequest(req,
+                           [&response](ReqResult, const HttpResponsePtr &resp) {
+                               response = resp;
+                           });
+        upstream.flush();
+        CHECK(ifNoneMatch == "\"v1\"");
+        MANDATE(response != nullptr);
+        CHECK(response->statusCode() == k200OK);
+        CHECK(response->body() == "etag body");
+        CHECK(response->getHeader("x-revalidated") == "yes");
+        // The validators are added to a copy of the request of the user
+        CHECK(req->getHeader("if-none-match").empty());
+        CHECK(cache->stats().revalidations == 1UL);
+        CHECK(cache->stats().notModified == 1UL);
+    }
+
+    SUBSECTION(Vary)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &req) {
+            auto resp =
+                makeResponse(req->getHeader("accept-language"), "max-age=60");
+            resp->addHeader("vary", "Accept-Language");
+            return resp;
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        auto en = makeRequest("/vary");
+        en->addHeader("accept-language", "en");
+        auto fr = makeRequest("/vary");
+        fr->addHeader("accept-language", "fr");
+        CHECK(get(*cache, upstream, en) == "en");
+        CHECK(get(*cache, upstream, fr) == "fr");
+        CHECK(get(*cache, upstream, en) == "en");
+        CHECK(get(*cache, upstream, fr) == "fr");
+        CHECK(upstream.count == 2UL);
+    }
+
+    SUBSECTION(Coalescing)
+    {
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &) {
+            return makeResponse("shared", "max-age=60");
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        size_t answers = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            cache->sendRequest(makeRequest("/jwks"),
+                               [&answers](ReqResult result,
+                                          const HttpResponsePtr &resp) {
+                                   if (result == ReqResult::Ok &&
+                                       resp->body() == "shared")
+                                       ++answers;
+                               });
+        }
+        CHECK(upstream.count == 1UL);
+        CHECK(answers == 0UL);
+        upstream.flush();
+        CHECK(answers == 3UL);
+        CHECK(cache->stats().coalesced == 2UL);
+    }
+
+    SUBSECTION(StaleWhileRevalidate)
+    {
+        StubUpstream upstream;
+        int version = 0;
+        upstream.handler = [&version](const HttpRequestPtr &) {
+            auto resp = makeResponse(std::to_string(++version),
+                                     "max-age=0, stale-while-revalidate=60");
+            resp->addHeader("etag", "\"" + std::to_string(version) + "\"");
+            return resp;
+        };
+        auto cache = std::make_shared<HttpClientCache>(HttpClientCacheConfig(),
+                                                       upstream.function());
+        CHECK(get(*cache, upstream, makeRequest("/swr")) == "1");
+
+        // The stale response is served at once and refreshed in background
+        std::string body;
+        auto req = makeRequest("/swr");
+        cache->sendRequest(req,
+                           [&body](ReqResult, const HttpResponsePtr &resp) {
+                               body = std::string(resp->body());
+                           });
+        CHECK(body == "1");
+        CHECK(upstream.count == 2UL);
+        // The revalidation doesn't change the request of the user
+        MANDATE(upstream.requests.size() == 1UL);
+        CHECK(upstream.requests[0].first != req);
+        CHECK(upstream.requests[0].first->getHeader("if-none-match") ==
+              "\"1\"");
+        CHECK(req->getHeader("if-none-match").empty());
+        upstream.flush();
+        CHECK(get(*cache, upstream, makeRequest("/swr")) == "2");
+        CHECK(cache->stats().staleHits == 2UL);
+    }
+
+    SUBSECTION(MemoryBudgetAndDisk)
+    {
+        auto dir = std::filesystem::temp_directory_path() /
+                   "drogon_http_client_cache_test";
+        StubUpstream upstream;
+        upstream.handler = [](const HttpRequestPtr &req) {
+            auto resp = makeResponse(req->path() + std::string(1000, 'x'),
+                                     "max-age=60");
+            Cookie cookie("session", "abc");
+            cookie.setPath("/");
+            resp->addCookie(cookie);
+            return resp;
+        };
+        HttpClientCacheConfig config;
+        config.maxMemorySize = 2500;
+        config.diskPath = dir.string();
+        auto cache =
+            std::make_shared<HttpClientCache>(config, upstream.function());
+        for (auto path : {"/1", "/2", "/3", "/4"})
+        {
+            get(*cache, upstream, makeRequest(path));
+        }
+        CHECK(cache->memorySize() <= config.maxMemorySize);
+        CHECK(cache->stats().evictions == 2UL);
+        CHECK(upstream.count == 4UL);
+
+        // The evicted responses are read back from the disk
+        HttpResponsePtr response;
+        cache->sendRequest(makeRequest("/1"),
+                           [&response](ReqResult, const HttpResponsePtr &resp) {
+                               response = resp;
+                           });
+        MANDATE(response != nullptr);
+        auto body = std::string(response->body());
+        CHECK(body.size() == 1002UL);
+        CHECK(body.compare(0, 2, "/1") == 0);
+        CHECK(response->getCookie("session").value() == "abc");
+        CHECK(response->getCookie("session").path() == "/");
+        CHECK(upstream.count == 4UL);
+        cache.reset();
+        std::filesystem::remove_all(dir);
+    }
+}
@@ -66,3 +66,46 @@ DROGON_TEST(ResquestSetCustomContentTypeString)
     req->setContentTypeString("thisdoesnotexist/unknown");
     CHECK(req->getContentType() == CT_CUSTOM);
 }
+
+DROGON_TEST(ResponseStatusLine)
+{
+    CHECK(statusLine(Version::kHttp11, 200) == "HTTP/1.1 200 OK\r\n");
+    CHECK(statusLine(Version::kHttp10, 404) == "HTTP/1.0 404 Not Found\r\n");
+    CHECK(statusLine(Version::kHttp11, 99).empty());
+
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setCustomStatusCode(299, "Custom Status");
+    auto buffer = static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer();
+    auto str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("HTTP/1.1 299 Custom Status\r\n") == 0);
+}
+
+DROGON_TEST(ResponseHeaderTemplate)
+{
+    ResponseHeaderTemplate tmpl;
+    tmpl.loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    auto render = [&tmpl](const std::string &value, const std::string &body) {
+        auto resp = std::dynamic_pointer_cast<HttpResponseImpl>(
+            HttpResponse::newHttpResponse());
+        resp->addHeader("x-value", value);
+        resp->setBody(body);
+        resp->setHeaderTemplate(&tmpl);
+        auto buffer = resp->renderToBuffer();
+        return std::string{buffer->peek(), buffer->readableBytes()};
+    };
+
+    auto str = render("a", "hello");
+    CHECK(str.find("HTTP/1.1 200 OK\r\n") == 0);
+    CHECK(str.find("x-value: a\r\n") != std::string::npos);
+    CHECK(str.find("content-length: 5\r\n") != std::string::npos);
+
+    // Same headers, the template is reused with the new content-length
+    str = render("a", "hello world");
+    CHECK(str.find("x-value: a\r\n") != std::string::npos);
+    CHECK(str.find("content-length: 11\r\n") != std::string::npos);
+
+    // Different headers, the template is rendered again
+    str = render("b", "hello");
+    CHECK(str.find("x-value: b\r\n") != std::string::npos);
+    CHECK(str.find("x-value: a\r\n") == std::string::npos);
+}
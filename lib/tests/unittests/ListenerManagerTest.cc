@@ -0,0 +1,209 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/net/TcpServer.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "../../lib/src/ListenerManager.h"
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+#ifndef _WIN32
+namespace
+{
+// A loopback server counting its connections in a limit, as HttpServer does
+class LimitedServer
+{
+  public:
+    LimitedServer()
+        : server_(loopThread_.getLoop(),
+                  trantor::InetAddress("127.0.0.1", 0),
+                  "ListenerManagerTest")
+    {
+        loopThread_.run();
+        server_.setRecvMessageCallback(
+            [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buf) {
+                buf->retrieveAll();
+            });
+        server_.setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (conn->connected())
+                {
+                    // The context tells releaseConnection() the connection
+                    // was counted
+                    conn->setContext(
+                        std::make_shared<HttpConnectionLimit *>(limit_));
+                    added_.push_back(limit_->tryAddConnection(conn));
+                }
+                else if (conn->disconnected())
+                {
+                    auto limit = conn->getContext<HttpConnectionLimit *>();
+                    (*limit)->releaseConnection(conn);
+                    ++released_;
+                }
+                cond_.notify_all();
+            });
+        server_.start();
+        std::promise<void> started;
+        loopThread_.getLoop()->queueInLoop(
+            [&started]() { started.set_value(); });
+        started.get_future().wait();
+    }
+
+    ~LimitedServer()
+    {
+        for (auto fd : fds_)
+        {
+            ::close(fd);
+        }
+        server_.stop();
+    }
+
+    // Return true if the limit accepted the new connection
+    bool connect(HttpConnectionLimit &limit)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        limit_ = &limit;
+        auto count = added_.size();
+        lock.unlock();
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server_.address().toPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+        fds_.push_back(fd);
+        lock.lock();
+        cond_.wait_for(lock, 5s, [this, count]() {
+            return added_.size() > count;
+        });
+        return added_.size() > count && added_.back();
+    }
+
+    // Close the connections and wait until their limits released them
+    void closeAll()
+    {
+        for (auto fd : fds_)
+        {
+            ::close(fd);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto count = fds_.size();
+        fds_.clear();
+        cond_.wait_for(lock, 5s, [this, count]() {
+            return released_ >= count;
+        });
+    }
+
+  private:
+    trantor::EventLoopThread loopThread_;
+    trantor::TcpServer server_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    HttpConnectionLimit *limit_{nullptr};
+    std::vector<bool> added_;
+    size_t released_{0};
+    std::vector<int> fds_;
+};
+}  // namespace
+
+DROGON_TEST(ListenerThreadGroupTest)
+{
+    trantor::EventLoopThreadPool pool(6, "ListenerManagerTest");
+    pool.start();
+    auto loops = pool.getLoops();
+    REQUIRE(loops.size() == 6UL);
+
+    ListenerManager manager;
+    manager.addListener("127.0.0.1", 8001);
+    manager.addListener("::1", 8002);
+    manager.addListener("127.0.0.1", 8003);
+    manager.setThreadGroup("::1", 8002, 2, 10);
+    manager.setThreadGroup("127.0.0.1", 8003, 1, 0);
+    manager.createThreadGroups(loops);
+    auto &globalLimit = HttpConnectionLimit::instance();
+
+    SUBSECTION(Carving)
+    {
+        // The groups take their loops from the end, in the order of the
+        // listeners, the other listeners share the first loops
+        auto shared = manager.getIoLoops("127.0.0.1", 8001);
+        REQUIRE(shared.size() == 3UL);
+        CHECK(shared[0] == loops[0]);
+        CHECK(shared[2] == loops[2]);
+        auto first = manager.getIoLoops("::1", 8002);
+        REQUIRE(first.size() == 2UL);
+        CHECK(first[0] == loops[3]);
+        CHECK(first[1] == loops[4]);
+        auto second = manager.getIoLoops("127.0.0.1", 8003);
+        REQUIRE(second.size() == 1UL);
+        CHECK(second[0] == loops[5]);
+    }
+
+    SUBSECTION(Stats)
+    {
+        // A group without max_connections inherits the global limit
+        auto stats = manager.getThreadGroupStats();
+        REQUIRE(stats.size() == 3UL);
+        CHECK(stats[0].name == "shared");
+        CHECK(stats[0].threads == 3UL);
+        CHECK(stats[0].maxConnections == globalLimit.getMaxConnectionNum());
+        CHECK(stats[1].name == "[::1]:8002");
+        CHECK(stats[1].threads == 2UL);
+        CHECK(stats[1].maxConnections == 10UL);
+        CHECK(stats[2].name == "127.0.0.1:8003");
+        CHECK(stats[2].threads == 1UL);
+        CHECK(stats[2].maxConnections == globalLimit.getMaxConnectionNum());
+        for (auto &groupStats : stats)
+        {
+            CHECK(groupStats.connections == 0UL);
+            CHECK(groupStats.utilization == 0.0);
+            CHECK(groupStats.maxUtilization == 0.0);
+        }
+        CHECK(&manager.getConnectionLimit("127.0.0.1", 8001) == &globalLimit);
+    }
+
+    SUBSECTION(Limits)
+    {
+        // Each group counts its own connections, but an IP is limited once
+        // across the groups
+        auto &first = manager.getConnectionLimit("::1", 8002);
+        auto &second = manager.getConnectionLimit("127.0.0.1", 8003);
+        REQUIRE(&first != &second);
+        globalLimit.setMaxConnectionNumPerIP(1);
+        {
+            LimitedServer server;
+            CHECK(server.connect(first));
+            CHECK(server.connect(second) == false);
+            auto stats = manager.getThreadGroupStats();
+            CHECK(stats[0].connections == 0UL);
+            CHECK(stats[1].connections == 1UL);
+            CHECK(stats[2].connections == 1UL);
+            CHECK(manager.getThreadGroupConnectionNum() == 2UL);
+
+            server.closeAll();
+            CHECK(manager.getThreadGroupConnectionNum() == 0UL);
+            CHECK(server.connect(second));
+            server.closeAll();
+        }
+        globalLimit.setMaxConnectionNumPerIP(0);
+        CHECK(manager.getThreadGroupConnectionNum() == 0UL);
+    }
+}
+#endif
@@ -0,0 +1,127 @@
+#include <drogon/HttpRequest.h>
+#include <drogon/ParameterView.h>
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(ParameterView)
+{
+    std::string query = "?a=1&b=%20x& c=y+z&flag&&d=&a=2";
+    ParameterView view;
+    view.parse(query, false);
+    view.setSources(query, {});
+
+    CHECK(view.get("a") == "2");
+    CHECK(view.get("b") == " x");
+    CHECK(view.get("c") == "y z");
+    CHECK(view.get("flag") == "");
+    CHECK(view.get("d") == "");
+    CHECK(view.contains(""));
+    CHECK(!view.get("e").has_value());
+    // Values without escapes are borrowed
+    auto d = view.get("d");
+    CHECK(d->data() == query.data() + query.find("d=") + 2);
+
+    SUBSECTION(Materialize)
+    {
+        SafeStringMap<std::string> params;
+        view.materialize(params);
+        CHECK(params.size() == 6);
+        CHECK(params["a"] == "2");
+        CHECK(params["b"] == " x");
+        CHECK(params["c"] == "y z");
+        CHECK(params.count("flag") == 1);
+        CHECK(params.count("") == 1);
+    }
+
+    SUBSECTION(EscapedKeys)
+    {
+        std::string body = "first+name=Tao&last%20name=An%2C+%E5%AE%89";
+        ParameterView form;
+        form.parse(body, true);
+        form.setSources({}, body);
+        CHECK(form.get("first name") == "Tao");
+        CHECK(form.get("last name") == "An, \xe5\xae\x89");
+        CHECK(!form.contains("first+name"));
+        // An escaped and a plain key are the same parameter
+        std::string more = "x%61=1&xa=2&x%61=3";
+        ParameterView other;
+        other.parse(more, false);
+        other.setSources(more, {});
+        CHECK(other.get("xa") == "3");
+    }
+
+    SUBSECTION(KeyWithoutValue)
+    {
+        // A key without '=' doesn't replace an earlier value
+        std::string flags = "a=1&a&b&b=2";
+        ParameterView other;
+        other.parse(flags, false);
+        other.setSources(flags, {});
+        CHECK(other.get("a") == "1");
+        CHECK(other.get("b") == "2");
+        SafeStringMap<std::string> params;
+        other.materialize(params);
+        CHECK(params["a"] == "1");
+        CHECK(params["b"] == "2");
+    }
+
+    SUBSECTION(MovedSources)
+    {
+        // The positions stay valid when the query moves
+        auto moved = query;
+        view.setSources(moved, {});
+        CHECK(view.get("a") == "2");
+        CHECK(view.get("c") == "y z");
+        view.setSources(query, {});
+    }
+
+    SUBSECTION(Set)
+    {
+        view.set("a", "3");
+        view.set("e", "4");
+        CHECK(view.get("a") == "3");
+        CHECK(view.get("e") == "4");
+        size_t count = 0;
+        view.forEach([&count](std::string_view, std::string_view) {
+            ++count;
+        });
+        CHECK(count == 9);
+    }
+}
+
+DROGON_TEST(RequestParameters)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setParameter("a", "1");
+    // The returned reference stays valid when the parameter is set again
+    auto &a = req->getParameter("a");
+    CHECK(a == "1");
+    req->setParameter("a", "2");
+    CHECK(a == "2");
+    CHECK(req->getParameter("a") == "2");
+}
+
+DROGON_TEST(RequestParametersAfterSetBody)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setBody("a=1&b=2");
+    CHECK(req->getParameter("a") == "1");
+    auto &b = req->getParameter("b");
+    CHECK(b == "2");
+    req->setParameter("c", "3");
+    // The parameters are parsed again from the new body, a shorter one used
+    // to be read with the positions of the former one
+    req->setBody("b=x");
+    CHECK(b == "x");
+    CHECK(req->getParameter("a") == "");
+    CHECK(req->getParameter("c") == "3");
+    CHECK(req->getParameters().size() == 2UL);
+
+    req->setBody("c=4&d=5");
+    // The parameters set by the user still win
+    CHECK(req->getParameter("c") == "3");
+    CHECK(req->getParameters().size() == 2UL);
+    CHECK(req->getParameters().at("d") == "5");
+}
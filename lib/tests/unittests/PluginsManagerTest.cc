@@ -0,0 +1,173 @@
+#include "../../lib/src/PluginsManager.h"
+#include <drogon/drogon_test.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace plugins_manager_test
+{
+// What the plugins saw when they were initialized
+struct InitLog
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::string> order;
+    std::map<std::string, std::thread::id> threads;
+    // The plugins waiting for each other
+    size_t waiting{0};
+    bool concurrent{false};
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.clear();
+        threads.clear();
+        waiting = 0;
+        concurrent = false;
+    }
+
+    size_t indexOf(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (order[i] == name)
+                return i;
+        }
+        return order.size();
+    }
+};
+
+InitLog initLog;
+
+// The plugins with Rendezvous set wait for each other, which only succeeds
+// when they are initialized in parallel
+template <int N, bool Rendezvous = false>
+class TestPlugin : public Plugin<TestPlugin<N, Rendezvous>>
+{
+  public:
+    void initAndStart(const Json::Value &) override
+    {
+        std::unique_lock<std::mutex> lock(initLog.mutex);
+        if (Rendezvous)
+        {
+            if (++initLog.waiting == 2)
+            {
+                initLog.concurrent = true;
+                initLog.cond.notify_all();
+            }
+            initLog.cond.wait_for(lock, 1s, []() {
+                return initLog.concurrent;
+            });
+            --initLog.waiting;
+        }
+        initLog.order.push_back(this->className());
+        initLog.threads[this->className()] = std::this_thread::get_id();
+    }
+
+    void shutdown() override
+    {
+    }
+};
+
+using Main = TestPlugin<1>;
+using First = TestPlugin<2, true>;
+using Second = TestPlugin<3, true>;
+using AfterFirst = TestPlugin<4>;
+using AfterMain = TestPlugin<5>;
+
+Json::Value pluginConfig(const std::string &name,
+                         bool parallel,
+                         const std::vector<std::string> &dependencies = {})
+{
+    Json::Value config;
+    config["name"] = name;
+    if (parallel)
+        config["parallel_init"] = true;
+    config["dependencies"] = Json::Value(Json::arrayValue);
+    for (auto &dependency : dependencies)
+    {
+        config["dependencies"].append(dependency);
+    }
+    return config;
+}
+
+Json::Value pluginConfigs()
+{
+    Json::Value configs(Json::arrayValue);
+    configs.append(pluginConfig(Main::classTypeName(), false));
+    configs.append(pluginConfig(AfterMain::classTypeName(),
+                                true,
+                                {Main::classTypeName()}));
+    configs.append(pluginConfig(AfterFirst::classTypeName(),
+                                true,
+                                {First::classTypeName()}));
+    configs.append(pluginConfig(First::classTypeName(), true));
+    configs.append(pluginConfig(Second::classTypeName(), true));
+    return configs;
+}
+}  // namespace plugins_manager_test
+
+using namespace plugins_manager_test;
+
+DROGON_TEST(PluginsManagerParallelInit)
+{
+    const auto mainThread = std::this_thread::get_id();
+
+    SUBSECTION(Parallel)
+    {
+        // The opted-in plugins run on the pool after their dependencies, a
+        // plugin depending on a plugin that isn't opted in runs in the main
+        // thread afterwards
+        initLog.clear();
+        std::vector<std::string> callbacks;
+        {
+            PluginsManager manager;
+            manager.initializeAllPlugins(
+                pluginConfigs(),
+                [&callbacks](PluginBase *plugin) {
+                    callbacks.push_back(plugin->className());
+                },
+                4);
+            CHECK(manager.initializationTimes().size() == 5UL);
+        }
+        CHECK(initLog.order.size() == 5UL);
+        CHECK(initLog.concurrent);
+        CHECK(initLog.indexOf(First::classTypeName()) <
+              initLog.indexOf(AfterFirst::classTypeName()));
+        CHECK(initLog.indexOf(Main::classTypeName()) <
+              initLog.indexOf(AfterMain::classTypeName()));
+        CHECK(initLog.threads[Main::classTypeName()] == mainThread);
+        CHECK(initLog.threads[AfterMain::classTypeName()] == mainThread);
+        // The callbacks follow the order of the configs
+        CHECK(callbacks.size() == 5UL);
+        CHECK(callbacks.front() == Main::classTypeName());
+        CHECK(callbacks.back() == Second::classTypeName());
+    }
+
+    SUBSECTION(SingleThread)
+    {
+        // Depth first in the main thread, the rendezvous times out
+        initLog.clear();
+        {
+            PluginsManager manager;
+            manager.initializeAllPlugins(
+                pluginConfigs(), [](PluginBase *) {}, 1);
+        }
+        CHECK(initLog.order.size() == 5UL);
+        CHECK(initLog.concurrent == false);
+        CHECK(initLog.indexOf(First::classTypeName()) <
+              initLog.indexOf(AfterFirst::classTypeName()));
+        for (auto &thread : initLog.threads)
+        {
+            CHECK(thread.second == mainThread);
+        }
+    }
+}
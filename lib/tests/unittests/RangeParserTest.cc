@@ -0,0 +1,65 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/RangeParser.h"
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(RangeParserTest)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=0-19", 1000, ranges) == SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 20);
+
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=-20", 1000, ranges) == SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 980);
+    CHECK(ranges[0].end == 1000);
+
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=500-599, 0-99", 1000, ranges) == MultiPart);
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 100);
+    CHECK(ranges[1].start == 500);
+    CHECK(ranges[1].end == 600);
+
+    // Overlapping and adjacent ranges are coalesced
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=0-99, 50-199, 200-299", 1000, ranges) ==
+          SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 300);
+
+    // So are ranges separated by a small gap
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=0-9, 20-29", 1000, ranges) == SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].end == 30);
+
+    // Repeated ranges don't make the response larger than the file
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=0-, 0-, 0-", 1000, ranges) == SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].end == 1000);
+
+    ranges.clear();
+    CHECK(parseRangeHeader("bytes=1000-", 1000, ranges) == NotSatisfiable);
+
+    ranges.clear();
+    CHECK(parseRangeHeader("items=0-1", 1000, ranges) == InvalidRange);
+
+    // Too many ranges
+    std::string header = "bytes=0-0";
+    for (size_t i = 1; i <= 100; ++i)
+    {
+        header.append(", ").append(std::to_string(i * 100)).append("-");
+        header.append(std::to_string(i * 100));
+    }
+    ranges.clear();
+    CHECK(parseRangeHeader(header, 100000, ranges) == InvalidRange);
+}
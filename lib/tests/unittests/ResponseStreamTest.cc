@@ -0,0 +1,284 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Collects the bytes written by a ResponseStream without a connection
+class StringStream : public trantor::AsyncStream
+{
+  public:
+    explicit StringStream(std::shared_ptr<std::string> out)
+        : out_(std::move(out))
+    {
+    }
+
+    bool send(const char *data, size_t len) override
+    {
+        if (closed_)
+            return false;
+        out_->append(data, len);
+        return true;
+    }
+
+    void close() override
+    {
+        closed_ = true;
+    }
+
+  private:
+    std::shared_ptr<std::string> out_;
+    bool closed_{false};
+};
+
+#ifndef _WIN32
+const size_t kChunkSize = 1024 * 1024;
+const size_t kChunks = 16;
+// "100000\r\n" + the payload + "\r\n"
+const size_t kFramedChunkSize = 8 + kChunkSize + 2;
+
+// A stream of 16MB to a loopback client that doesn't read, so the send
+// buffer of the connection exceeds the high water mark of the stream
+class BlockedStream
+{
+  public:
+    BlockedStream()
+        : server_(loopThread_.getLoop(),
+                  trantor::InetAddress("127.0.0.1", 0),
+                  "ResponseStreamTest")
+    {
+        loopThread_.run();
+        server_.setRecvMessageCallback(
+            [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buf) {
+                buf->retrieveAll();
+            });
+        server_.setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                if (conn->connected())
+                    startStream(conn);
+            });
+        server_.start();
+        // The server listens once the loop has run start()
+        std::promise<void> listening;
+        loopThread_.getLoop()->queueInLoop(
+            [&listening]() { listening.set_value(); });
+        listening.get_future().wait();
+
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int rcvbuf = 4096;
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server_.address().toPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected_ = ::connect(fd_,
+                               reinterpret_cast<struct sockaddr *>(&addr),
+                               sizeof(addr)) == 0;
+    }
+
+    ~BlockedStream()
+    {
+        if (stream_)
+            stream_->close();
+        ::close(fd_);
+        server_.stop();
+    }
+
+    // Wait until the stream is blocked, false on timeout
+    bool waitBlocked()
+    {
+        if (!connected_ || blocked_.wait_for(5s) != std::future_status::ready)
+            return false;
+        stream_ = streamFuture_.get();
+        return true;
+    }
+
+    bool waitDrained()
+    {
+        return drained_.wait_for(5s) == std::future_status::ready;
+    }
+
+    // Read the given number of bytes from the client socket
+    size_t read(size_t length)
+    {
+        std::string buffer(64 * 1024, '\0');
+        size_t received{0};
+        while (received < length)
+        {
+            auto n = ::recv(fd_,
+                            &buffer[0],
+                            (std::min)(buffer.size(), length - received),
+                            0);
+            if (n <= 0)
+                break;
+            received += static_cast<size_t>(n);
+        }
+        return received;
+    }
+
+    const std::shared_ptr<ResponseStream> &stream() const
+    {
+        return stream_;
+    }
+
+    std::atomic<int> highWaterMarks{0};
+    std::atomic<int> drains{0};
+
+  private:
+    void startStream(const trantor::TcpConnectionPtr &conn)
+    {
+        auto stream =
+            std::make_shared<ResponseStream>(conn->sendAsyncStream(), conn);
+        stream->setHighWaterMark(64 * 1024);
+        stream->setHighWaterMarkCallback([this]() {
+            if (++highWaterMarks == 1)
+                blockedPromise_.set_value();
+        });
+        stream->setDrainCallback([this]() {
+            if (++drains == 1)
+                drainedPromise_.set_value();
+        });
+        for (size_t i = 0; i < kChunks; ++i)
+        {
+            stream->send(std::string(kChunkSize, 'x'));
+        }
+        streamPromise_.set_value(std::move(stream));
+    }
+
+    trantor::EventLoopThread loopThread_;
+    trantor::TcpServer server_;
+    int fd_{-1};
+    bool connected_{false};
+    std::promise<std::shared_ptr<ResponseStream>> streamPromise_;
+    std::future<std::shared_ptr<ResponseStream>> streamFuture_{
+        streamPromise_.get_future()};
+    std::promise<void> blockedPromise_;
+    std::future<void> blocked_{blockedPromise_.get_future()};
+    std::promise<void> drainedPromise_;
+    std::future<void> drained_{drainedPromise_.get_future()};
+    std::shared_ptr<ResponseStream> stream_;
+};
+#endif
+}  // namespace
+
+DROGON_TEST(ResponseStreamChunks)
+{
+    auto out = std::make_shared<std::string>();
+    ResponseStream stream(std::make_unique<StringStream>(out));
+    CHECK(stream.send(std::string("hello")));
+    // Empty chunks would end the response
+    CHECK(stream.send(std::string()));
+    auto large = std::make_shared<const std::string>(20000, 'x');
+    CHECK(stream.send(large));
+    stream.close();
+    CHECK(stream.send(std::string("late")) == false);
+    CHECK(stream.writable() == false);
+    CHECK(*out == "5\r\nhello\r\n4e20\r\n" + *large + "\r\n0\r\n\r\n");
+
+    int called{0};
+    stream.whenWritable(
+        [&called](bool writable) { called = writable ? 1 : -1; });
+    CHECK(called == -1);
+}
+
+#ifdef __cpp_impl_coroutine
+DROGON_TEST(ResponseStreamCoroutineLoop)
+{
+    // The stream is always writable, every sendCoro() goes on at once. It
+    // used to resume the coroutine from inside the previous one, a stack
+    // frame per chunk.
+    auto out = std::make_shared<std::string>();
+    ResponseStream stream(std::make_unique<StringStream>(out));
+    const size_t chunks = 200000;
+    auto sent = sync_wait([&stream, chunks]() -> Task<size_t> {
+        size_t n{0};
+        for (; n < chunks; ++n)
+        {
+            if (!co_await stream.sendCoro("x"))
+                break;
+        }
+        co_return n;
+    }());
+    CHECK(sent == chunks);
+    CHECK(out->size() == chunks * 6);
+
+    stream.close();
+    auto result = sync_wait([&stream]() -> Task<bool> {
+        co_return co_await stream.sendCoro("x");
+    }());
+    CHECK(result == false);
+}
+#endif
+
+#ifndef _WIN32
+DROGON_TEST(ResponseStreamBackpressure)
+{
+    BlockedStream blocked;
+    REQUIRE(blocked.waitBlocked());
+    auto &stream = blocked.stream();
+    CHECK(stream->writable() == false);
+
+    std::promise<bool> woken;
+    auto wokenFuture = woken.get_future();
+    stream->whenWritable(
+        [&woken](bool writable) { woken.set_value(writable); });
+    CHECK(wokenFuture.wait_for(100ms) == std::future_status::timeout);
+
+    // Reading everything drains the send buffer
+    CHECK(blocked.read(kChunks * kFramedChunkSize) ==
+          kChunks * kFramedChunkSize);
+    REQUIRE(blocked.waitDrained());
+    REQUIRE(wokenFuture.wait_for(5s) == std::future_status::ready);
+    CHECK(wokenFuture.get() == true);
+    CHECK(stream->writable());
+    CHECK(blocked.highWaterMarks == 1);
+    CHECK(blocked.drains == 1);
+}
+
+DROGON_TEST(ResponseStreamCloseWakesWaiters)
+{
+    BlockedStream blocked;
+    REQUIRE(blocked.waitBlocked());
+    auto &stream = blocked.stream();
+
+    std::promise<bool> woken;
+    auto wokenFuture = woken.get_future();
+    stream->whenWritable(
+        [&woken](bool writable) { woken.set_value(writable); });
+    CHECK(wokenFuture.wait_for(100ms) == std::future_status::timeout);
+
+    stream->close();
+    REQUIRE(wokenFuture.wait_for(5s) == std::future_status::ready);
+    CHECK(wokenFuture.get() == false);
+    CHECK(blocked.drains == 0);
+
+    // The waiters registered after the close are called at once
+    int called{0};
+    stream->whenWritable(
+        [&called](bool writable) { called = writable ? 1 : -1; });
+    CHECK(called == -1);
+}
+#endif
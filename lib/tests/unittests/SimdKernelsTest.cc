@@ -0,0 +1,169 @@
+#include <drogon/utils/Utilities.h>
+#include <drogon/drogon_test.h>
+#include "../../lib/src/SimdKernels.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+std::vector<SimdLevel> vectorLevels()
+{
+    std::vector<SimdLevel> levels;
+    for (auto level : {SimdLevel::kSse4, SimdLevel::kAvx2})
+    {
+        if (level <= SimdKernels::supportedLevel())
+            levels.push_back(level);
+    }
+    return levels;
+}
+
+// The results of the utilities which have vectorized kernels
+std::vector<std::string> results(const std::string &in)
+{
+    using namespace drogon::utils;
+    std::vector<std::string> out;
+    out.push_back(base64Encode(in));
+    out.push_back(base64Encode(in, true));
+    out.push_back(base64EncodeUnpadded(in));
+    out.push_back(base64EncodeUnpadded(in, true));
+    out.push_back(base64Decode(in));
+    auto decoded = base64DecodeToVector(in);
+    out.emplace_back(decoded.begin(), decoded.end());
+    out.push_back(binaryStringToHex(
+        reinterpret_cast<const unsigned char *>(in.data()), in.size()));
+    out.push_back(binaryStringToHex(
+        reinterpret_cast<const unsigned char *>(in.data()), in.size(), true));
+    // Odd lengths are not hex
+    auto even = in.substr(0, in.size() & ~size_t(1));
+    out.push_back(hexToBinaryString(even.data(), even.size()));
+    auto binary = hexToBinaryVector(even.data(), even.size());
+    out.emplace_back(binary.begin(), binary.end());
+    out.push_back(urlEncode(in));
+    out.push_back(urlEncodeComponent(in));
+    out.push_back(urlDecode(in));
+    out.push_back(needUrlDecoding(in.data(), in.data() + in.size()) ? "1"
+                                                                     : "0");
+    out.push_back(isInteger(in) ? "1" : "0");
+    out.push_back(isBase64(in) ? "1" : "0");
+    return out;
+}
+
+std::string randomString(std::mt19937 &rng,
+                         size_t length,
+                         std::string_view alphabet)
+{
+    std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+    std::string str(length, '\0');
+    for (auto &c : str)
+        c = alphabet[dist(rng)];
+    return str;
+}
+}  // namespace
+
+DROGON_TEST(SimdKernels)
+{
+    auto levels = vectorLevels();
+    auto supported = SimdKernels::supportedLevel();
+
+    SUBSECTION(Span)
+    {
+        // Every byte at every position of a vector, after a run of digits
+        auto digits =
+            CharSet::make([](char c) { return c >= '0' && c <= '9'; });
+        auto notPercent =
+            CharSet::make([](char c) { return c != '%'; }, true);
+        for (auto level : levels)
+        {
+            SimdKernels::setLevel(level);
+            bool same = true;
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                for (size_t pos = 0; pos < 70; ++pos)
+                {
+                    std::string str(70, '7');
+                    str[pos] = static_cast<char>(byte);
+                    for (auto *set : {&digits, &notPercent})
+                    {
+                        auto expected = set->contains(byte) ? str.size() : pos;
+                        auto span =
+                            SimdKernels::span(str.data(), str.size(), *set);
+                        // The kernel leaves the tail to the scalar code
+                        auto vectors = str.size() / 16 * 16;
+                        same = same && (span == expected ||
+                                        (span == vectors && expected > span));
+                    }
+                }
+            }
+            CHECK(same);
+        }
+        SimdKernels::setLevel(supported);
+    }
+
+    SUBSECTION(Equivalence)
+    {
+        std::mt19937 rng(42);
+        std::string bytes;
+        for (int c = 0; c < 256; ++c)
+            bytes.push_back(static_cast<char>(c));
+        const std::string_view alphabets[] = {
+            bytes,
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_",
+            "0123456789abcdefABCDEF",
+            "0123456789",
+            "abcXYZ019-_.~!*'()&=/\\? %+\xe5\xae\x89"};
+        std::vector<std::string> inputs;
+        for (auto alphabet : alphabets)
+        {
+            for (size_t length = 0; length <= 200; ++length)
+            {
+                auto str = randomString(rng, length, alphabet);
+                inputs.push_back(str);
+                if (length == 0)
+                    continue;
+                // A character of another alphabet somewhere
+                std::uniform_int_distribution<size_t> dist(0, length - 1);
+                str[dist(rng)] = bytes[dist(rng) % 256];
+                inputs.push_back(std::move(str));
+            }
+        }
+        // Base64 with padding and whole vectors before it
+        inputs.push_back(utils::base64Encode(bytes));
+        inputs.push_back(utils::base64Encode(bytes.substr(1), true));
+
+        std::vector<std::vector<std::string>> expected;
+        SimdKernels::setLevel(SimdLevel::kScalar);
+        for (auto &in : inputs)
+            expected.push_back(results(in));
+        for (auto level : levels)
+        {
+            SimdKernels::setLevel(level);
+            size_t mismatches = 0;
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                if (results(inputs[i]) != expected[i])
+                    ++mismatches;
+            }
+            CHECK(mismatches == 0);
+        }
+        SimdKernels::setLevel(supported);
+    }
+
+    SUBSECTION(RoundTrip)
+    {
+        std::string bytes;
+        for (int i = 0; i < 1000; ++i)
+            bytes.push_back(static_cast<char>(i * 7));
+        auto hex = utils::binaryStringToHex(
+            reinterpret_cast<const unsigned char *>(bytes.data()),
+            bytes.size());
+        CHECK(hex.compare(0, 8, "00070E15") == 0);
+        CHECK(utils::hexToBinaryString(hex.data(), hex.size()) == bytes);
+        CHECK(utils::base64Decode(utils::base64Encode(bytes)) == bytes);
+        CHECK(utils::base64Decode(utils::base64Encode(bytes, true)) == bytes);
+        CHECK(utils::urlDecode(utils::urlEncode(bytes)) == bytes);
+    }
+}
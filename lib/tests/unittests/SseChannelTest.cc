@@ -0,0 +1,276 @@
+#include <drogon/drogon_test.h>
+#include <drogon/ServerSentEvents.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "../../lib/src/HttpResponseImpl.h"
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+#ifndef _WIN32
+namespace
+{
+// The client side of an event stream, a blocking loopback socket
+class SseClient
+{
+  public:
+    explicit SseClient(int fd) : fd_(fd)
+    {
+    }
+
+    ~SseClient()
+    {
+        ::close(fd_);
+    }
+
+    // Read until the data received contains the text, false on timeout
+    bool readUntil(const std::string &text)
+    {
+        char buffer[4096];
+        while (received_.find(text) == std::string::npos)
+        {
+            auto n = ::recv(fd_, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return false;
+            received_.append(buffer, static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+    const std::string &received() const
+    {
+        return received_;
+    }
+
+  private:
+    int fd_;
+    std::string received_;
+};
+
+// A loopback server in its own event loop, every connection is handed to the
+// Server-Sent Events response of a channel as if it were requested
+class SseServer
+{
+  public:
+    SseServer()
+        : server_(loopThread_.getLoop(),
+                  trantor::InetAddress("127.0.0.1", 0),
+                  "SseChannelTest")
+    {
+        loopThread_.run();
+        server_.setRecvMessageCallback(
+            [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buf) {
+                buf->retrieveAll();
+            });
+        server_.setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                if (conn->connected())
+                    startStream(conn);
+            });
+        server_.start();
+        // The server listens once the loop has run start()
+        sync();
+    }
+
+    ~SseServer()
+    {
+        server_.stop();
+    }
+
+    // Connect a client subscribed to the channel. A small receive buffer
+    // makes a slow consumer when the client doesn't read.
+    std::unique_ptr<SseClient> connect(const SseChannelPtr &channel,
+                                       const std::string &lastEventId = "",
+                                       int receiveBuffer = 0)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        if (!lastEventId.empty())
+            req->addHeader("last-event-id", lastEventId);
+        std::promise<void> subscribed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            response_ = channel->newResponse(req);
+            subscribed_ = &subscribed;
+        }
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (receiveBuffer > 0)
+        {
+            ::setsockopt(fd,
+                         SOL_SOCKET,
+                         SO_RCVBUF,
+                         &receiveBuffer,
+                         sizeof(receiveBuffer));
+        }
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server_.address().toPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        auto client = std::make_unique<SseClient>(fd);
+        if (::connect(fd,
+                      reinterpret_cast<struct sockaddr *>(&addr),
+                      sizeof(addr)) != 0 ||
+            subscribed.get_future().wait_for(5s) != std::future_status::ready)
+            return nullptr;
+        return client;
+    }
+
+    // Wait until the event loop has run what was queued before
+    void sync()
+    {
+        std::promise<void> done;
+        loopThread_.getLoop()->queueInLoop([&done]() { done.set_value(); });
+        done.get_future().wait();
+    }
+
+  private:
+    void startStream(const trantor::TcpConnectionPtr &conn)
+    {
+        HttpResponsePtr response;
+        std::promise<void> *subscribed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            response = std::move(response_);
+            subscribed = subscribed_;
+        }
+        auto responseImpl =
+            std::static_pointer_cast<HttpResponseImpl>(response);
+        responseImpl->asyncStreamCallback()(std::make_unique<ResponseStream>(
+            conn->sendAsyncStream(true), conn));
+        subscribed->set_value();
+    }
+
+    trantor::EventLoopThread loopThread_;
+    trantor::TcpServer server_;
+    std::mutex mutex_;
+    HttpResponsePtr response_;
+    std::promise<void> *subscribed_{nullptr};
+};
+}  // namespace
+
+DROGON_TEST(SseChannelTest)
+{
+    SUBSECTION(FanOut)
+    {
+        // Every event reaches the subscribers of all event loops in order
+        auto channel = SseChannel::newChannel();
+        SseServer server1;
+        SseServer server2;
+        auto client1 = server1.connect(channel);
+        auto client2 = server1.connect(channel);
+        auto client3 = server2.connect(channel);
+        REQUIRE(client1 != nullptr);
+        REQUIRE(client2 != nullptr);
+        REQUIRE(client3 != nullptr);
+        CHECK(channel->subscriberCount() == 3UL);
+
+        CHECK(channel->publish(SseEvent("one")) == "1");
+        SseEvent event("two");
+        event.id = "custom";
+        CHECK(channel->publish(event) == "custom");
+        for (auto client : {client1.get(), client2.get(), client3.get()})
+        {
+            CHECK(client->readUntil("id: custom\ndata: two\n\n"));
+            auto &received = client->received();
+            CHECK(received.find("id: 1\ndata: one\n\n") <
+                  received.find("id: custom\ndata: two\n\n"));
+        }
+    }
+
+    SUBSECTION(Replay)
+    {
+        // The events after the Last-Event-ID are replayed from the buffer,
+        // all of them if the ID is no longer in it
+        SseChannelConfig config;
+        config.replayBufferSize = 2;
+        auto channel = SseChannel::newChannel(config);
+        channel->publish(SseEvent("one"));
+        channel->publish(SseEvent("two"));
+        channel->publish(SseEvent("three"));
+
+        SseServer server;
+        auto resumed = server.connect(channel, "2");
+        auto evicted = server.connect(channel, "1");
+        auto fresh = server.connect(channel);
+        REQUIRE(resumed != nullptr);
+        REQUIRE(evicted != nullptr);
+        REQUIRE(fresh != nullptr);
+        channel->publish(SseEvent("four"));
+
+        CHECK(resumed->readUntil("id: 4\ndata: four\n\n"));
+        CHECK(resumed->received().find("id: 2\n") == std::string::npos);
+        CHECK(resumed->received().find("id: 3\ndata: three\n\n") <
+              resumed->received().find("id: 4\n"));
+
+        CHECK(evicted->readUntil("id: 4\ndata: four\n\n"));
+        CHECK(evicted->received().find("id: 1\n") == std::string::npos);
+        CHECK(evicted->received().find("id: 2\ndata: two\n\n") <
+              evicted->received().find("id: 3\n"));
+
+        CHECK(fresh->readUntil("id: 4\ndata: four\n\n"));
+        CHECK(fresh->received().find("id: 3\n") == std::string::npos);
+    }
+
+    SUBSECTION(DropEvents)
+    {
+        // The events for a client that doesn't read are skipped once its
+        // send buffer exceeds the high water mark, it stays subscribed
+        SseChannelConfig config;
+        config.highWaterMark = 64 * 1024;
+        config.slowConsumerPolicy = SseSlowConsumerPolicy::kDropEvents;
+        auto channel = SseChannel::newChannel(config);
+        SseServer server;
+        auto client = server.connect(channel, "", 4096);
+        REQUIRE(client != nullptr);
+
+        channel->publish(SseEvent(std::string(4 * 1024 * 1024, 'x')));
+        // The high water mark callback is queued by the delivery
+        server.sync();
+        server.sync();
+        channel->publish(SseEvent("a"));
+        channel->publish(SseEvent("b"));
+        channel->publish(SseEvent("c"));
+        server.sync();
+        CHECK(channel->slowConsumerEvents() == 3UL);
+        CHECK(channel->subscriberCount() == 1UL);
+    }
+
+    SUBSECTION(Disconnect)
+    {
+        // A slow consumer is closed, to resume from the replay buffer
+        SseChannelConfig config;
+        config.highWaterMark = 64 * 1024;
+        config.slowConsumerPolicy = SseSlowConsumerPolicy::kDisconnect;
+        auto channel = SseChannel::newChannel(config);
+        SseServer server;
+        auto client = server.connect(channel, "", 4096);
+        REQUIRE(client != nullptr);
+
+        channel->publish(SseEvent(std::string(4 * 1024 * 1024, 'x')));
+        server.sync();
+        server.sync();
+        channel->publish(SseEvent("a"));
+        server.sync();
+        CHECK(channel->slowConsumerEvents() == 1UL);
+        CHECK(channel->subscriberCount() == 0UL);
+    }
+}
+#endif
@@ -0,0 +1,26 @@
+#include <drogon/ServerSentEvents.h>
+#include <drogon/drogon_test.h>
+using namespace drogon;
+
+DROGON_TEST(SseEventTest)
+{
+    CHECK(SseEvent("hello").format() == "data: hello\n\n");
+
+    SseEvent event;
+    event.event = "update";
+    event.id = "42";
+    event.retry = std::chrono::milliseconds(3000);
+    event.data = "line1\nline2\r\nline3\rline4";
+    CHECK(event.format() ==
+          "event: update\nid: 42\nretry: 3000\n"
+          "data: line1\ndata: line2\ndata: line3\ndata: line4\n\n");
+
+    // Line breaks would start new fields
+    event = SseEvent();
+    event.event = "a\nb";
+    event.id = "1\r\n2";
+    CHECK(event.format() == "event: ab\nid: 12\n\n");
+
+    // Trailing line breaks are kept as empty data lines
+    CHECK(SseEvent("x\n").format() == "data: x\ndata: \n\n");
+}
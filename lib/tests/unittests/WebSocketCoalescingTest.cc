@@ -0,0 +1,191 @@
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "../../lib/src/WebSocketConnectionImpl.h"
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+#ifndef _WIN32
+namespace
+{
+// The server side of a loopback connection wrapped in a WebSocket connection,
+// the client reads the frames from a blocking socket
+class LoopbackWebSocket
+{
+  public:
+    LoopbackWebSocket()
+        : server_(loopThread_.getLoop(),
+                  trantor::InetAddress("127.0.0.1", 0),
+                  "WebSocketCoalescingTest")
+    {
+        loopThread_.run();
+        server_.setRecvMessageCallback(
+            [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buf) {
+                buf->retrieveAll();
+            });
+        server_.setConnectionCallback(
+            [this](const trantor::TcpConnectionPtr &conn) {
+                if (conn->connected())
+                    connPromise_.set_value(
+                        std::make_shared<WebSocketConnectionImpl>(conn));
+            });
+        server_.start();
+        sync();
+
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server_.address().toPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd_,
+                      reinterpret_cast<struct sockaddr *>(&addr),
+                      sizeof(addr)) == 0 &&
+            connFuture_.wait_for(5s) == std::future_status::ready)
+            conn_ = connFuture_.get();
+    }
+
+    ~LoopbackWebSocket()
+    {
+        conn_.reset();
+        ::close(fd_);
+        server_.stop();
+    }
+
+    WebSocketConnectionPtr conn() const
+    {
+        return conn_;
+    }
+
+    trantor::EventLoop *loop() const
+    {
+        return loopThread_.getLoop();
+    }
+
+    // Wait until the event loop has run what was queued before
+    void sync()
+    {
+        std::promise<void> done;
+        loop()->queueInLoop([&done]() { done.set_value(); });
+        done.get_future().wait();
+    }
+
+    // Read the given number of bytes
+    std::string read(size_t length)
+    {
+        std::string data(length, '\0');
+        size_t received{0};
+        while (received < length)
+        {
+            auto n = ::recv(fd_, &data[received], length - received, 0);
+            if (n <= 0)
+                break;
+            received += static_cast<size_t>(n);
+        }
+        data.resize(received);
+        return data;
+    }
+
+    // Return true if nothing was received after a while
+    bool idle()
+    {
+        std::this_thread::sleep_for(100ms);
+        char c;
+        return ::recv(fd_, &c, 1, MSG_DONTWAIT) < 0;
+    }
+
+  private:
+    trantor::EventLoopThread loopThread_;
+    trantor::TcpServer server_;
+    std::promise<WebSocketConnectionImplPtr> connPromise_;
+    std::future<WebSocketConnectionImplPtr> connFuture_{
+        connPromise_.get_future()};
+    WebSocketConnectionImplPtr conn_;
+    int fd_{-1};
+};
+
+// An unmasked frame from the server with a short payload
+std::string frame(unsigned char opcode, const std::string &payload)
+{
+    std::string data;
+    data.push_back(static_cast<char>(0x80 | opcode));
+    data.push_back(static_cast<char>(payload.size()));
+    return data + payload;
+}
+}  // namespace
+
+DROGON_TEST(WebSocketCoalescingTest)
+{
+    LoopbackWebSocket ws;
+    auto conn = ws.conn();
+    REQUIRE(conn != nullptr);
+
+    SUBSECTION(FlushThreshold)
+    {
+        // The frames are held back until their size reaches the buffer size,
+        // then written in order
+        conn->enableWriteCoalescing(10s, 8);
+        ws.sync();
+        conn->send("1");
+        conn->send("2");
+        CHECK(ws.idle());
+        conn->send("3");
+        auto frames = frame(0x1, "1") + frame(0x1, "2") + frame(0x1, "3");
+        CHECK(ws.read(9) == frames);
+    }
+
+    SUBSECTION(ControlFrame)
+    {
+        // A ping is written at once, after the pending frames
+        conn->send("4");
+        CHECK(ws.idle());
+        conn->send("p", WebSocketMessageType::Ping);
+        CHECK(ws.read(6) == frame(0x1, "4") + frame(0x9, "p"));
+    }
+
+    SUBSECTION(Disable)
+    {
+        // The pending frames are flushed, the next ones are written at once
+        conn->send("5");
+        CHECK(ws.idle());
+        conn->disableWriteCoalescing();
+        CHECK(ws.read(3) == frame(0x1, "5"));
+        conn->send("6");
+        CHECK(ws.read(3) == frame(0x1, "6"));
+    }
+
+    SUBSECTION(EndOfIteration)
+    {
+        // Without a delay, the frames sent in the loop and from another
+        // thread are written in the order they were sent
+        conn->enableWriteCoalescing();
+        ws.sync();
+        ws.loop()->queueInLoop([conn]() {
+            conn->send("7");
+            conn->send("8");
+        });
+        conn->send("9");
+        auto frames = frame(0x1, "7") + frame(0x1, "8") + frame(0x1, "9");
+        CHECK(ws.read(9) == frames);
+    }
+}
+#endif
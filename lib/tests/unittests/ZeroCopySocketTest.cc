@@ -0,0 +1,179 @@
+#include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "../../lib/src/ZeroCopySocket.h"
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+#ifdef __linux__
+namespace
+{
+// A loopback TCP connection, the server side has SO_ZEROCOPY
+struct LoopbackPair
+{
+    LoopbackPair()
+    {
+        int listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = static_cast<socklen_t>(sizeof(addr));
+        auto sockAddr = reinterpret_cast<struct sockaddr *>(&addr);
+        if (::bind(listenFd, sockAddr, len) == 0 &&
+            ::listen(listenFd, 1) == 0 &&
+            ::getsockname(listenFd, sockAddr, &len) == 0)
+        {
+            clientFd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (::connect(clientFd, sockAddr, len) == 0)
+                serverFd = ::accept(listenFd, nullptr, nullptr);
+        }
+        ::close(listenFd);
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        ::setsockopt(
+            clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~LoopbackPair()
+    {
+        if (clientFd >= 0)
+            ::close(clientFd);
+        if (serverFd >= 0)
+            ::close(serverFd);
+    }
+
+    std::string read(size_t length)
+    {
+        std::string data(length, '\0');
+        size_t received{0};
+        while (received < length)
+        {
+            auto n = ::recv(clientFd, &data[received], length - received, 0);
+            if (n <= 0)
+                break;
+            received += static_cast<size_t>(n);
+        }
+        data.resize(received);
+        return data;
+    }
+
+    int clientFd{-1};
+    int serverFd{-1};
+};
+
+// Send everything the stream gives back, like trantor does with the chunks
+// copied when the socket is full
+void drainStream(const std::function<std::size_t(char *, std::size_t)> &stream,
+                 int fd)
+{
+    char buffer[16 * 1024];
+    for (;;)
+    {
+        auto n = stream(buffer, sizeof(buffer));
+        if (n == 0)
+            break;
+        size_t sent{0};
+        while (sent < n)
+        {
+            auto ret = ::send(fd, buffer + sent, n - sent, MSG_NOSIGNAL);
+            if (ret <= 0)
+                return;
+            sent += static_cast<size_t>(ret);
+        }
+    }
+}
+}  // namespace
+
+DROGON_TEST(ZeroCopySocketTest)
+{
+    if (!ZeroCopySocket::isSupported())
+        return;
+    LoopbackPair pair;
+    REQUIRE(pair.serverFd >= 0);
+    if (!ZeroCopySocket::enable(pair.serverFd))
+        return;
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    auto socket = std::make_shared<ZeroCopySocket>(pair.serverFd, loop);
+
+    SUBSECTION(SendAndComplete)
+    {
+        // The bytes arrive in order, and the body is released once the
+        // completions of its sends are read from the error queue
+        const size_t length = 4 * 1024 * 1024;
+        auto body = std::make_shared<std::string>(length, '\0');
+        for (size_t i = 0; i < length; ++i)
+            (*body)[i] = static_cast<char>('a' + i % 26);
+        const auto expected = *body;
+        std::weak_ptr<std::string> weakBody = body;
+        auto before = ZeroCopySocket::getStats();
+        std::promise<void> sent;
+        loop->runInLoop(
+            [socket,
+             body = std::move(body),
+             fd = pair.serverFd,
+             &sent]() mutable {
+                auto stream =
+                    socket->makeStream(body, body->data(), body->size());
+                body.reset();
+                drainStream(stream, fd);
+                // Cleanup
+                stream(nullptr, 0);
+                sent.set_value();
+            });
+        auto received = pair.read(length);
+        CHECK(received.size() == length);
+        CHECK(received == expected);
+        REQUIRE(sent.get_future().wait_for(5s) == std::future_status::ready);
+        auto after = ZeroCopySocket::getStats();
+        CHECK(after.bytes + after.fallbackBytes ==
+              before.bytes + before.fallbackBytes + length);
+
+        for (int i = 0; i < 500 && !weakBody.expired(); ++i)
+            std::this_thread::sleep_for(10ms);
+        CHECK(weakBody.expired());
+    }
+
+    SUBSECTION(Close)
+    {
+        // Once the connection is closed the socket is no longer written, the
+        // whole body is copied to trantor
+        std::promise<std::pair<size_t, size_t>> copied;
+        loop->runInLoop([socket, &copied]() {
+            socket->close();
+            auto body = std::make_shared<std::string>(100000, 'x');
+            auto stream =
+                socket->makeStream(body, body->data(), body->size());
+            char buffer[16 * 1024];
+            size_t total{0};
+            size_t chunks{0};
+            while (auto n = stream(buffer, sizeof(buffer)))
+            {
+                total += n;
+                ++chunks;
+            }
+            copied.set_value({total, chunks});
+        });
+        auto result = copied.get_future().get();
+        CHECK(result.first == 100000UL);
+        CHECK(result.second == 7UL);
+    }
+}
+#endif
@@ -17,12 +17,16 @@
 #include <drogon/nosql/RedisResult.h>
 #include <drogon/nosql/RedisException.h>
 #include <drogon/nosql/RedisSubscriber.h>
+#include <drogon/nosql/RedisStreamConsumer.h>
+#include <drogon/utils/monitoring/Registry.h>
 #include <string_view>
 #include <trantor/net/InetAddress.h>
+#include <trantor/utils/Date.h>
 #include <trantor/utils/Logger.h>
 #include <memory>
 #include <functional>
 #include <future>
+#include <vector>
 #ifdef __cpp_impl_coroutine
 #include <drogon/utils/coroutine.h>
 #endif
@@ -82,6 +86,21 @@ struct [[nodiscard]] RedisTransactionAwaiter
 
 class RedisTransaction;
 
+/**
+ * @brief An entry of the client-side slowlog of a redis client.
+ */
+struct RedisSlowlogEntry
+{
+    /// The time when the command was sent to the server.
+    trantor::Date time;
+    /// The command name in upper case, such as "GET".
+    std::string command;
+    /// The arguments of the command, each of them is truncated.
+    std::string arguments;
+    /// The time in seconds from sending the command to receiving the reply.
+    double duration{0};
+};
+
 /**
  * @brief This class represents a redis client that contains several connections
  * to a redis server.
@@ -209,6 +228,43 @@ class DROGON_EXPORT RedisClient
      */
     virtual std::shared_ptr<RedisSubscriber> newSubscriber() noexcept = 0;
 
+    /**
+     * @brief Create a consumer of a redis stream in a consumer group.
+     *
+     * @return std::shared_ptr<RedisStreamConsumer>
+     * @note The consumer creates two new redis connections dedicated to
+     * reading and acknowledging messages. The consumer stops when it is
+     * destroyed or stop() is called. The batch callback is held by the
+     * consumer, it must not own the consumer.
+     * For example:
+     * @code
+       RedisStreamConsumerConfig config;
+       config.stream = "jobs";
+       config.group = "workers";
+       config.consumer = "worker-1";
+       auto consumer = redisClientPtr->newStreamConsumer(config);
+       std::weak_ptr<RedisStreamConsumer> weakConsumer = consumer;
+       consumer->setBatchCallback([weakConsumer](RedisStreamBatch &&batch) {
+           auto consumer = weakConsumer.lock();
+           if (!consumer)
+               return;
+           for (auto &msg : batch)
+           {
+               // handle the message
+               consumer->ack(msg.id);
+           }
+       });
+       @endcode
+     * @note Only the clients created by drogon support it, the default
+     * implementation returns nullptr so that other subclasses keep compiling.
+     */
+    virtual std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config) noexcept
+    {
+        (void)config;
+        return nullptr;
+    }
+
     /**
      * @brief Create a redis transaction object.
      *
@@ -241,6 +297,46 @@ class DROGON_EXPORT RedisClient
      */
     virtual void setTimeout(double timeout) = 0;
 
+    /**
+     * @brief Enable the instrumentation of the client.
+     *
+     * @param registry The registry to which the collectors are registered,
+     * usually the PromExporter plugin. The collectors are shared by all redis
+     * clients and are distinguished by the "client" label.
+     * @param clientName The value of the "client" label.
+     * @param slowlogThreshold Commands that take longer than this value (in
+     * seconds) are recorded in the client-side slowlog. Set it to zero or a
+     * negative value to disable the slowlog.
+     * @param slowlogSampleRate The probability (0 to 1) that a slow command is
+     * recorded in the slowlog.
+     * @param slowlogCapacity The maximum number of entries in the slowlog.
+     * @note The following metrics are exported:
+     * - redis_command_duration_seconds{client,command}, histogram, the time
+     *   from sending a command to receiving its reply;
+     * - redis_queue_wait_seconds{client}, histogram, the time a command waits
+     *   for an available connection;
+     * - redis_sent_bytes_total{client,command}, counter;
+     * - redis_received_bytes_total{client,command}, counter;
+     * - redis_slow_commands_total{client,command}, counter.
+     */
+    virtual void enableMetrics(monitoring::Registry & /*registry*/,
+                               const std::string & /*clientName*/ = "default",
+                               double /*slowlogThreshold*/ = 0.01,
+                               double /*slowlogSampleRate*/ = 1.0,
+                               size_t /*slowlogCapacity*/ = 128)
+    {
+        LOG_WARN << "Metrics are not supported by this redis client";
+    }
+
+    /**
+     * @brief Get the entries of the client-side slowlog, the newest entry is
+     * the last one.
+     */
+    virtual std::vector<RedisSlowlogEntry> getSlowlog() const
+    {
+        return {};
+    }
+
     virtual ~RedisClient() = default;
 
     /**
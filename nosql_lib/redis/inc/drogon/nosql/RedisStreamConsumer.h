@@ -0,0 +1,162 @@
+/**
+ *
+ *  @file RedisStreamConsumer.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+
+namespace drogon::nosql
+{
+/**
+ * @brief A message (an entry) of a redis stream.
+ */
+struct RedisStreamMessage
+{
+    std::string id;
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+using RedisStreamBatch = std::vector<RedisStreamMessage>;
+using RedisStreamBatchCallback = std::function<void(RedisStreamBatch &&)>;
+
+struct RedisStreamConsumerConfig
+{
+    /// The key of the stream.
+    std::string stream;
+    /// The consumer group.
+    std::string group;
+    /// The name of the consumer in the group.
+    std::string consumer;
+    /// The maximum number of messages read by one XREADGROUP command.
+    size_t batchSize{100};
+    /// The maximum number of messages that are delivered but not yet
+    /// acknowledged, reading is paused when the limit is reached.
+    size_t maxInFlight{1000};
+    /// The BLOCK time of XREADGROUP in seconds.
+    double blockTime{1.0};
+    /// The acknowledgements are sent in one XACK command every ackInterval
+    /// seconds.
+    double ackInterval{0.005};
+    /// Pending messages idle for longer than this value (in seconds) are
+    /// claimed from other consumers by XAUTOCLAIM. Zero disables reclaiming.
+    double reclaimIdleTime{0.0};
+    /// The interval in seconds between two XAUTOCLAIM commands.
+    double reclaimInterval{5.0};
+    /// Create the group (and the stream) if it doesn't exist.
+    bool createGroup{true};
+};
+
+#ifdef __cpp_impl_coroutine
+class RedisStreamConsumer;
+
+namespace internal
+{
+struct [[nodiscard]] RedisStreamAwaiter
+    : public CallbackAwaiter<RedisStreamBatch>
+{
+    explicit RedisStreamAwaiter(RedisStreamConsumer *consumer)
+        : consumer_(consumer)
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+  private:
+    RedisStreamConsumer *consumer_;
+};
+}  // namespace internal
+#endif
+
+/**
+ * @brief This class consumes a redis stream as a member of a consumer group.
+ * The messages are read by XREADGROUP on a dedicated connection, and the
+ * acknowledgements and XAUTOCLAIM commands are sent on another dedicated
+ * connection, so they are never blocked by the reading.
+ * Messages are delivered in batches either to the batch callback (push mode)
+ * or to the callers of fetchAsync()/fetchCoro() (pull mode).
+ */
+class DROGON_EXPORT RedisStreamConsumer
+{
+  public:
+    /**
+     * @brief Set the callback which is called with every batch of messages.
+     * The callback is called in the event loop of the consumer.
+     */
+    virtual void setBatchCallback(
+        RedisStreamBatchCallback &&callback) noexcept = 0;
+
+    /**
+     * @brief Get the next batch of messages. The callback is called once,
+     * with an empty batch if the consumer is stopped.
+     * @note Only used when no batch callback is set.
+     */
+    virtual void fetchAsync(RedisStreamBatchCallback &&callback) noexcept = 0;
+
+    /**
+     * @brief Acknowledge a message. Acknowledgements are batched and sent in
+     * one XACK command per tick (see RedisStreamConsumerConfig::ackInterval).
+     */
+    virtual void ack(const std::string &id) noexcept = 0;
+
+    /**
+     * @brief Stop reading messages. Pending acknowledgements are flushed
+     * before the connections are closed, and the batch callback is released.
+     */
+    virtual void stop() noexcept = 0;
+
+    virtual ~RedisStreamConsumer() = default;
+
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Await the next batch of messages in a coroutine. An empty batch
+     * means the consumer is stopped. For example:
+     * @code
+       for (;;)
+       {
+           auto batch = co_await consumer->fetchCoro();
+           if (batch.empty())
+               break;
+           for (auto &msg : batch)
+           {
+               co_await handleMessage(msg);
+               consumer->ack(msg.id);
+           }
+       }
+       @endcode
+     */
+    internal::RedisStreamAwaiter fetchCoro()
+    {
+        return internal::RedisStreamAwaiter(this);
+    }
+#endif
+};
+
+#ifdef __cpp_impl_coroutine
+inline void internal::RedisStreamAwaiter::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    consumer_->fetchAsync([this, handle](RedisStreamBatch &&batch) {
+        setValue(std::move(batch));
+        handle.resume();
+    });
+}
+#endif
+
+}  // namespace drogon::nosql
@@ -15,8 +15,10 @@
 #include "RedisConnection.h"
 #include "RedisClientImpl.h"
 #include "RedisSubscriberImpl.h"
+#include "RedisStreamConsumerImpl.h"
 #include "RedisTransactionImpl.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
+#include <drogon/utils/monitoring/StopWatch.h>
 
 using namespace drogon::nosql;
 
@@ -67,6 +69,7 @@ RedisConnectionPtr RedisClientImpl::newConnection(trantor::EventLoop *loop)
 {
     auto conn = std::make_shared<RedisConnection>(
         serverAddr_, username_, password_, db_, loop);
+    conn->setMetrics(metrics_);
     std::weak_ptr<RedisClientImpl> thisWeakPtr = shared_from_this();
     conn->setConnectCallback([thisWeakPtr](RedisConnectionPtr &&conn) {
         auto thisPtr = thisWeakPtr.lock();
@@ -171,6 +174,63 @@ RedisConnectionPtr RedisClientImpl::newSubscribeConnection(
     return conn;
 }
 
+RedisConnectionPtr RedisClientImpl::newStreamConnection(
+    trantor::EventLoop *loop,
+    const std::shared_ptr<RedisStreamConsumerImpl> &consumer,
+    bool isReader)
+{
+    auto conn = std::make_shared<RedisConnection>(
+        serverAddr_, username_, password_, db_, loop);
+    std::weak_ptr<RedisClientImpl> weakThis = shared_from_this();
+    std::weak_ptr<RedisStreamConsumerImpl> weakConsumer(consumer);
+    conn->setMetrics(metrics_);
+    conn->setConnectCallback(
+        [weakThis, weakConsumer, isReader](RedisConnectionPtr &&conn) {
+            auto thisPtr = weakThis.lock();
+            if (!thisPtr)
+                return;
+            auto consumerPtr = weakConsumer.lock();
+            if (consumerPtr && !consumerPtr->stopped())
+            {
+                consumerPtr->setConnection(conn, isReader);
+            }
+            else
+            {
+                {
+                    std::lock_guard<std::mutex> lock(
+                        thisPtr->connectionsMutex_);
+                    thisPtr->connections_.erase(conn);
+                }
+                conn->disconnect();
+            }
+        });
+    conn->setDisconnectCallback(
+        [weakThis, weakConsumer, isReader](RedisConnectionPtr &&conn) {
+            auto thisPtr = weakThis.lock();
+            if (!thisPtr)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+                thisPtr->connections_.erase(conn);
+            }
+            auto consumerPtr = weakConsumer.lock();
+            if (!consumerPtr)
+                return;
+            consumerPtr->clearConnection(conn);
+            if (consumerPtr->stopped())
+                return;
+
+            auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+            assert(loop);
+            loop->runAfter(2.0, [thisPtr, loop, consumerPtr, isReader]() {
+                std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+                thisPtr->connections_.insert(
+                    thisPtr->newStreamConnection(loop, consumerPtr, isReader));
+            });
+        });
+    return conn;
+}
+
 void RedisClientImpl::execCommandAsync(
     RedisResultCallback &&resultCallback,
     RedisExceptionCallback &&exceptionCallback,
@@ -189,8 +249,10 @@ void RedisClientImpl::execCommandAsync(
         return;
     }
     RedisConnectionPtr connPtr;
+    RedisClientMetricsPtr metrics;
     {
         std::lock_guard<std::mutex> lock(connectionsMutex_);
+        metrics = metrics_;
         if (!readyConnections_.empty())
         {
             if (connectionPos_ >= readyConnections_.size())
@@ -206,6 +268,10 @@ void RedisClientImpl::execCommandAsync(
     }
     if (connPtr)
     {
+        if (metrics)
+        {
+            metrics->observeQueueWait(0.0);
+        }
         va_list args;
         va_start(args, command);
         connPtr->sendvCommand(command,
@@ -226,8 +292,14 @@ void RedisClientImpl::execCommandAsync(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(formattedCmd),
+                 metrics = std::move(metrics),
+                 watch = StopWatch()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (metrics)
+                    {
+                        metrics->observeQueueWait(watch.elapsed());
+                    }
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -434,8 +506,10 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
         }
     };
     RedisConnectionPtr connPtr;
+    RedisClientMetricsPtr metrics;
     {
         std::lock_guard<std::mutex> lock(connectionsMutex_);
+        metrics = metrics_;
         if (!readyConnections_.empty())
         {
             if (connectionPos_ >= readyConnections_.size())
@@ -451,6 +525,10 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
+        if (metrics)
+        {
+            metrics->observeQueueWait(0.0);
+        }
         connPtr->sendvCommand(command,
                               std::move(newResultCallback),
                               std::move(newExceptionCallback),
@@ -464,8 +542,14 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(formattedCmd),
+                 metrics = std::move(metrics),
+                 watch = StopWatch()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (metrics)
+                    {
+                        metrics->observeQueueWait(watch.elapsed());
+                    }
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -488,3 +572,47 @@ std::shared_ptr<RedisSubscriber> RedisClientImpl::newSubscriber() noexcept
 
     return subscriber;
 }
+
+std::shared_ptr<RedisStreamConsumer> RedisClientImpl::newStreamConsumer(
+    const RedisStreamConsumerConfig &config) noexcept
+{
+    auto loop = loops_.getNextLoop();
+    auto consumer = std::make_shared<RedisStreamConsumerImpl>(config, loop);
+    loop->queueInLoop([this, loop, consumer]() {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections_.insert(newStreamConnection(loop, consumer, true));
+        connections_.insert(newStreamConnection(loop, consumer, false));
+    });
+
+    return consumer;
+}
+
+void RedisClientImpl::enableMetrics(monitoring::Registry &registry,
+                                    const std::string &clientName,
+                                    double slowlogThreshold,
+                                    double slowlogSampleRate,
+                                    size_t slowlogCapacity)
+{
+    auto metrics = std::make_shared<RedisClientMetrics>(registry,
+                                                        clientName,
+                                                        slowlogThreshold,
+                                                        slowlogSampleRate,
+                                                        slowlogCapacity);
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    metrics_ = metrics;
+    for (auto &conn : connections_)
+    {
+        conn->getLoop()->runInLoop(
+            [conn, metrics]() { conn->setMetrics(metrics); });
+    }
+}
+
+std::vector<RedisSlowlogEntry> RedisClientImpl::getSlowlog() const
+{
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    if (metrics_)
+    {
+        return metrics_->slowlog();
+    }
+    return {};
+}
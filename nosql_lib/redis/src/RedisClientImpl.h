@@ -15,6 +15,8 @@
 
 #include "RedisConnection.h"
 #include "RedisSubscriberImpl.h"
+#include "RedisStreamConsumerImpl.h"
+#include "RedisClientMetrics.h"
 #include "SubscribeContext.h"
 #include <drogon/nosql/RedisClient.h>
 #include <trantor/utils/NonCopyable.h>
@@ -48,6 +50,8 @@ class RedisClientImpl final
                           ...) noexcept override;
     ~RedisClientImpl() override;
     std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config) noexcept override;
 
     RedisTransactionPtr newTransaction() noexcept(false) override
     {
@@ -75,12 +79,36 @@ class RedisClientImpl final
         timeout_ = timeout;
     }
 
+    void enableMetrics(monitoring::Registry &registry,
+                       const std::string &clientName,
+                       double slowlogThreshold,
+                       double slowlogSampleRate,
+                       size_t slowlogCapacity) override;
+    std::vector<RedisSlowlogEntry> getSlowlog() const override;
+
     void init();
     void closeAll() override;
 
+    // The number of established connections
+    size_t availableConnectionsNumber() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        return readyConnections_.size();
+    }
+
+    size_t connectionsNumber() const noexcept
+    {
+        return numberOfConnections_;
+    }
+
+    std::vector<trantor::EventLoop *> getLoops() const
+    {
+        return loops_.getLoops();
+    }
+
   private:
     trantor::EventLoopThreadPool loops_;
-    std::mutex connectionsMutex_;
+    mutable std::mutex connectionsMutex_;
     std::unordered_set<RedisConnectionPtr> connections_;
     std::vector<RedisConnectionPtr> readyConnections_;
     size_t connectionPos_{0};
@@ -92,11 +120,17 @@ class RedisClientImpl final
     double timeout_{-1.0};
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
+    // Guarded by connectionsMutex_
+    RedisClientMetricsPtr metrics_;
 
     RedisConnectionPtr newConnection(trantor::EventLoop *loop);
     RedisConnectionPtr newSubscribeConnection(
         trantor::EventLoop *loop,
         const std::shared_ptr<RedisSubscriberImpl> &subscriber);
+    RedisConnectionPtr newStreamConnection(
+        trantor::EventLoop *loop,
+        const std::shared_ptr<RedisStreamConsumerImpl> &consumer,
+        bool isReader);
 
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
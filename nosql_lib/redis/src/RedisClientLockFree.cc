@@ -15,8 +15,10 @@
 #include "RedisConnection.h"
 #include "RedisClientLockFree.h"
 #include "RedisSubscriberImpl.h"
+#include "RedisStreamConsumerImpl.h"
 #include "RedisTransactionImpl.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
+#include <drogon/utils/monitoring/StopWatch.h>
 using namespace drogon::nosql;
 
 RedisClientLockFree::RedisClientLockFree(
@@ -45,6 +47,7 @@ RedisConnectionPtr RedisClientLockFree::newConnection()
     loop_->assertInLoopThread();
     auto conn = std::make_shared<RedisConnection>(
         serverAddr_, username_, password_, db_, loop_);
+    conn->setMetrics(metrics_);
     std::weak_ptr<RedisClientLockFree> thisWeakPtr = shared_from_this();
     conn->setConnectCallback([thisWeakPtr](RedisConnectionPtr &&conn) {
         auto thisPtr = thisWeakPtr.lock();
@@ -139,6 +142,53 @@ RedisConnectionPtr RedisClientLockFree::newSubscribeConnection(
     return conn;
 }
 
+RedisConnectionPtr RedisClientLockFree::newStreamConnection(
+    const std::shared_ptr<RedisStreamConsumerImpl> &consumer,
+    bool isReader)
+{
+    loop_->assertInLoopThread();
+    auto conn = std::make_shared<RedisConnection>(
+        serverAddr_, username_, password_, db_, loop_);
+    conn->setMetrics(metrics_);
+    std::weak_ptr<RedisClientLockFree> weakThis = shared_from_this();
+    std::weak_ptr<RedisStreamConsumerImpl> weakConsumer(consumer);
+    conn->setConnectCallback(
+        [weakThis, weakConsumer, isReader](RedisConnectionPtr &&conn) {
+            auto thisPtr = weakThis.lock();
+            if (!thisPtr)
+                return;
+            auto consumerPtr = weakConsumer.lock();
+            if (consumerPtr && !consumerPtr->stopped())
+            {
+                consumerPtr->setConnection(conn, isReader);
+            }
+            else
+            {
+                thisPtr->connections_.erase(conn);
+                conn->disconnect();
+            }
+        });
+    conn->setDisconnectCallback(
+        [weakThis, weakConsumer, isReader](RedisConnectionPtr &&conn) {
+            auto thisPtr = weakThis.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->connections_.erase(conn);
+            auto consumerPtr = weakConsumer.lock();
+            if (!consumerPtr)
+                return;
+            consumerPtr->clearConnection(conn);
+            if (consumerPtr->stopped())
+                return;
+
+            thisPtr->loop_->runAfter(2.0, [thisPtr, consumerPtr, isReader]() {
+                thisPtr->connections_.insert(
+                    thisPtr->newStreamConnection(consumerPtr, isReader));
+            });
+        });
+    return conn;
+}
+
 void RedisClientLockFree::execCommandAsync(
     RedisResultCallback &&resultCallback,
     RedisExceptionCallback &&exceptionCallback,
@@ -174,6 +224,10 @@ void RedisClientLockFree::execCommandAsync(
     }
     if (connPtr)
     {
+        if (metrics_)
+        {
+            metrics_->observeQueueWait(0.0);
+        }
         va_list args;
         va_start(args, command);
         connPtr->sendvCommand(command,
@@ -195,8 +249,14 @@ void RedisClientLockFree::execCommandAsync(
                 [thisWeakPtr,
                  resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(formattedCmd),
+                 metrics = metrics_,
+                 watch = StopWatch()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (metrics)
+                    {
+                        metrics->observeQueueWait(watch.elapsed());
+                    }
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -409,6 +469,10 @@ void RedisClientLockFree::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
+        if (metrics_)
+        {
+            metrics_->observeQueueWait(0.0);
+        }
         connPtr->sendvCommand(command,
                               std::move(newResultCallback),
                               std::move(newExceptionCallback),
@@ -422,8 +486,14 @@ void RedisClientLockFree::execCommandAsyncWithTimeout(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(formattedCmd),
+                 metrics = metrics_,
+                 watch = StopWatch()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    if (metrics)
+                    {
+                        metrics->observeQueueWait(watch.elapsed());
+                    }
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -443,3 +513,53 @@ std::shared_ptr<RedisSubscriber> RedisClientLockFree::newSubscriber() noexcept
 
     return subscriber;
 }
+
+std::shared_ptr<RedisStreamConsumer> RedisClientLockFree::newStreamConsumer(
+    const RedisStreamConsumerConfig &config) noexcept
+{
+    auto consumer = std::make_shared<RedisStreamConsumerImpl>(config, loop_);
+    loop_->runInLoop([this, consumer]() {
+        connections_.insert(newStreamConnection(consumer, true));
+        connections_.insert(newStreamConnection(consumer, false));
+    });
+
+    return consumer;
+}
+
+void RedisClientLockFree::enableMetrics(monitoring::Registry &registry,
+                                        const std::string &clientName,
+                                        double slowlogThreshold,
+                                        double slowlogSampleRate,
+                                        size_t slowlogCapacity)
+{
+    auto metrics = std::make_shared<RedisClientMetrics>(registry,
+                                                        clientName,
+                                                        slowlogThreshold,
+                                                        slowlogSampleRate,
+                                                        slowlogCapacity);
+    {
+        std::lock_guard<std::mutex> lock(slowlogMetricsMutex_);
+        slowlogMetrics_ = metrics;
+    }
+    loop_->runInLoop([this, metrics]() {
+        metrics_ = metrics;
+        for (auto &conn : connections_)
+        {
+            conn->setMetrics(metrics);
+        }
+    });
+}
+
+std::vector<RedisSlowlogEntry> RedisClientLockFree::getSlowlog() const
+{
+    RedisClientMetricsPtr metrics;
+    {
+        std::lock_guard<std::mutex> lock(slowlogMetricsMutex_);
+        metrics = slowlogMetrics_;
+    }
+    if (metrics)
+    {
+        return metrics->slowlog();
+    }
+    return {};
+}
@@ -15,6 +15,8 @@
 
 #include "RedisConnection.h"
 #include "RedisSubscriberImpl.h"
+#include "RedisStreamConsumerImpl.h"
+#include "RedisClientMetrics.h"
 #include <drogon/nosql/RedisClient.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoopThreadPool.h>
@@ -22,6 +24,7 @@
 #include <unordered_set>
 #include <list>
 #include <future>
+#include <mutex>
 
 namespace drogon
 {
@@ -48,6 +51,8 @@ class RedisClientLockFree final
                           ...) noexcept override;
     ~RedisClientLockFree() override;
     std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config) noexcept override;
 
     RedisTransactionPtr newTransaction() override
     {
@@ -68,6 +73,13 @@ class RedisClientLockFree final
         timeout_ = timeout;
     }
 
+    void enableMetrics(monitoring::Registry &registry,
+                       const std::string &clientName,
+                       double slowlogThreshold,
+                       double slowlogSampleRate,
+                       size_t slowlogCapacity) override;
+    std::vector<RedisSlowlogEntry> getSlowlog() const override;
+
     void closeAll() override;
 
   private:
@@ -83,10 +95,17 @@ class RedisClientLockFree final
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
     double timeout_{-1.0};
+    RedisClientMetricsPtr metrics_;
+    // A copy of metrics_ for getSlowlog(), which may be called from any thread
+    mutable std::mutex slowlogMetricsMutex_;
+    RedisClientMetricsPtr slowlogMetrics_;
 
     RedisConnectionPtr newConnection();
     RedisConnectionPtr newSubscribeConnection(
         const std::shared_ptr<RedisSubscriberImpl> &);
+    RedisConnectionPtr newStreamConnection(
+        const std::shared_ptr<RedisStreamConsumerImpl> &consumer,
+        bool isReader);
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
     void handleNextTask(const RedisConnectionPtr &connPtr);
@@ -110,6 +110,32 @@ void RedisClientManager::createRedisClient(const std::string &name,
 //    return true;
 //}
 
+bool RedisClientManager::areAllRedisClientsWarmedUp(
+    size_t minConnections) const noexcept
+{
+    for (auto const &pair : redisClientsMap_)
+    {
+        // The clients in the map are created in createRedisClients()
+        auto client = static_cast<RedisClientImpl *>(pair.second.get());
+        if (client->availableConnectionsNumber() <
+            (std::min)(minConnections, client->connectionsNumber()))
+            return false;
+    }
+    return true;
+}
+
+std::vector<trantor::EventLoop *> RedisClientManager::getClientLoops() const
+{
+    std::vector<trantor::EventLoop *> loops;
+    for (auto const &pair : redisClientsMap_)
+    {
+        auto clientLoops =
+            static_cast<RedisClientImpl *>(pair.second.get())->getLoops();
+        loops.insert(loops.end(), clientLoops.begin(), clientLoops.end());
+    }
+    return loops;
+}
+
 RedisClientManager::~RedisClientManager()
 {
     for (auto &pair : redisClientsMap_)
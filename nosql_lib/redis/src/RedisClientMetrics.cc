@@ -0,0 +1,319 @@
+/**
+ *
+ *  @file RedisClientMetrics.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisClientMetrics.h"
+#include <drogon/HttpAppFramework.h>
+#include <hiredis/hiredis.h>
+#include <algorithm>
+#include <random>
+#include <set>
+
+using namespace drogon::nosql;
+using namespace drogon::monitoring;
+
+namespace
+{
+struct RedisCollectors
+{
+    std::shared_ptr<Collector<Histogram>> commandDuration{
+        std::make_shared<Collector<Histogram>>(
+            "redis_command_duration_seconds",
+            "The time from sending a redis command to receiving its reply",
+            std::vector<std::string>{"client", "command"})};
+    std::shared_ptr<Collector<Histogram>> queueWait{
+        std::make_shared<Collector<Histogram>>(
+            "redis_queue_wait_seconds",
+            "The time a redis command waits for an available connection",
+            std::vector<std::string>{"client"})};
+    std::shared_ptr<Collector<Counter>> sentBytes{
+        std::make_shared<Collector<Counter>>(
+            "redis_sent_bytes_total",
+            "The number of bytes sent to redis servers",
+            std::vector<std::string>{"client", "command"})};
+    std::shared_ptr<Collector<Counter>> receivedBytes{
+        std::make_shared<Collector<Counter>>(
+            "redis_received_bytes_total",
+            "The number of bytes received from redis servers",
+            std::vector<std::string>{"client", "command"})};
+    std::shared_ptr<Collector<Counter>> slowCommands{
+        std::make_shared<Collector<Counter>>(
+            "redis_slow_commands_total",
+            "The number of redis commands slower than the slowlog threshold",
+            std::vector<std::string>{"client", "command"})};
+    std::mutex mutex;
+    std::set<Registry *> registries;
+};
+
+RedisCollectors &getCollectors()
+{
+    static RedisCollectors collectors;
+    return collectors;
+}
+
+void registerCollectors(Registry &registry)
+{
+    auto &collectors = getCollectors();
+    std::lock_guard<std::mutex> lock(collectors.mutex);
+    if (collectors.registries.insert(&registry).second)
+    {
+        collectors.commandDuration->registerTo(registry);
+        collectors.queueWait->registerTo(registry);
+        collectors.sentBytes->registerTo(registry);
+        collectors.receivedBytes->registerTo(registry);
+        collectors.slowCommands->registerTo(registry);
+    }
+}
+
+// The histograms never rotate (maxAge is zero), so the main loop is passed to
+// them only to prevent each histogram from creating its own loop thread.
+const std::vector<double> durationBoundaries{
+    0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5};
+
+std::shared_ptr<Histogram> makeHistogram(
+    Collector<Histogram> &collector,
+    const std::vector<std::string> &labelValues)
+{
+    return collector.metric(labelValues,
+                            durationBoundaries,
+                            std::chrono::duration<double>(0),
+                            1,
+                            drogon::app().getLoop());
+}
+
+bool readLine(std::string_view &buf, std::string_view &line)
+{
+    auto pos = buf.find("\r\n");
+    if (pos == std::string_view::npos)
+        return false;
+    line = buf.substr(0, pos);
+    buf.remove_prefix(pos + 2);
+    return true;
+}
+
+// Parse the bulk strings of a command formatted by redisFormatCommand(), the
+// callback returns false to stop the parsing.
+template <typename F>
+void forEachArgument(std::string_view cmd, F &&callback)
+{
+    std::string_view line;
+    if (!readLine(cmd, line) || line.empty() || line[0] != '*')
+        return;
+    while (readLine(cmd, line) && !line.empty() && line[0] == '$')
+    {
+        size_t len = 0;
+        for (size_t i = 1; i < line.size(); ++i)
+        {
+            if (line[i] < '0' || line[i] > '9')
+                return;
+            len = len * 10 + (line[i] - '0');
+        }
+        if (cmd.size() < len + 2)
+            return;
+        if (!callback(cmd.substr(0, len)))
+            return;
+        cmd.remove_prefix(len + 2);
+    }
+}
+
+size_t numberOfDigits(long long n)
+{
+    size_t digits = n < 0 ? 2 : 1;
+    while (n >= 10 || n <= -10)
+    {
+        n /= 10;
+        ++digits;
+    }
+    return digits;
+}
+}  // namespace
+
+RedisClientMetrics::RedisClientMetrics(Registry &registry,
+                                       std::string clientName,
+                                       double slowlogThreshold,
+                                       double slowlogSampleRate,
+                                       size_t slowlogCapacity)
+    : clientName_(std::move(clientName)),
+      slowlogThreshold_(slowlogThreshold),
+      slowlogSampleRate_(slowlogSampleRate),
+      slowlogCapacity_(slowlogCapacity)
+{
+    registerCollectors(registry);
+    queueWait_ = makeHistogram(*getCollectors().queueWait, {clientName_});
+}
+
+const RedisClientMetrics::CommandMetrics &RedisClientMetrics::commandMetrics(
+    const std::string &command)
+{
+    std::lock_guard<std::mutex> lock(metricsMutex_);
+    auto iter = commandMetrics_.find(command);
+    if (iter != commandMetrics_.end())
+        return iter->second;
+    auto &collectors = getCollectors();
+    std::vector<std::string> labelValues{clientName_, command};
+    CommandMetrics metrics;
+    metrics.duration = makeHistogram(*collectors.commandDuration, labelValues);
+    metrics.sentBytes = collectors.sentBytes->metric(labelValues);
+    metrics.receivedBytes = collectors.receivedBytes->metric(labelValues);
+    metrics.slowCommands = collectors.slowCommands->metric(labelValues);
+    return commandMetrics_.emplace(command, std::move(metrics)).first->second;
+}
+
+std::unique_ptr<RedisCommandTrace> RedisClientMetrics::startCommand(
+    const std::string &formattedCommand)
+{
+    auto trace = std::make_unique<RedisCommandTrace>();
+    trace->command = getCommandName(formattedCommand);
+    if (slowlogThreshold_ > 0.0)
+    {
+        trace->arguments = getTruncatedArguments(formattedCommand);
+        trace->sendTime = trantor::Date::now();
+    }
+    trace->start = std::chrono::steady_clock::now();
+    commandMetrics(trace->command)
+        .sentBytes->increment(static_cast<double>(formattedCommand.size()));
+    return trace;
+}
+
+void RedisClientMetrics::finishCommand(const RedisCommandTrace &trace,
+                                       const redisReply *reply)
+{
+    auto duration = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - trace.start)
+                        .count();
+    auto &metrics = commandMetrics(trace.command);
+    metrics.duration->observe(duration);
+    if (reply)
+    {
+        metrics.receivedBytes->increment(
+            static_cast<double>(getReplySize(reply)));
+    }
+    if (slowlogThreshold_ <= 0.0 || duration < slowlogThreshold_)
+        return;
+    metrics.slowCommands->increment();
+    if (!shouldSample())
+        return;
+    RedisSlowlogEntry entry;
+    entry.time = trace.sendTime;
+    entry.command = trace.command;
+    entry.arguments = trace.arguments;
+    entry.duration = duration;
+    std::lock_guard<std::mutex> lock(slowlogMutex_);
+    slowlog_.emplace_back(std::move(entry));
+    while (slowlog_.size() > slowlogCapacity_)
+    {
+        slowlog_.pop_front();
+    }
+}
+
+void RedisClientMetrics::observeQueueWait(double seconds)
+{
+    queueWait_->observe(seconds);
+}
+
+std::vector<RedisSlowlogEntry> RedisClientMetrics::slowlog() const
+{
+    std::lock_guard<std::mutex> lock(slowlogMutex_);
+    return {slowlog_.begin(), slowlog_.end()};
+}
+
+bool RedisClientMetrics::shouldSample() const
+{
+    if (slowlogSampleRate_ >= 1.0)
+        return true;
+    if (slowlogSampleRate_ <= 0.0)
+        return false;
+    thread_local std::minstd_rand engine{std::random_device{}()};
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    return dist(engine) < slowlogSampleRate_;
+}
+
+std::string RedisClientMetrics::getCommandName(
+    std::string_view formattedCommand)
+{
+    std::string name;
+    forEachArgument(formattedCommand, [&name](std::string_view arg) {
+        name.assign(arg.data(), arg.size());
+        return false;
+    });
+    if (name.empty())
+        return "UNKNOWN";
+    std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+        return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    });
+    return name;
+}
+
+std::string RedisClientMetrics::getTruncatedArguments(
+    std::string_view formattedCommand,
+    size_t maxArgs,
+    size_t maxArgLength)
+{
+    std::string args;
+    size_t index = 0;
+    forEachArgument(formattedCommand, [&](std::string_view arg) {
+        if (index++ == 0)
+            return true;  // skip the command name
+        if (index > maxArgs + 1)
+        {
+            args.append(" ...");
+            return false;
+        }
+        if (!args.empty())
+            args.append(1, ' ');
+        if (arg.size() > maxArgLength)
+        {
+            args.append(arg.data(), maxArgLength);
+            args.append("...(")
+                .append(std::to_string(arg.size()))
+                .append(" bytes)");
+        }
+        else
+        {
+            args.append(arg.data(), arg.size());
+        }
+        return true;
+    });
+    return args;
+}
+
+size_t RedisClientMetrics::getReplySize(const redisReply *reply)
+{
+    switch (reply->type)
+    {
+        case REDIS_REPLY_STRING:
+            // $<len>\r\n<data>\r\n
+            return 1 + numberOfDigits(static_cast<long long>(reply->len)) +
+                   2 + reply->len + 2;
+        case REDIS_REPLY_STATUS:
+        case REDIS_REPLY_ERROR:
+            return 1 + reply->len + 2;
+        case REDIS_REPLY_INTEGER:
+            return 1 + numberOfDigits(reply->integer) + 2;
+        case REDIS_REPLY_NIL:
+            return 5;  // $-1\r\n
+        case REDIS_REPLY_ARRAY:
+        {
+            size_t size =
+                1 + numberOfDigits(static_cast<long long>(reply->elements)) +
+                2;
+            for (size_t i = 0; i < reply->elements; ++i)
+            {
+                size += getReplySize(reply->element[i]);
+            }
+            return size;
+        }
+        default:
+            return reply->len + 3;
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ *
+ *  @file RedisClientMetrics.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisClient.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct redisReply;
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief The information of a command that is waiting for its reply.
+ */
+struct RedisCommandTrace
+{
+    std::string command;
+    std::string arguments;
+    trantor::Date sendTime;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief This class records the metrics and the slowlog of a redis client, it
+ * is shared by the client and all its connections.
+ */
+class RedisClientMetrics : public trantor::NonCopyable
+{
+  public:
+    RedisClientMetrics(monitoring::Registry &registry,
+                       std::string clientName,
+                       double slowlogThreshold,
+                       double slowlogSampleRate,
+                       size_t slowlogCapacity);
+
+    /**
+     * @brief Called when a formatted command is written to a connection.
+     */
+    std::unique_ptr<RedisCommandTrace> startCommand(
+        const std::string &formattedCommand);
+
+    /**
+     * @brief Called when the reply of a traced command is received. The reply
+     * is nullptr if the connection is broken.
+     */
+    void finishCommand(const RedisCommandTrace &trace, const redisReply *reply);
+
+    void observeQueueWait(double seconds);
+
+    std::vector<RedisSlowlogEntry> slowlog() const;
+
+    /**
+     * @brief Get the name (the first token) of a command in the RESP format,
+     * the name is converted to upper case.
+     */
+    static std::string getCommandName(std::string_view formattedCommand);
+
+    /**
+     * @brief Get the arguments (without the name) of a command in the RESP
+     * format, every argument is truncated to maxArgLength bytes and at most
+     * maxArgs arguments are returned.
+     */
+    static std::string getTruncatedArguments(std::string_view formattedCommand,
+                                             size_t maxArgs = 8,
+                                             size_t maxArgLength = 32);
+
+    /**
+     * @brief Get the size of a reply in the RESP format.
+     */
+    static size_t getReplySize(const redisReply *reply);
+
+  private:
+    struct CommandMetrics
+    {
+        std::shared_ptr<monitoring::Histogram> duration;
+        std::shared_ptr<monitoring::Counter> sentBytes;
+        std::shared_ptr<monitoring::Counter> receivedBytes;
+        std::shared_ptr<monitoring::Counter> slowCommands;
+    };
+
+    const CommandMetrics &commandMetrics(const std::string &command);
+    bool shouldSample() const;
+
+    const std::string clientName_;
+    const double slowlogThreshold_;
+    const double slowlogSampleRate_;
+    const size_t slowlogCapacity_;
+    std::shared_ptr<monitoring::Histogram> queueWait_;
+    std::mutex metricsMutex_;
+    std::unordered_map<std::string, CommandMetrics> commandMetrics_;
+    mutable std::mutex slowlogMutex_;
+    std::deque<RedisSlowlogEntry> slowlog_;
+};
+
+using RedisClientMetricsPtr = std::shared_ptr<RedisClientMetrics>;
+}  // namespace nosql
+}  // namespace drogon
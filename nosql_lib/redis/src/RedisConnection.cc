@@ -252,6 +252,14 @@ void RedisConnection::handleDisconnect()
         }
         resultCallbacks_.pop();
         exceptionCallbacks_.pop();
+        if (!commandTraces_.empty())
+        {
+            if (commandTraces_.front() && metrics_)
+            {
+                metrics_->finishCommand(*commandTraces_.front(), nullptr);
+            }
+            commandTraces_.pop();
+        }
     }
     status_ = ConnectStatus::kEnd;
     channel_->disableAll();
@@ -320,6 +328,14 @@ void RedisConnection::sendCommandInLoop(
 {
     resultCallbacks_.emplace(std::move(resultCallback));
     exceptionCallbacks_.emplace(std::move(exceptionCallback));
+    if (metrics_)
+    {
+        commandTraces_.emplace(metrics_->startCommand(command));
+    }
+    else
+    {
+        commandTraces_.emplace(nullptr);
+    }
 
     redisAsyncFormattedCommand(
         redisContext_,
@@ -338,6 +354,12 @@ void RedisConnection::handleResult(redisReply *result)
     resultCallbacks_.pop();
     auto exceptionCallback = std::move(exceptionCallbacks_.front());
     exceptionCallbacks_.pop();
+    assert(!commandTraces_.empty());
+    if (commandTraces_.front() && metrics_)
+    {
+        metrics_->finishCommand(*commandTraces_.front(), result);
+    }
+    commandTraces_.pop();
     if (result && result->type != REDIS_REPLY_ERROR)
     {
         commandCallback(RedisResult(result));
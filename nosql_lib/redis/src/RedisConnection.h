@@ -25,8 +25,10 @@
 #include <hiredis/hiredis.h>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "SubscribeContext.h"
+#include "RedisClientMetrics.h"
 
 namespace drogon
 {
@@ -96,6 +98,37 @@ class RedisConnection : public trantor::NonCopyable,
         return fullCommand;
     }
 
+    /**
+     * @brief Format a command whose arguments are given one by one, the
+     * arguments are binary safe.
+     */
+    static std::string getFormattedCommand(
+        const std::vector<std::string> &argv) noexcept(false)
+    {
+        std::vector<const char *> args;
+        std::vector<size_t> argsLen;
+        args.reserve(argv.size());
+        argsLen.reserve(argv.size());
+        for (auto const &arg : argv)
+        {
+            args.push_back(arg.data());
+            argsLen.push_back(arg.size());
+        }
+        char *cmd{nullptr};
+        auto len = redisFormatCommandArgv(&cmd,
+                                          static_cast<int>(args.size()),
+                                          args.data(),
+                                          argsLen.data());
+        if (len < 0)
+        {
+            throw RedisException(RedisErrorCode::kInternalError,
+                                 "Out of memory");
+        }
+        std::string fullCommand{cmd, static_cast<size_t>(len)};
+        redisFreeCommand(cmd);
+        return fullCommand;
+    }
+
     void sendFormattedCommand(std::string &&command,
                               RedisResultCallback &&resultCallback,
                               RedisExceptionCallback &&exceptionCallback)
@@ -185,6 +218,15 @@ class RedisConnection : public trantor::NonCopyable,
         return loop_;
     }
 
+    /**
+     * @brief Set the metrics recorder, must be called in the loop thread of
+     * the connection.
+     */
+    void setMetrics(const RedisClientMetricsPtr &metrics)
+    {
+        metrics_ = metrics;
+    }
+
   private:
     redisAsyncContext *redisContext_{nullptr};
     const trantor::InetAddress serverAddr_;
@@ -199,6 +241,9 @@ class RedisConnection : public trantor::NonCopyable,
     std::function<void(const std::shared_ptr<RedisConnection> &)> idleCallback_;
     std::queue<RedisResultCallback> resultCallbacks_;
     std::queue<RedisExceptionCallback> exceptionCallbacks_;
+    // Null traces are pushed when the metrics are disabled
+    std::queue<std::unique_ptr<RedisCommandTrace>> commandTraces_;
+    RedisClientMetricsPtr metrics_;
     ConnectStatus status_{ConnectStatus::kNone};
 
     // used to keep the lifetime of context object
@@ -0,0 +1,452 @@
+/**
+ *
+ *  @file RedisStreamConsumerImpl.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisStreamConsumerImpl.h"
+#include <algorithm>
+
+using namespace drogon::nosql;
+
+RedisStreamConsumerImpl::RedisStreamConsumerImpl(
+    RedisStreamConsumerConfig config,
+    trantor::EventLoop *loop)
+    : config_(std::move(config)), loop_(loop)
+{
+    assert(loop_);
+    groupReady_ = !config_.createGroup;
+}
+
+RedisStreamConsumerImpl::~RedisStreamConsumerImpl()
+{
+    if (ackConn_ && !pendingAcks_.empty())
+    {
+        std::vector<std::string> argv{"XACK", config_.stream, config_.group};
+        argv.insert(argv.end(), pendingAcks_.begin(), pendingAcks_.end());
+        ackConn_->sendFormattedCommand(RedisConnection::getFormattedCommand(
+                                           argv),
+                                       [](const RedisResult &) {},
+                                       [](const RedisException &err) {
+                                           LOG_ERROR << err.what();
+                                       });
+    }
+    if (ackTimerId_ != trantor::InvalidTimerId)
+        loop_->invalidateTimer(ackTimerId_);
+    if (reclaimTimerId_ != trantor::InvalidTimerId)
+        loop_->invalidateTimer(reclaimTimerId_);
+    if (readConn_)
+        readConn_->disconnect();
+    if (ackConn_)
+        ackConn_->disconnect();
+}
+
+void RedisStreamConsumerImpl::setBatchCallback(
+    RedisStreamBatchCallback &&callback) noexcept
+{
+    loop_->runInLoop([thisPtr = shared_from_this(),
+                      callback = std::move(callback)]() mutable {
+        while (!thisPtr->batches_.empty())
+        {
+            auto batch = std::move(thisPtr->batches_.front());
+            thisPtr->batches_.pop_front();
+            callback(std::move(batch));
+        }
+        // A stopped consumer doesn't keep the callback, see stop()
+        if (!thisPtr->stopped_)
+            thisPtr->batchCallback_ = std::move(callback);
+    });
+}
+
+void RedisStreamConsumerImpl::fetchAsync(
+    RedisStreamBatchCallback &&callback) noexcept
+{
+    loop_->runInLoop([thisPtr = shared_from_this(),
+                      callback = std::move(callback)]() mutable {
+        if (!thisPtr->batches_.empty())
+        {
+            auto batch = std::move(thisPtr->batches_.front());
+            thisPtr->batches_.pop_front();
+            callback(std::move(batch));
+        }
+        else if (thisPtr->stopped_)
+        {
+            callback(RedisStreamBatch{});
+        }
+        else
+        {
+            thisPtr->fetchers_.emplace_back(std::move(callback));
+        }
+    });
+}
+
+void RedisStreamConsumerImpl::ack(const std::string &id) noexcept
+{
+    loop_->runInLoop([thisPtr = shared_from_this(), id]() {
+        auto wasFull = thisPtr->availableSlots() == 0;
+        if (thisPtr->inFlight_ > 0)
+            --thisPtr->inFlight_;
+        thisPtr->pendingAcks_.push_back(id);
+        if (thisPtr->pendingAcks_.size() >= thisPtr->config_.maxInFlight)
+        {
+            thisPtr->flushAcks();
+        }
+        else if (thisPtr->ackTimerId_ == trantor::InvalidTimerId)
+        {
+            std::weak_ptr<RedisStreamConsumerImpl> weakPtr = thisPtr;
+            thisPtr->ackTimerId_ =
+                thisPtr->loop_->runAfter(thisPtr->config_.ackInterval,
+                                         [weakPtr]() {
+                                             auto thisPtr = weakPtr.lock();
+                                             if (!thisPtr)
+                                                 return;
+                                             thisPtr->ackTimerId_ =
+                                                 trantor::InvalidTimerId;
+                                             thisPtr->flushAcks();
+                                         });
+        }
+        if (wasFull)
+        {
+            thisPtr->readNext();
+        }
+    });
+}
+
+void RedisStreamConsumerImpl::stop() noexcept
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->stopped_)
+            return;
+        thisPtr->stopped_ = true;
+        // The callback often owns the consumer, release it to break the cycle
+        auto batchCallback = std::move(thisPtr->batchCallback_);
+        thisPtr->batchCallback_ = nullptr;
+        thisPtr->flushAcks();
+        if (thisPtr->reclaimTimerId_ != trantor::InvalidTimerId)
+        {
+            thisPtr->loop_->invalidateTimer(thisPtr->reclaimTimerId_);
+            thisPtr->reclaimTimerId_ = trantor::InvalidTimerId;
+        }
+        while (!thisPtr->fetchers_.empty())
+        {
+            auto callback = std::move(thisPtr->fetchers_.front());
+            thisPtr->fetchers_.pop_front();
+            callback(RedisStreamBatch{});
+        }
+        if (thisPtr->readConn_)
+        {
+            thisPtr->readConn_->disconnect();
+        }
+        if (thisPtr->ackConn_)
+        {
+            thisPtr->ackConn_->disconnect();
+        }
+    });
+}
+
+void RedisStreamConsumerImpl::setConnection(const RedisConnectionPtr &conn,
+                                            bool isReader)
+{
+    loop_->assertInLoopThread();
+    if (isReader)
+    {
+        readConn_ = conn;
+        if (!groupReady_)
+            createGroup();
+        else
+            readNext();
+    }
+    else
+    {
+        ackConn_ = conn;
+        flushAcks();
+        if (config_.reclaimIdleTime > 0.0 &&
+            reclaimTimerId_ == trantor::InvalidTimerId)
+        {
+            std::weak_ptr<RedisStreamConsumerImpl> weakPtr =
+                shared_from_this();
+            reclaimTimerId_ =
+                loop_->runEvery(config_.reclaimInterval, [weakPtr]() {
+                    auto thisPtr = weakPtr.lock();
+                    if (thisPtr)
+                        thisPtr->reclaim();
+                });
+        }
+    }
+}
+
+void RedisStreamConsumerImpl::clearConnection(const RedisConnectionPtr &conn)
+{
+    loop_->assertInLoopThread();
+    if (conn == readConn_)
+    {
+        readConn_.reset();
+        reading_ = false;
+    }
+    else if (conn == ackConn_)
+    {
+        ackConn_.reset();
+        reclaiming_ = false;
+    }
+}
+
+void RedisStreamConsumerImpl::createGroup()
+{
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    readConn_->sendFormattedCommand(
+        RedisConnection::getFormattedCommand({"XGROUP",
+                                              "CREATE",
+                                              config_.stream,
+                                              config_.group,
+                                              "$",
+                                              "MKSTREAM"}),
+        [weakPtr](const RedisResult &) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->groupReady_ = true;
+            thisPtr->readNext();
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            if (err.code() == RedisErrorCode::kRedisError &&
+                std::string_view(err.what()).find("BUSYGROUP") !=
+                    std::string_view::npos)
+            {
+                thisPtr->groupReady_ = true;
+                thisPtr->readNext();
+                return;
+            }
+            LOG_ERROR << "Failed to create the consumer group "
+                      << thisPtr->config_.group << ": " << err.what();
+        });
+}
+
+void RedisStreamConsumerImpl::readNext()
+{
+    loop_->assertInLoopThread();
+    if (stopped_ || reading_ || !readConn_ || !groupReady_)
+        return;
+    auto count = std::min(config_.batchSize, availableSlots());
+    if (count == 0)
+        return;
+    reading_ = true;
+    auto blockMs = static_cast<long long>(config_.blockTime * 1000);
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    readConn_->sendFormattedCommand(
+        RedisConnection::getFormattedCommand({"XREADGROUP",
+                                              "GROUP",
+                                              config_.group,
+                                              config_.consumer,
+                                              "COUNT",
+                                              std::to_string(count),
+                                              "BLOCK",
+                                              std::to_string(blockMs),
+                                              "STREAMS",
+                                              config_.stream,
+                                              ">"}),
+        [weakPtr](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->reading_ = false;
+            thisPtr->handleReadResult(result);
+            thisPtr->readNext();
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->reading_ = false;
+            if (err.code() != RedisErrorCode::kRedisError)
+                return;  // The connection is broken and will be recreated
+            LOG_ERROR << "XREADGROUP error: " << err.what();
+            if (std::string_view(err.what()).find("NOGROUP") !=
+                    std::string_view::npos &&
+                thisPtr->config_.createGroup)
+            {
+                thisPtr->groupReady_ = false;
+            }
+            thisPtr->loop_->runAfter(1.0, [weakPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr || !thisPtr->readConn_)
+                    return;
+                if (!thisPtr->groupReady_)
+                    thisPtr->createGroup();
+                else
+                    thisPtr->readNext();
+            });
+        });
+}
+
+void RedisStreamConsumerImpl::handleReadResult(const RedisResult &result)
+{
+    // nil when BLOCK times out, otherwise [[stream, [[id, [f, v, ...]], ...]]]
+    if (result.isNil() || stopped_)
+        return;
+    RedisStreamBatch batch;
+    try
+    {
+        for (auto const &stream : result.asArray())
+        {
+            auto streamAndEntries = stream.asArray();
+            if (streamAndEntries.size() == 2)
+                parseEntries(streamAndEntries[1], batch);
+        }
+    }
+    catch (const std::exception &err)
+    {
+        LOG_ERROR << "Unexpected XREADGROUP reply: " << err.what();
+        return;
+    }
+    deliver(std::move(batch));
+}
+
+void RedisStreamConsumerImpl::reclaim()
+{
+    loop_->assertInLoopThread();
+    if (stopped_ || reclaiming_ || !ackConn_ || !groupReady_)
+        return;
+    auto count = std::min(config_.batchSize, availableSlots());
+    if (count == 0)
+        return;
+    reclaiming_ = true;
+    auto minIdleMs = static_cast<long long>(config_.reclaimIdleTime * 1000);
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    ackConn_->sendFormattedCommand(
+        RedisConnection::getFormattedCommand({"XAUTOCLAIM",
+                                              config_.stream,
+                                              config_.group,
+                                              config_.consumer,
+                                              std::to_string(minIdleMs),
+                                              reclaimCursor_,
+                                              "COUNT",
+                                              std::to_string(count)}),
+        [weakPtr](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->reclaiming_ = false;
+            thisPtr->handleReclaimResult(result);
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->reclaiming_ = false;
+            LOG_ERROR << "XAUTOCLAIM error: " << err.what();
+        });
+}
+
+void RedisStreamConsumerImpl::handleReclaimResult(const RedisResult &result)
+{
+    // [next-cursor, [[id, [f, v, ...]], ...], (deleted ids since redis 7)]
+    if (stopped_)
+        return;
+    RedisStreamBatch batch;
+    try
+    {
+        auto reply = result.asArray();
+        if (reply.size() < 2)
+            return;
+        reclaimCursor_ = reply[0].asString();
+        parseEntries(reply[1], batch);
+    }
+    catch (const std::exception &err)
+    {
+        LOG_ERROR << "Unexpected XAUTOCLAIM reply: " << err.what();
+        return;
+    }
+    if (!batch.empty())
+    {
+        LOG_DEBUG << "Reclaimed " << batch.size() << " messages from "
+                  << config_.stream;
+        deliver(std::move(batch));
+    }
+}
+
+void RedisStreamConsumerImpl::parseEntries(const RedisResult &entries,
+                                           RedisStreamBatch &batch)
+{
+    for (auto const &entry : entries.asArray())
+    {
+        // Deleted entries are returned as nil by XAUTOCLAIM before redis 7
+        if (entry.isNil())
+            continue;
+        auto idAndFields = entry.asArray();
+        if (idAndFields.size() != 2)
+            continue;
+        RedisStreamMessage message;
+        message.id = idAndFields[0].asString();
+        if (!idAndFields[1].isNil())
+        {
+            auto fields = idAndFields[1].asArray();
+            message.fields.reserve(fields.size() / 2);
+            for (size_t i = 0; i + 1 < fields.size(); i += 2)
+            {
+                message.fields.emplace_back(fields[i].asString(),
+                                            fields[i + 1].asString());
+            }
+        }
+        batch.emplace_back(std::move(message));
+    }
+}
+
+void RedisStreamConsumerImpl::deliver(RedisStreamBatch &&batch)
+{
+    if (batch.empty())
+        return;
+    inFlight_ += batch.size();
+    if (batchCallback_)
+    {
+        batchCallback_(std::move(batch));
+    }
+    else if (!fetchers_.empty())
+    {
+        auto callback = std::move(fetchers_.front());
+        fetchers_.pop_front();
+        callback(std::move(batch));
+    }
+    else
+    {
+        batches_.emplace_back(std::move(batch));
+    }
+}
+
+void RedisStreamConsumerImpl::flushAcks()
+{
+    loop_->assertInLoopThread();
+    if (pendingAcks_.empty() || !ackConn_)
+        return;
+    if (ackTimerId_ != trantor::InvalidTimerId)
+    {
+        loop_->invalidateTimer(ackTimerId_);
+        ackTimerId_ = trantor::InvalidTimerId;
+    }
+    std::vector<std::string> argv;
+    argv.reserve(pendingAcks_.size() + 3);
+    argv.emplace_back("XACK");
+    argv.emplace_back(config_.stream);
+    argv.emplace_back(config_.group);
+    for (auto &id : pendingAcks_)
+    {
+        argv.emplace_back(std::move(id));
+    }
+    pendingAcks_.clear();
+    ackConn_->sendFormattedCommand(RedisConnection::getFormattedCommand(argv),
+                                   [](const RedisResult &) {},
+                                   [](const RedisException &err) {
+                                       LOG_ERROR << "XACK error: "
+                                                 << err.what();
+                                   });
+}
@@ -0,0 +1,87 @@
+/**
+ *
+ *  @file RedisStreamConsumerImpl.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisStreamConsumer.h>
+#include "RedisConnection.h"
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon::nosql
+{
+class RedisStreamConsumerImpl
+    : public RedisStreamConsumer,
+      public std::enable_shared_from_this<RedisStreamConsumerImpl>
+{
+  public:
+    RedisStreamConsumerImpl(RedisStreamConsumerConfig config,
+                            trantor::EventLoop *loop);
+    ~RedisStreamConsumerImpl() override;
+
+    void setBatchCallback(
+        RedisStreamBatchCallback &&callback) noexcept override;
+    void fetchAsync(RedisStreamBatchCallback &&callback) noexcept override;
+    void ack(const std::string &id) noexcept override;
+    void stop() noexcept override;
+
+    bool stopped() const
+    {
+        return stopped_;
+    }
+
+    // Set a connected connection to the consumer, called in the loop.
+    void setConnection(const RedisConnectionPtr &conn, bool isReader);
+    // Clear a broken connection, called in the loop.
+    void clearConnection(const RedisConnectionPtr &conn);
+
+  private:
+    const RedisStreamConsumerConfig config_;
+    trantor::EventLoop *loop_;
+    RedisConnectionPtr readConn_;
+    RedisConnectionPtr ackConn_;
+    std::atomic<bool> stopped_{false};
+    bool groupReady_{false};
+    bool reading_{false};
+    bool reclaiming_{false};
+    size_t inFlight_{0};
+    std::string reclaimCursor_{"0-0"};
+    std::vector<std::string> pendingAcks_;
+    trantor::TimerId ackTimerId_{trantor::InvalidTimerId};
+    trantor::TimerId reclaimTimerId_{trantor::InvalidTimerId};
+    RedisStreamBatchCallback batchCallback_;
+    std::deque<RedisStreamBatch> batches_;
+    std::deque<RedisStreamBatchCallback> fetchers_;
+
+    size_t availableSlots() const
+    {
+        return inFlight_ >= config_.maxInFlight
+                   ? 0
+                   : config_.maxInFlight - inFlight_;
+    }
+
+    void createGroup();
+    void readNext();
+    void handleReadResult(const RedisResult &result);
+    void reclaim();
+    void handleReclaimResult(const RedisResult &result);
+    void deliver(RedisStreamBatch &&batch);
+    void flushAcks();
+    static void parseEntries(const RedisResult &entries,
+                             RedisStreamBatch &batch);
+};
+}  // namespace drogon::nosql
@@ -42,6 +42,14 @@ class RedisTransactionImpl final
         return nullptr;
     }
 
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig & /*config*/) noexcept override
+    {
+        LOG_ERROR << "You can't create stream consumer from redis transaction";
+        assert(0);
+        return nullptr;
+    }
+
     std::shared_ptr<RedisTransaction> newTransaction() override
     {
         return shared_from_this();
@@ -0,0 +1,175 @@
+/**
+ * Compares consuming a redis stream one message at a time (XREADGROUP COUNT 1
+ * followed by an XACK per message) with the batched RedisStreamConsumer.
+ *
+ * Usage: redis_stream_bench [number of messages] [batch size]
+ */
+#include <drogon/nosql/RedisClient.h>
+#include <drogon/drogon.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace drogon::nosql;
+using namespace std::chrono_literals;
+
+namespace
+{
+const char *streamKey = "drogon_bench_stream";
+const char *groupName = "drogon_bench_group";
+
+void prepareStream(const RedisClientPtr &client, size_t count)
+{
+    client->execCommandSync([](const RedisResult &r) { return r.asInteger(); },
+                            "del %s",
+                            streamKey);
+    client->execCommandSync([](const RedisResult &r) { return r.asString(); },
+                            "xgroup create %s %s $ MKSTREAM",
+                            streamKey,
+                            groupName);
+    std::promise<void> pro;
+    auto f = pro.get_future();
+    auto left = std::make_shared<std::atomic<size_t>>(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        client->execCommandAsync(
+            [left, &pro](const RedisResult &) {
+                if (--(*left) == 0)
+                    pro.set_value();
+            },
+            [](const RedisException &err) { LOG_ERROR << err.what(); },
+            "xadd %s * index %d payload %s",
+            streamKey,
+            static_cast<int>(i),
+            "0123456789abcdef0123456789abcdef");
+    }
+    f.get();
+}
+
+struct NaiveConsumer : public std::enable_shared_from_this<NaiveConsumer>
+{
+    RedisClientPtr client;
+    size_t left{0};
+    std::promise<void> done;
+
+    void readNext()
+    {
+        if (left == 0)
+        {
+            done.set_value();
+            return;
+        }
+        auto thisPtr = shared_from_this();
+        client->execCommandAsync(
+            [thisPtr](const RedisResult &r) {
+                if (r.isNil())
+                {
+                    thisPtr->readNext();
+                    return;
+                }
+                auto entries = r.asArray()[0].asArray()[1].asArray();
+                auto id = entries[0].asArray()[0].asString();
+                thisPtr->client->execCommandAsync(
+                    [thisPtr](const RedisResult &) {
+                        --thisPtr->left;
+                        thisPtr->readNext();
+                    },
+                    [](const RedisException &err) {
+                        LOG_ERROR << err.what();
+                    },
+                    "xack %s %s %s",
+                    streamKey,
+                    groupName,
+                    id.c_str());
+            },
+            [](const RedisException &err) { LOG_ERROR << err.what(); },
+            "xreadgroup group %s naive count 1 block 1000 streams %s >",
+            groupName,
+            streamKey);
+    }
+};
+
+double runNaive(const RedisClientPtr &client, size_t count)
+{
+    prepareStream(client, count);
+    auto consumer = std::make_shared<NaiveConsumer>();
+    consumer->client = client;
+    consumer->left = count;
+    auto f = consumer->done.get_future();
+    auto start = std::chrono::steady_clock::now();
+    consumer->readNext();
+    f.get();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+double runBatched(const RedisClientPtr &client, size_t count, size_t batch)
+{
+    prepareStream(client, count);
+    RedisStreamConsumerConfig config;
+    config.stream = streamKey;
+    config.group = groupName;
+    config.consumer = "batched";
+    config.batchSize = batch;
+    config.maxInFlight = batch * 4;
+    auto consumer = client->newStreamConsumer(config);
+    std::promise<void> done;
+    auto f = done.get_future();
+    size_t received = 0;
+    auto start = std::chrono::steady_clock::now();
+    consumer->setBatchCallback(
+        [&, consumer](RedisStreamBatch &&messages) {
+            for (auto &msg : messages)
+            {
+                consumer->ack(msg.id);
+            }
+            received += messages.size();
+            if (received == count)
+                done.set_value();
+        });
+    f.get();
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    consumer->stop();
+    return elapsed;
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t batch = argc > 2 ? std::stoul(argv[2]) : 100;
+    trantor::Logger::setLogLevel(trantor::Logger::kWarn);
+
+    std::thread thr([]() { drogon::app().run(); });
+    while (!drogon::app().isRunning())
+        std::this_thread::sleep_for(10ms);
+
+    auto client =
+        RedisClient::newRedisClient(trantor::InetAddress("127.0.0.1", 6379), 1);
+    try
+    {
+        auto naive = runNaive(client, count);
+        std::cout << "one at a time: " << count / naive << " msgs/s"
+                  << std::endl;
+        auto batched = runBatched(client, count, batch);
+        std::cout << "batched (" << batch << "): " << count / batched
+                  << " msgs/s, " << naive / batched << "x" << std::endl;
+        client->execCommandSync(
+            [](const RedisResult &r) { return r.asInteger(); },
+            "del %s",
+            streamKey);
+    }
+    catch (const RedisException &err)
+    {
+        std::cerr << err.what() << std::endl;
+    }
+
+    drogon::app().getLoop()->queueInLoop([]() { drogon::app().quit(); });
+    thr.join();
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <drogon/nosql/RedisClient.h>
 #include <drogon/drogon_test.h>
 #include <drogon/drogon.h>
+#include <drogon/utils/monitoring/Collector.h>
 #include <iostream>
 #include <thread>
 
@@ -183,6 +184,156 @@ DROGON_TEST(RedisTest)
     }
 }
 
+class TestRegistry : public drogon::monitoring::Registry
+{
+  public:
+    void registerCollector(
+        const std::shared_ptr<drogon::monitoring::CollectorBase> &collector)
+        override
+    {
+        collectors_.push_back(collector);
+    }
+
+    std::shared_ptr<drogon::monitoring::CollectorBase> find(
+        const std::string &name) const
+    {
+        for (auto &collector : collectors_)
+        {
+            if (collector->name() == name)
+                return collector;
+        }
+        return nullptr;
+    }
+
+  private:
+    std::vector<std::shared_ptr<drogon::monitoring::CollectorBase>>
+        collectors_;
+};
+
+DROGON_TEST(RedisMetricsTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    TestRegistry registry;
+    client->enableMetrics(registry, "metrics_test", 0.05);
+    try
+    {
+        client->execCommandSync([](const RedisResult &r) { return r.isNil(); },
+                                "blpop %s %s",
+                                "metrics_not_exists",
+                                "0.1");
+        client->execCommandSync(
+            [](const RedisResult &r) { return r.asString(); }, "ping");
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+    auto slowlog = client->getSlowlog();
+    MANDATE(slowlog.size() == 1UL);
+    CHECK(slowlog[0].command == "BLPOP");
+    CHECK(slowlog[0].arguments == "metrics_not_exists 0.1");
+    CHECK(slowlog[0].duration >= 0.05);
+
+    auto collector = registry.find("redis_command_duration_seconds");
+    MANDATE(collector != nullptr);
+    size_t commands = 0;
+    for (auto &group : collector->collect())
+    {
+        for (auto &label : group.metric->labels())
+        {
+            if (label.first == "client" && label.second == "metrics_test")
+                ++commands;
+        }
+    }
+    CHECK(commands == 2UL);
+    CHECK(registry.find("redis_queue_wait_seconds") != nullptr);
+    CHECK(registry.find("redis_sent_bytes_total") != nullptr);
+    CHECK(registry.find("redis_received_bytes_total") != nullptr);
+    CHECK(registry.find("redis_slow_commands_total") != nullptr);
+}
+
+DROGON_TEST(RedisStreamConsumerTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    try
+    {
+        client->execCommandSync(
+            [](const RedisResult &r) { return r.asInteger(); },
+            "del %s",
+            "drogon_test_stream");
+        client->execCommandSync(
+            [](const RedisResult &r) { return r.asString(); },
+            "xgroup create %s %s $ MKSTREAM",
+            "drogon_test_stream",
+            "drogon_test_group");
+        for (int i = 0; i < 10; ++i)
+        {
+            client->execCommandSync(
+                [](const RedisResult &r) { return r.asString(); },
+                "xadd %s * index %d",
+                "drogon_test_stream",
+                i);
+        }
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+
+    RedisStreamConsumerConfig config;
+    config.stream = "drogon_test_stream";
+    config.group = "drogon_test_group";
+    config.consumer = "consumer1";
+    config.batchSize = 4;
+    config.blockTime = 0.1;
+    auto consumer = client->newStreamConsumer(config);
+    MANDATE(consumer != nullptr);
+
+    size_t received = 0;
+    while (received < 10)
+    {
+        std::promise<RedisStreamBatch> pro;
+        auto f = pro.get_future();
+        consumer->fetchAsync([&pro](RedisStreamBatch &&batch) {
+            pro.set_value(std::move(batch));
+        });
+        MANDATE(f.wait_for(5s) == std::future_status::ready);
+        auto batch = f.get();
+        MANDATE(!batch.empty());
+        CHECK(batch.size() <= 4UL);
+        for (auto &msg : batch)
+        {
+            MANDATE(msg.fields.size() == 1UL);
+            CHECK(msg.fields[0].first == "index");
+            CHECK(msg.fields[0].second == std::to_string(received));
+            ++received;
+            consumer->ack(msg.id);
+        }
+    }
+    CHECK(received == 10UL);
+    consumer->stop();
+
+    // All the acknowledgements are flushed by stop()
+    std::this_thread::sleep_for(200ms);
+    auto pending = client->execCommandSync(
+        [](const RedisResult &r) { return r.asArray()[0].asInteger(); },
+        "xpending %s %s",
+        "drogon_test_stream",
+        "drogon_test_group");
+    CHECK(pending == 0);
+
+    std::promise<size_t> pro;
+    auto f = pro.get_future();
+    consumer->fetchAsync(
+        [&pro](RedisStreamBatch &&batch) { pro.set_value(batch.size()); });
+    CHECK(f.get() == 0UL);
+    client->execCommandSync([](const RedisResult &r) { return r.asInteger(); },
+                            "del %s",
+                            "drogon_test_stream");
+}
+
 int main(int argc, char **argv)
 {
 #ifndef USE_REDIS
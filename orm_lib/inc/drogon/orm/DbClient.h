@@ -117,12 +117,20 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
      * 'filename'.
      *
      * @param connNum: The number of connections to database server;
+     * @param autoBatch: With PostgreSQL, queries are sent in pipeline mode.
+     * With MySQL, the connections are opened with CLIENT_MULTI_STATEMENTS and
+     * the statements queued in the client are sent to the server in one
+     * multi-statement query, each statement still gets its own result or
+     * exception.
+     * @note Enabling autoBatch on MySQL lets any SQL string with several
+     * statements be executed, so never build SQL strings from user input.
      */
     static std::shared_ptr<DbClient> newPgClient(const std::string &connInfo,
                                                  size_t connNum,
                                                  bool autoBatch = false);
     static std::shared_ptr<DbClient> newMysqlClient(const std::string &connInfo,
-                                                    size_t connNum);
+                                                    size_t connNum,
+                                                    bool autoBatch = false);
     static std::shared_ptr<DbClient> newSqlite3Client(
         const std::string &connInfo,
         size_t connNum);
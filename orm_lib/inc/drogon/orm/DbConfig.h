@@ -48,6 +48,7 @@ struct MysqlConfig
     bool isFast;
     std::string characterSet;
     double timeout;
+    bool autoBatch;
 };
 
 struct Sqlite3Config
@@ -37,12 +37,8 @@ std::shared_ptr<DbClient> DbClient::newPgClient(const std::string &connInfo,
 #if USE_POSTGRESQL
     auto client = std::make_shared<DbClientImpl>(connInfo,
                                                  connNum,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                                                  ClientType::PostgreSQL,
                                                  autoBatch);
-#else
-                                                 ClientType::PostgreSQL);
-#endif
     client->init();
     return client;
 #else
@@ -50,21 +46,19 @@ std::shared_ptr<DbClient> DbClient::newPgClient(const std::string &connInfo,
     exit(1);
     (void)(connInfo);
     (void)(connNum);
+    (void)(autoBatch);
 #endif
 }
 
 std::shared_ptr<DbClient> DbClient::newMysqlClient(const std::string &connInfo,
-                                                   size_t connNum)
+                                                   size_t connNum,
+                                                   bool autoBatch)
 {
 #if USE_MYSQL
     auto client = std::make_shared<DbClientImpl>(connInfo,
                                                  connNum,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                                                  ClientType::Mysql,
-                                                 false);
-#else
-                                                 ClientType::Mysql);
-#endif
+                                                 autoBatch);
     client->init();
     return client;
 #else
@@ -72,6 +66,7 @@ std::shared_ptr<DbClient> DbClient::newMysqlClient(const std::string &connInfo,
     exit(1);
     (void)(connInfo);
     (void)(connNum);
+    (void)(autoBatch);
 #endif
 }
 
@@ -82,12 +77,8 @@ std::shared_ptr<DbClient> DbClient::newSqlite3Client(
 #if USE_SQLITE3
     auto client = std::make_shared<DbClientImpl>(connInfo,
                                                  connNum,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                                                  ClientType::Sqlite3,
                                                  false);
-#else
-                                                 ClientType::Sqlite3);
-#endif
     client->init();
     return client;
 #else
@@ -49,22 +49,16 @@ using namespace drogon::orm;
 
 DbClientImpl::DbClientImpl(const std::string &connInfo,
                            size_t connNum,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                            ClientType type,
                            bool autoBatch)
-#else
-                           ClientType type)
-#endif
     : numberOfConnections_(connNum),
-#if LIBPQ_SUPPORTS_BATCH_MODE
-      autoBatch_(autoBatch),
-#endif
       loops_(type == ClientType::Sqlite3
                  ? 1
                  : (connNum < std::thread::hardware_concurrency()
                         ? connNum
                         : std::thread::hardware_concurrency()),
-             "DbLoop")
+             "DbLoop"),
+      autoBatch_(autoBatch)
 {
     type_ = type;
     connectionInfo_ = connInfo;
@@ -337,6 +331,7 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
 {
     std::function<void(const std::shared_ptr<Transaction> &)> transCallback;
     std::shared_ptr<SqlCmd> cmd;
+    std::deque<std::shared_ptr<SqlCmd>> cmds;
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
         if (!transCallbacks_.empty())
@@ -346,8 +341,15 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
         }
         else if (!sqlCmdBuffer_.empty())
         {
-            cmd = std::move(sqlCmdBuffer_.front());
-            sqlCmdBuffer_.pop_front();
+#if USE_MYSQL
+            if (autoBatch_ && type_ == ClientType::Mysql)
+                cmds = MysqlConnection::takeBatch(sqlCmdBuffer_);
+            if (cmds.empty())
+#endif
+            {
+                cmd = std::move(sqlCmdBuffer_.front());
+                sqlCmdBuffer_.pop_front();
+            }
         }
         else
         {
@@ -361,6 +363,11 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
         makeTrans(connPtr, std::move(transCallback));
         return;
     }
+    if (!cmds.empty())
+    {
+        connPtr->batchSql(std::move(cmds));
+        return;
+    }
     if (cmd)
     {
         connPtr->execSql(std::move(cmd->sql_),
@@ -393,7 +400,9 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     else if (type_ == ClientType::Mysql)
     {
 #if USE_MYSQL
-        connPtr = std::make_shared<MysqlConnection>(loop, connectionInfo_);
+        connPtr = std::make_shared<MysqlConnection>(loop,
+                                                    connectionInfo_,
+                                                    autoBatch_);
 #else
         return nullptr;
 #endif
@@ -482,6 +491,12 @@ bool DbClientImpl::hasAvailableConnections() const noexcept
     return (!readyConnections_.empty()) || (!busyConnections_.empty());
 }
 
+size_t DbClientImpl::availableConnectionsNumber() const noexcept
+{
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    return readyConnections_.size() + busyConnections_.size();
+}
+
 void DbClientImpl::execSqlWithTimeout(
     const char *sql,
     size_t sqlLength,
@@ -34,12 +34,8 @@ class DbClientImpl : public DbClient,
   public:
     DbClientImpl(const std::string &connInfo,
                  size_t connNum,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                  ClientType type,
                  bool autoBatch);
-#else
-                 ClientType type);
-#endif
     ~DbClientImpl() noexcept override;
     void execSql(const char *sql,
                  size_t sqlLength,
@@ -58,6 +54,19 @@ class DbClientImpl : public DbClient,
             &callback) override;
     bool hasAvailableConnections() const noexcept override;
 
+    // The number of established connections
+    size_t availableConnectionsNumber() const noexcept;
+
+    size_t connectionsNumber() const noexcept
+    {
+        return numberOfConnections_;
+    }
+
+    std::vector<trantor::EventLoop *> getLoops() const
+    {
+        return loops_.getLoops();
+    }
+
     void setTimeout(double timeout) override
     {
         timeout_ = timeout;
@@ -71,9 +80,7 @@ class DbClientImpl : public DbClient,
     trantor::EventLoopThreadPool loops_;
     std::shared_ptr<SharedMutex> sharedMutexPtr_;
     double timeout_{-1.0};
-#if LIBPQ_SUPPORTS_BATCH_MODE
     bool autoBatch_{false};
-#endif
     DbConnectionPtr newConnection(trantor::EventLoop *loop);
 
     void makeTrans(
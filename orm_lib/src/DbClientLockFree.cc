@@ -44,18 +44,12 @@ using namespace drogon::orm;
 DbClientLockFree::DbClientLockFree(const std::string &connInfo,
                                    trantor::EventLoop *loop,
                                    ClientType type,
-#if LIBPQ_SUPPORTS_BATCH_MODE
                                    size_t connectionNumberPerLoop,
                                    bool autoBatch)
-#else
-                                   size_t connectionNumberPerLoop)
-#endif
     : connectionInfo_(connInfo),
       loop_(loop),
-#if LIBPQ_SUPPORTS_BATCH_MODE
-      autoBatch_(autoBatch),
-#endif
-      numberOfConnections_(connectionNumberPerLoop)
+      numberOfConnections_(connectionNumberPerLoop),
+      autoBatch_(autoBatch)
 {
     type_ = type;
     LOG_TRACE << "type=" << (int)type;
@@ -368,6 +362,17 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
 
     if (!sqlCmdBuffer_.empty())
     {
+#if USE_MYSQL
+        if (autoBatch_ && type_ == ClientType::Mysql)
+        {
+            auto cmds = MysqlConnection::takeBatch(sqlCmdBuffer_);
+            if (!cmds.empty())
+            {
+                conn->batchSql(std::move(cmds));
+                return;
+            }
+        }
+#endif
 #if LIBPQ_SUPPORTS_BATCH_MODE
         if (type_ != ClientType::PostgreSQL)
         {
@@ -422,7 +427,9 @@ DbConnectionPtr DbClientLockFree::newConnection()
     else if (type_ == ClientType::Mysql)
     {
 #if USE_MYSQL
-        connPtr = std::make_shared<MysqlConnection>(loop_, connectionInfo_);
+        connPtr = std::make_shared<MysqlConnection>(loop_,
+                                                    connectionInfo_,
+                                                    autoBatch_);
 #else
         return nullptr;
 #endif
@@ -13,6 +13,7 @@
  */
 
 #include "../../lib/src/DbClientManager.h"
+#include "DbClientImpl.h"
 #include "DbClientLockFree.h"
 #include <drogon/config.h>
 #include <drogon/HttpAppFramework.h>
@@ -57,12 +58,8 @@ static void initFastDbClients(IOThreadStorage<orm::DbClientPtr> &storage,
             new drogon::orm::DbClientLockFree(connInfo,
                                               ioLoops[idx],
                                               dbType,
-#if LIBPQ_SUPPORTS_BATCH_MODE  // Bad code
                                               connNum,
                                               autoBatch));
-#else
-                                              connNum));
-#endif
         if (timeout > 0.0)
         {
             c->setTimeout(timeout);
@@ -117,13 +114,15 @@ void DbClientManager::createDbClients(
                                   dbInfo.connectionInfo_,
                                   ClientType::Mysql,
                                   cfg.connectionNumber,
-                                  false,
+                                  cfg.autoBatch,
                                   cfg.timeout);
             }
             else
             {
                 dbClientsMap_[cfg.name] = drogon::orm::DbClient::newMysqlClient(
-                    dbInfo.connectionInfo_, cfg.connectionNumber);
+                    dbInfo.connectionInfo_,
+                    cfg.connectionNumber,
+                    cfg.autoBatch);
                 if (cfg.timeout > 0.0)
                 {
                     dbClientsMap_[cfg.name]->setTimeout(cfg.timeout);
@@ -261,6 +260,32 @@ bool DbClientManager::areAllDbClientsAvailable() const noexcept
     return true;
 }
 
+bool DbClientManager::areAllDbClientsWarmedUp(
+    size_t minConnections) const noexcept
+{
+    for (auto const &pair : dbClientsMap_)
+    {
+        // The clients in the map are created by DbClient::newXxxClient()
+        auto client = static_cast<DbClientImpl *>(pair.second.get());
+        if (client->availableConnectionsNumber() <
+            (std::min)(minConnections, client->connectionsNumber()))
+            return false;
+    }
+    return true;
+}
+
+std::vector<trantor::EventLoop *> DbClientManager::getClientLoops() const
+{
+    std::vector<trantor::EventLoop *> loops;
+    for (auto const &pair : dbClientsMap_)
+    {
+        auto clientLoops =
+            static_cast<DbClientImpl *>(pair.second.get())->getLoops();
+        loops.insert(loops.end(), clientLoops.begin(), clientLoops.end());
+    }
+    return loops;
+}
+
 DbClientManager::~DbClientManager()
 {
     for (auto &pair : dbClientsMap_)
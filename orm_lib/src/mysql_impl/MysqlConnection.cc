@@ -48,13 +48,74 @@ Result makeResult(std::shared_ptr<MYSQL_RES> &&r = nullptr,
 }  // namespace orm
 }  // namespace drogon
 
+// The limits of a multi-statement query, far below the default
+// max_allowed_packet of the server.
+static const size_t kMaxBatchStatements{128};
+static const size_t kMaxBatchBytes{512 * 1024};
+
+static std::string_view trimStatement(std::string_view sql)
+{
+    while (!sql.empty() && (sql.back() == ';' ||
+                            isspace(static_cast<unsigned char>(sql.back()))))
+        sql.remove_suffix(1);
+    return sql;
+}
+
+static bool isBatchable(std::string_view sql)
+{
+    sql = trimStatement(sql);
+    // Several statements in one string can't be told apart from the others
+    // of the batch.
+    if (sql.empty() || sql.find(';') != std::string_view::npos)
+        return false;
+    while (!sql.empty() && isspace(static_cast<unsigned char>(sql.front())))
+        sql.remove_prefix(1);
+    // Stored procedures return an extra result
+    if (sql.size() >= 5 && isspace(static_cast<unsigned char>(sql[4])))
+    {
+        std::string keyword(sql.substr(0, 4));
+        std::transform(keyword.begin(),
+                       keyword.end(),
+                       keyword.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (keyword == "call")
+            return false;
+    }
+    return true;
+}
+
+std::deque<std::shared_ptr<SqlCmd>> MysqlConnection::takeBatch(
+    std::deque<std::shared_ptr<SqlCmd>> &buffer)
+{
+    std::deque<std::shared_ptr<SqlCmd>> batch;
+    size_t bytes{0};
+    while (!buffer.empty() && batch.size() < kMaxBatchStatements &&
+           bytes < kMaxBatchBytes && isBatchable(buffer.front()->sql_))
+    {
+        auto &cmd = buffer.front();
+        bytes += cmd->sql_.length();
+        for (auto len : cmd->lengths_)
+            bytes += len;
+        batch.push_back(std::move(cmd));
+        buffer.pop_front();
+    }
+    if (batch.size() == 1)
+    {
+        buffer.push_front(std::move(batch.front()));
+        batch.clear();
+    }
+    return batch;
+}
+
 MysqlConnection::MysqlConnection(trantor::EventLoop *loop,
-                                 const std::string &connInfo)
+                                 const std::string &connInfo,
+                                 bool autoBatch)
     : DbConnection(loop),
       mysqlPtr_(std::shared_ptr<MYSQL>(new MYSQL, [](MYSQL *p) {
           mysql_close(p);
           delete p;
-      }))
+      })),
+      autoBatch_(autoBatch)
 {
     static MysqlEnv env;
     static thread_local MysqlThreadEnv threadEnv;
@@ -119,7 +180,7 @@ void MysqlConnection::init()
                                                      : dbname_.c_str(),
                                      port_.empty() ? 3306 : atol(port_.c_str()),
                                      nullptr,
-                                     0);
+                                     autoBatch_ ? CLIENT_MULTI_STATEMENTS : 0);
         // LOG_DEBUG << ret;
         auto fd = mysql_get_socket(mysqlPtr_.get());
         if (fd < 0)
@@ -444,7 +505,19 @@ void MysqlConnection::execSqlInLoop(
     callback_ = std::move(rcb);
     isWorking_ = true;
     exceptionCallback_ = std::move(exceptCallback);
-    sql_.clear();
+    sql_ = buildSql(sql, paraNum, parameters, length, format);
+    startQuery();
+    setChannel();
+}
+
+std::string MysqlConnection::buildSql(
+    const std::string_view &sql,
+    size_t paraNum,
+    const std::vector<const char *> &parameters,
+    const std::vector<int> &length,
+    const std::vector<int> &format)
+{
+    std::string query;
     if (paraNum > 0)
     {
         std::string::size_type pos = 0;
@@ -455,49 +528,49 @@ void MysqlConnection::execSqlInLoop(
             if (seekPos == std::string::npos)
             {
                 auto sub = sql.substr(pos);
-                sql_.append(sub.data(), sub.length());
+                query.append(sub.data(), sub.length());
                 pos = seekPos;
                 break;
             }
             else
             {
                 auto sub = sql.substr(pos, seekPos - pos);
-                sql_.append(sub.data(), sub.length());
+                query.append(sub.data(), sub.length());
                 pos = seekPos + 1;
                 switch (format[i])
                 {
                     case internal::MySqlTiny:
-                        sql_.append(std::to_string(*((char *)parameters[i])));
+                        query.append(std::to_string(*((char *)parameters[i])));
                         break;
                     case internal::MySqlShort:
-                        sql_.append(std::to_string(*((short *)parameters[i])));
+                        query.append(std::to_string(*((short *)parameters[i])));
                         break;
                     case internal::MySqlLong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((int32_t *)parameters[i])));
                         break;
                     case internal::MySqlLongLong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((int64_t *)parameters[i])));
                         break;
                     case internal::MySqlNull:
-                        sql_.append("NULL");
+                        query.append("NULL");
                         break;
                     case internal::MySqlString:
                     {
-                        sql_.append("'");
+                        query.append("'");
                         std::string to(length[i] * 2, '\0');
                         auto len = mysql_real_escape_string(mysqlPtr_.get(),
                                                             (char *)to.c_str(),
                                                             parameters[i],
                                                             length[i]);
                         to.resize(len);
-                        sql_.append(to);
-                        sql_.append("'");
+                        query.append(to);
+                        query.append("'");
                     }
                     break;
                     case internal::DrogonDefaultValue:
-                        sql_.append("default");
+                        query.append("default");
                         break;
                     default:
                         LOG_FATAL
@@ -510,17 +583,69 @@ void MysqlConnection::execSqlInLoop(
         if (pos < sql.length())
         {
             auto sub = sql.substr(pos);
-            sql_.append(sub.data(), sub.length());
+            query.append(sub.data(), sub.length());
         }
     }
     else
     {
-        sql_ = std::string(sql.data(), sql.length());
+        query = std::string(sql.data(), sql.length());
+    }
+    return query;
+}
+
+void MysqlConnection::batchSqlInLoop(
+    std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
+{
+    assert(!isWorking_);
+    assert(!sqlCommands.empty());
+    if (status_ != ConnectStatus::Ok)
+    {
+        LOG_ERROR << "Connection is not ready";
+        auto exceptPtr =
+            std::make_exception_ptr(drogon::orm::BrokenConnection());
+        for (auto &cmd : sqlCommands)
+        {
+            cmd->exceptionCallback_(exceptPtr);
+        }
+        return;
+    }
+    isWorking_ = true;
+    batchCommands_ = std::move(sqlCommands);
+    sendBatch();
+}
+
+void MysqlConnection::sendBatch()
+{
+    sql_.clear();
+    for (auto &cmd : batchCommands_)
+    {
+        auto query = buildSql(cmd->sql_,
+                              cmd->parametersNumber_,
+                              cmd->parameters_,
+                              cmd->lengths_,
+                              cmd->formats_);
+        auto statement = trimStatement(query);
+        // The newline ends a trailing '-- ' or '#' comment, which would
+        // otherwise swallow the following statements.
+        if (!sql_.empty())
+            sql_.append("\n;");
+        sql_.append(statement.data(), statement.length());
     }
+    LOG_TRACE << "batch of " << batchCommands_.size() << ":" << sql_;
     startQuery();
     setChannel();
 }
 
+void MysqlConnection::failBatch(const std::exception_ptr &exceptPtr)
+{
+    auto commands = std::move(batchCommands_);
+    batchCommands_.clear();
+    for (auto &cmd : commands)
+    {
+        cmd->exceptionCallback_(exceptPtr);
+    }
+}
+
 void MysqlConnection::outputError()
 {
     channelPtr_->disableAll();
@@ -528,7 +653,33 @@ void MysqlConnection::outputError()
     LOG_ERROR << "Error(" << errorNo << ") [" << mysql_sqlstate(mysqlPtr_.get())
               << "] \"" << mysql_error(mysqlPtr_.get()) << "\"";
     LOG_ERROR << "sql:" << sql_;
-    if (isWorking_)
+    bool lost = (errorNo == CR_SERVER_GONE_ERROR || errorNo == CR_SERVER_LOST);
+    if (isWorking_ && !batchCommands_.empty())
+    {
+        // The failed statement is the one waiting for the next result
+        auto cmd = std::move(batchCommands_.front());
+        batchCommands_.pop_front();
+        cmd->exceptionCallback_(std::make_exception_ptr(
+            SqlError(mysql_error(mysqlPtr_.get()), std::string(cmd->sql_))));
+        if (lost)
+        {
+            failBatch(std::make_exception_ptr(
+                SqlError(mysql_error(mysqlPtr_.get()), sql_)));
+            isWorking_ = false;
+        }
+        else if (!batchCommands_.empty())
+        {
+            // The server stops at the failed statement, send the rest again.
+            sendBatch();
+            return;
+        }
+        else
+        {
+            isWorking_ = false;
+            idleCb_();
+        }
+    }
+    else if (isWorking_)
     {
         // TODO: exception type
         auto exceptPtr = std::make_exception_ptr(
@@ -538,12 +689,12 @@ void MysqlConnection::outputError()
 
         callback_ = nullptr;
         isWorking_ = false;
-        if (errorNo != CR_SERVER_GONE_ERROR && errorNo != CR_SERVER_LOST)
+        if (!lost)
         {
             idleCb_();
         }
     }
-    if (errorNo == CR_SERVER_GONE_ERROR || errorNo == CR_SERVER_LOST)
+    if (lost)
     {
         handleClosed();
     }
@@ -618,9 +769,24 @@ void MysqlConnection::getResult(MYSQL_RES *res)
                              mysql_insert_id(mysqlPtr_.get()));
     if (isWorking_)
     {
-        callback_(Result);
+        if (!batchCommands_.empty())
+        {
+            auto cmd = std::move(batchCommands_.front());
+            batchCommands_.pop_front();
+            cmd->callback_(Result);
+        }
+        else
+        {
+            callback_(Result);
+        }
         if (!mysql_more_results(mysqlPtr_.get()))
         {
+            if (!batchCommands_.empty())
+            {
+                LOG_ERROR << "Less results than statements in the batch";
+                failBatch(std::make_exception_ptr(
+                    SqlError("Missing result of a batched statement", sql_)));
+            }
             callback_ = nullptr;
             exceptionCallback_ = nullptr;
             isWorking_ = false;
@@ -19,6 +19,7 @@
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/Channel.h>
 #include <trantor/utils/NonCopyable.h>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -36,7 +37,9 @@ class MysqlConnection : public DbConnection,
                         public std::enable_shared_from_this<MysqlConnection>
 {
   public:
-    MysqlConnection(trantor::EventLoop *loop, const std::string &connInfo);
+    MysqlConnection(trantor::EventLoop *loop,
+                    const std::string &connInfo,
+                    bool autoBatch = false);
 
     void init() override;
 
@@ -86,12 +89,43 @@ class MysqlConnection : public DbConnection,
         }
     }
 
-    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&) override
+    /**
+     * @brief Execute the statements in one multi-statement query, every
+     * statement gets its own result or exception. The statements after a
+     * failed one are not executed by the server, they are sent again.
+     * @note Only available with autoBatch, the statements are taken from the
+     * buffer of the client with takeBatch().
+     */
+    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) override
     {
-        LOG_FATAL << "The mysql library does not support batch mode";
-        exit(1);
+        if (!autoBatch_)
+        {
+            LOG_FATAL << "The mysql connection is not in batch mode";
+            exit(1);
+        }
+        if (loop_->isInLoopThread())
+        {
+            batchSqlInLoop(std::move(sqlCommands));
+        }
+        else
+        {
+            auto thisPtr = shared_from_this();
+            loop_->queueInLoop(
+                [thisPtr, sqlCommands = std::move(sqlCommands)]() mutable {
+                    thisPtr->batchSqlInLoop(std::move(sqlCommands));
+                });
+        }
     }
 
+    /**
+     * @brief Move the leading statements of the buffer that can share one
+     * multi-statement query to the returned batch. The batch is empty if less
+     * than two statements can be batched, statements with several queries in
+     * them or calling stored procedures are never batched.
+     */
+    static std::deque<std::shared_ptr<SqlCmd>> takeBatch(
+        std::deque<std::shared_ptr<SqlCmd>> &buffer);
+
     void disconnect() override;
 
   private:
@@ -131,6 +165,14 @@ class MysqlConnection : public DbConnection,
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback);
+    void batchSqlInLoop(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands);
+    void sendBatch();
+    void failBatch(const std::exception_ptr &exceptPtr);
+    std::string buildSql(const std::string_view &sql,
+                         size_t paraNum,
+                         const std::vector<const char *> &parameters,
+                         const std::vector<int> &length,
+                         const std::vector<int> &format);
     void startSetCharacterSet();
     void continueSetCharacterSet(int status);
     std::unique_ptr<trantor::Channel> channelPtr_;
@@ -158,6 +200,10 @@ class MysqlConnection : public DbConnection,
     void outputError();
     std::string sql_;
     std::string host_, user_, passwd_, dbname_, port_;
+    bool autoBatch_{false};
+    // The statements of the batch on the fly, the front one gets the next
+    // result.
+    std::deque<std::shared_ptr<SqlCmd>> batchCommands_;
 };
 
 }  // namespace orm
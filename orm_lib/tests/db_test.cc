@@ -2738,6 +2738,77 @@ DROGON_TEST(MySQLTest)
         }
     }
 }
+
+DbClientPtr mysqlBatchClient;
+
+DROGON_TEST(MySQLBatchTest)
+{
+    auto &clientPtr = mysqlBatchClient;
+    REQUIRE(clientPtr != nullptr);
+    // The statements queued together are sent as one multi-statement query,
+    // every statement still gets its own result or error.
+    for (int i = 0; i < 5; ++i)
+    {
+        if (i == 2)
+        {
+            clientPtr->execSqlAsync(
+                "select * from drogon_no_such_table",
+                [TEST_CTX](const Result &r) {
+                    FAULT("mysql - batch: the failed statement returned");
+                },
+                [TEST_CTX](const DrogonDbException &e) { SUCCESS(); });
+            continue;
+        }
+        clientPtr->execSqlAsync(
+            "select ? as value",
+            [TEST_CTX, i](const Result &r) {
+                MANDATE(r.size() == 1);
+                CHECK(r[0]["value"].as<int>() == i);
+            },
+            [TEST_CTX](const DrogonDbException &e) {
+                FAULT("mysql - batch what():", e.base().what());
+            },
+            i);
+    }
+    // A trailing line comment must not swallow the next statements
+    clientPtr->execSqlAsync(
+        "select 10 as value -- the first one",
+        [TEST_CTX](const Result &r) {
+            MANDATE(r.size() == 1);
+            CHECK(r[0]["value"].as<int>() == 10);
+        },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("mysql - batch what():", e.base().what());
+        });
+    clientPtr->execSqlAsync(
+        "select 11 as value # the second one",
+        [TEST_CTX](const Result &r) {
+            MANDATE(r.size() == 1);
+            CHECK(r[0]["value"].as<int>() == 11);
+        },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("mysql - batch what():", e.base().what());
+        });
+    clientPtr->execSqlAsync(
+        "select 12 as value",
+        [TEST_CTX](const Result &r) {
+            MANDATE(r.size() == 1);
+            CHECK(r[0]["value"].as<int>() == 12);
+        },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("mysql - batch what():", e.base().what());
+        });
+    // Statements containing ';' are not batched
+    clientPtr->execSqlAsync(
+        "select ';' as value",
+        [TEST_CTX](const Result &r) {
+            MANDATE(r.size() == 1);
+            CHECK(r[0]["value"].as<std::string>() == ";");
+        },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("mysql - batch what():", e.base().what());
+        });
+}
 #endif
 
 #if USE_SQLITE3
@@ -4072,6 +4143,8 @@ int main(int argc, char **argv)
 #if USE_MYSQL
     mysqlClient = DbClient::newMysqlClient(
         "host=127.0.0.1 port=3306 user=root client_encoding=utf8mb4", 1);
+    mysqlBatchClient = DbClient::newMysqlClient(
+        "host=127.0.0.1 port=3306 user=root client_encoding=utf8mb4", 1, true);
 #endif
 #if USE_POSTGRESQL
     postgreClient = DbClient::newPgClient(
@@ -0,0 +1,108 @@
+/**
+ *
+ *  @file mysql_batch_bench.cc
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ *  Compares the throughput of small independent statements queued on a MySQL
+ *  client with and without auto batching (multi-statement queries).
+ *  Usage: mysql_batch_bench [statements] [connection string]
+ */
+
+#include <drogon/config.h>
+#include <drogon/orm/DbClient.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace drogon::orm;
+
+#if USE_MYSQL
+static double run(const DbClientPtr &client, size_t statements)
+{
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> errors{0};
+    std::promise<void> finished;
+    auto start = std::chrono::steady_clock::now();
+    auto onDone = [&]() {
+        if (++done == statements)
+            finished.set_value();
+    };
+    for (size_t i = 0; i < statements; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            client->execSqlAsync(
+                "insert into drogon_batch_bench (value) values (?)",
+                [&](const Result &) { onDone(); },
+                [&](const DrogonDbException &) {
+                    ++errors;
+                    onDone();
+                },
+                std::to_string(i));
+        }
+        else
+        {
+            client->execSqlAsync(
+                "select count(*) from drogon_batch_bench where id < ?",
+                [&](const Result &) { onDone(); },
+                [&](const DrogonDbException &) {
+                    ++errors;
+                    onDone();
+                },
+                static_cast<int64_t>(i));
+        }
+    }
+    finished.get_future().wait();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (errors > 0)
+        std::cout << errors << " statements failed" << std::endl;
+    return elapsed.count();
+}
+
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kWarn);
+    size_t statements = argc > 1 ? std::stoul(argv[1]) : 20000;
+    std::string connInfo =
+        argc > 2 ? argv[2]
+                 : "host=127.0.0.1 port=3306 dbname=test user=root "
+                   "client_encoding=utf8mb4";
+
+    for (bool autoBatch : {false, true})
+    {
+        auto client = DbClient::newMysqlClient(connInfo, 1, autoBatch);
+        // Wait for the connection
+        while (!client->hasAvailableConnections())
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        client->execSqlSync("drop table if exists drogon_batch_bench");
+        client->execSqlSync(
+            "create table drogon_batch_bench (id int auto_increment primary "
+            "key, value varchar(32))");
+        auto seconds = run(client, statements);
+        std::cout << (autoBatch ? "batched:    " : "one by one: ") << statements
+                  << " statements in " << seconds << "s, "
+                  << static_cast<size_t>(statements / seconds)
+                  << " statements/s" << std::endl;
+        client->execSqlSync("drop table if exists drogon_batch_bench");
+    }
+    return 0;
+}
+#else
+int main()
+{
+    std::cout << "MySQL is not supported in this build" << std::endl;
+    return 0;
+}
+#endif